@@ -0,0 +1,3 @@
+#!/bin/sh
+# Needs premake5 on the PATH, the bundled binary is Windows only
+premake5 gmake2
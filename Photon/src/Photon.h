@@ -4,7 +4,25 @@
 
 #include "Photon/Application.h"
 #include "Photon/Layer.h"
+#include "Photon/Input.h"
+#include "Photon/Timestep.h"
 #include "Photon/Log.h"
+#include "Photon/Debug/Instrumentor.h"
+
+#include "Photon/Memory/Memory.h"
+#include "Photon/Memory/LinearAllocator.h"
+#include "Photon/Memory/PoolAllocator.h"
+#include "Photon/Memory/StlAllocator.h"
+
+#include "Photon/ECS/World.h"
+#include "Photon/ECS/Query.h"
+#include "Photon/ECS/CommandBuffer.h"
+
+#include "Photon/Tasks/Task.h"
+#include "Photon/Tasks/TaskScheduler.h"
+
+#include "Photon/Metrics/Metrics.h"
+#include "Photon/Metrics/MetricsExporter.h"
 
 /* -------- ENTRY POINT -------- */
 #include "Photon/EntryPoint.h"
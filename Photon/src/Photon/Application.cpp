@@ -2,52 +2,556 @@
 
 #include "Application.h"
 
+#include "Debug/Instrumentor.h"
+#include "Input.h"
+#include "Memory/Memory.h"
+
+#include "Platform/Vulkan/VulkanRenderer.h"
+
+#include <charconv>
+#include <chrono>
+
 namespace Photon
 {
-#define BIND_EVENT_FN(x) std::bind(&Application::x, this, std::placeholders::_1)
+#define BIND_EVENT_FN(x) [this](auto& e) { return x(e); }
+
+	// Caps the time fed to the fixed update so a long stall (debugger, window
+	// drag) doesn't trigger a burst of catch up steps
+	static constexpr float MaxFrameTime = 0.25f;
+
+	// Starting size, the allocator grows to the largest frame it has seen
+	static constexpr size_t FrameAllocatorSize = 1024 * 1024;
+
+	Application* Application::s_Instance = nullptr;
+	RunOptions Application::s_RunOptions;
 
-	Application::Application() 
+	Application::Application()
+		: Application(WindowProps())
 	{
-		m_Window = std::unique_ptr<Window>(Window::Create());
+	}
+
+	Application::Application(const WindowProps& props)
+		: m_FrameAllocator(FrameAllocatorSize),
+		m_FrameTimeMetric(Metrics::GetHistogram("frame.time_ns")),
+		m_FrameWorkMetric(Metrics::GetHistogram("frame.work_ns")),
+		m_TaskCountMetric(Metrics::GetGauge("tasks.active")),
+		m_PostedDroppedMetric(Metrics::GetCounter("events.posted.dropped"))
+	{
+		PT_PROFILE_FUNCTION();
+
+		PT_CORE_ASSERT(!s_Instance, "Application already exists!");
+		s_Instance = this;
+
+		JobSystem::Init();
+
+		WindowProps windowProps = props;
+		if (s_RunOptions.Headless)
+		{
+			windowProps.Headless = true;
+			windowProps.Offscreen = s_RunOptions.Offscreen;
+			if (s_RunOptions.SyntheticEventsPerFrame)
+				windowProps.SyntheticEventsPerFrame = s_RunOptions.SyntheticEventsPerFrame;
+		}
+
+		m_Window = std::unique_ptr<Window>(Window::Create(windowProps));
 		m_Window->SetEventCallback(BIND_EVENT_FN(OnEvent));
+
+		SetEventQueueing(s_RunOptions.QueueEvents);
+		m_TargetFrameRate = s_RunOptions.TargetFrameRate;
+
+		if (!s_RunOptions.RecordPath.empty())
+			StartRecording(s_RunOptions.RecordPath);
+		if (!s_RunOptions.ReplayPath.empty() && !StartReplay(s_RunOptions.ReplayPath, s_RunOptions.Replay))
+			m_Running = false;
+		if (!s_RunOptions.MetricsPath.empty())
+			StartMetricsExport(s_RunOptions.MetricsPath, s_RunOptions.MetricsInterval);
 	}
 
 	Application::~Application()
 	{
+		PT_PROFILE_FUNCTION();
+
+		StopRecording();
+		StopMetricsExport();
+
+		JobSystem::Shutdown();
+
+		s_Instance = nullptr;
 	}
 
 	void Application::Run()
 	{
-		while (m_Running)
+		PT_PROFILE_FUNCTION();
+
+		if (s_RunOptions.BenchmarkFrames)
+		{
+			RunBenchmark(s_RunOptions.BenchmarkFrames);
+		}
+		else
+		{
+			m_LastFrameTime = FrameLimiter::Clock::now();
+			while (m_Running)
+			{
+				RunFrame();
+
+				m_FrameLimiter.SetTargetFrameRate(m_Focused || m_IdleFrameRate <= 0.0 ? m_TargetFrameRate : m_IdleFrameRate);
+				m_FrameLimiter.Wait();
+			}
+		}
+
+		bool checked = true;
+		if (!s_RunOptions.ComparePath.empty())
+			checked = CompareFrame(s_RunOptions.ComparePath, s_RunOptions.CompareTolerance, s_RunOptions.CapturePath);
+		else if (!s_RunOptions.CapturePath.empty())
+			checked = CaptureFrame(s_RunOptions.CapturePath);
+		if (!checked)
+			m_ExitCode = 1;
+	}
+
+	bool Application::CaptureFrame(const std::string& filepath)
+	{
+		VulkanRenderer* renderer = m_Window->GetRenderer();
+		if (!renderer)
+		{
+			PT_CORE_ERROR("The window has no renderer, can't capture '{0}'", filepath);
+			return false;
+		}
+
+		return renderer->CaptureFrame(filepath);
+	}
+
+	bool Application::CompareFrame(const std::string& referencePath, uint32_t tolerance, const std::string& capturePath)
+	{
+		VulkanRenderer* renderer = m_Window->GetRenderer();
+		if (!renderer)
+		{
+			PT_CORE_ERROR("The window has no renderer, can't compare with '{0}'", referencePath);
+			return false;
+		}
+
+		VulkanPpmImage reference;
+		if (!VulkanReadback::ReadPpm(referencePath, reference))
+			return false;
+
+		return renderer->ReadFrame([&](const VulkanReadbackData& data)
+		{
+			// Written even when it doesn't match, to look at the difference
+			bool written = capturePath.empty() || VulkanReadback::WritePpm(capturePath, data);
+
+			VulkanImageDifference difference = VulkanReadback::Compare(data, reference, tolerance);
+			if (!difference.SizeMatches)
+			{
+				PT_CORE_ERROR("Frame is {0}x{1}, '{2}' is {3}x{4}", data.Extent.width, data.Extent.height, referencePath,
+					reference.Width, reference.Height);
+				return false;
+			}
+			if (difference.DifferingPixels)
+			{
+				PT_CORE_ERROR("{0} pixels differ from '{1}' by more than {2}, by up to {3}", difference.DifferingPixels, referencePath,
+					tolerance, difference.MaxDifference);
+				return false;
+			}
+
+			PT_CORE_REPORT("Frame matches '{0}', largest difference {1}", referencePath, difference.MaxDifference);
+			return written;
+		});
+	}
+
+	FrameStats Application::RunBenchmark(uint64_t frameCount)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		std::vector<double> frameTimes;
+		frameTimes.reserve(frameCount);
+
+		uint64_t startEvents = m_EventCount;
+		uint64_t startAllocations = Memory::GetTotalAllocationCount();
+		Clock::time_point start = Clock::now();
+		Clock::time_point frameStart = start;
+		m_LastFrameTime = start;
+
+		for (uint64_t i = 0; i < frameCount && m_Running; i++)
 		{
-			m_Window->OnUpdate();
+			RunFrame();
 
-			for (Layer* layer : m_LayerStack)
-				layer->OnUpdate();
+			Clock::time_point frameEnd = Clock::now();
+			frameTimes.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+			frameStart = frameEnd;
+		}
+
+		FrameStats stats;
+		stats.Frames = frameTimes.size();
+		stats.Events = m_EventCount - startEvents;
+		stats.TotalSeconds = std::chrono::duration<double>(frameStart - start).count();
+
+		if (!frameTimes.empty())
+		{
+			double total = 0.0;
+			for (double t : frameTimes)
+				total += t;
+			stats.MeanMs = total / frameTimes.size();
+
+			std::sort(frameTimes.begin(), frameTimes.end());
+			stats.MinMs = frameTimes.front();
+			stats.MaxMs = frameTimes.back();
+			stats.P99Ms = frameTimes[std::min(frameTimes.size() - 1, (size_t)(frameTimes.size() * 0.99))];
+		}
+
+		if (stats.TotalSeconds > 0.0)
+			stats.EventsPerSecond = stats.Events / stats.TotalSeconds;
+		if (stats.Frames)
+			stats.AllocationsPerFrame = (double)(Memory::GetTotalAllocationCount() - startAllocations) / stats.Frames;
+
+		PT_CORE_REPORT("Benchmark: {0} frames in {1:.3f}s", stats.Frames, stats.TotalSeconds);
+		PT_CORE_REPORT("\tFrame time (ms): min {0:.4f}, mean {1:.4f}, p99 {2:.4f}, max {3:.4f}", stats.MinMs, stats.MeanMs, stats.P99Ms, stats.MaxMs);
+		PT_CORE_REPORT("\tEvents: {0} ({1:.0f}/s)", stats.Events, stats.EventsPerSecond);
+		PT_CORE_REPORT("\tTracked allocations per frame: {0:.2f}", stats.AllocationsPerFrame);
+
+		return stats;
+	}
+
+	void Application::RunFrame()
+	{
+		PT_PROFILE_FUNCTION();
+
+		FrameLimiter::Clock::time_point now = FrameLimiter::Clock::now();
+		Timestep timestep = std::chrono::duration<float>(now - m_LastFrameTime).count();
+		m_FrameTimeMetric.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_LastFrameTime));
+		m_LastFrameTime = now;
+
+		HistogramTimer frameWork(m_FrameWorkMetric);
+
+		m_FrameAllocator.Reset();
+
+		// Layers pushed or popped during the frame are applied on Unlock
+		m_LayerStack.Lock();
+
+		if (m_EventRecorder)
+			m_EventRecorder->NextFrame();
+
+		m_Window->OnUpdate();
+
+		if (m_EventPlayer && !m_EventPlayer->NextFrame())
+		{
+			StopReplay();
+			m_Running = false;
+		}
+
+		// Layers and jobs see the input gathered up to this point all frame
+		Input::Publish();
+
+		if (!m_EventQueue.Empty())
+		{
+			PT_PROFILE_SCOPE("EventQueue Drain");
+			m_EventQueue.Drain(BIND_EVENT_FN(DispatchEvent));
+		}
+
+		if (!m_PostedEvents.Empty())
+		{
+			PT_PROFILE_SCOPE("PostedEvents Drain");
+			m_PostedEvents.Drain(BIND_EVENT_FN(DispatchEvent));
+
+			uint64_t dropped = m_PostedEvents.GetDroppedCount();
+			if (dropped != m_ReportedDroppedEvents)
+			{
+				m_PostedDroppedMetric.Add(dropped - m_ReportedDroppedEvents);
+				PT_CORE_WARN("{0} posted events were dropped, the queue holds {1}", dropped - m_ReportedDroppedEvents, m_PostedEvents.GetCapacity());
+				m_ReportedDroppedEvents = dropped;
+			}
+		}
+
+		{
+			PT_PROFILE_SCOPE("TaskScheduler Update");
+			m_TaskScheduler.Update(timestep);
+			m_TaskCountMetric.Set((double)m_TaskScheduler.GetTaskCount());
+		}
+
+		if (m_FixedTimestep > 0.0f)
+			FixedUpdate(timestep);
+
+		{
+			PT_PROFILE_SCOPE("LayerStack OnUpdate");
+
+			// Independent layers are kicked off first so they overlap with the
+			// layers that have to run in order on this thread
+			JobCounter independentLayers;
+			m_LayerUpdateJobs.clear();
+			for (Layer* layer : m_LayerStack.GetUpdateLayers())
+			{
+				if (layer->IsIndependent())
+				{
+					GetUpdateMetric(*layer);
+					m_LayerUpdateJobs.push_back({ layer, timestep });
+				}
+			}
+
+			Job job;
+			job.Function = [](void* data, uint32_t, uint32_t)
+			{
+				LayerUpdateJob& update = *(LayerUpdateJob*)data;
+				PT_PROFILE_SCOPE(update.Target->m_ProfileUpdateName);
+				HistogramTimer timer(*update.Target->m_UpdateMetric);
+				update.Target->OnUpdate(update.Ts);
+			};
+			for (LayerUpdateJob& update : m_LayerUpdateJobs)
+			{
+				job.Data = &update;
+				JobSystem::Schedule(job, independentLayers);
+			}
+
+			for (Layer* layer : m_LayerStack.GetUpdateLayers())
+			{
+				if (layer->IsIndependent())
+					continue;
+
+				PT_PROFILE_SCOPE(layer->m_ProfileUpdateName);
+				HistogramTimer timer(GetUpdateMetric(*layer));
+				layer->OnUpdate(timestep);
+			}
+
+			JobSystem::Wait(independentLayers);
+		}
+
+		m_LayerStack.Unlock();
+	}
+
+	void Application::FixedUpdate(Timestep ts)
+	{
+		PT_PROFILE_FUNCTION();
+
+		m_FixedAccumulator += std::min(ts.GetSeconds(), MaxFrameTime);
+
+		while (m_FixedAccumulator >= m_FixedTimestep)
+		{
+			for (Layer* layer : m_LayerStack.GetFixedUpdateLayers())
+			{
+				PT_PROFILE_SCOPE(layer->m_ProfileFixedUpdateName);
+				layer->OnFixedUpdate(m_FixedTimestep);
+			}
+
+			m_FixedAccumulator -= m_FixedTimestep;
 		}
 	}
 
 	void Application::OnEvent(Event& e)
 	{
+		if (m_EventRecorder)
+			m_EventRecorder->Record(e);
+
+		Input::OnEvent(e);
+
+		if (m_QueueEvents)
+			m_EventQueue.Push(e);
+		else
+			DispatchEvent(e);
+	}
+
+	void Application::SetEventQueueing(bool enabled)
+	{
+		// Deliver anything still pending so no events are lost when switching
+		if (!enabled && !m_EventQueue.Empty())
+			m_EventQueue.Drain(BIND_EVENT_FN(DispatchEvent));
+
+		m_QueueEvents = enabled;
+	}
+
+	bool Application::StartRecording(const std::string& filepath)
+	{
+		m_EventRecorder = std::make_unique<EventRecorder>(filepath);
+		if (!m_EventRecorder->IsOpen())
+		{
+			m_EventRecorder.reset();
+			return false;
+		}
+
+		PT_CORE_REPORT("Recording events to '{0}'", filepath);
+		return true;
+	}
+
+	void Application::StopRecording()
+	{
+		if (!m_EventRecorder)
+			return;
+
+		PT_CORE_REPORT("Recorded {0} events in {1} bytes", m_EventRecorder->GetEventCount(), m_EventRecorder->GetBytesWritten());
+		m_EventRecorder.reset();
+	}
+
+	bool Application::StartReplay(const std::string& filepath, ReplayMode mode)
+	{
+		m_EventPlayer = std::make_unique<EventPlayer>(filepath, mode);
+		if (m_EventPlayer->IsFinished())
+		{
+			m_EventPlayer.reset();
+			return false;
+		}
+
+		// Replayed events take the place of live input, everything else the
+		// window raises (close, resize, focus) still goes through
+		m_EventPlayer->SetEventCallback(BIND_EVENT_FN(OnEvent));
+		m_Window->SetEventCallback([this](Event& e)
+		{
+			if (!e.IsInCategory(EventCategoryInput))
+				OnEvent(e);
+		});
+
+		PT_CORE_REPORT("Replaying events from '{0}'", filepath);
+		return true;
+	}
+
+	void Application::StopReplay()
+	{
+		if (!m_EventPlayer)
+			return;
+
+		PT_CORE_REPORT("Replayed {0} events over {1} frames", m_EventPlayer->GetEventCount(), m_EventPlayer->GetFrame());
+		m_EventPlayer.reset();
+		m_Window->SetEventCallback(BIND_EVENT_FN(OnEvent));
+	}
+
+	void Application::DispatchEvent(Event& e)
+	{
+		PT_PROFILE_FUNCTION();
+
+		m_EventCount++;
+
+		Counter*& dispatched = m_DispatchedMetrics[(size_t)e.GetEventType()];
+		if (!dispatched)
+			dispatched = &Metrics::GetCounter(std::string("events.") + e.GetName() + ".dispatched");
+		dispatched->Increment();
+
 		EventDispatcher dispatcher(e);
 		dispatcher.Dispatch<WindowCloseEvent>(BIND_EVENT_FN(OnWindowClose));
+		dispatcher.Dispatch<WindowFocusEvent>(BIND_EVENT_FN(OnWindowFocus));
+		dispatcher.Dispatch<WindowLostFocusEvent>(BIND_EVENT_FN(OnWindowLostFocus));
+
+		m_TaskScheduler.OnEvent(e);
 
-		for (auto it = m_LayerStack.end(); it != m_LayerStack.begin(); )
+		m_LayerStack.Lock();
+		int categories = e.GetCategoryFlags();
+		for (Layer* layer : m_LayerStack.GetEventLayers())
 		{
-			(*--it)->OnEvent(e);
+			if (!(layer->GetEventCategories() & categories))
+				continue;
+
+			PT_PROFILE_SCOPE(layer->m_ProfileEventName);
+			layer->OnEvent(e);
 			if (e.Handled)
 				break;
 		}
+		m_LayerStack.Unlock();
+	}
+
+	bool Application::StartMetricsExport(const std::string& filepath, double intervalSeconds)
+	{
+		m_MetricsExporter = std::make_unique<MetricsExporter>(filepath, intervalSeconds, MetricsExporter::GetFormatForPath(filepath));
+		if (!m_MetricsExporter->IsOpen())
+		{
+			m_MetricsExporter.reset();
+			return false;
+		}
+
+		PT_CORE_REPORT("Exporting metrics to '{0}' every {1}s", filepath, intervalSeconds);
+		return true;
+	}
+
+	void Application::StopMetricsExport()
+	{
+		// The exporter writes a last snapshot as it is destroyed
+		m_MetricsExporter.reset();
+	}
+
+	Histogram& Application::GetUpdateMetric(Layer& layer)
+	{
+		// Layers that never update don't get a histogram
+		if (!layer.m_UpdateMetric)
+			layer.m_UpdateMetric = &Metrics::GetHistogram("layer." + layer.GetName() + ".update_ns");
+		return *layer.m_UpdateMetric;
+	}
+
+	void Application::PopLayer(Layer* layer)
+	{
+		m_LayerStack.PopLayer(layer);
 	}
 
-	void Application::PushLayer(Layer* layer)
+	void Application::PopOverlay(Layer* overlay)
 	{
-		m_LayerStack.PushLayer(layer);
+		m_LayerStack.PopOverlay(overlay);
 	}
 
-	void Application::PushOverlay(Layer* overlay)
+	std::vector<std::string> Application::ParseCommandLine(int argc, char** argv)
 	{
-		m_LayerStack.PushOverlay(overlay);
+		std::vector<std::string> problems;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			// Takes the next argument, which has to be a number of at least
+			// min. A bad one is reported and the option keeps its value
+			auto parseValue = [&](auto& value, std::remove_reference_t<decltype(value)> min = 0)
+			{
+				std::string text = argv[++i];
+				std::remove_reference_t<decltype(value)> parsed;
+				auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+				if (error != std::errc() || end != text.data() + text.size() || parsed < min)
+					problems.push_back(fmt::format("Invalid value '{0}' for {1}", text, arg));
+				else
+					value = parsed;
+			};
+
+			if (arg == "--headless")
+				s_RunOptions.Headless = true;
+			else if (arg == "--offscreen")
+				s_RunOptions.Headless = s_RunOptions.Offscreen = true;
+			else if (arg == "--capture" && hasValue)
+				s_RunOptions.CapturePath = argv[++i];
+			else if (arg == "--compare" && hasValue)
+				s_RunOptions.ComparePath = argv[++i];
+			else if (arg == "--compare-tolerance" && hasValue)
+				parseValue(s_RunOptions.CompareTolerance);
+			else if (arg == "--profile")
+				s_RunOptions.Profile = true;
+			else if (arg == "--queue-events")
+				s_RunOptions.QueueEvents = true;
+			else if (arg == "--synthetic-events" && hasValue)
+				parseValue(s_RunOptions.SyntheticEventsPerFrame);
+			else if (arg == "--fps" && hasValue)
+				parseValue(s_RunOptions.TargetFrameRate);
+			else if (arg == "--benchmark" && hasValue)
+				parseValue(s_RunOptions.BenchmarkFrames);
+			else if (arg == "--record" && hasValue)
+				s_RunOptions.RecordPath = argv[++i];
+			else if (arg == "--replay" && hasValue)
+				s_RunOptions.ReplayPath = argv[++i];
+			else if (arg == "--replay-fast")
+				s_RunOptions.Replay = ReplayMode::Immediate;
+			else if (arg == "--metrics" && hasValue)
+				s_RunOptions.MetricsPath = argv[++i];
+			else if (arg == "--metrics-interval" && hasValue)
+				parseValue(s_RunOptions.MetricsInterval, 0.001);
+			else if (arg == "--log-file" && hasValue)
+				s_RunOptions.Log.FilePath = argv[++i];
+			else if (arg == "--log-sync")
+				s_RunOptions.Log.Async = false;
+			else if (arg == "--log-queue" && hasValue)
+				parseValue(s_RunOptions.Log.QueueSize, (size_t)1);
+			else if (arg == "--log-overflow" && hasValue)
+			{
+				std::string policy = argv[++i];
+				if (policy == "block")
+					s_RunOptions.Log.OverflowPolicy = LogOverflowPolicy::Block;
+				else if (policy == "drop")
+					s_RunOptions.Log.OverflowPolicy = LogOverflowPolicy::Drop;
+				else if (policy == "overwrite")
+					s_RunOptions.Log.OverflowPolicy = LogOverflowPolicy::OverwriteOldest;
+				else
+					problems.push_back(fmt::format("Unknown log overflow policy '{0}'", policy));
+			}
+			else
+				problems.push_back(fmt::format("Unknown command line argument '{0}'", arg));
+		}
+		return problems;
 	}
 
 	bool Application::OnWindowClose(WindowCloseEvent& e)
@@ -55,4 +559,16 @@ namespace Photon
 		m_Running = false;
 		return true;
 	}
-}
\ No newline at end of file
+
+	bool Application::OnWindowFocus(WindowFocusEvent& e)
+	{
+		m_Focused = true;
+		return false;
+	}
+
+	bool Application::OnWindowLostFocus(WindowLostFocusEvent& e)
+	{
+		m_Focused = false;
+		return false;
+	}
+}
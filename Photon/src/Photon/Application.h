@@ -1,31 +1,229 @@
 #pragma once
 #include "Core.h"
 #include "Window.h"
+#include "Log.h"
 #include "Events/Event.h"
 #include "Events/ApplicationEvent.h"
+#include "Events/EventQueue.h"
+#include "Events/ConcurrentEventQueue.h"
+#include "Events/EventRecording.h"
 #include "LayerStack.h"
+#include "FrameLimiter.h"
+#include "Timestep.h"
+#include "Jobs/JobSystem.h"
+#include "Tasks/TaskScheduler.h"
+#include "Memory/LinearAllocator.h"
+#include "Metrics/Metrics.h"
+#include "Metrics/MetricsExporter.h"
 
 namespace Photon
 {
+	// Options read from the command line by the entry point
+	//   --headless           run without an OS window
+	//   --offscreen          run headless with a renderer that draws into
+	//                        offscreen images, without a surface
+	//   --capture FILE       write the last frame to FILE as a PPM image
+	//   --compare FILE       compare the last frame with the PPM image in FILE,
+	//                        and exit with 1 when they differ
+	//   --compare-tolerance N
+	//                        largest channel difference, 0 to 255, a pixel
+	//                        may have and still match, 0 by default
+	//   --synthetic-events N generate N input events per frame when headless
+	//   --benchmark N        pump N frames as fast as possible and report timings
+	//   --queue-events       defer window events to a once per frame drain
+	//   --profile            write Chrome trace files for startup, runtime and shutdown
+	//   --fps N              limit the frame rate to N
+	//   --record FILE        record every window event to FILE
+	//   --replay FILE        feed the events recorded in FILE instead of live
+	//                        input, and exit when the recording ends
+	//   --replay-fast        deliver the whole recording in the first frame,
+	//                        then run out the recorded number of frames
+	//   --metrics FILE       export metrics to FILE, JSON lines when it ends
+	//                        in .json and CSV otherwise
+	//   --metrics-interval S seconds between metrics exports, 10 by default
+	//   --log-file FILE      also write the log to FILE
+	//   --log-sync           write the log on the calling thread
+	//   --log-overflow P     what the async log does when its queue is full:
+	//                        block (default), drop or overwrite
+	//   --log-queue N        async log queue size in messages
+	struct RunOptions
+	{
+		bool Headless = false;
+		bool Offscreen = false;
+		bool QueueEvents = false;
+		bool Profile = false;
+		uint32_t SyntheticEventsPerFrame = 0;
+		uint64_t BenchmarkFrames = 0;
+		double TargetFrameRate = 0.0;
+		std::string RecordPath;
+		std::string ReplayPath;
+		ReplayMode Replay = ReplayMode::Recorded;
+		std::string MetricsPath;
+		double MetricsInterval = 10.0;
+		std::string CapturePath;
+		std::string ComparePath;
+		uint32_t CompareTolerance = 0;
+		// The entry point initializes the log with it
+		LogConfig Log;
+	};
+
+	struct FrameStats
+	{
+		uint64_t Frames = 0;
+		uint64_t Events = 0;
+		double TotalSeconds = 0.0;
+		double MinMs = 0.0, MeanMs = 0.0, P99Ms = 0.0, MaxMs = 0.0;
+		double EventsPerSecond = 0.0;
+		// Tracked (Memory::Allocate) allocations, 0 without PT_TRACK_MEMORY
+		double AllocationsPerFrame = 0.0;
+	};
+
 	class PHOTON_API Application
 	{
 	public:
 		Application();
-		~Application();
+		Application(const WindowProps& props);
+		virtual ~Application();
 
 		void Run();
+		// Pumps frameCount frames without any pacing and reports frame times
+		FrameStats RunBenchmark(uint64_t frameCount);
+		// Writes the window's current frame to a PPM file, false when the
+		// window has no renderer or the frame can't be read back
+		bool CaptureFrame(const std::string& filepath);
+		// Compares the window's current frame with the PPM image in
+		// referencePath, writing the frame to capturePath too when given.
+		// False when a pixel differs by more than tolerance in any channel
+		bool CompareFrame(const std::string& referencePath, uint32_t tolerance, const std::string& capturePath = {});
+		// What main returns, 1 when a --capture or --compare failed
+		inline int GetExitCode() const { return m_ExitCode; }
 
 		void OnEvent(Event& e);
 
-		void PushLayer(Layer* layer);
-		void PushOverlay(Layer* overlay);
+		// When enabled, events raised by the window are queued and coalesced,
+		// then dispatched to the layer stack once per frame
+		void SetEventQueueing(bool enabled);
+		inline bool IsEventQueueing() const { return m_QueueEvents; }
+
+		// Records the window's events, frame stamped, until StopRecording
+		bool StartRecording(const std::string& filepath);
+		void StopRecording();
+		// Plays a recording back through OnEvent. Live input events from the
+		// window are ignored until the replay ends or is stopped
+		bool StartReplay(const std::string& filepath, ReplayMode mode = ReplayMode::Recorded);
+		void StopReplay();
+		inline bool IsReplaying() const { return (bool)m_EventPlayer; }
+
+		// Writes every registered metric to filepath each intervalSeconds
+		// from a background thread, until StopMetricsExport
+		bool StartMetricsExport(const std::string& filepath, double intervalSeconds = 10.0);
+		void StopMetricsExport();
+
+		// Thread-safe and lock-free. The event is copied and dispatched to the
+		// layer stack on the main thread at the start of the next frame.
+		// Returns false if the queue is full and the event was dropped
+		inline bool PostEvent(const Event& e) { return m_PostedEvents.Post(e); }
+
+		// Pushes and pops made during a frame take effect at the end of it
+		template<typename T>
+		void PushLayer(T* layer) { m_LayerStack.PushLayer(layer); }
+		template<typename T>
+		void PushOverlay(T* overlay) { m_LayerStack.PushOverlay(overlay); }
+		template<typename T, typename... Args>
+		T* EmplaceLayer(Args&&... args) { return m_LayerStack.EmplaceLayer<T>(std::forward<Args>(args)...); }
+		template<typename T, typename... Args>
+		T* EmplaceOverlay(Args&&... args) { return m_LayerStack.EmplaceOverlay<T>(std::forward<Args>(args)...); }
+		void PopLayer(Layer* layer);
+		void PopOverlay(Layer* overlay);
+
+		// Frame rate limit while the window has focus, 0 is unlimited
+		inline void SetTargetFrameRate(double fps) { m_TargetFrameRate = fps; }
+		inline double GetTargetFrameRate() const { return m_TargetFrameRate; }
+		// Frame rate limit while the window does not have focus, 0 disables throttling
+		inline void SetIdleFrameRate(double fps) { m_IdleFrameRate = fps; }
+		inline double GetIdleFrameRate() const { return m_IdleFrameRate; }
+
+		// Enables Layer::OnFixedUpdate at a fixed step in seconds, 0 disables it
+		inline void SetFixedTimestep(float seconds) { m_FixedTimestep = seconds; m_FixedAccumulator = 0.0f; }
+		inline float GetFixedTimestep() const { return m_FixedTimestep; }
+		// How far between the last and next fixed update this frame is, in
+		// [0, 1). Used to interpolate state that is simulated at the fixed rate
+		inline float GetFixedUpdateAlpha() const { return m_FixedTimestep > 0.0f ? m_FixedAccumulator / m_FixedTimestep : 0.0f; }
+
+		inline Window& GetWindow() { return *m_Window; }
+
+		// Coroutine tasks, resumed every frame after events are dispatched
+		inline TaskScheduler& GetTaskScheduler() { return m_TaskScheduler; }
+		inline void SpawnTask(Task task) { m_TaskScheduler.Spawn(std::move(task)); }
+
+		// Scratch memory for the current frame, reset at the start of every
+		// frame. Main thread only
+		inline LinearAllocator& GetFrameAllocator() { return m_FrameAllocator; }
+
+		inline static Application& Get() { return *s_Instance; }
+
+		// Runs before the log is initialized, so the arguments it couldn't
+		// use are returned for the caller to report
+		static std::vector<std::string> ParseCommandLine(int argc, char** argv);
+		inline static const RunOptions& GetRunOptions() { return s_RunOptions; }
 	private:
+		void RunFrame();
+		void FixedUpdate(Timestep ts);
+		void DispatchEvent(Event& e);
+
+		static Histogram& GetUpdateMetric(Layer& layer);
+
 		bool OnWindowClose(WindowCloseEvent& e);
+		bool OnWindowFocus(WindowFocusEvent& e);
+		bool OnWindowLostFocus(WindowLostFocusEvent& e);
 
 		std::unique_ptr<Window> m_Window;
 		bool m_Running = true;
+		int m_ExitCode = 0;
+		bool m_Focused = true;
+		uint64_t m_EventCount = 0;
+
+		struct LayerUpdateJob
+		{
+			Layer* Target;
+			Timestep Ts;
+		};
+		std::vector<LayerUpdateJob> m_LayerUpdateJobs;
+
+		FrameLimiter::Clock::time_point m_LastFrameTime;
+		FrameLimiter m_FrameLimiter;
+		double m_TargetFrameRate = 0.0;
+		double m_IdleFrameRate = 15.0;
+
+		float m_FixedTimestep = 0.0f;
+		float m_FixedAccumulator = 0.0f;
+
+		bool m_QueueEvents = false;
+		EventQueue m_EventQueue;
+		std::unique_ptr<EventRecorder> m_EventRecorder;
+		std::unique_ptr<EventPlayer> m_EventPlayer;
+		ConcurrentEventQueue m_PostedEvents;
+		uint64_t m_ReportedDroppedEvents = 0;
+
+		LinearAllocator m_FrameAllocator;
+
+		// Time between the starts of consecutive frames, and the part of it
+		// spent in RunFrame, i.e. without the frame limiter's wait
+		Histogram& m_FrameTimeMetric;
+		Histogram& m_FrameWorkMetric;
+		Gauge& m_TaskCountMetric;
+		Counter& m_PostedDroppedMetric;
+		// "events.<type>.dispatched", looked up on the first event of a type
+		std::array<Counter*, EventTypeCount> m_DispatchedMetrics = {};
+		std::unique_ptr<MetricsExporter> m_MetricsExporter;
 
 		LayerStack m_LayerStack;
+		// Declared after the layer stack so tasks, which usually point into
+		// layers, are destroyed first
+		TaskScheduler m_TaskScheduler;
+
+		static Application* s_Instance;
+		static RunOptions s_RunOptions;
 	};
 
 	// To be define in client
@@ -0,0 +1,186 @@
+#include "ptpch.h"
+#include "AsyncLogSink.h"
+
+#include <chrono>
+
+namespace Photon
+{
+	static size_t RoundUpToPowerOfTwo(size_t value)
+	{
+		size_t result = 2;
+		while (result < value)
+			result <<= 1;
+		return result;
+	}
+
+	AsyncLogSink::AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t capacity, LogOverflowPolicy policy)
+		: m_Sinks(std::move(sinks)), m_Policy(policy), m_DroppedMetric(Metrics::GetCounter("log.dropped"))
+	{
+		capacity = RoundUpToPowerOfTwo(capacity);
+		m_Mask = capacity - 1;
+
+		m_Slots = std::make_unique<Slot[]>(capacity);
+		for (size_t i = 0; i < capacity; i++)
+			m_Slots[i].Sequence.store(i, std::memory_order_relaxed);
+
+		m_Writer = std::thread(&AsyncLogSink::WriterThread, this);
+	}
+
+	AsyncLogSink::~AsyncLogSink()
+	{
+		m_Stopping.store(true, std::memory_order_release);
+		if (m_Writer.joinable())
+			m_Writer.join();
+	}
+
+	bool AsyncLogSink::TryEnqueue(const spdlog::details::log_msg& msg)
+	{
+		size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = m_Slots[pos & m_Mask];
+			size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+			if (diff == 0)
+			{
+				if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					slot.Message = spdlog::details::log_msg_buffer(msg);
+					slot.Sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// Full
+				return false;
+			}
+			else
+			{
+				pos = m_EnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool AsyncLogSink::TryDequeue(spdlog::details::log_msg_buffer& out)
+	{
+		size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = m_Slots[pos & m_Mask];
+			size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+			if (diff == 0)
+			{
+				if (m_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					out = std::move(slot.Message);
+					slot.Sequence.store(pos + m_Mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// Empty
+				return false;
+			}
+			else
+			{
+				pos = m_DequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void AsyncLogSink::log(const spdlog::details::log_msg& msg)
+	{
+		while (!TryEnqueue(msg))
+		{
+			switch (m_Policy)
+			{
+				case LogOverflowPolicy::Block:
+					std::this_thread::yield();
+					break;
+				case LogOverflowPolicy::Drop:
+					m_Dropped.fetch_add(1, std::memory_order_relaxed);
+					m_DroppedMetric.Increment();
+					return;
+				case LogOverflowPolicy::OverwriteOldest:
+				{
+					spdlog::details::log_msg_buffer discarded;
+					if (TryDequeue(discarded))
+					{
+						m_Dropped.fetch_add(1, std::memory_order_relaxed);
+						m_DroppedMetric.Increment();
+						m_Retired.fetch_add(1, std::memory_order_release);
+					}
+					break;
+				}
+			}
+		}
+
+		m_Enqueued.fetch_add(1, std::memory_order_release);
+	}
+
+	void AsyncLogSink::flush()
+	{
+		// Called for every error through flush_on, waiting for an idle writer
+		// would stall the logging thread for its whole poll interval
+		uint64_t target = m_Enqueued.load(std::memory_order_acquire);
+		uint64_t current = m_FlushTarget.load(std::memory_order_relaxed);
+		while (current < target && !m_FlushTarget.compare_exchange_weak(current, target, std::memory_order_release))
+			;
+	}
+
+	void AsyncLogSink::set_pattern(const std::string& pattern)
+	{
+		for (auto& sink : m_Sinks)
+			sink->set_pattern(pattern);
+	}
+
+	void AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> formatter)
+	{
+		for (auto& sink : m_Sinks)
+			sink->set_formatter(formatter->clone());
+	}
+
+	void AsyncLogSink::WriterThread()
+	{
+		spdlog::details::log_msg_buffer message;
+		uint64_t flushed = 0;
+
+		for (;;)
+		{
+			uint64_t flushTarget = m_FlushTarget.load(std::memory_order_acquire);
+			if (flushTarget > flushed && m_Retired.load(std::memory_order_acquire) >= flushTarget)
+			{
+				for (auto& sink : m_Sinks)
+					sink->flush();
+				flushed = flushTarget;
+			}
+
+			if (TryDequeue(message))
+			{
+				for (auto& sink : m_Sinks)
+				{
+					if (sink->should_log(message.level))
+						sink->log(message);
+				}
+
+				m_Retired.fetch_add(1, std::memory_order_release);
+				continue;
+			}
+
+			if (m_Stopping.load(std::memory_order_acquire))
+				break;
+
+			// Producers never signal the writer, which keeps the logging call
+			// free of syscalls. An idle writer just polls at a low rate
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		for (auto& sink : m_Sinks)
+			sink->flush();
+	}
+}
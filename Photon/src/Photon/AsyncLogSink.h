@@ -0,0 +1,68 @@
+#pragma once
+#include "Log.h"
+#include "Metrics/Metrics.h"
+
+#include "spdlog/sinks/sink.h"
+#include "spdlog/details/log_msg_buffer.h"
+
+#include <atomic>
+#include <thread>
+
+namespace Photon
+{
+	// spdlog sink that hands messages to a background writer thread through a
+	// bounded lock-free ring buffer (Vyukov MPMC queue). The calling thread only
+	// formats the payload and copies it into a preallocated slot, the pattern
+	// formatting and console/file IO happen on the writer thread.
+	//
+	// flush doesn't wait either, it marks what was logged so far and the
+	// writer flushes the sinks once it has written that far. Everything is
+	// written and flushed when the sink is destroyed.
+	class AsyncLogSink : public spdlog::sinks::sink
+	{
+	public:
+		AsyncLogSink(std::vector<spdlog::sink_ptr> sinks, size_t capacity, LogOverflowPolicy policy);
+		virtual ~AsyncLogSink();
+
+		void log(const spdlog::details::log_msg& msg) override;
+		void flush() override;
+		void set_pattern(const std::string& pattern) override;
+		void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+		inline uint64_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+	private:
+		bool TryEnqueue(const spdlog::details::log_msg& msg);
+		bool TryDequeue(spdlog::details::log_msg_buffer& out);
+
+		void WriterThread();
+	private:
+		struct Slot
+		{
+			std::atomic<size_t> Sequence;
+			spdlog::details::log_msg_buffer Message;
+		};
+
+		std::vector<spdlog::sink_ptr> m_Sinks;
+		LogOverflowPolicy m_Policy;
+
+		std::unique_ptr<Slot[]> m_Slots;
+		size_t m_Mask;
+
+		alignas(64) std::atomic<size_t> m_EnqueuePos = 0;
+		alignas(64) std::atomic<size_t> m_DequeuePos = 0;
+
+		// Messages accepted into the ring and messages that have left it, either
+		// written by the writer thread or discarded by OverwriteOldest
+		alignas(64) std::atomic<uint64_t> m_Enqueued = 0;
+		alignas(64) std::atomic<uint64_t> m_Retired = 0;
+		std::atomic<uint64_t> m_Dropped = 0;
+		// Retired count the last flush asked for, the writer flushes the
+		// sinks once it gets there
+		alignas(64) std::atomic<uint64_t> m_FlushTarget = 0;
+		// "log.dropped", shared by every sink over the process lifetime
+		Counter& m_DroppedMetric;
+
+		std::atomic<bool> m_Stopping = false;
+		std::thread m_Writer;
+	};
+}
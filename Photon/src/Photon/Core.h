@@ -1,18 +1,31 @@
 #pragma once
 
-#ifdef PT_PLATFORM_WINDOWS
+// PT_STATIC: Photon is linked in as a static library, nothing is imported or
+// exported and the whole engine is visible to link-time optimisation
+#if defined(PT_STATIC)
+	#define PHOTON_API
+#elif defined(PT_PLATFORM_WINDOWS)
 	#ifdef PT_BUILD_DLL
 		#define PHOTON_API __declspec(dllexport)
 	#else
 		#define PHOTON_API __declspec(dllimport)
 	#endif
+#elif defined(PT_PLATFORM_LINUX)
+	#define PHOTON_API __attribute__((visibility("default")))
 #else
-	#error Photon only supports Windows!
+	#error Photon only supports Windows and Linux!
+#endif
+
+#if defined(PT_PLATFORM_WINDOWS)
+	#define PT_DEBUGBREAK() __debugbreak()
+#elif defined(PT_PLATFORM_LINUX)
+	#include <signal.h>
+	#define PT_DEBUGBREAK() raise(SIGTRAP)
 #endif
 
 #ifdef PT_ENABLE_ASSERTS
-	#define PT_ASSERT(x, ...) { if(!(x)) { PT_ERROR("Assertion failed: {0}", __VA_ARGS__); __debugbreak(); } }
-	#define PT_CORE_ASSERT(x, ...) { if(!(x)) { PT_CORE_ERROR("Assertion failed: {0}", __VA_ARGS__); __debugbreak(); } }
+	#define PT_ASSERT(x, ...) { if(!(x)) { PT_ERROR("Assertion failed: {0}", __VA_ARGS__); PT_DEBUGBREAK(); } }
+	#define PT_CORE_ASSERT(x, ...) { if(!(x)) { PT_CORE_ERROR("Assertion failed: {0}", __VA_ARGS__); PT_DEBUGBREAK(); } }
 #else
 	#define PT_ASSERT(x, ...)
 	#define PT_CORE_ASSERT(x, ...)
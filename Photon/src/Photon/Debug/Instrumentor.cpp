@@ -0,0 +1,214 @@
+#include "ptpch.h"
+#include "Instrumentor.h"
+
+#include <fstream>
+
+namespace Photon
+{
+	std::atomic<uint32_t> Instrumentor::s_SessionID = 0;
+
+	struct ProfileResult
+	{
+		const char* Name;
+		Instrumentor::Clock::time_point Start;
+		Instrumentor::Clock::time_point End;
+	};
+
+	// Records of one thread, in fixed size chunks that are kept for reuse.
+	// Only the owning thread writes; EndSession reads a chunk up to its
+	// published Count, and only chunks stamped with the ending session
+	struct Instrumentor::ThreadBuffer
+	{
+		static constexpr size_t ChunkSize = 4096;
+
+		struct Chunk
+		{
+			ProfileResult Results[ChunkSize];
+			std::atomic<size_t> Count = 0;
+			std::atomic<uint32_t> SessionID = 0;
+			std::atomic<Chunk*> Next = nullptr;
+		};
+
+		Chunk* Head = new Chunk();
+		Chunk* Tail = Head;
+		uint32_t SessionID = 0;
+		uint32_t ThreadID = 0;
+
+		~ThreadBuffer()
+		{
+			Chunk* chunk = Head;
+			while (chunk)
+			{
+				Chunk* next = chunk->Next.load(std::memory_order_relaxed);
+				delete chunk;
+				chunk = next;
+			}
+		}
+
+		void Write(uint32_t sessionID, const ProfileResult& result)
+		{
+			if (SessionID != sessionID)
+			{
+				// First record of a new session, rewind to the first chunk
+				SessionID = sessionID;
+				Tail = Head;
+				Tail->Count.store(0, std::memory_order_relaxed);
+				Tail->SessionID.store(sessionID, std::memory_order_release);
+			}
+
+			size_t count = Tail->Count.load(std::memory_order_relaxed);
+			if (count == ChunkSize)
+			{
+				Chunk* next = Tail->Next.load(std::memory_order_relaxed);
+				if (!next)
+				{
+					next = new Chunk();
+					Tail->Next.store(next, std::memory_order_release);
+				}
+
+				next->Count.store(0, std::memory_order_relaxed);
+				next->SessionID.store(sessionID, std::memory_order_release);
+				Tail = next;
+				count = 0;
+			}
+
+			Tail->Results[count] = result;
+			Tail->Count.store(count + 1, std::memory_order_release);
+		}
+	};
+
+	Instrumentor& Instrumentor::Get()
+	{
+		static Instrumentor instance;
+		return instance;
+	}
+
+	Instrumentor::~Instrumentor()
+	{
+		EndSession();
+
+		// Thread buffers are owned by the instrumentor so records of threads
+		// that already exited can still be written out
+		for (ThreadBuffer* buffer : m_Threads)
+			delete buffer;
+	}
+
+	Instrumentor::ThreadBuffer& Instrumentor::GetThreadBuffer()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (!buffer)
+		{
+			buffer = new ThreadBuffer();
+
+			std::lock_guard lock(m_ThreadsMutex);
+			buffer->ThreadID = (uint32_t)m_Threads.size();
+			m_Threads.push_back(buffer);
+		}
+
+		return *buffer;
+	}
+
+	void Instrumentor::BeginSession(const std::string& name, const std::string& filepath)
+	{
+		std::lock_guard lock(m_SessionMutex);
+
+		if (s_SessionID.load(std::memory_order_relaxed))
+		{
+			PT_CORE_ERROR("Instrumentor::BeginSession('{0}') when session '{1}' already open.", name, m_SessionName);
+			return;
+		}
+
+		m_SessionName = name;
+		m_SessionFilepath = filepath;
+		m_SessionStart = Clock::now();
+		s_SessionID.store(m_NextSessionID++, std::memory_order_release);
+	}
+
+	static void WriteEscaped(std::ofstream& out, const char* str)
+	{
+		for (; *str; str++)
+		{
+			if (*str == '"' || *str == '\\')
+				out << '\\';
+			out << *str;
+		}
+	}
+
+	void Instrumentor::EndSession()
+	{
+		std::lock_guard lock(m_SessionMutex);
+
+		uint32_t sessionID = s_SessionID.exchange(0, std::memory_order_acq_rel);
+		if (!sessionID)
+			return;
+
+		std::ofstream out(m_SessionFilepath);
+		if (!out.is_open())
+		{
+			PT_CORE_ERROR("Instrumentor could not open results file '{0}'.", m_SessionFilepath);
+			return;
+		}
+
+		out << "{\"otherData\": {\"session\": \"";
+		WriteEscaped(out, m_SessionName.c_str());
+		out << "\"},\"traceEvents\":[";
+
+		size_t written = 0;
+		out.precision(3);
+		out << std::fixed;
+
+		std::lock_guard threadsLock(m_ThreadsMutex);
+		for (ThreadBuffer* buffer : m_Threads)
+		{
+			using Chunk = ThreadBuffer::Chunk;
+			for (Chunk* chunk = buffer->Head; chunk; chunk = chunk->Next.load(std::memory_order_acquire))
+			{
+				if (chunk->SessionID.load(std::memory_order_acquire) != sessionID)
+					break;
+
+				size_t count = chunk->Count.load(std::memory_order_acquire);
+				for (size_t i = 0; i < count; i++)
+				{
+					const ProfileResult& result = chunk->Results[i];
+					double start = std::chrono::duration<double, std::micro>(result.Start - m_SessionStart).count();
+					double duration = std::chrono::duration<double, std::micro>(result.End - result.Start).count();
+
+					if (written++)
+						out << ",";
+
+					out << "{\"cat\":\"function\",\"dur\":" << duration << ",\"name\":\"";
+					WriteEscaped(out, result.Name);
+					out << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->ThreadID << ",\"ts\":" << start << "}";
+				}
+
+				if (count < ThreadBuffer::ChunkSize)
+					break;
+			}
+		}
+
+		out << "]}";
+		out.flush();
+	}
+
+	void Instrumentor::WriteProfile(const char* name, Clock::time_point start, Clock::time_point end)
+	{
+		uint32_t sessionID = s_SessionID.load(std::memory_order_acquire);
+		if (!sessionID)
+			return;
+
+		GetThreadBuffer().Write(sessionID, { name, start, end });
+	}
+
+	const char* Instrumentor::InternName(const std::string& name)
+	{
+		std::lock_guard lock(m_NamesMutex);
+		for (auto& interned : m_Names)
+		{
+			if (*interned == name)
+				return interned->c_str();
+		}
+
+		m_Names.push_back(std::make_unique<std::string>(name));
+		return m_Names.back()->c_str();
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "Photon/Core.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Photon
+{
+	// Scoped CPU profiler writing Chrome/Perfetto trace JSON.
+	//
+	// Every thread appends its scopes to its own chunked buffer without any
+	// locking. Only BeginSession/EndSession take a lock; EndSession collects
+	// all thread buffers and writes the trace file. Scope names must outlive
+	// the session: use string literals, or InternName for runtime strings.
+	class PHOTON_API Instrumentor
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		void BeginSession(const std::string& name, const std::string& filepath = "results.json");
+		void EndSession();
+
+		inline static bool IsActive() { return s_SessionID.load(std::memory_order_relaxed) != 0; }
+
+		void WriteProfile(const char* name, Clock::time_point start, Clock::time_point end);
+
+		// Returns a copy of name that lives until the program exits
+		const char* InternName(const std::string& name);
+
+		static Instrumentor& Get();
+	private:
+		Instrumentor() = default;
+		~Instrumentor();
+
+		struct ThreadBuffer;
+		ThreadBuffer& GetThreadBuffer();
+	private:
+		static std::atomic<uint32_t> s_SessionID;
+
+		std::mutex m_SessionMutex;
+		std::string m_SessionName;
+		std::string m_SessionFilepath;
+		Clock::time_point m_SessionStart;
+		uint32_t m_NextSessionID = 1;
+
+		std::mutex m_ThreadsMutex;
+		std::vector<ThreadBuffer*> m_Threads;
+
+		std::mutex m_NamesMutex;
+		std::vector<std::unique_ptr<std::string>> m_Names;
+	};
+
+	class InstrumentationTimer
+	{
+	public:
+		InstrumentationTimer(const char* name)
+			: m_Name(name)
+		{
+			if (Instrumentor::IsActive())
+				m_Start = Instrumentor::Clock::now();
+			else
+				m_Name = nullptr;
+		}
+
+		~InstrumentationTimer()
+		{
+			if (m_Name)
+				Instrumentor::Get().WriteProfile(m_Name, m_Start, Instrumentor::Clock::now());
+		}
+
+		InstrumentationTimer(const InstrumentationTimer&) = delete;
+		InstrumentationTimer& operator=(const InstrumentationTimer&) = delete;
+	private:
+		const char* m_Name;
+		Instrumentor::Clock::time_point m_Start;
+	};
+}
+
+#ifndef PT_PROFILE
+	#ifdef PT_DIST
+		#define PT_PROFILE 0
+	#else
+		#define PT_PROFILE 1
+	#endif
+#endif
+
+#if PT_PROFILE
+	#if defined(_MSC_VER)
+		#define PT_FUNC_SIG __FUNCSIG__
+	#elif defined(__GNUC__) || defined(__clang__)
+		#define PT_FUNC_SIG __PRETTY_FUNCTION__
+	#else
+		#define PT_FUNC_SIG __func__
+	#endif
+
+	#define PT_PROFILE_BEGIN_SESSION(name, filepath) ::Photon::Instrumentor::Get().BeginSession(name, filepath)
+	#define PT_PROFILE_END_SESSION() ::Photon::Instrumentor::Get().EndSession()
+	#define PT_PROFILE_SCOPE_LINE2(name, line) ::Photon::InstrumentationTimer timer##line(name)
+	#define PT_PROFILE_SCOPE_LINE(name, line) PT_PROFILE_SCOPE_LINE2(name, line)
+	#define PT_PROFILE_SCOPE(name) PT_PROFILE_SCOPE_LINE(name, __LINE__)
+	#define PT_PROFILE_FUNCTION() PT_PROFILE_SCOPE(PT_FUNC_SIG)
+#else
+	#define PT_PROFILE_BEGIN_SESSION(name, filepath) (void)0
+	#define PT_PROFILE_END_SESSION() (void)0
+	#define PT_PROFILE_SCOPE(name)
+	#define PT_PROFILE_FUNCTION()
+#endif
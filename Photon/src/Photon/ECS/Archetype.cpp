@@ -0,0 +1,114 @@
+#include "ptpch.h"
+#include "Archetype.h"
+
+namespace Photon
+{
+	static constexpr size_t ArrayAlignment = Archetype::ChunkAlignment;
+
+	static size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	Archetype::Archetype(const ComponentMask& mask, PoolAllocator& chunkPool)
+		: m_Mask(mask), m_ChunkPool(chunkPool)
+	{
+		PT_CORE_ASSERT(chunkPool.GetBlockSize() == ChunkSize, "Chunk pool has the wrong block size");
+
+		m_Slots.fill(NoSlot);
+
+		size_t bytesPerEntity = sizeof(Entity);
+		for (ComponentID id = 0; id < MaxComponents; id++)
+		{
+			if (!mask.test(id))
+				continue;
+
+			m_Slots[id] = (uint8_t)m_Components.size();
+			m_Components.push_back(id);
+			m_Sizes.push_back(ComponentRegistry::Get(id).Size);
+			bytesPerEntity += m_Sizes.back();
+		}
+
+		// Every array starts on a cache line, leave room for the padding
+		size_t padding = ArrayAlignment * (m_Components.size() + 1);
+		PT_CORE_ASSERT(padding + bytesPerEntity <= ChunkSize, "Archetype does not fit in a chunk");
+		m_Capacity = (uint32_t)((ChunkSize - padding) / bytesPerEntity);
+
+		size_t offset = AlignUp(sizeof(Entity) * m_Capacity, ArrayAlignment);
+		for (size_t size : m_Sizes)
+		{
+			m_Offsets.push_back(offset);
+			offset = AlignUp(offset + size * m_Capacity, ArrayAlignment);
+		}
+	}
+
+	Archetype::~Archetype()
+	{
+		for (Chunk& chunk : m_Chunks)
+		{
+			for (uint32_t row = 0; row < chunk.Count; row++)
+				DestroyComponents((uint32_t)(&chunk - m_Chunks.data()), row);
+			m_ChunkPool.Free(chunk.Data);
+		}
+	}
+
+	void Archetype::Allocate(Entity entity, uint32_t& chunk, uint32_t& row)
+	{
+		if (m_Chunks.empty() || m_Chunks.back().Count == m_Capacity)
+		{
+			m_Chunks.push_back({ (uint8_t*)m_ChunkPool.Allocate(), 0 });
+		}
+
+		Chunk& last = m_Chunks.back();
+		chunk = (uint32_t)m_Chunks.size() - 1;
+		row = last.Count++;
+		GetEntities(last)[row] = entity;
+		m_EntityCount++;
+	}
+
+	Entity Archetype::Remove(uint32_t chunk, uint32_t row)
+	{
+		Chunk& last = m_Chunks.back();
+		uint32_t lastChunk = (uint32_t)m_Chunks.size() - 1;
+		uint32_t lastRow = last.Count - 1;
+
+		Entity moved = NullEntity;
+		if (chunk != lastChunk || row != lastRow)
+		{
+			Chunk& target = m_Chunks[chunk];
+			moved = GetEntities(last)[lastRow];
+			GetEntities(target)[row] = moved;
+
+			for (size_t i = 0; i < m_Components.size(); i++)
+			{
+				const ComponentInfo& info = ComponentRegistry::Get(m_Components[i]);
+				uint8_t* dst = target.Data + m_Offsets[i] + row * m_Sizes[i];
+				uint8_t* src = last.Data + m_Offsets[i] + lastRow * m_Sizes[i];
+				if (info.Trivial)
+					memcpy(dst, src, m_Sizes[i]);
+				else
+					info.Relocate(dst, src);
+			}
+		}
+
+		m_EntityCount--;
+		if (--last.Count == 0)
+		{
+			m_ChunkPool.Free(last.Data);
+			m_Chunks.pop_back();
+		}
+
+		return moved;
+	}
+
+	void Archetype::DestroyComponents(uint32_t chunk, uint32_t row)
+	{
+		Chunk& target = m_Chunks[chunk];
+		for (size_t i = 0; i < m_Components.size(); i++)
+		{
+			const ComponentInfo& info = ComponentRegistry::Get(m_Components[i]);
+			if (!info.Trivial)
+				info.Destroy(target.Data + m_Offsets[i] + row * m_Sizes[i]);
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Entity.h"
+#include "Component.h"
+#include "Photon/Memory/PoolAllocator.h"
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+namespace Photon
+{
+	// All entities with exactly the same set of components. Entities are
+	// packed into fixed size chunks, and inside a chunk every component type
+	// has its own contiguous array (structure of arrays):
+	//
+	//   [Entity x Capacity][A x Capacity][B x Capacity]...
+	//
+	// Chunks are kept dense: removing an entity moves the very last entity
+	// of the archetype into the hole, so only the last chunk is ever partial.
+	class PHOTON_API Archetype
+	{
+	public:
+		static constexpr size_t ChunkSize = 16 * 1024;
+		static constexpr size_t ChunkAlignment = 64;
+
+		struct Chunk
+		{
+			uint8_t* Data = nullptr;
+			uint32_t Count = 0;
+		};
+
+		// Chunks are taken from chunkPool, whose blocks must be ChunkSize bytes
+		Archetype(const ComponentMask& mask, PoolAllocator& chunkPool);
+		~Archetype();
+
+		Archetype(const Archetype&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+
+		inline const ComponentMask& GetMask() const { return m_Mask; }
+		inline const std::vector<ComponentID>& GetComponents() const { return m_Components; }
+		inline bool Has(ComponentID id) const { return m_Mask.test(id); }
+
+		inline uint32_t GetChunkCapacity() const { return m_Capacity; }
+		inline size_t GetChunkCount() const { return m_Chunks.size(); }
+		inline Chunk& GetChunk(size_t index) { return m_Chunks[index]; }
+		inline uint32_t GetEntityCount() const { return m_EntityCount; }
+
+		inline Entity* GetEntities(const Chunk& chunk) const { return (Entity*)chunk.Data; }
+
+		// Start of the array of component id in chunk. The archetype must
+		// have the component
+		inline void* GetComponentArray(const Chunk& chunk, ComponentID id) const
+		{
+			return chunk.Data + m_Offsets[m_Slots[id]];
+		}
+
+		inline void* GetComponent(uint32_t chunk, uint32_t row, ComponentID id) const
+		{
+			return m_Chunks[chunk].Data + m_Offsets[m_Slots[id]] + row * m_Sizes[m_Slots[id]];
+		}
+
+		// Appends entity, leaving its components uninitialised
+		void Allocate(Entity entity, uint32_t& chunk, uint32_t& row);
+		// Relocates the last entity into (chunk, row), whose components must
+		// already be moved out or destroyed. Returns the relocated entity, or
+		// NullEntity if the removed entity was the last one
+		Entity Remove(uint32_t chunk, uint32_t row);
+		// Destroys the components of the entity at (chunk, row)
+		void DestroyComponents(uint32_t chunk, uint32_t row);
+
+		// Cached archetype graph edges
+		std::unordered_map<ComponentID, Archetype*> AddEdges;
+		std::unordered_map<ComponentID, Archetype*> RemoveEdges;
+	private:
+		static constexpr uint8_t NoSlot = 0xFF;
+
+		ComponentMask m_Mask;
+		std::vector<ComponentID> m_Components;
+		std::vector<size_t> m_Offsets;
+		std::vector<size_t> m_Sizes;
+		std::array<uint8_t, MaxComponents> m_Slots;
+
+		uint32_t m_Capacity = 0;
+		uint32_t m_EntityCount = 0;
+		std::vector<Chunk> m_Chunks;
+		PoolAllocator& m_ChunkPool;
+	};
+}
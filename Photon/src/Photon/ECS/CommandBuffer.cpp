@@ -0,0 +1,114 @@
+#include "ptpch.h"
+#include "CommandBuffer.h"
+
+namespace Photon
+{
+	static constexpr size_t BlockAlignment = 64;
+
+	CommandBuffer::CommandBuffer(size_t blockSize)
+		: m_BlockSize(blockSize)
+	{
+	}
+
+	CommandBuffer::~CommandBuffer()
+	{
+		Clear();
+
+		for (uint8_t* block : m_Blocks)
+			Memory::Free(block, m_BlockSize, BlockAlignment, MemoryTag::ECS);
+	}
+
+	Entity CommandBuffer::Create()
+	{
+		Entity pending = { m_PendingCount++, 0 };
+		m_Commands.push_back({ CommandType::Create, 0, pending, nullptr });
+		return pending;
+	}
+
+	void CommandBuffer::Destroy(Entity entity)
+	{
+		m_Commands.push_back({ CommandType::Destroy, 0, entity, nullptr });
+	}
+
+	void* CommandBuffer::Allocate(size_t size, size_t alignment)
+	{
+		PT_CORE_ASSERT(size <= m_BlockSize, "Component does not fit in a command buffer block");
+
+		size_t offset = (m_BlockOffset + alignment - 1) & ~(alignment - 1);
+		if (m_Blocks.empty() || offset + size > m_BlockSize)
+		{
+			if (!m_Blocks.empty())
+				m_BlockIndex++;
+			if (m_BlockIndex == m_Blocks.size())
+				m_Blocks.push_back((uint8_t*)Memory::Allocate(m_BlockSize, BlockAlignment, MemoryTag::ECS));
+			offset = 0;
+		}
+
+		m_BlockOffset = offset + size;
+		return m_Blocks[m_BlockIndex] + offset;
+	}
+
+	void CommandBuffer::Playback(World& world)
+	{
+		m_Created.resize(m_PendingCount);
+
+		for (Command& command : m_Commands)
+		{
+			Entity target = IsPending(command.Target) ? m_Created[command.Target.Index] : command.Target;
+
+			switch (command.Type)
+			{
+				case CommandType::Create:
+					m_Created[command.Target.Index] = world.Create();
+					break;
+				case CommandType::Destroy:
+					if (world.IsAlive(target))
+						world.Destroy(target);
+					break;
+				case CommandType::Add:
+				{
+					const ComponentInfo& info = ComponentRegistry::Get(command.Component);
+					if (world.IsAlive(target))
+					{
+						void* component = world.AddComponent(target, command.Component);
+						if (info.Trivial)
+							memcpy(component, command.Payload, info.Size);
+						else
+							info.Relocate(component, command.Payload);
+					}
+					else if (!info.Trivial)
+					{
+						info.Destroy(command.Payload);
+					}
+					// The payload is gone either way
+					command.Payload = nullptr;
+					break;
+				}
+				case CommandType::Remove:
+					if (world.IsAlive(target))
+						world.RemoveComponent(target, command.Component);
+					break;
+			}
+		}
+
+		Clear();
+	}
+
+	void CommandBuffer::Clear()
+	{
+		for (const Command& command : m_Commands)
+		{
+			if (command.Type != CommandType::Add || !command.Payload)
+				continue;
+
+			const ComponentInfo& info = ComponentRegistry::Get(command.Component);
+			if (!info.Trivial)
+				info.Destroy(command.Payload);
+		}
+
+		m_Commands.clear();
+		m_PendingCount = 0;
+		m_BlockIndex = 0;
+		m_BlockOffset = 0;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "World.h"
+
+namespace Photon
+{
+	// Records structural changes (create, destroy, add, remove) to apply to a
+	// World later, e.g. after a Query has finished iterating. Commands are
+	// applied in the order they were recorded.
+	//
+	// Create returns a pending entity that is only valid for this buffer
+	// until Playback, where it becomes a real entity. Commands that target an
+	// entity which has died in the meantime are skipped.
+	//
+	// A CommandBuffer is not thread safe, use one per job.
+	class PHOTON_API CommandBuffer
+	{
+	public:
+		CommandBuffer(size_t blockSize = 16 * 1024);
+		~CommandBuffer();
+
+		CommandBuffer(const CommandBuffer&) = delete;
+		CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+		Entity Create();
+		void Destroy(Entity entity);
+
+		template<typename T, typename... Args>
+		void Add(Entity entity, Args&&... args)
+		{
+			void* payload = Allocate(sizeof(T), alignof(T));
+			new (payload) T(std::forward<Args>(args)...);
+			m_Commands.push_back({ CommandType::Add, GetComponentID<T>(), entity, payload });
+		}
+
+		template<typename T>
+		void Remove(Entity entity)
+		{
+			m_Commands.push_back({ CommandType::Remove, GetComponentID<T>(), entity, nullptr });
+		}
+
+		// Applies and clears every recorded command
+		void Playback(World& world);
+		// Drops every recorded command
+		void Clear();
+
+		inline bool Empty() const { return m_Commands.empty(); }
+		inline size_t Size() const { return m_Commands.size(); }
+	private:
+		enum class CommandType : uint8_t
+		{
+			Create, Destroy, Add, Remove
+		};
+
+		struct Command
+		{
+			CommandType Type;
+			ComponentID Component;
+			Entity Target;
+			void* Payload;
+		};
+
+		static inline bool IsPending(Entity entity) { return entity.Generation == 0 && !entity.IsNull(); }
+
+		void* Allocate(size_t size, size_t alignment);
+	private:
+		std::vector<Command> m_Commands;
+		uint32_t m_PendingCount = 0;
+		std::vector<Entity> m_Created;
+
+		// Component payloads live in a block arena that is rewound on Clear
+		std::vector<uint8_t*> m_Blocks;
+		size_t m_BlockSize;
+		size_t m_BlockIndex = 0;
+		size_t m_BlockOffset = 0;
+	};
+}
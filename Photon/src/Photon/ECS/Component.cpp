@@ -0,0 +1,39 @@
+#include "ptpch.h"
+#include "Component.h"
+
+#include <mutex>
+
+namespace Photon
+{
+	static std::mutex s_RegistryMutex;
+	static std::array<ComponentInfo, MaxComponents> s_Components;
+	static std::unordered_map<std::string, ComponentID> s_ComponentIDs;
+
+	ComponentID ComponentRegistry::Register(const ComponentInfo& info)
+	{
+		std::lock_guard lock(s_RegistryMutex);
+
+		auto it = s_ComponentIDs.find(info.Name);
+		if (it != s_ComponentIDs.end())
+			return it->second;
+
+		ComponentID id = (ComponentID)s_ComponentIDs.size();
+		PT_CORE_ASSERT(id < MaxComponents, "Too many component types, raise MaxComponents");
+
+		s_Components[id] = info;
+		s_ComponentIDs.emplace(info.Name, id);
+		return id;
+	}
+
+	const ComponentInfo& ComponentRegistry::Get(ComponentID id)
+	{
+		// Entries never move once registered, so no lock is needed here
+		return s_Components[id];
+	}
+
+	uint32_t ComponentRegistry::GetCount()
+	{
+		std::lock_guard lock(s_RegistryMutex);
+		return (uint32_t)s_ComponentIDs.size();
+	}
+}
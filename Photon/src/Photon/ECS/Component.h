@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Photon/Core.h"
+
+#include <bitset>
+#include <cstdint>
+#include <new>
+#include <typeinfo>
+#include <type_traits>
+
+namespace Photon
+{
+	using ComponentID = uint32_t;
+
+	constexpr uint32_t MaxComponents = 128;
+	using ComponentMask = std::bitset<MaxComponents>;
+
+	// Type erased description of a component, enough for archetype chunks to
+	// lay out, move and destroy components they know nothing else about
+	struct ComponentInfo
+	{
+		const char* Name = nullptr;
+		size_t Size = 0;
+		size_t Alignment = 0;
+		// Trivially copyable components are relocated with memcpy and never
+		// destroyed, which keeps the hot paths free of indirect calls
+		bool Trivial = false;
+
+		// Move constructs dst from src, then destroys src
+		void (*Relocate)(void* dst, void* src) = nullptr;
+		void (*Destroy)(void* ptr) = nullptr;
+	};
+
+	// Hands out component IDs. IDs are keyed by type name so the engine and
+	// the client module agree on them even though each has its own copy of
+	// GetComponentID<T>
+	class PHOTON_API ComponentRegistry
+	{
+	public:
+		static ComponentID Register(const ComponentInfo& info);
+		static const ComponentInfo& Get(ComponentID id);
+		static uint32_t GetCount();
+	};
+
+	template<typename T>
+	ComponentID GetComponentID()
+	{
+		using Type = std::remove_cv_t<T>;
+		static_assert(std::is_move_constructible_v<Type>, "Components have to be movable");
+		static_assert(alignof(Type) <= 64, "Components can be at most cache line aligned");
+
+		static const ComponentID id = ComponentRegistry::Register({
+			typeid(Type).name(), sizeof(Type), alignof(Type), std::is_trivially_copyable_v<Type>,
+			[](void* dst, void* src) { new (dst) Type(std::move(*(Type*)src)); ((Type*)src)->~Type(); },
+			[](void* ptr) { ((Type*)ptr)->~Type(); }
+		});
+		return id;
+	}
+
+	template<typename... Ts>
+	ComponentMask MakeComponentMask()
+	{
+		ComponentMask mask;
+		(mask.set(GetComponentID<Ts>()), ...);
+		return mask;
+	}
+}
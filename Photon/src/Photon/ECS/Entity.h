@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace Photon
+{
+	// Handle to an entity in a World. The index addresses the entity record,
+	// the generation is bumped every time that index is recycled so stale
+	// handles to destroyed entities can be told apart from live ones.
+	struct Entity
+	{
+		uint32_t Index = UINT32_MAX;
+		uint32_t Generation = 0;
+
+		inline bool operator==(const Entity& other) const { return Index == other.Index && Generation == other.Generation; }
+		inline bool operator!=(const Entity& other) const { return !(*this == other); }
+
+		inline bool IsNull() const { return Index == UINT32_MAX; }
+	};
+
+	constexpr Entity NullEntity = {};
+}
+
+template<>
+struct std::hash<Photon::Entity>
+{
+	size_t operator()(const Photon::Entity& entity) const
+	{
+		return std::hash<uint64_t>()(((uint64_t)entity.Generation << 32) | entity.Index);
+	}
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "World.h"
+#include "Photon/Jobs/JobSystem.h"
+
+#include <utility>
+
+namespace Photon
+{
+	// Iterates every entity that has all of Ts (and none of the Without
+	// components), archetype by archetype and chunk by chunk, so each
+	// component is read from a contiguous array. Matching archetypes are
+	// cached and only new archetypes are checked on later runs, keep the
+	// Query around instead of building it every frame.
+	//
+	//   Query<Position, const Velocity> query(world);
+	//   query.Each([&](Entity e, Position& p, const Velocity& v) { p.Value += v.Value * ts; });
+	template<typename... Ts>
+	class Query
+	{
+	public:
+		Query(World& world)
+			: m_World(world), m_Include(MakeComponentMask<Ts...>()), m_IDs{ GetComponentID<Ts>()... }
+		{}
+
+		template<typename... Ex>
+		Query& Without()
+		{
+			m_Exclude |= MakeComponentMask<Ex...>();
+			m_Archetypes.clear();
+			m_ArchetypeCursor = 0;
+			return *this;
+		}
+
+		// func(uint32_t count, Entity* entities, Ts*... components)
+		template<typename F>
+		void EachChunk(F&& func)
+		{
+			Refresh();
+
+			m_World.m_IterationDepth++;
+			for (Archetype* archetype : m_Archetypes)
+			{
+				for (size_t i = 0; i < archetype->GetChunkCount(); i++)
+					Invoke(func, *archetype, archetype->GetChunk(i), std::index_sequence_for<Ts...>());
+			}
+			m_World.m_IterationDepth--;
+		}
+
+		// func(Entity entity, Ts&... components)
+		template<typename F>
+		void Each(F&& func)
+		{
+			EachChunk([&func](uint32_t count, Entity* entities, Ts*... components)
+			{
+				for (uint32_t i = 0; i < count; i++)
+					func(entities[i], components[i]...);
+			});
+		}
+
+		// Like Each, but chunks are handed out to the job system. func is
+		// called concurrently, so it must only touch the components it is given
+		template<typename F>
+		void ParallelEach(const F& func)
+		{
+			Refresh();
+
+			m_Chunks.clear();
+			for (Archetype* archetype : m_Archetypes)
+			{
+				for (size_t i = 0; i < archetype->GetChunkCount(); i++)
+					m_Chunks.push_back({ archetype, &archetype->GetChunk(i) });
+			}
+
+			m_World.m_IterationDepth++;
+			JobSystem::ParallelFor((uint32_t)m_Chunks.size(), 1, [this, &func](uint32_t index)
+			{
+				const ChunkRef& ref = m_Chunks[index];
+				Invoke([&func](uint32_t count, Entity* entities, Ts*... components)
+				{
+					for (uint32_t i = 0; i < count; i++)
+						func(entities[i], components[i]...);
+				}, *ref.Owner, *ref.Target, std::index_sequence_for<Ts...>());
+			});
+			m_World.m_IterationDepth--;
+		}
+
+		uint32_t Count()
+		{
+			Refresh();
+
+			uint32_t count = 0;
+			for (Archetype* archetype : m_Archetypes)
+				count += archetype->GetEntityCount();
+			return count;
+		}
+	private:
+		void Refresh()
+		{
+			const std::vector<Archetype*>& archetypes = m_World.m_ArchetypeList;
+			for (; m_ArchetypeCursor < archetypes.size(); m_ArchetypeCursor++)
+			{
+				const ComponentMask& mask = archetypes[m_ArchetypeCursor]->GetMask();
+				if ((mask & m_Include) == m_Include && (mask & m_Exclude).none())
+					m_Archetypes.push_back(archetypes[m_ArchetypeCursor]);
+			}
+		}
+
+		template<typename F, size_t... I>
+		void Invoke(F&& func, const Archetype& archetype, const Archetype::Chunk& chunk, std::index_sequence<I...>)
+		{
+			func(chunk.Count, archetype.GetEntities(chunk), (Ts*)archetype.GetComponentArray(chunk, m_IDs[I])...);
+		}
+	private:
+		struct ChunkRef
+		{
+			Archetype* Owner;
+			Archetype::Chunk* Target;
+		};
+
+		World& m_World;
+		ComponentMask m_Include;
+		ComponentMask m_Exclude;
+		ComponentID m_IDs[sizeof...(Ts)];
+
+		std::vector<Archetype*> m_Archetypes;
+		size_t m_ArchetypeCursor = 0;
+		std::vector<ChunkRef> m_Chunks;
+	};
+}
@@ -0,0 +1,176 @@
+#include "ptpch.h"
+#include "World.h"
+
+namespace Photon
+{
+	static constexpr size_t ChunksPerPage = 16;
+
+	World::World()
+		: m_ChunkPool(Archetype::ChunkSize, Archetype::ChunkAlignment, ChunksPerPage, MemoryTag::ECS)
+	{
+		m_EmptyArchetype = GetArchetype(ComponentMask());
+	}
+
+	World::~World()
+	{
+	}
+
+	Entity World::Create()
+	{
+		AssertNotIterating();
+		return AllocateEntity(m_EmptyArchetype);
+	}
+
+	Entity World::AllocateEntity(Archetype* archetype)
+	{
+		AssertNotIterating();
+
+		uint32_t index;
+		if (!m_FreeIndices.empty())
+		{
+			index = m_FreeIndices.back();
+			m_FreeIndices.pop_back();
+		}
+		else
+		{
+			index = (uint32_t)m_Records.size();
+			m_Records.emplace_back();
+		}
+
+		EntityRecord& record = m_Records[index];
+		Entity entity = { index, record.Generation };
+		record.Owner = archetype;
+		archetype->Allocate(entity, record.Chunk, record.Row);
+
+		m_AliveCount++;
+		return entity;
+	}
+
+	void World::Destroy(Entity entity)
+	{
+		AssertNotIterating();
+		PT_CORE_ASSERT(IsAlive(entity), "Entity is not alive");
+
+		EntityRecord& record = m_Records[entity.Index];
+		record.Owner->DestroyComponents(record.Chunk, record.Row);
+		Relocated(record.Owner->Remove(record.Chunk, record.Row), record.Chunk, record.Row);
+
+		record.Owner = nullptr;
+		// Skip 0 on wrap around, it marks pending entities
+		if (++record.Generation == 0)
+			record.Generation = 1;
+		m_FreeIndices.push_back(entity.Index);
+		m_AliveCount--;
+	}
+
+	bool World::IsAlive(Entity entity) const
+	{
+		return entity.Index < m_Records.size()
+			&& m_Records[entity.Index].Generation == entity.Generation
+			&& m_Records[entity.Index].Owner != nullptr;
+	}
+
+	void* World::AddComponent(Entity entity, ComponentID id)
+	{
+		PT_CORE_ASSERT(IsAlive(entity), "Entity is not alive");
+
+		EntityRecord& record = m_Records[entity.Index];
+		Archetype* source = record.Owner;
+		if (source->Has(id))
+		{
+			// Replace in place, no structural change
+			void* component = source->GetComponent(record.Chunk, record.Row, id);
+			const ComponentInfo& info = ComponentRegistry::Get(id);
+			if (!info.Trivial)
+				info.Destroy(component);
+			return component;
+		}
+
+		Archetype*& target = source->AddEdges[id];
+		if (!target)
+		{
+			ComponentMask mask = source->GetMask();
+			target = GetArchetype(mask.set(id));
+		}
+
+		MoveEntity(entity, target);
+		return target->GetComponent(record.Chunk, record.Row, id);
+	}
+
+	void World::RemoveComponent(Entity entity, ComponentID id)
+	{
+		PT_CORE_ASSERT(IsAlive(entity), "Entity is not alive");
+
+		EntityRecord& record = m_Records[entity.Index];
+		Archetype* source = record.Owner;
+		if (!source->Has(id))
+			return;
+
+		Archetype*& target = source->RemoveEdges[id];
+		if (!target)
+		{
+			ComponentMask mask = source->GetMask();
+			target = GetArchetype(mask.reset(id));
+		}
+
+		MoveEntity(entity, target);
+	}
+
+	Archetype* World::GetArchetype(const ComponentMask& mask)
+	{
+		std::unique_ptr<Archetype>& archetype = m_Archetypes[mask];
+		if (!archetype)
+		{
+			archetype = std::make_unique<Archetype>(mask, m_ChunkPool);
+			m_ArchetypeList.push_back(archetype.get());
+		}
+		return archetype.get();
+	}
+
+	void World::MoveEntity(Entity entity, Archetype* target)
+	{
+		AssertNotIterating();
+
+		EntityRecord& record = m_Records[entity.Index];
+		Archetype* source = record.Owner;
+		uint32_t sourceChunk = record.Chunk, sourceRow = record.Row;
+
+		uint32_t targetChunk, targetRow;
+		target->Allocate(entity, targetChunk, targetRow);
+
+		// Components both archetypes share are relocated, the rest destroyed
+		for (ComponentID id : source->GetComponents())
+		{
+			const ComponentInfo& info = ComponentRegistry::Get(id);
+			void* src = source->GetComponent(sourceChunk, sourceRow, id);
+			if (target->Has(id))
+			{
+				void* dst = target->GetComponent(targetChunk, targetRow, id);
+				if (info.Trivial)
+					memcpy(dst, src, info.Size);
+				else
+					info.Relocate(dst, src);
+			}
+			else if (!info.Trivial)
+			{
+				info.Destroy(src);
+			}
+		}
+
+		Relocated(source->Remove(sourceChunk, sourceRow), sourceChunk, sourceRow);
+
+		record.Owner = target;
+		record.Chunk = targetChunk;
+		record.Row = targetRow;
+	}
+
+	void World::Relocated(Entity moved, uint32_t chunk, uint32_t row)
+	{
+		if (moved.IsNull())
+			return;
+
+		EntityRecord& record = m_Records[moved.Index];
+		record.Chunk = chunk;
+		record.Row = row;
+	}
+}
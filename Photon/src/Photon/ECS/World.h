@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Entity.h"
+#include "Component.h"
+#include "Archetype.h"
+#include "Photon/Memory/StlAllocator.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Photon
+{
+	template<typename... Ts>
+	class Query;
+
+	// Owns entities and their components. Components are stored by archetype
+	// (see Archetype), so adding or removing a component moves the entity to
+	// another archetype. Those structural changes are not allowed while a
+	// Query is iterating, record them in a CommandBuffer instead.
+	//
+	// A World is not thread safe. Queries can spread iteration over the job
+	// system with ParallelEach, as long as only component data is touched.
+	class PHOTON_API World
+	{
+	public:
+		World();
+		~World();
+
+		World(const World&) = delete;
+		World& operator=(const World&) = delete;
+
+		Entity Create();
+
+		// Creates an entity straight in its final archetype
+		template<typename... Ts>
+		Entity Create(Ts&&... components)
+		{
+			Archetype* archetype = GetArchetype(MakeComponentMask<std::decay_t<Ts>...>());
+			Entity entity = AllocateEntity(archetype);
+
+			const EntityRecord& record = m_Records[entity.Index];
+			(new (archetype->GetComponent(record.Chunk, record.Row, GetComponentID<std::decay_t<Ts>>()))
+				std::decay_t<Ts>(std::forward<Ts>(components)), ...);
+			return entity;
+		}
+
+		void Destroy(Entity entity);
+		bool IsAlive(Entity entity) const;
+
+		// Adds a component, replacing the existing one if there is one
+		template<typename T, typename... Args>
+		T& Add(Entity entity, Args&&... args)
+		{
+			return *new (AddComponent(entity, GetComponentID<T>())) T(std::forward<Args>(args)...);
+		}
+
+		template<typename T>
+		void Remove(Entity entity)
+		{
+			RemoveComponent(entity, GetComponentID<T>());
+		}
+
+		template<typename T>
+		bool Has(Entity entity) const
+		{
+			PT_CORE_ASSERT(IsAlive(entity), "Entity is not alive");
+			return m_Records[entity.Index].Owner->Has(GetComponentID<T>());
+		}
+
+		template<typename T>
+		T& Get(Entity entity)
+		{
+			T* component = TryGet<T>(entity);
+			PT_CORE_ASSERT(component, "Entity does not have the component");
+			return *component;
+		}
+
+		template<typename T>
+		T* TryGet(Entity entity)
+		{
+			PT_CORE_ASSERT(IsAlive(entity), "Entity is not alive");
+			const EntityRecord& record = m_Records[entity.Index];
+			ComponentID id = GetComponentID<T>();
+			if (!record.Owner->Has(id))
+				return nullptr;
+			return (T*)record.Owner->GetComponent(record.Chunk, record.Row, id);
+		}
+
+		// Type erased versions of Add/Remove. AddComponent returns storage the
+		// caller must construct the component in
+		void* AddComponent(Entity entity, ComponentID id);
+		void RemoveComponent(Entity entity, ComponentID id);
+
+		inline uint32_t GetEntityCount() const { return m_AliveCount; }
+		inline size_t GetArchetypeCount() const { return m_ArchetypeList.size(); }
+	private:
+		struct EntityRecord
+		{
+			Archetype* Owner = nullptr;
+			uint32_t Chunk = 0;
+			uint32_t Row = 0;
+			// Live generations start at 1, 0 is left for pending entities in
+			// command buffers
+			uint32_t Generation = 1;
+		};
+
+		Entity AllocateEntity(Archetype* archetype);
+		Archetype* GetArchetype(const ComponentMask& mask);
+		void MoveEntity(Entity entity, Archetype* target);
+		void Relocated(Entity moved, uint32_t chunk, uint32_t row);
+
+		inline void AssertNotIterating() const
+		{
+			PT_CORE_ASSERT(m_IterationDepth == 0, "Structural change while a query is iterating, use a CommandBuffer");
+		}
+	private:
+		TrackedVector<EntityRecord, MemoryTag::ECS> m_Records;
+		std::vector<uint32_t> m_FreeIndices;
+		uint32_t m_AliveCount = 0;
+
+		// Shared by every archetype, so chunks emptied by one are reused by
+		// the others. Declared first so it outlives the archetypes
+		PoolAllocator m_ChunkPool;
+		std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> m_Archetypes;
+		// In creation order, queries use it to pick up new archetypes
+		std::vector<Archetype*> m_ArchetypeList;
+		Archetype* m_EmptyArchetype = nullptr;
+
+		uint32_t m_IterationDepth = 0;
+
+		template<typename... Ts>
+		friend class Query;
+	};
+}
@@ -1,25 +1,41 @@
 #pragma once
 
-#ifdef PT_PLATFORM_WINDOWS
-
-//#define _CRTDBG_MAP_ALLOC
-//#include <stdlib.h>
-//#include <crtdbg.h>
+#if defined(PT_PLATFORM_WINDOWS) || defined(PT_PLATFORM_LINUX)
 
 extern Photon::Application* Photon::CreateApplication();
 
 int main(int argc, char** argv)
 {
-	//_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
-
-	Photon::Log::Init();
-
+	std::vector<std::string> problems = Photon::Application::ParseCommandLine(argc, argv);
+	Photon::Log::Init(Photon::Application::GetRunOptions().Log);
+	for (const std::string& problem : problems)
+		PT_CORE_WARN("{0}", problem);
+	bool profile = Photon::Application::GetRunOptions().Profile;
+
+	if (profile)
+		PT_PROFILE_BEGIN_SESSION("Startup", "PhotonProfile-Startup.json");
 	auto app = Photon::CreateApplication();
+	if (profile)
+		PT_PROFILE_END_SESSION();
+
+	if (profile)
+		PT_PROFILE_BEGIN_SESSION("Runtime", "PhotonProfile-Runtime.json");
 	app->Run();
+	if (profile)
+		PT_PROFILE_END_SESSION();
+	int exitCode = app->GetExitCode();
+
+	if (profile)
+		PT_PROFILE_BEGIN_SESSION("Shutdown", "PhotonProfile-Shutdown.json");
 	delete app;
+	if (profile)
+		PT_PROFILE_END_SESSION();
+
+	// Anything still live now is a leak
+	Photon::Memory::LogReport();
 
-	/*_CrtSetReportMode(_CRT_WARN, _CRTDBG_MODE_DEBUG);
-	_CrtDumpMemoryLeaks();*/
+	Photon::Log::Shutdown();
+	return exitCode;
 }
 
 #endif
\ No newline at end of file
@@ -6,7 +6,9 @@ namespace Photon
 	class PHOTON_API WindowCloseEvent : public Event
 	{
 	public:
-		WindowCloseEvent() {}
+		WindowCloseEvent()
+			: Event(StaticType, StaticCategoryFlags)
+		{}
 
 		EVENT_CLASS_TYPE(WindowClose)
 		EVENT_CLASS_CATEGORY(EventCategoryApplication)
@@ -16,17 +18,15 @@ namespace Photon
 	{
 	public:
 		WindowResizeEvent(uint32_t width, uint32_t height)
-			: m_Width(width), m_Height(height)
+			: Event(StaticType, StaticCategoryFlags), m_Width(width), m_Height(height)
 		{}
 
 		inline uint32_t GetWidth() const { return m_Width; }
 		inline uint32_t GetHeight() const { return m_Height; }
 
-		std::string ToString() const override
+		fmt::format_context::iterator FormatTo(fmt::format_context::iterator out) const override
 		{
-			std::stringstream ss;
-			ss << "WindowResizeEvent: " << m_Width << ", " << m_Height;
-			return ss.str();
+			return fmt::format_to(out, "WindowResizeEvent: {}, {}", m_Width, m_Height);
 		}
 
 		EVENT_CLASS_TYPE(WindowResize)
@@ -39,16 +39,20 @@ namespace Photon
 	class PHOTON_API WindowFocusEvent : public Event
 	{
 	public:
-		WindowFocusEvent() {}
+		WindowFocusEvent()
+			: Event(StaticType, StaticCategoryFlags)
+		{}
 
 		EVENT_CLASS_TYPE(WindowFocus)
-			EVENT_CLASS_CATEGORY(EventCategoryApplication)
+		EVENT_CLASS_CATEGORY(EventCategoryApplication)
 	};
 
 	class PHOTON_API WindowLostFocusEvent : public Event
 	{
 	public:
-		WindowLostFocusEvent() {}
+		WindowLostFocusEvent()
+			: Event(StaticType, StaticCategoryFlags)
+		{}
 
 		EVENT_CLASS_TYPE(WindowLostFocus)
 		EVENT_CLASS_CATEGORY(EventCategoryApplication)
@@ -58,17 +62,15 @@ namespace Photon
 	{
 	public:
 		WindowMovedEvent(uint32_t x, uint32_t y)
-			: m_X(x), m_Y(y)
+			: Event(StaticType, StaticCategoryFlags), m_X(x), m_Y(y)
 		{}
 
 		inline uint32_t GetX() const { return m_X; }
 		inline uint32_t GetY() const { return m_Y; }
 
-		std::string ToString() const override
+		fmt::format_context::iterator FormatTo(fmt::format_context::iterator out) const override
 		{
-			std::stringstream ss;
-			ss << "WindowMovedEvent: " << m_X << ", " << m_Y;
-			return ss.str();
+			return fmt::format_to(out, "WindowMovedEvent: {}, {}", m_X, m_Y);
 		}
 
 		EVENT_CLASS_TYPE(WindowMoved)
@@ -81,7 +83,9 @@ namespace Photon
 	class PHOTON_API AppTickEvent : public Event
 	{
 	public:
-		AppTickEvent() {}
+		AppTickEvent()
+			: Event(StaticType, StaticCategoryFlags)
+		{}
 
 		EVENT_CLASS_TYPE(AppTick)
 		EVENT_CLASS_CATEGORY(EventCategoryApplication)
@@ -90,7 +94,9 @@ namespace Photon
 	class PHOTON_API AppUpdateEvent : public Event
 	{
 	public:
-		AppUpdateEvent() {}
+		AppUpdateEvent()
+			: Event(StaticType, StaticCategoryFlags)
+		{}
 
 		EVENT_CLASS_TYPE(AppUpdate)
 		EVENT_CLASS_CATEGORY(EventCategoryApplication)
@@ -99,7 +105,9 @@ namespace Photon
 	class PHOTON_API AppRenderEvent : public Event
 	{
 	public:
-		AppRenderEvent() {}
+		AppRenderEvent()
+			: Event(StaticType, StaticCategoryFlags)
+		{}
 
 		EVENT_CLASS_TYPE(AppRender)
 		EVENT_CLASS_CATEGORY(EventCategoryApplication)
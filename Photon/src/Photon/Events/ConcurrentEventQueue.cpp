@@ -0,0 +1,74 @@
+#include "ptpch.h"
+#include "ConcurrentEventQueue.h"
+
+#include "Photon/Memory/Memory.h"
+
+namespace Photon
+{
+	static size_t RoundUpToPowerOfTwo(size_t value)
+	{
+		size_t result = 2;
+		while (result < value)
+			result <<= 1;
+		return result;
+	}
+
+	ConcurrentEventQueue::ConcurrentEventQueue(size_t capacity)
+	{
+		capacity = RoundUpToPowerOfTwo(capacity);
+		m_Mask = capacity - 1;
+
+		m_Slots = (Slot*)Memory::Allocate(capacity * sizeof(Slot), alignof(Slot), MemoryTag::Events);
+		for (size_t i = 0; i < capacity; i++)
+			new (&m_Slots[i]) Slot{ i, {} };
+	}
+
+	ConcurrentEventQueue::~ConcurrentEventQueue()
+	{
+		// Events are trivially destructible, the slots can simply be released
+		Memory::Free(m_Slots, (m_Mask + 1) * sizeof(Slot), alignof(Slot), MemoryTag::Events);
+	}
+
+	bool ConcurrentEventQueue::Post(const Event& event)
+	{
+		if (event.GetEventType() == EventType::None || (size_t)event.GetEventType() >= EventTypeCount)
+		{
+			PT_CORE_ASSERT(false, "Unknown event type cannot be posted");
+			return false;
+		}
+
+		size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = m_Slots[pos & m_Mask];
+			size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+			if (diff == 0)
+			{
+				if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					VisitEvent(event, [&slot](const auto& e)
+					{
+						using T = std::remove_cvref_t<decltype(e)>;
+						static_assert(std::is_trivially_destructible_v<T>, "Posted events are never destroyed");
+						new (slot.Storage) T(e);
+					});
+
+					slot.Sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// Full
+				m_Dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				pos = m_EnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+}
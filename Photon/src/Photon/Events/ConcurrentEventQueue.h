@@ -0,0 +1,77 @@
+#pragma once
+#include "EventStorage.h"
+
+#include <atomic>
+
+namespace Photon
+{
+	// Multi-producer/single-consumer event queue for raising events from
+	// worker threads. Post copies the event into a preallocated slot of a
+	// bounded lock-free ring (Vyukov style), so posting never takes a mutex
+	// or allocates. The owning thread drains the ring and dispatches the
+	// events in the order their slots were claimed.
+	class PHOTON_API ConcurrentEventQueue
+	{
+	public:
+		ConcurrentEventQueue(size_t capacity = 4096);
+		~ConcurrentEventQueue();
+
+		ConcurrentEventQueue(const ConcurrentEventQueue&) = delete;
+		ConcurrentEventQueue& operator=(const ConcurrentEventQueue&) = delete;
+
+		// Safe to call from any thread. Returns false and counts the event as
+		// dropped when the ring is full
+		bool Post(const Event& event);
+
+		// Consumer thread only. Calls func for the events that were posted
+		// before the drain started, events posted from inside func wait for
+		// the next drain. Returns the number of events delivered
+		template<typename F>
+		size_t Drain(F&& func)
+		{
+			size_t end = m_EnqueuePos.load(std::memory_order_acquire);
+			size_t count = 0;
+
+			while (m_DequeuePos != end)
+			{
+				Slot& slot = m_Slots[m_DequeuePos & m_Mask];
+
+				// A producer has claimed the slot but not finished copying into
+				// it yet, what remains is delivered by the next drain
+				if (slot.Sequence.load(std::memory_order_acquire) != m_DequeuePos + 1)
+					break;
+
+				func(*(Event*)slot.Storage);
+
+				slot.Sequence.store(m_DequeuePos + m_Mask + 1, std::memory_order_release);
+				m_DequeuePos++;
+				count++;
+			}
+
+			return count;
+		}
+
+		// Consumer thread only
+		inline bool Empty() const { return m_EnqueuePos.load(std::memory_order_acquire) == m_DequeuePos; }
+		inline size_t GetCapacity() const { return m_Mask + 1; }
+		inline uint64_t GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+	private:
+		// One cache line per slot so producers writing neighbouring slots
+		// don't contend with each other
+		struct alignas(64) Slot
+		{
+			std::atomic<size_t> Sequence;
+			alignas(MaxEventAlignment) uint8_t Storage[MaxEventSize];
+		};
+
+		static_assert(sizeof(Slot) == 64, "Event no longer fits in a cache line slot");
+
+		Slot* m_Slots;
+		size_t m_Mask;
+
+		alignas(64) std::atomic<size_t> m_EnqueuePos = 0;
+		// Only touched by the consumer
+		alignas(64) size_t m_DequeuePos = 0;
+		std::atomic<uint64_t> m_Dropped = 0;
+	};
+}
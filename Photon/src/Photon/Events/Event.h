@@ -1,11 +1,16 @@
 #pragma once
 #include "Photon/Core.h"
+#include "spdlog/fmt/fmt.h"
 #include "spdlog/fmt/ostr.h"
 
+#include <array>
+#include <tuple>
+
 namespace Photon
 {
-	// Events in Photon are blocking, i.e. they are handled as soon
-	// as they are received.
+	// Events in Photon are blocking by default, i.e. they are handled as soon
+	// as they are received. Application can instead queue them in an
+	// EventQueue and dispatch them once per frame.
 
 	enum class EventType
 	{
@@ -26,52 +31,142 @@ namespace Photon
 		EventCategoryMouseButton     = BIT(4)
 	};
 
-#define EVENT_CLASS_TYPE(type)  static EventType GetStaticType() { return EventType::##type;} \
-								virtual EventType GetEventType() const override { return GetStaticType(); } \
+	constexpr size_t EventTypeCount = (size_t)EventType::MouseScrolled + 1;
+
+	// Type and category are compile-time constants of each event class and are
+	// also stored in the Event itself so the hot path never needs a virtual call
+#define EVENT_CLASS_TYPE(type)  static constexpr EventType StaticType = EventType::type; \
+								static constexpr EventType GetStaticType() { return StaticType; } \
 								virtual const char* GetName() const override { return #type; }
 
-#define EVENT_CLASS_CATEGORY(category) virtual int GetCategoryFlags() const override { return category; }
+#define EVENT_CLASS_CATEGORY(category) static constexpr int StaticCategoryFlags = category;
 
 	class PHOTON_API Event
 	{
 		friend class EventDispatcher;
 	public:
-		virtual EventType GetEventType() const = 0;
+		inline EventType GetEventType() const { return m_Type; }
+		inline int GetCategoryFlags() const { return m_CategoryFlags; }
+
 		virtual const char* GetName() const = 0;
-		virtual int GetCategoryFlags() const = 0;
-		virtual std::string ToString() const { return GetName(); }
 
-		inline bool IsInCategory(EventCategory category)
+		// Writes a description of the event straight into a fmt buffer. This is
+		// what the log macros use, so logging an event allocates nothing and
+		// does no work at all when the log level is disabled
+		virtual fmt::format_context::iterator FormatTo(fmt::format_context::iterator out) const
+		{
+			return fmt::format_to(out, "{}", GetName());
+		}
+
+		std::string ToString() const
+		{
+			fmt::memory_buffer buffer;
+			FormatTo(fmt::appender(buffer));
+			return fmt::to_string(buffer);
+		}
+
+		inline bool IsInCategory(EventCategory category) const
 		{
 			return GetCategoryFlags() & category;
 		}
 
+	protected:
+		Event(EventType type, int categoryFlags)
+			: m_Type(type), m_CategoryFlags(categoryFlags)
+		{
+		}
+
 	public:
 		bool Handled = false;
+	private:
+		EventType m_Type;
+		int m_CategoryFlags;
 	};
 
+	namespace Detail
+	{
+		// Extracts the event type a handler takes, e.g. bool(KeyPressedEvent&)
+		template<typename F>
+		struct EventHandlerTraits : EventHandlerTraits<decltype(&F::operator())> {};
+
+		template<typename R, typename T>
+		struct EventHandlerTraits<R(*)(T&)> { using EventT = T; };
+
+		template<typename C, typename R, typename T>
+		struct EventHandlerTraits<R(C::*)(T&)> { using EventT = T; };
+
+		template<typename C, typename R, typename T>
+		struct EventHandlerTraits<R(C::*)(T&) const> { using EventT = T; };
+
+		template<typename F>
+		using HandlerEventT = typename EventHandlerTraits<std::remove_cvref_t<F>>::EventT;
+
+		template<typename... Ts>
+		inline constexpr bool DistinctTypes = true;
+
+		template<typename T, typename... Ts>
+		inline constexpr bool DistinctTypes<T, Ts...> = (!std::is_same_v<T, Ts> && ...) && DistinctTypes<Ts...>;
+	}
+
+	// Dispatches an event to handlers taking a concrete event type. Handlers
+	// are taken as plain callables so nothing is type erased or heap allocated
 	class PHOTON_API EventDispatcher
 	{
-		template<typename T>
-		using EventFn = std::function<bool(T&)>;
 	public:
 		EventDispatcher(Event& event)
 			: m_Event(event)
 		{
 		}
 
-		template<typename T>
-		bool Dispatch(EventFn<T> func)
+		template<typename T, typename F>
+		bool Dispatch(const F& func)
 		{
-			if (m_Event.GetEventType() == T::GetStaticType())
+			if (m_Event.GetEventType() == T::StaticType)
 			{
-				m_Event.Handled = func(*(T*)&m_Event);
+				m_Event.Handled = func(static_cast<T&>(m_Event));
 				return true;
 			}
 
 			return false;
 		}
 
+		// Invokes whichever of the handlers takes this event's type through a
+		// table indexed by EventType. Each handler must take a different type
+		template<typename... Fs>
+		bool DispatchAny(Fs&&... handlers)
+		{
+			// A later handler would silently take the table slot of an earlier one
+			static_assert(Detail::DistinctTypes<Detail::HandlerEventT<Fs>...>, "DispatchAny takes at most one handler per event type");
+			return DispatchTable(std::index_sequence_for<Fs...>{}, std::forward_as_tuple(handlers...));
+		}
+
+	private:
+		template<typename Tuple, size_t I>
+		static bool Invoke(Event& event, Tuple& handlers)
+		{
+			using T = Detail::HandlerEventT<std::tuple_element_t<I, Tuple>>;
+			event.Handled = std::get<I>(handlers)(static_cast<T&>(event));
+			return true;
+		}
+
+		template<size_t... Is, typename Tuple>
+		bool DispatchTable(std::index_sequence<Is...>, Tuple handlers)
+		{
+			using Thunk = bool(*)(Event&, Tuple&);
+
+			static constexpr std::array<Thunk, EventTypeCount> table = []()
+			{
+				std::array<Thunk, EventTypeCount> t{};
+				((t[(size_t)Detail::HandlerEventT<std::tuple_element_t<Is, Tuple>>::StaticType] = &Invoke<Tuple, Is>), ...);
+				return t;
+			}();
+
+			static_assert(std::tuple_size_v<Tuple> == sizeof...(Is));
+
+			Thunk thunk = table[(size_t)m_Event.GetEventType()];
+			return thunk ? thunk(m_Event, handlers) : false;
+		}
+
 	private:
 		Event& m_Event;
 	};
@@ -80,4 +175,18 @@ namespace Photon
 	{
 		return os << e.ToString();
 	}
-}
\ No newline at end of file
+}
+
+template<typename T>
+struct fmt::formatter<T, char, std::enable_if_t<std::is_base_of_v<Photon::Event, T>>>
+{
+	constexpr auto parse(format_parse_context& ctx) -> decltype(ctx.begin())
+	{
+		return ctx.begin();
+	}
+
+	auto format(const Photon::Event& e, format_context& ctx) const -> decltype(ctx.out())
+	{
+		return e.FormatTo(ctx.out());
+	}
+};
@@ -0,0 +1,143 @@
+#include "ptpch.h"
+#include "EventQueue.h"
+
+#include "EventStorage.h"
+
+#include "Photon/Memory/Memory.h"
+
+namespace Photon
+{
+	EventQueue::EventQueue(size_t chunkSize)
+		: m_ChunkSize(chunkSize)
+	{
+		m_Chunks.push_back(AllocateChunk());
+		m_Events.reserve(256);
+	}
+
+	EventQueue::~EventQueue()
+	{
+		for (uint8_t* chunk : m_Chunks)
+			Memory::Free(chunk, m_ChunkSize, alignof(std::max_align_t), MemoryTag::Events);
+	}
+
+	uint8_t* EventQueue::AllocateChunk()
+	{
+		return (uint8_t*)Memory::Allocate(m_ChunkSize, alignof(std::max_align_t), MemoryTag::Events);
+	}
+
+	void* EventQueue::Allocate(size_t size, size_t alignment)
+	{
+		PT_CORE_ASSERT(size <= m_ChunkSize, "Event does not fit in an arena chunk");
+
+		size_t offset = (m_ChunkOffset + alignment - 1) & ~(alignment - 1);
+		if (offset + size > m_ChunkSize)
+		{
+			// Chunks are kept between frames, so this only allocates while
+			// the arena is still growing to its steady state size
+			if (++m_ChunkIndex == m_Chunks.size())
+				m_Chunks.push_back(AllocateChunk());
+			offset = 0;
+		}
+
+		m_ChunkOffset = offset + size;
+		return m_Chunks[m_ChunkIndex] + offset;
+	}
+
+	template<typename T>
+	T* EventQueue::Emplace(const T& event)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Queued events are never destroyed");
+
+		T* copy = new (Allocate(sizeof(T), alignof(T))) T(event);
+		m_Events.push_back(copy);
+		return copy;
+	}
+
+	void EventQueue::Push(const Event& event)
+	{
+		switch (event.GetEventType())
+		{
+			case EventType::WindowResize:
+			{
+				const WindowResizeEvent& e = (const WindowResizeEvent&)event;
+				if (m_WindowResizeSlot != NoSlot)
+				{
+					new (m_Events[m_WindowResizeSlot]) WindowResizeEvent(e);
+					m_CoalescedCount++;
+				}
+				else
+				{
+					m_WindowResizeSlot = m_Events.size();
+					Emplace(e);
+				}
+				break;
+			}
+			case EventType::MouseMoved:
+			{
+				const MouseMovedEvent& e = (const MouseMovedEvent&)event;
+				if (m_MouseMovedSlot != NoSlot)
+				{
+					new (m_Events[m_MouseMovedSlot]) MouseMovedEvent(e);
+					m_CoalescedCount++;
+				}
+				else
+				{
+					m_MouseMovedSlot = m_Events.size();
+					Emplace(e);
+				}
+				break;
+			}
+			case EventType::MouseScrolled:
+			{
+				const MouseScrolledEvent& e = (const MouseScrolledEvent&)event;
+				if (m_MouseScrolledSlot != NoSlot)
+				{
+					MouseScrolledEvent* pending = (MouseScrolledEvent*)m_Events[m_MouseScrolledSlot];
+					new (pending) MouseScrolledEvent(pending->GetXOffset() + e.GetXOffset(), pending->GetYOffset() + e.GetYOffset());
+					m_CoalescedCount++;
+				}
+				else
+				{
+					m_MouseScrolledSlot = m_Events.size();
+					Emplace(e);
+				}
+				break;
+			}
+			case EventType::KeyPressed:
+			case EventType::KeyReleased:
+			case EventType::MouseButtonPressed:
+			case EventType::MouseButtonReleased:
+				m_MouseMovedSlot = NoSlot;
+				m_MouseScrolledSlot = NoSlot;
+				[[fallthrough]];
+			default:
+			{
+				[[maybe_unused]] bool known = VisitEvent(event, [this](const auto& e) { Emplace(e); });
+				PT_CORE_ASSERT(known, "Unknown event type cannot be queued");
+				break;
+			}
+		}
+	}
+
+	void EventQueue::EndCoalescing(size_t index)
+	{
+		// An event that is being delivered can no longer be merged into
+		if (m_MouseMovedSlot == index)
+			m_MouseMovedSlot = NoSlot;
+		if (m_MouseScrolledSlot == index)
+			m_MouseScrolledSlot = NoSlot;
+		if (m_WindowResizeSlot == index)
+			m_WindowResizeSlot = NoSlot;
+	}
+
+	void EventQueue::Clear()
+	{
+		m_Events.clear();
+		m_ChunkIndex = 0;
+		m_ChunkOffset = 0;
+
+		m_MouseMovedSlot = NoSlot;
+		m_MouseScrolledSlot = NoSlot;
+		m_WindowResizeSlot = NoSlot;
+	}
+}
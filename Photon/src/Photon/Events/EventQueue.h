@@ -0,0 +1,67 @@
+#pragma once
+#include "Event.h"
+
+namespace Photon
+{
+	// Deferred event queue. Events are copied into a linear arena that is
+	// rewound every frame, and high-rate events are coalesced on the way in:
+	//   MouseMovedEvent   - only the latest position is kept
+	//   WindowResizeEvent - only the latest size is kept
+	//   MouseScrolledEvent - offsets are summed
+	// Key and mouse button events end the current mouse move/scroll run so
+	// that input order is preserved around clicks and key presses.
+	class PHOTON_API EventQueue
+	{
+	public:
+		EventQueue(size_t chunkSize = 16 * 1024);
+		~EventQueue();
+
+		EventQueue(const EventQueue&) = delete;
+		EventQueue& operator=(const EventQueue&) = delete;
+
+		void Push(const Event& event);
+
+		// Calls func for every queued event in order, then rewinds the arena.
+		// Events pushed from inside func are delivered in the same drain
+		template<typename F>
+		void Drain(F&& func)
+		{
+			for (size_t i = 0; i < m_Events.size(); i++)
+			{
+				EndCoalescing(i);
+				func(*m_Events[i]);
+			}
+
+			Clear();
+		}
+
+		void Clear();
+
+		inline size_t Size() const { return m_Events.size(); }
+		inline bool Empty() const { return m_Events.empty(); }
+		inline uint64_t GetCoalescedCount() const { return m_CoalescedCount; }
+	private:
+		uint8_t* AllocateChunk();
+		void* Allocate(size_t size, size_t alignment);
+
+		template<typename T>
+		T* Emplace(const T& event);
+
+		void EndCoalescing(size_t index);
+	private:
+		static constexpr size_t NoSlot = (size_t)-1;
+
+		std::vector<uint8_t*> m_Chunks;
+		size_t m_ChunkSize;
+		size_t m_ChunkIndex = 0;
+		size_t m_ChunkOffset = 0;
+
+		std::vector<Event*> m_Events;
+
+		size_t m_MouseMovedSlot = NoSlot;
+		size_t m_MouseScrolledSlot = NoSlot;
+		size_t m_WindowResizeSlot = NoSlot;
+
+		uint64_t m_CoalescedCount = 0;
+	};
+}
@@ -0,0 +1,373 @@
+#include "ptpch.h"
+#include "EventRecording.h"
+
+#include "ApplicationEvent.h"
+#include "KeyEvent.h"
+#include "MouseEvent.h"
+
+#include "Photon/Memory/Memory.h"
+
+namespace Photon
+{
+	static inline uint64_t ZigZag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+	static inline int64_t UnZigZag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+	static inline uint8_t* WriteVarint(uint8_t* out, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			*out++ = (uint8_t)(value | 0x80);
+			value >>= 7;
+		}
+		*out++ = (uint8_t)value;
+		return out;
+	}
+
+	static inline bool ReadVarint(const uint8_t*& in, const uint8_t* end, uint64_t& value)
+	{
+		value = 0;
+		for (uint32_t shift = 0; shift < 64 && in < end; shift += 7)
+		{
+			uint8_t byte = *in++;
+			value |= (uint64_t)(byte & 0x7f) << shift;
+			if (!(byte & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	static inline bool IsWholeNumber(float value, int64_t& whole)
+	{
+		if (!(value >= -2147483648.0f && value <= 2147483647.0f))
+			return false;
+
+		whole = (int64_t)value;
+		return (float)whole == value;
+	}
+
+	static inline uint8_t* WriteFloat(uint8_t* out, float value, int64_t& previous)
+	{
+		int64_t whole;
+		if (IsWholeNumber(value, whole))
+		{
+			out = WriteVarint(out, ZigZag(whole - previous) << 1);
+			previous = whole;
+			return out;
+		}
+
+		*out++ = 1;
+		memcpy(out, &value, sizeof(float));
+		return out + sizeof(float);
+	}
+
+	static inline bool ReadFloat(const uint8_t*& in, const uint8_t* end, float& value, int64_t& previous)
+	{
+		uint64_t encoded;
+		if (!ReadVarint(in, end, encoded))
+			return false;
+
+		if (encoded & 1)
+		{
+			if (end - in < (ptrdiff_t)sizeof(float))
+				return false;
+			memcpy(&value, in, sizeof(float));
+			in += sizeof(float);
+			return true;
+		}
+
+		previous += UnZigZag(encoded >> 1);
+		value = (float)previous;
+		return true;
+	}
+
+	EventRecorder::EventRecorder(const std::string& filepath, size_t bufferSize)
+		: m_File(filepath, std::ios::binary), m_Capacity(std::max(bufferSize, EventStream::MaxRecordSize))
+	{
+		if (!m_File.is_open())
+		{
+			PT_CORE_ERROR("EventRecorder could not open '{0}'", filepath);
+			return;
+		}
+
+		m_Buffer = (uint8_t*)Memory::Allocate(m_Capacity, alignof(std::max_align_t), MemoryTag::Events);
+
+		memcpy(m_Buffer, EventStream::Magic, sizeof(EventStream::Magic));
+		m_Buffer[sizeof(EventStream::Magic)] = EventStream::Version;
+		m_Used = sizeof(EventStream::Magic) + 1;
+	}
+
+	EventRecorder::~EventRecorder()
+	{
+		if (!m_Buffer)
+			return;
+
+		// End marker carrying the final frame count
+		if (m_Capacity - m_Used < EventStream::MaxRecordSize)
+			Flush();
+		uint8_t* out = WriteVarint(m_Buffer + m_Used, m_Frame - m_LastFrame);
+		*out++ = (uint8_t)EventType::None;
+		m_Used = out - m_Buffer;
+
+		Flush();
+		Memory::Free(m_Buffer, m_Capacity, alignof(std::max_align_t), MemoryTag::Events);
+	}
+
+	void EventRecorder::Record(const Event& event)
+	{
+		if (!m_Buffer)
+			return;
+
+		if (m_Capacity - m_Used < EventStream::MaxRecordSize)
+			Flush();
+
+		uint8_t* out = m_Buffer + m_Used;
+		out = WriteVarint(out, m_Frame - m_LastFrame);
+		*out++ = (uint8_t)event.GetEventType();
+		m_LastFrame = m_Frame;
+
+		switch (event.GetEventType())
+		{
+			case EventType::WindowResize:
+			{
+				const WindowResizeEvent& e = (const WindowResizeEvent&)event;
+				out = WriteVarint(out, e.GetWidth());
+				out = WriteVarint(out, e.GetHeight());
+				break;
+			}
+			case EventType::WindowMoved:
+			{
+				const WindowMovedEvent& e = (const WindowMovedEvent&)event;
+				out = WriteVarint(out, e.GetX());
+				out = WriteVarint(out, e.GetY());
+				break;
+			}
+			case EventType::KeyPressed:
+			{
+				const KeyPressedEvent& e = (const KeyPressedEvent&)event;
+				out = WriteVarint(out, ZigZag(e.GetKeyCode()));
+				out = WriteVarint(out, ZigZag(e.GetRepeatCount()));
+				break;
+			}
+			case EventType::KeyReleased:
+				out = WriteVarint(out, ZigZag(((const KeyReleasedEvent&)event).GetKeyCode()));
+				break;
+			case EventType::MouseButtonPressed:
+			case EventType::MouseButtonReleased:
+				out = WriteVarint(out, ZigZag(((const MouseButtonEvent&)event).GetMouseButton()));
+				break;
+			case EventType::MouseMoved:
+			{
+				const MouseMovedEvent& e = (const MouseMovedEvent&)event;
+				out = WriteFloat(out, e.GetX(), m_History.MouseX);
+				out = WriteFloat(out, e.GetY(), m_History.MouseY);
+				break;
+			}
+			case EventType::MouseScrolled:
+			{
+				// Scroll offsets are independent steps, not a running value
+				const MouseScrolledEvent& e = (const MouseScrolledEvent&)event;
+				int64_t previous = 0;
+				out = WriteFloat(out, e.GetXOffset(), previous);
+				previous = 0;
+				out = WriteFloat(out, e.GetYOffset(), previous);
+				break;
+			}
+			case EventType::WindowClose:
+			case EventType::WindowFocus:
+			case EventType::WindowLostFocus:
+			case EventType::AppTick:
+			case EventType::AppUpdate:
+			case EventType::AppRender:
+				break;
+			default:
+				PT_CORE_ASSERT(false, "Unknown event type cannot be recorded");
+				return;
+		}
+
+		m_Used = out - m_Buffer;
+		m_EventCount++;
+	}
+
+	void EventRecorder::Flush()
+	{
+		if (!m_Used)
+			return;
+
+		m_File.write((const char*)m_Buffer, m_Used);
+		m_File.flush();
+		m_BytesWritten += m_Used;
+		m_Used = 0;
+	}
+
+	EventPlayer::EventPlayer(const std::string& filepath, ReplayMode mode, size_t bufferSize)
+		: m_File(filepath, std::ios::binary), m_Mode(mode), m_Capacity(std::max(bufferSize, EventStream::MaxRecordSize))
+	{
+		if (!m_File.is_open())
+		{
+			PT_CORE_ERROR("EventPlayer could not open '{0}'", filepath);
+			m_Finished = true;
+			return;
+		}
+
+		m_Buffer = (uint8_t*)Memory::Allocate(m_Capacity, alignof(std::max_align_t), MemoryTag::Events);
+
+		Fill();
+		if (m_End - m_Begin < sizeof(EventStream::Magic) + 1
+			|| memcmp(m_Buffer, EventStream::Magic, sizeof(EventStream::Magic)) != 0
+			|| m_Buffer[sizeof(EventStream::Magic)] == 0
+			|| m_Buffer[sizeof(EventStream::Magic)] > EventStream::Version)
+		{
+			PT_CORE_ERROR("'{0}' is not a version 1 to {1} event recording", filepath, EventStream::Version);
+			m_Finished = true;
+			return;
+		}
+		m_Begin += sizeof(EventStream::Magic) + 1;
+
+		m_HasNext = ReadRecord(m_Next);
+	}
+
+	EventPlayer::~EventPlayer()
+	{
+		if (m_Buffer)
+			Memory::Free(m_Buffer, m_Capacity, alignof(std::max_align_t), MemoryTag::Events);
+	}
+
+	bool EventPlayer::Fill()
+	{
+		if (m_End - m_Begin >= EventStream::MaxRecordSize || m_EndOfFile)
+			return m_Begin != m_End;
+
+		// Keep the partial record at the front and top the buffer up behind it
+		size_t remaining = m_End - m_Begin;
+		memmove(m_Buffer, m_Buffer + m_Begin, remaining);
+		m_Begin = 0;
+		m_End = remaining;
+
+		m_File.read((char*)m_Buffer + m_End, m_Capacity - m_End);
+		m_End += (size_t)m_File.gcount();
+		if (!m_File)
+			m_EndOfFile = true;
+
+		return m_Begin != m_End;
+	}
+
+	bool EventPlayer::ReadRecord(Record& record)
+	{
+		if (!Fill())
+			return false;
+
+		const uint8_t* in = m_Buffer + m_Begin;
+		const uint8_t* end = m_Buffer + m_End;
+
+		uint64_t frameDelta, a = 0, b = 0;
+		bool valid = ReadVarint(in, end, frameDelta) && in < end;
+		if (valid)
+		{
+			record.Type = (EventType)*in++;
+			switch (record.Type)
+			{
+				case EventType::None:
+					break;
+				case EventType::WindowResize:
+				case EventType::WindowMoved:
+					valid = ReadVarint(in, end, a) && ReadVarint(in, end, b);
+					record.A = (int64_t)a;
+					record.B = (int64_t)b;
+					break;
+				case EventType::KeyPressed:
+					valid = ReadVarint(in, end, a) && ReadVarint(in, end, b);
+					record.A = UnZigZag(a);
+					record.B = UnZigZag(b);
+					break;
+				case EventType::KeyReleased:
+				case EventType::MouseButtonPressed:
+				case EventType::MouseButtonReleased:
+					valid = ReadVarint(in, end, a);
+					record.A = UnZigZag(a);
+					break;
+				case EventType::MouseMoved:
+					valid = ReadFloat(in, end, record.X, m_History.MouseX) && ReadFloat(in, end, record.Y, m_History.MouseY);
+					break;
+				case EventType::MouseScrolled:
+				{
+					int64_t previousX = 0, previousY = 0;
+					valid = ReadFloat(in, end, record.X, previousX) && ReadFloat(in, end, record.Y, previousY);
+					break;
+				}
+				case EventType::WindowClose:
+				case EventType::WindowFocus:
+				case EventType::WindowLostFocus:
+				case EventType::AppTick:
+				case EventType::AppUpdate:
+				case EventType::AppRender:
+					break;
+				default:
+					valid = false;
+					break;
+			}
+		}
+
+		if (!valid)
+		{
+			PT_CORE_ERROR("EventPlayer: corrupt or truncated record after {0} events", m_EventCount);
+			return false;
+		}
+
+		m_RecordFrame += frameDelta;
+		record.Frame = m_RecordFrame;
+		m_Begin = in - m_Buffer;
+
+		if (record.Type == EventType::None)
+		{
+			m_EndFrame = m_RecordFrame;
+			m_HasEnd = true;
+			return false;
+		}
+		return true;
+	}
+
+	void EventPlayer::Deliver(const Record& record)
+	{
+		m_EventCount++;
+		if (!m_EventCallback)
+			return;
+
+		switch (record.Type)
+		{
+			case EventType::WindowClose:         { WindowCloseEvent e; m_EventCallback(e); break; }
+			case EventType::WindowResize:        { WindowResizeEvent e((uint32_t)record.A, (uint32_t)record.B); m_EventCallback(e); break; }
+			case EventType::WindowFocus:         { WindowFocusEvent e; m_EventCallback(e); break; }
+			case EventType::WindowLostFocus:     { WindowLostFocusEvent e; m_EventCallback(e); break; }
+			case EventType::WindowMoved:         { WindowMovedEvent e((uint32_t)record.A, (uint32_t)record.B); m_EventCallback(e); break; }
+			case EventType::AppTick:             { AppTickEvent e; m_EventCallback(e); break; }
+			case EventType::AppUpdate:           { AppUpdateEvent e; m_EventCallback(e); break; }
+			case EventType::AppRender:           { AppRenderEvent e; m_EventCallback(e); break; }
+			case EventType::KeyPressed:          { KeyPressedEvent e((int)record.A, (int)record.B); m_EventCallback(e); break; }
+			case EventType::KeyReleased:         { KeyReleasedEvent e((int)record.A); m_EventCallback(e); break; }
+			case EventType::MouseButtonPressed:  { MouseButtonPressedEvent e((int)record.A); m_EventCallback(e); break; }
+			case EventType::MouseButtonReleased: { MouseButtonReleasedEvent e((int)record.A); m_EventCallback(e); break; }
+			case EventType::MouseMoved:          { MouseMovedEvent e(record.X, record.Y); m_EventCallback(e); break; }
+			case EventType::MouseScrolled:       { MouseScrolledEvent e(record.X, record.Y); m_EventCallback(e); break; }
+			default: break;
+		}
+	}
+
+	bool EventPlayer::NextFrame()
+	{
+		if (m_Finished)
+			return false;
+
+		m_Frame++;
+
+		// Events recorded before the first frame are delivered with it
+		while (m_HasNext && (m_Mode == ReplayMode::Immediate || m_Next.Frame <= m_Frame))
+		{
+			Deliver(m_Next);
+			m_HasNext = ReadRecord(m_Next);
+		}
+
+		// Version 1 recordings have no end marker and stop at their last event
+		m_Finished = !m_HasNext && (!m_HasEnd || m_Frame >= m_EndFrame);
+		return !m_Finished;
+	}
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include "Event.h"
+#include "Photon/Window.h"
+
+#include <fstream>
+
+namespace Photon
+{
+	// Binary event stream, written by EventRecorder and read by EventPlayer
+	//   header: "PTEV" and a version byte
+	//   record: frames since the previous record (varint), EventType (byte),
+	//           then the event's fields
+	//   end:    frames since the previous record (varint), EventType::None
+	//           (version 2), so the final frame count survives trailing
+	//           frames without input
+	// Integer fields are varints, zigzag encoded when signed. Float fields are
+	// written as the zigzag varint change from the previous value when they
+	// hold a whole number, and as raw bits otherwise, so ordinary mouse
+	// motion costs a byte or two per axis.
+	namespace EventStream
+	{
+		constexpr char Magic[4] = { 'P', 'T', 'E', 'V' };
+		constexpr uint8_t Version = 2;
+		// Largest encoded record: frame varint, type, two 10 byte fields
+		constexpr size_t MaxRecordSize = 32;
+
+		// Previous values the float fields are encoded against
+		struct FloatHistory
+		{
+			int64_t MouseX = 0, MouseY = 0;
+		};
+	}
+
+	// Appends every recorded event to a file, stamped with the frame it
+	// arrived in. Records are encoded into a fixed buffer that is written out
+	// when it fills up, so recording costs a few nanoseconds per event and a
+	// file write every bufferSize bytes.
+	class PHOTON_API EventRecorder
+	{
+	public:
+		EventRecorder(const std::string& filepath, size_t bufferSize = 64 * 1024);
+		~EventRecorder();
+
+		EventRecorder(const EventRecorder&) = delete;
+		EventRecorder& operator=(const EventRecorder&) = delete;
+
+		inline bool IsOpen() const { return m_File.is_open(); }
+
+		// Events recorded after this are stamped with the next frame
+		inline void NextFrame() { m_Frame++; }
+		void Record(const Event& event);
+		void Flush();
+
+		inline uint64_t GetEventCount() const { return m_EventCount; }
+		inline uint64_t GetBytesWritten() const { return m_BytesWritten + m_Used; }
+	private:
+		std::ofstream m_File;
+
+		uint8_t* m_Buffer = nullptr;
+		size_t m_Capacity;
+		size_t m_Used = 0;
+
+		uint64_t m_Frame = 0;
+		uint64_t m_LastFrame = 0;
+		EventStream::FloatHistory m_History;
+
+		uint64_t m_EventCount = 0;
+		uint64_t m_BytesWritten = 0;
+	};
+
+	enum class ReplayMode
+	{
+		// Events are delivered in the frame they were recorded in
+		Recorded,
+		// The whole recording is delivered in the first frame, as fast as it
+		// can be read. Playback still lasts the recorded number of frames
+		Immediate
+	};
+
+	// Feeds a recording back through an event callback, normally the same one
+	// the window calls. The file is streamed through a fixed buffer rather
+	// than loaded whole.
+	class PHOTON_API EventPlayer
+	{
+	public:
+		EventPlayer(const std::string& filepath, ReplayMode mode = ReplayMode::Recorded, size_t bufferSize = 64 * 1024);
+		~EventPlayer();
+
+		EventPlayer(const EventPlayer&) = delete;
+		EventPlayer& operator=(const EventPlayer&) = delete;
+
+		inline bool IsOpen() const { return m_File.is_open(); }
+		inline void SetEventCallback(const Window::EventCallbackFn& callback) { m_EventCallback = callback; }
+
+		// Advances one frame and delivers the events recorded for it. Returns
+		// false once the recording's last frame has been played
+		bool NextFrame();
+
+		inline bool IsFinished() const { return m_Finished; }
+		inline uint64_t GetFrame() const { return m_Frame; }
+		inline uint64_t GetEventCount() const { return m_EventCount; }
+	private:
+		struct Record
+		{
+			uint64_t Frame;
+			EventType Type;
+			int64_t A, B;
+			float X, Y;
+		};
+
+		bool ReadRecord(Record& record);
+		bool Fill();
+		void Deliver(const Record& record);
+	private:
+		std::ifstream m_File;
+		ReplayMode m_Mode;
+		Window::EventCallbackFn m_EventCallback;
+
+		uint8_t* m_Buffer = nullptr;
+		size_t m_Capacity;
+		size_t m_Begin = 0, m_End = 0;
+		bool m_EndOfFile = false;
+
+		Record m_Next;
+		bool m_HasNext = false;
+		bool m_HasEnd = false;
+		bool m_Finished = false;
+
+		uint64_t m_Frame = 0;
+		uint64_t m_RecordFrame = 0;
+		uint64_t m_EndFrame = 0;
+		EventStream::FloatHistory m_History;
+
+		uint64_t m_EventCount = 0;
+	};
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "ApplicationEvent.h"
+#include "KeyEvent.h"
+#include "MouseEvent.h"
+
+namespace Photon
+{
+	// Storage big enough to hold a copy of any engine event, used by the
+	// queues that keep events by value
+	constexpr size_t MaxEventSize = std::max({
+		sizeof(WindowCloseEvent), sizeof(WindowResizeEvent), sizeof(WindowFocusEvent),
+		sizeof(WindowLostFocusEvent), sizeof(WindowMovedEvent), sizeof(AppTickEvent),
+		sizeof(AppUpdateEvent), sizeof(AppRenderEvent), sizeof(KeyPressedEvent),
+		sizeof(KeyReleasedEvent), sizeof(MouseButtonPressedEvent), sizeof(MouseButtonReleasedEvent),
+		sizeof(MouseMovedEvent), sizeof(MouseScrolledEvent) });
+
+	constexpr size_t MaxEventAlignment = std::max({
+		alignof(WindowCloseEvent), alignof(WindowResizeEvent), alignof(WindowFocusEvent),
+		alignof(WindowLostFocusEvent), alignof(WindowMovedEvent), alignof(AppTickEvent),
+		alignof(AppUpdateEvent), alignof(AppRenderEvent), alignof(KeyPressedEvent),
+		alignof(KeyReleasedEvent), alignof(MouseButtonPressedEvent), alignof(MouseButtonReleasedEvent),
+		alignof(MouseMovedEvent), alignof(MouseScrolledEvent) });
+
+	// Calls func with the event cast to its concrete type, so it can be copied
+	// without knowing the type up front. Returns false for unknown types
+	template<typename F>
+	bool VisitEvent(const Event& event, F&& func)
+	{
+		switch (event.GetEventType())
+		{
+			case EventType::WindowClose:         func((const WindowCloseEvent&)event); return true;
+			case EventType::WindowResize:        func((const WindowResizeEvent&)event); return true;
+			case EventType::WindowFocus:         func((const WindowFocusEvent&)event); return true;
+			case EventType::WindowLostFocus:     func((const WindowLostFocusEvent&)event); return true;
+			case EventType::WindowMoved:         func((const WindowMovedEvent&)event); return true;
+			case EventType::AppTick:             func((const AppTickEvent&)event); return true;
+			case EventType::AppUpdate:           func((const AppUpdateEvent&)event); return true;
+			case EventType::AppRender:           func((const AppRenderEvent&)event); return true;
+			case EventType::KeyPressed:          func((const KeyPressedEvent&)event); return true;
+			case EventType::KeyReleased:         func((const KeyReleasedEvent&)event); return true;
+			case EventType::MouseButtonPressed:  func((const MouseButtonPressedEvent&)event); return true;
+			case EventType::MouseButtonReleased: func((const MouseButtonReleasedEvent&)event); return true;
+			case EventType::MouseMoved:          func((const MouseMovedEvent&)event); return true;
+			case EventType::MouseScrolled:       func((const MouseScrolledEvent&)event); return true;
+			default: return false;
+		}
+	}
+}
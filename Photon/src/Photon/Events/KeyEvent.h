@@ -8,19 +8,17 @@ namespace Photon
 	public:
 		inline int GetKeyCode() const { return m_KeyCode; }
 
+		fmt::format_context::iterator FormatTo(fmt::format_context::iterator out) const override
+		{
+			return fmt::format_to(out, "{}: {}", GetName(), m_KeyCode);
+		}
+
 		EVENT_CLASS_CATEGORY(EventCategoryKeyboard | EventCategoryInput)
 	protected:
-		KeyEvent(int keyCode)
-			: m_KeyCode(keyCode)
+		KeyEvent(EventType type, int keyCode)
+			: Event(type, StaticCategoryFlags), m_KeyCode(keyCode)
 		{}
 
-		std::string ToString() const override
-		{
-			std::stringstream ss;
-			ss << GetName() << ": " << m_KeyCode;
-			return ss.str();
-		}
-
 	protected:
 		int m_KeyCode;
 	};
@@ -29,16 +27,14 @@ namespace Photon
 	{
 	public: 
 		KeyPressedEvent(int keyCode, int repeatCount)
-			: KeyEvent(keyCode), m_RepeatCount(repeatCount)
+			: KeyEvent(StaticType, keyCode), m_RepeatCount(repeatCount)
 		{}
 
 		inline int GetRepeatCount() const { return m_RepeatCount; }
 
-		std::string ToString() const override
+		fmt::format_context::iterator FormatTo(fmt::format_context::iterator out) const override
 		{
-			std::stringstream ss;
-			ss << KeyEvent::ToString() << " (" << m_RepeatCount << " repeats)";
-			return ss.str();
+			return fmt::format_to(KeyEvent::FormatTo(out), " ({} repeats)", m_RepeatCount);
 		}
 
 		EVENT_CLASS_TYPE(KeyPressed)
@@ -50,7 +46,7 @@ namespace Photon
 	{
 	public:
 		KeyReleasedEvent(int keyCode)
-			: KeyEvent(keyCode)
+			: KeyEvent(StaticType, keyCode)
 		{}
 
 		EVENT_CLASS_TYPE(KeyReleased)
@@ -6,19 +6,17 @@ namespace Photon
 	class PHOTON_API MouseButtonEvent : public Event
 	{
 	public:
-		inline int GetMouseButton() { return m_Button; }
+		inline int GetMouseButton() const { return m_Button; }
 
-		std::string ToString() const override
+		fmt::format_context::iterator FormatTo(fmt::format_context::iterator out) const override
 		{
-			std::stringstream ss;
-			ss << GetName() << ": " << m_Button;
-			return ss.str();
+			return fmt::format_to(out, "{}: {}", GetName(), m_Button);
 		}
 
 		EVENT_CLASS_CATEGORY(EventCategoryMouseButton | EventCategoryInput)
 	protected:
-		MouseButtonEvent(int button)
-			: m_Button(button)
+		MouseButtonEvent(EventType type, int button)
+			: Event(type, StaticCategoryFlags), m_Button(button)
 		{}
 
 	protected:
@@ -29,7 +27,7 @@ namespace Photon
 	{
 	public:
 		MouseButtonPressedEvent(int button)
-			: MouseButtonEvent(button)
+			: MouseButtonEvent(StaticType, button)
 		{}
 
 		EVENT_CLASS_TYPE(MouseButtonPressed)
@@ -39,7 +37,7 @@ namespace Photon
 	{
 	public:
 		MouseButtonReleasedEvent(int button)
-			: MouseButtonEvent(button)
+			: MouseButtonEvent(StaticType, button)
 		{}
 
 		EVENT_CLASS_TYPE(MouseButtonReleased)
@@ -49,17 +47,15 @@ namespace Photon
 	{
 	public:
 		MouseMovedEvent(float x, float y)
-			: m_MouseX(x), m_MouseY(y)
+			: Event(StaticType, StaticCategoryFlags), m_MouseX(x), m_MouseY(y)
 		{}
 
 		inline float GetX() const { return m_MouseX; }
 		inline float GetY() const { return m_MouseY; }
 
-		std::string ToString() const
+		fmt::format_context::iterator FormatTo(fmt::format_context::iterator out) const override
 		{
-			std::stringstream ss;
-			ss << "MouseMovedEvent: " << m_MouseX << ", " << m_MouseY;
-			return ss.str();
+			return fmt::format_to(out, "MouseMovedEvent: {}, {}", m_MouseX, m_MouseY);
 		}
 
 		EVENT_CLASS_TYPE(MouseMoved)
@@ -73,17 +69,15 @@ namespace Photon
 	{
 	public:
 		MouseScrolledEvent(float xOffset, float yOffset)
-			: m_XOffset(xOffset), m_YOffset(yOffset)
+			: Event(StaticType, StaticCategoryFlags), m_XOffset(xOffset), m_YOffset(yOffset)
 		{}
 
 		inline float GetXOffset() const { return m_XOffset; }
 		inline float GetYOffset() const { return m_YOffset; }
 
-		std::string ToString() const
+		fmt::format_context::iterator FormatTo(fmt::format_context::iterator out) const override
 		{
-			std::stringstream ss;
-			ss << "MouseScrolledEvent: " << m_XOffset << ", " << m_YOffset;
-			return ss.str();
+			return fmt::format_to(out, "MouseScrolledEvent: {}, {}", m_XOffset, m_YOffset);
 		}
 
 		EVENT_CLASS_TYPE(MouseScrolled)
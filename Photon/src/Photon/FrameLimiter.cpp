@@ -0,0 +1,91 @@
+#include "ptpch.h"
+#include "FrameLimiter.h"
+
+#include "Debug/Instrumentor.h"
+
+#include <thread>
+
+namespace Photon
+{
+	FrameLimiter::FrameLimiter()
+	{
+#ifdef PT_PLATFORM_WINDOWS
+		// Default Windows sleeps have ~15.6ms granularity, a high resolution
+		// waitable timer (Windows 10 1803+) gets close to 0.5ms
+	#ifdef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+		m_Timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	#endif
+		m_SpinThreshold = m_Timer ? std::chrono::microseconds(1000) : std::chrono::microseconds(16000);
+#else
+		m_SpinThreshold = std::chrono::microseconds(200);
+#endif
+	}
+
+	FrameLimiter::~FrameLimiter()
+	{
+#ifdef PT_PLATFORM_WINDOWS
+		if (m_Timer)
+			CloseHandle(m_Timer);
+#endif
+	}
+
+	void FrameLimiter::SetTargetFrameRate(double fps)
+	{
+		if (fps == m_TargetFrameRate)
+			return;
+
+		m_TargetFrameRate = fps;
+		if (fps > 0.0)
+			m_FrameDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+		else
+			m_FrameDuration = Clock::duration::zero();
+
+		m_NextFrame = Clock::now() + m_FrameDuration;
+	}
+
+	void FrameLimiter::Wait()
+	{
+		if (m_FrameDuration == Clock::duration::zero())
+			return;
+
+		PT_PROFILE_FUNCTION();
+
+		Clock::time_point now = Clock::now();
+		if (now < m_NextFrame)
+		{
+			Clock::time_point wakeUp = m_NextFrame - m_SpinThreshold;
+			if (now < wakeUp)
+				SleepUntil(wakeUp);
+
+			while (Clock::now() < m_NextFrame)
+				std::this_thread::yield();
+
+			m_NextFrame += m_FrameDuration;
+		}
+		else
+		{
+			// Deadlines are kept on a fixed grid so short hitches are made up
+			// for, but a frame that overran a whole period starts a new grid
+			m_NextFrame += m_FrameDuration;
+			if (now - m_NextFrame > m_FrameDuration)
+				m_NextFrame = now + m_FrameDuration;
+		}
+	}
+
+	void FrameLimiter::SleepUntil(Clock::time_point deadline)
+	{
+#ifdef PT_PLATFORM_WINDOWS
+		if (m_Timer)
+		{
+			// Relative due time in 100ns units, negative means relative
+			auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now());
+			LARGE_INTEGER dueTime;
+			dueTime.QuadPart = -(LONGLONG)(remaining.count() / 100);
+			if (dueTime.QuadPart < 0 && SetWaitableTimerEx(m_Timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+				WaitForSingleObject(m_Timer, INFINITE);
+			return;
+		}
+#endif
+		std::this_thread::sleep_until(deadline);
+	}
+}
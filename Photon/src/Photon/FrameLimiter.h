@@ -0,0 +1,37 @@
+#pragma once
+#include "Core.h"
+
+#include <chrono>
+
+namespace Photon
+{
+	// Paces a loop to a target frame rate. Wait() sleeps with the highest
+	// resolution timer the platform offers until shortly before the frame
+	// deadline, then spins for the remainder so the deadline is hit exactly
+	// without keeping a core busy for the whole frame.
+	class PHOTON_API FrameLimiter
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		FrameLimiter();
+		~FrameLimiter();
+
+		// 0 disables limiting
+		void SetTargetFrameRate(double fps);
+		inline double GetTargetFrameRate() const { return m_TargetFrameRate; }
+
+		void Wait();
+	private:
+		void SleepUntil(Clock::time_point deadline);
+	private:
+		double m_TargetFrameRate = 0.0;
+		Clock::duration m_FrameDuration = Clock::duration::zero();
+		Clock::time_point m_NextFrame;
+
+		// Sleeps are cut short by this much and the rest is spun
+		Clock::duration m_SpinThreshold;
+
+		void* m_Timer = nullptr;
+	};
+}
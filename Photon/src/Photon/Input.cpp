@@ -0,0 +1,126 @@
+#include "ptpch.h"
+#include "Input.h"
+
+#include "Events/ApplicationEvent.h"
+#include "Events/KeyEvent.h"
+#include "Events/MouseEvent.h"
+
+#include <atomic>
+
+namespace Photon
+{
+	struct InputData
+	{
+		// Collected from events since the last publish
+		InputState Pending;
+		float PublishedMouseX = 0.0f, PublishedMouseY = 0.0f;
+
+		InputState Snapshots[2];
+		std::atomic<uint32_t> Current = 0;
+	};
+
+	static InputData s_Data;
+
+	void Input::OnEvent(const Event& e)
+	{
+		InputState& state = s_Data.Pending;
+
+		switch (e.GetEventType())
+		{
+			case EventType::KeyPressed:
+			{
+				const KeyPressedEvent& event = (const KeyPressedEvent&)e;
+				int key = event.GetKeyCode();
+				if (InputState::IsValidKey(key) && !state.m_KeysDown[key])
+				{
+					state.m_KeysDown[key] = true;
+					state.m_KeysPressed[key] = true;
+				}
+				break;
+			}
+			case EventType::KeyReleased:
+			{
+				int key = ((const KeyReleasedEvent&)e).GetKeyCode();
+				if (InputState::IsValidKey(key) && state.m_KeysDown[key])
+				{
+					state.m_KeysDown[key] = false;
+					state.m_KeysReleased[key] = true;
+				}
+				break;
+			}
+			case EventType::MouseButtonPressed:
+			{
+				int button = ((const MouseButtonPressedEvent&)e).GetMouseButton();
+				if (InputState::IsValidButton(button) && !state.m_ButtonsDown[button])
+				{
+					state.m_ButtonsDown[button] = true;
+					state.m_ButtonsPressed[button] = true;
+				}
+				break;
+			}
+			case EventType::MouseButtonReleased:
+			{
+				int button = ((const MouseButtonReleasedEvent&)e).GetMouseButton();
+				if (InputState::IsValidButton(button) && state.m_ButtonsDown[button])
+				{
+					state.m_ButtonsDown[button] = false;
+					state.m_ButtonsReleased[button] = true;
+				}
+				break;
+			}
+			case EventType::MouseMoved:
+			{
+				const MouseMovedEvent& event = (const MouseMovedEvent&)e;
+				state.m_MouseX = event.GetX();
+				state.m_MouseY = event.GetY();
+				break;
+			}
+			case EventType::MouseScrolled:
+			{
+				const MouseScrolledEvent& event = (const MouseScrolledEvent&)e;
+				state.m_ScrollX += event.GetXOffset();
+				state.m_ScrollY += event.GetYOffset();
+				break;
+			}
+			case EventType::WindowLostFocus:
+			{
+				// Releases may never arrive once the window loses focus
+				state.m_KeysReleased |= state.m_KeysDown;
+				state.m_KeysDown.reset();
+				state.m_ButtonsReleased |= state.m_ButtonsDown;
+				state.m_ButtonsDown.reset();
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	void Input::Publish()
+	{
+		InputState& pending = s_Data.Pending;
+		pending.m_MouseDeltaX = pending.m_MouseX - s_Data.PublishedMouseX;
+		pending.m_MouseDeltaY = pending.m_MouseY - s_Data.PublishedMouseY;
+		pending.m_Frame++;
+
+		// Readers are on the other snapshot, which stays untouched until the
+		// next publish
+		uint32_t next = s_Data.Current.load(std::memory_order_relaxed) ^ 1;
+		s_Data.Snapshots[next] = pending;
+		s_Data.Current.store(next, std::memory_order_release);
+
+		s_Data.PublishedMouseX = pending.m_MouseX;
+		s_Data.PublishedMouseY = pending.m_MouseY;
+		pending.m_KeysPressed.reset();
+		pending.m_KeysReleased.reset();
+		pending.m_ButtonsPressed.reset();
+		pending.m_ButtonsReleased.reset();
+		pending.m_ScrollX = 0.0f;
+		pending.m_ScrollY = 0.0f;
+	}
+
+	const InputState& Input::GetState()
+	{
+		return s_Data.Snapshots[s_Data.Current.load(std::memory_order_acquire)];
+	}
+}
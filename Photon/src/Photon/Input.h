@@ -0,0 +1,79 @@
+#pragma once
+#include "Core.h"
+#include "Events/Event.h"
+
+#include <bitset>
+
+namespace Photon
+{
+	// Enough for every GLFW key code (GLFW_KEY_LAST is 348) and mouse button
+	constexpr int MaxKeys = 512;
+	constexpr int MaxMouseButtons = 8;
+
+	// Input as it was at the start of a frame. Pressed and Released cover
+	// everything that happened since the previous frame, so a key tapped
+	// within one frame is reported as both pressed and released.
+	class PHOTON_API InputState
+	{
+	public:
+		inline bool IsKeyDown(int key) const { return IsValidKey(key) && m_KeysDown[key]; }
+		inline bool IsKeyPressed(int key) const { return IsValidKey(key) && m_KeysPressed[key]; }
+		inline bool IsKeyReleased(int key) const { return IsValidKey(key) && m_KeysReleased[key]; }
+
+		inline bool IsMouseButtonDown(int button) const { return IsValidButton(button) && m_ButtonsDown[button]; }
+		inline bool IsMouseButtonPressed(int button) const { return IsValidButton(button) && m_ButtonsPressed[button]; }
+		inline bool IsMouseButtonReleased(int button) const { return IsValidButton(button) && m_ButtonsReleased[button]; }
+
+		inline float GetMouseX() const { return m_MouseX; }
+		inline float GetMouseY() const { return m_MouseY; }
+		inline float GetMouseDeltaX() const { return m_MouseDeltaX; }
+		inline float GetMouseDeltaY() const { return m_MouseDeltaY; }
+		inline float GetScrollX() const { return m_ScrollX; }
+		inline float GetScrollY() const { return m_ScrollY; }
+
+		// Number of the Input::Publish call that produced this snapshot
+		inline uint64_t GetFrame() const { return m_Frame; }
+	private:
+		static inline bool IsValidKey(int key) { return (unsigned)key < (unsigned)MaxKeys; }
+		static inline bool IsValidButton(int button) { return (unsigned)button < (unsigned)MaxMouseButtons; }
+	private:
+		std::bitset<MaxKeys> m_KeysDown, m_KeysPressed, m_KeysReleased;
+		std::bitset<MaxMouseButtons> m_ButtonsDown, m_ButtonsPressed, m_ButtonsReleased;
+
+		float m_MouseX = 0.0f, m_MouseY = 0.0f;
+		float m_MouseDeltaX = 0.0f, m_MouseDeltaY = 0.0f;
+		float m_ScrollX = 0.0f, m_ScrollY = 0.0f;
+
+		uint64_t m_Frame = 0;
+
+		friend class Input;
+	};
+
+	// Polling access to keyboard and mouse state. Application feeds every
+	// window event into Input as it arrives and publishes a new snapshot once
+	// per frame. Snapshots are double buffered, so job threads can read the
+	// current one without locks while the main thread collects the next
+	// frame's input. A snapshot stays valid until the publish after next,
+	// i.e. for the frame it was published in.
+	class PHOTON_API Input
+	{
+	public:
+		// Main thread only
+		static void OnEvent(const Event& e);
+		static void Publish();
+
+		// Any thread
+		static const InputState& GetState();
+
+		inline static bool IsKeyDown(int key) { return GetState().IsKeyDown(key); }
+		inline static bool IsKeyPressed(int key) { return GetState().IsKeyPressed(key); }
+		inline static bool IsKeyReleased(int key) { return GetState().IsKeyReleased(key); }
+		inline static bool IsMouseButtonDown(int button) { return GetState().IsMouseButtonDown(button); }
+		inline static bool IsMouseButtonPressed(int button) { return GetState().IsMouseButtonPressed(button); }
+		inline static bool IsMouseButtonReleased(int button) { return GetState().IsMouseButtonReleased(button); }
+		inline static float GetMouseX() { return GetState().GetMouseX(); }
+		inline static float GetMouseY() { return GetState().GetMouseY(); }
+		inline static float GetMouseDeltaX() { return GetState().GetMouseDeltaX(); }
+		inline static float GetMouseDeltaY() { return GetState().GetMouseDeltaY(); }
+	};
+}
@@ -0,0 +1,276 @@
+#include "ptpch.h"
+#include "JobSystem.h"
+#include "WorkStealingDeque.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+#include <deque>
+#include <thread>
+
+namespace Photon
+{
+	static constexpr size_t DequeCapacity = 4096;
+
+	struct JobSystemData
+	{
+		std::atomic<bool> Running = false;
+
+		// Index 0 belongs to the thread that called Init
+		std::vector<std::unique_ptr<WorkStealingDeque<Job>>> Queues;
+		std::vector<std::thread> Workers;
+
+		std::mutex InjectionMutex;
+		std::deque<Job> InjectionQueue;
+		std::atomic<size_t> InjectionSize = 0;
+
+		// Idle workers sleep on WorkEpoch, which is bumped whenever work is added
+		std::atomic<uint32_t> WorkEpoch = 0;
+		std::atomic<uint32_t> Sleeping = 0;
+	};
+
+	static JobSystemData s_Data;
+
+	// Deque owned by the current thread, -1 for threads outside the job system
+	static thread_local int32_t t_QueueIndex = -1;
+
+	void JobSystem::Init(uint32_t workerCount)
+	{
+		PT_PROFILE_FUNCTION();
+
+		PT_CORE_ASSERT(!s_Data.Running, "JobSystem already initialized!");
+
+		if (workerCount == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		for (uint32_t i = 0; i < workerCount + 1; i++)
+			s_Data.Queues.push_back(std::make_unique<WorkStealingDeque<Job>>(DequeCapacity));
+
+		t_QueueIndex = 0;
+		s_Data.Running = true;
+
+		for (uint32_t i = 1; i <= workerCount; i++)
+			s_Data.Workers.emplace_back(&JobSystem::WorkerThread, i);
+
+		PT_CORE_INFO("JobSystem started with {0} workers", workerCount);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		PT_PROFILE_FUNCTION();
+
+		if (!s_Data.Running)
+			return;
+
+		// Finish everything that was already scheduled
+		while (RunOne())
+			;
+
+		s_Data.Running = false;
+		s_Data.WorkEpoch.fetch_add(1);
+		s_Data.WorkEpoch.notify_all();
+
+		for (std::thread& worker : s_Data.Workers)
+			worker.join();
+
+		// Jobs the workers were running may have queued continuations before
+		// they stopped. Continuations submitted from here on run inline
+		while (RunOne())
+			;
+
+		s_Data.Workers.clear();
+		s_Data.Queues.clear();
+		s_Data.InjectionQueue.clear();
+		s_Data.InjectionSize = 0;
+		t_QueueIndex = -1;
+	}
+
+	bool JobSystem::IsInitialized()
+	{
+		return s_Data.Running.load(std::memory_order_relaxed);
+	}
+
+	uint32_t JobSystem::GetWorkerCount()
+	{
+		return (uint32_t)s_Data.Workers.size();
+	}
+
+	int32_t JobSystem::GetThreadIndex()
+	{
+		return t_QueueIndex;
+	}
+
+	void JobSystem::Schedule(const Job& job, JobCounter& counter, JobCounter* dependency)
+	{
+		counter.m_Value.fetch_add(1, std::memory_order_relaxed);
+
+		Job scheduled = job;
+		scheduled.Counter = &counter;
+
+		if (dependency)
+		{
+			// Finish takes the continuations under this lock once the value
+			// is zero, so deciding on the value here either queues the job
+			// before they are taken or submits it right away. Checking
+			// IsDone would queue it while the last job is still finishing,
+			// after its continuations were taken
+			std::lock_guard lock(dependency->m_ContinuationMutex);
+			if (dependency->m_Value.load() != 0)
+			{
+				dependency->m_Continuations.push_back(scheduled);
+				return;
+			}
+		}
+
+		Submit(scheduled);
+	}
+
+	void JobSystem::Submit(const Job& job)
+	{
+		if (!s_Data.Running.load(std::memory_order_relaxed))
+		{
+			Execute(job);
+			return;
+		}
+
+		int32_t index = t_QueueIndex;
+		if (index >= 0)
+		{
+			// A full deque means the system is saturated, running the job here
+			// is as good as queueing it
+			if (!s_Data.Queues[index]->Push(job))
+			{
+				Execute(job);
+				return;
+			}
+		}
+		else
+		{
+			std::lock_guard lock(s_Data.InjectionMutex);
+			s_Data.InjectionQueue.push_back(job);
+			s_Data.InjectionSize.fetch_add(1);
+		}
+
+		s_Data.WorkEpoch.fetch_add(1);
+		if (s_Data.Sleeping.load() > 0)
+			s_Data.WorkEpoch.notify_one();
+	}
+
+	void JobSystem::Execute(const Job& job)
+	{
+		job.Function(job.Data, job.Begin, job.End);
+
+		if (job.Counter)
+			Finish(*job.Counter);
+	}
+
+	void JobSystem::Finish(JobCounter& counter)
+	{
+		counter.m_Finishing.fetch_add(1);
+
+		if (counter.m_Value.fetch_sub(1) == 1)
+		{
+			std::vector<Job> continuations;
+			{
+				std::lock_guard lock(counter.m_ContinuationMutex);
+				continuations.swap(counter.m_Continuations);
+			}
+
+			for (const Job& job : continuations)
+				Submit(job);
+		}
+
+		// The counter must not be touched after this
+		counter.m_Finishing.fetch_sub(1);
+	}
+
+	bool JobSystem::RunOne()
+	{
+		Job job;
+		int32_t index = t_QueueIndex;
+
+		if (index >= 0 && s_Data.Queues[index]->Pop(job))
+		{
+			Execute(job);
+			return true;
+		}
+
+		// Steal, starting after our own deque so thieves spread out
+		size_t queueCount = s_Data.Queues.size();
+		size_t start = index >= 0 ? (size_t)index + 1 : 0;
+		for (size_t i = 0; i < queueCount; i++)
+		{
+			size_t victim = (start + i) % queueCount;
+			if ((int32_t)victim != index && s_Data.Queues[victim]->Steal(job))
+			{
+				Execute(job);
+				return true;
+			}
+		}
+
+		if (s_Data.InjectionSize.load() > 0)
+		{
+			bool found = false;
+			{
+				std::lock_guard lock(s_Data.InjectionMutex);
+				if (!s_Data.InjectionQueue.empty())
+				{
+					job = s_Data.InjectionQueue.front();
+					s_Data.InjectionQueue.pop_front();
+					s_Data.InjectionSize.fetch_sub(1);
+					found = true;
+				}
+			}
+
+			if (found)
+			{
+				Execute(job);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void JobSystem::Wait(const JobCounter& counter)
+	{
+		while (!counter.IsDone())
+		{
+			if (!RunOne())
+				std::this_thread::yield();
+		}
+	}
+
+	static bool HasWork()
+	{
+		if (s_Data.InjectionSize.load() > 0)
+			return true;
+
+		for (auto& queue : s_Data.Queues)
+		{
+			if (!queue->Empty())
+				return true;
+		}
+
+		return false;
+	}
+
+	void JobSystem::WorkerThread(uint32_t index)
+	{
+		t_QueueIndex = (int32_t)index;
+
+		while (s_Data.Running.load(std::memory_order_relaxed))
+		{
+			if (RunOne())
+				continue;
+
+			s_Data.Sleeping.fetch_add(1);
+			uint32_t epoch = s_Data.WorkEpoch.load();
+			if (!HasWork() && s_Data.Running.load())
+				s_Data.WorkEpoch.wait(epoch);
+			s_Data.Sleeping.fetch_sub(1);
+		}
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "Photon/Core.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Photon
+{
+	class JobCounter;
+
+	// A unit of work. Function is called with Data and the [Begin, End) range
+	// the job covers, which lets one function pointer serve a batched loop.
+	// Jobs are plain data so scheduling them never allocates
+	struct Job
+	{
+		void (*Function)(void* data, uint32_t begin, uint32_t end) = nullptr;
+		void* Data = nullptr;
+		uint32_t Begin = 0, End = 0;
+
+		JobCounter* Counter = nullptr;
+	};
+
+	// Number of unfinished jobs in a group. Waiting on a counter runs other
+	// jobs in the meantime, and jobs can be scheduled to start only once a
+	// counter reaches zero
+	class PHOTON_API JobCounter
+	{
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		inline bool IsDone() const
+		{
+			return m_Value.load() == 0 && m_Finishing.load() == 0;
+		}
+	private:
+		std::atomic<uint32_t> m_Value = 0;
+		// Jobs currently inside JobSystem::Finish. A waiter may destroy the
+		// counter once it is done, so it isn't until these have left
+		std::atomic<uint32_t> m_Finishing = 0;
+
+		std::mutex m_ContinuationMutex;
+		std::vector<Job> m_Continuations;
+
+		friend class JobSystem;
+	};
+
+	// Engine-wide job system with one worker per hardware thread. The thread
+	// that calls Init (the main thread) takes part in the work while it waits.
+	// Every participating thread owns a Chase-Lev work stealing deque, other
+	// threads submit through a locked injection queue.
+	class PHOTON_API JobSystem
+	{
+	public:
+		// workerCount 0 uses one worker per hardware thread besides the main thread
+		static void Init(uint32_t workerCount = 0);
+		static void Shutdown();
+
+		static bool IsInitialized();
+		static uint32_t GetWorkerCount();
+		// 0 for the thread that called Init, 1 to GetWorkerCount() for the
+		// workers and -1 for threads outside the job system. Lets jobs pick
+		// per thread resources without locking
+		static int32_t GetThreadIndex();
+
+		// Runs job once dependency (if any) is done. Without a job system the
+		// job runs immediately on the calling thread
+		static void Schedule(const Job& job, JobCounter& counter, JobCounter* dependency = nullptr);
+
+		// Runs func() as a job. func must stay alive until counter is done
+		template<typename F>
+		static void Run(F& func, JobCounter& counter, JobCounter* dependency = nullptr)
+		{
+			Job job;
+			job.Function = [](void* data, uint32_t, uint32_t) { (*(F*)data)(); };
+			job.Data = (void*)&func;
+			Schedule(job, counter, dependency);
+		}
+
+		// Calls func(i) for every i in [0, count) in batches of batchSize and
+		// returns once all of them are done
+		template<typename F>
+		static void ParallelFor(uint32_t count, uint32_t batchSize, const F& func)
+		{
+			if (batchSize == 0)
+				batchSize = 1;
+
+			JobCounter counter;
+
+			Job job;
+			job.Function = [](void* data, uint32_t begin, uint32_t end)
+			{
+				const F& f = *(const F*)data;
+				for (uint32_t i = begin; i < end; i++)
+					f(i);
+			};
+			job.Data = (void*)&func;
+
+			for (uint32_t begin = 0; begin < count; begin += batchSize)
+			{
+				job.Begin = begin;
+				job.End = count - begin > batchSize ? begin + batchSize : count;
+				Schedule(job, counter);
+			}
+
+			Wait(counter);
+		}
+
+		// Runs other jobs until counter is done
+		static void Wait(const JobCounter& counter);
+	private:
+		static void Execute(const Job& job);
+		static void Finish(JobCounter& counter);
+		static void Submit(const Job& job);
+		static bool RunOne();
+		static void WorkerThread(uint32_t index);
+	};
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace Photon
+{
+	// Fixed capacity Chase-Lev deque (Le et al., "Correct and Efficient
+	// Work-Stealing for Weak Memory Models"). The owning thread pushes and
+	// pops at the bottom, any other thread steals from the top.
+	//
+	// A thief may read a slot that the owner is overwriting, its CAS on the
+	// top then fails and the torn copy is thrown away. Slots are stored as
+	// relaxed atomic words so that read is still well defined.
+	template<typename T>
+	class WorkStealingDeque
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque items are copied word by word");
+	public:
+		WorkStealingDeque(size_t capacity)
+			: m_Buffer(std::make_unique<Slot[]>(capacity)), m_Mask((int64_t)capacity - 1)
+		{
+			// capacity must be a power of two
+		}
+
+		// Owner only. Returns false when full
+		bool Push(const T& item)
+		{
+			int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+			int64_t top = m_Top.load(std::memory_order_acquire);
+			if (bottom - top > m_Mask)
+				return false;
+
+			Store(bottom, item);
+			m_Bottom.store(bottom + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Owner only
+		bool Pop(T& item)
+		{
+			int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+			m_Bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = m_Top.load(std::memory_order_relaxed);
+
+			if (top > bottom)
+			{
+				m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			item = Load(bottom);
+			if (top == bottom)
+			{
+				// Last item, race against thieves for it
+				bool won = m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+				return won;
+			}
+
+			return true;
+		}
+
+		// Any thread
+		bool Steal(T& item)
+		{
+			int64_t top = m_Top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+				return false;
+
+			item = Load(top);
+			return m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		}
+
+		inline bool Empty() const
+		{
+			return m_Top.load(std::memory_order_acquire) >= m_Bottom.load(std::memory_order_acquire);
+		}
+	private:
+		static constexpr size_t SlotWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+		struct Slot { std::atomic<uint64_t> Words[SlotWords]; };
+
+		inline void Store(int64_t index, const T& item)
+		{
+			uint64_t words[SlotWords] = {};
+			std::memcpy(words, &item, sizeof(T));
+			Slot& slot = m_Buffer[index & m_Mask];
+			for (size_t i = 0; i < SlotWords; i++)
+				slot.Words[i].store(words[i], std::memory_order_relaxed);
+		}
+
+		inline T Load(int64_t index) const
+		{
+			uint64_t words[SlotWords];
+			const Slot& slot = m_Buffer[index & m_Mask];
+			for (size_t i = 0; i < SlotWords; i++)
+				words[i] = slot.Words[i].load(std::memory_order_relaxed);
+
+			T item;
+			std::memcpy(&item, words, sizeof(T));
+			return item;
+		}
+
+	private:
+		std::unique_ptr<Slot[]> m_Buffer;
+		int64_t m_Mask;
+
+		alignas(64) std::atomic<int64_t> m_Top = 0;
+		alignas(64) std::atomic<int64_t> m_Bottom = 0;
+	};
+}
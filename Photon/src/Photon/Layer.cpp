@@ -1,11 +1,18 @@
 #include "ptpch.h"
 #include "Layer.h"
 
+#include "Debug/Instrumentor.h"
+
 namespace Photon
 {
 	Layer::Layer(const std::string& name)
 		: m_DebugName(name)
 	{
+#if PT_PROFILE
+		m_ProfileUpdateName = Instrumentor::Get().InternName(name + "::OnUpdate");
+		m_ProfileFixedUpdateName = Instrumentor::Get().InternName(name + "::OnFixedUpdate");
+		m_ProfileEventName = Instrumentor::Get().InternName(name + "::OnEvent");
+#endif
 	}
 
 	Layer::~Layer()
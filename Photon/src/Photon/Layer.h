@@ -1,9 +1,23 @@
 #pragma once
 #include "Core.h"
 #include "Events/Event.h"
+#include "Timestep.h"
 
 namespace Photon
 {
+	class Histogram;
+
+	// Which of a layer's per-frame hooks are worth calling. The LayerStack
+	// keeps a dense list per hook so layers that don't override one are
+	// never visited for it
+	enum LayerHook
+	{
+		LayerHookUpdate      = BIT(0),
+		LayerHookFixedUpdate = BIT(1),
+		LayerHookEvent       = BIT(2),
+		LayerHookAll         = LayerHookUpdate | LayerHookFixedUpdate | LayerHookEvent
+	};
+
 	class PHOTON_API Layer
 	{
 	public:
@@ -13,12 +27,43 @@ namespace Photon
 
 		virtual void OnAttach() {}
 		virtual void OnDetach() {}
-		virtual void OnUpdate() {}
+		virtual void OnUpdate(Timestep ts) {}
+		// Called zero or more times per frame at the application's fixed
+		// timestep, before OnUpdate. Only used when a fixed timestep is set
+		virtual void OnFixedUpdate(Timestep ts) {}
 		virtual void OnEvent(Event& event) {}
 
 		inline const std::string& GetName() const { return m_DebugName; }
 
+		inline bool IsIndependent() const { return m_Independent; }
+		inline int GetHooks() const { return m_Hooks; }
+		inline int GetEventCategories() const { return m_EventCategories; }
+	protected:
+		// Independent layers have OnUpdate run as a job, concurrently with the
+		// other layers, and joined before the frame ends. Such a layer must not
+		// touch state shared with other layers during OnUpdate
+		inline void SetIndependent(bool independent) { m_Independent = independent; }
+
+		// Only events in one of these categories (EventCategory flags) reach
+		// OnEvent. Every category by default
+		inline void SetEventCategories(int categories) { m_EventCategories = categories; }
+
 	private:
 		std::string m_DebugName;
+		bool m_Independent = false;
+		// Set by the LayerStack when the layer is pushed
+		int m_Hooks = LayerHookAll;
+		int m_EventCategories = ~0;
+
+		// Interned "<name>::OnUpdate" etc. profiler scope names
+		const char* m_ProfileUpdateName = "Layer::OnUpdate";
+		const char* m_ProfileFixedUpdateName = "Layer::OnFixedUpdate";
+		const char* m_ProfileEventName = "Layer::OnEvent";
+
+		// "layer.<name>.update_ns", looked up on the first update
+		Histogram* m_UpdateMetric = nullptr;
+
+		friend class Application;
+		friend class LayerStack;
 	};
 }
\ No newline at end of file
@@ -1,44 +1,185 @@
 #include "ptpch.h"
 #include "LayerStack.h"
 
+#include "Memory/Memory.h"
+
 namespace Photon
 {
+	static constexpr size_t StorageBlockSize = 4096;
+	static constexpr size_t StorageAlignment = 64;
+
 	LayerStack::LayerStack()
 	{
-		m_LayerInsert = m_Layers.begin();
 	}
 
 	LayerStack::~LayerStack()
 	{
 		for (Layer* layer : m_Layers)
-			delete layer;
+		{
+			layer->OnDetach();
+			if (!Destroy(layer))
+				delete layer;
+		}
+
+		// Pushed while locked and never applied
+		for (const PendingChange& change : m_Pending)
+		{
+			if (change.Push && !Destroy(change.Target))
+				delete change.Target;
+		}
+
+		for (const StorageBlock& block : m_Blocks)
+			Memory::Free(block.Data, block.Size, StorageAlignment, MemoryTag::Layers);
 	}
 
-	void LayerStack::PushLayer(Layer* layer)
+	void LayerStack::Push(Layer* layer, int hooks, bool overlay)
 	{
-		m_LayerInsert = m_Layers.emplace(m_LayerInsert, layer);
+		layer->m_Hooks = hooks;
+
+		PendingChange change = { layer, true, overlay };
+		if (m_LockCount > 0)
+			m_Pending.push_back(change);
+		else
+			Apply(change);
 	}
 
-	void LayerStack::PushOverlay(Layer* overlay)
+	void LayerStack::Pop(Layer* layer)
 	{
-		m_Layers.emplace_back(overlay);
+		PendingChange change = { layer, false, false };
+		if (m_LockCount > 0)
+			m_Pending.push_back(change);
+		else
+			Apply(change);
 	}
 
 	void LayerStack::PopLayer(Layer* layer)
 	{
+		Pop(layer);
+	}
+
+	void LayerStack::PopOverlay(Layer* overlay)
+	{
+		Pop(overlay);
+	}
+
+	void LayerStack::Lock()
+	{
+		m_LockCount++;
+	}
+
+	void LayerStack::Unlock()
+	{
+		PT_CORE_ASSERT(m_LockCount > 0, "LayerStack is not locked");
+		if (--m_LockCount > 0)
+			return;
+
+		// Attach/detach can push and pop in turn, those are applied right away
+		std::vector<PendingChange> pending;
+		pending.swap(m_Pending);
+		for (const PendingChange& change : pending)
+			Apply(change);
+	}
+
+	void LayerStack::Apply(const PendingChange& change)
+	{
+		Layer* layer = change.Target;
+
+		if (change.Push)
+		{
+			if (change.Overlay)
+			{
+				m_Layers.push_back(layer);
+			}
+			else
+			{
+				m_Layers.insert(m_Layers.begin() + m_LayerInsertIndex, layer);
+				m_LayerInsertIndex++;
+			}
+
+			RebuildHookLists();
+			layer->OnAttach();
+			return;
+		}
+
 		auto it = std::find(m_Layers.begin(), m_Layers.end(), layer);
-		if (it != m_Layers.end())
+		if (it == m_Layers.end())
+			return;
+
+		if ((size_t)(it - m_Layers.begin()) < m_LayerInsertIndex)
+			m_LayerInsertIndex--;
+		m_Layers.erase(it);
+
+		RebuildHookLists();
+		layer->OnDetach();
+		Destroy(layer);
+	}
+
+	void LayerStack::RebuildHookLists()
+	{
+		m_UpdateLayers.clear();
+		m_FixedUpdateLayers.clear();
+		m_EventLayers.clear();
+
+		for (Layer* layer : m_Layers)
+		{
+			if (layer->m_Hooks & LayerHookUpdate)
+				m_UpdateLayers.push_back(layer);
+			if (layer->m_Hooks & LayerHookFixedUpdate)
+				m_FixedUpdateLayers.push_back(layer);
+		}
+
+		for (auto it = m_Layers.rbegin(); it != m_Layers.rend(); ++it)
 		{
-			m_Layers.erase(it);
-			m_LayerInsert--;
+			if ((*it)->m_Hooks & LayerHookEvent)
+				m_EventLayers.push_back(*it);
 		}
 	}
 
-	void LayerStack::PopOverlay(Layer* overlay)
+	bool LayerStack::Destroy(Layer* layer)
 	{
-		auto it = std::find(m_Layers.begin(), m_Layers.end(), overlay);
-		if (it != m_Layers.end())
-			m_Layers.erase(it);
+		auto it = std::find_if(m_Storage.begin(), m_Storage.end(), [layer](const StorageSlot& slot) { return slot.Owner == layer; });
+		if (it == m_Storage.end())
+			return false;
+
+		StorageSlot slot = *it;
+		m_Storage.erase(it);
+
+		layer->~Layer();
+		slot.Owner = nullptr;
+		m_FreeStorage.push_back(slot);
+		return true;
 	}
-}
 
+	void* LayerStack::AllocateStorage(size_t& size, size_t alignment)
+	{
+		for (auto it = m_FreeStorage.begin(); it != m_FreeStorage.end(); ++it)
+		{
+			if (it->Size >= size && ((uintptr_t)it->Memory & (alignment - 1)) == 0)
+			{
+				void* memory = it->Memory;
+				size = it->Size;
+				m_FreeStorage.erase(it);
+				return memory;
+			}
+		}
+
+		if (size > StorageBlockSize)
+		{
+			// Too big to share a block, give the layer a block of its own
+			uint8_t* block = (uint8_t*)Memory::Allocate(size, StorageAlignment, MemoryTag::Layers);
+			m_Blocks.push_back({ block, size });
+			return block;
+		}
+
+		size_t offset = (m_BlockOffset + alignment - 1) & ~(alignment - 1);
+		if (!m_CurrentBlock || offset + size > StorageBlockSize)
+		{
+			m_CurrentBlock = (uint8_t*)Memory::Allocate(StorageBlockSize, StorageAlignment, MemoryTag::Layers);
+			m_Blocks.push_back({ m_CurrentBlock, StorageBlockSize });
+			offset = 0;
+		}
+
+		m_BlockOffset = offset + size;
+		return m_CurrentBlock + offset;
+	}
+}
@@ -2,26 +2,146 @@
 #include "Core.h"
 #include "Layer.h"
 
+#include <typeinfo>
+
 namespace Photon
 {
+	// Layers are updated front to back and receive events back to front,
+	// overlays always sit after the regular layers.
+	//
+	// While the stack is locked (the application holds the lock for the whole
+	// frame) pushes and pops are queued and applied in order once it is
+	// unlocked, so layers are free to push and pop from their own hooks.
+	// OnAttach and OnDetach are called when a change is applied.
+	//
+	// Hooks a layer doesn't override are detected when it is pushed and the
+	// layer is left out of that hook's list. Detection uses the static type
+	// passed in, so the overrides have to be public.
 	class PHOTON_API LayerStack
 	{
 	public:
 		LayerStack();
 		~LayerStack();
 
-		void PushLayer(Layer* layer);
-		void PushOverlay(Layer* overlay);
+		LayerStack(const LayerStack&) = delete;
+		LayerStack& operator=(const LayerStack&) = delete;
+
+		// The stack owns the layer until it is popped
+		template<typename T>
+		void PushLayer(T* layer) { Push(layer, DetectHooks<T>(layer), false); }
+		template<typename T>
+		void PushOverlay(T* overlay) { Push(overlay, DetectHooks<T>(overlay), true); }
+
+		// Constructs the layer in storage owned by the stack. Popping it
+		// destroys it, the pointer must not be used after that
+		template<typename T, typename... Args>
+		T* EmplaceLayer(Args&&... args) { return Emplace<T>(false, std::forward<Args>(args)...); }
+		template<typename T, typename... Args>
+		T* EmplaceOverlay(Args&&... args) { return Emplace<T>(true, std::forward<Args>(args)...); }
+
+		// A popped layer that was pushed by pointer is handed back to the
+		// caller, who is then responsible for deleting it
 		void PopLayer(Layer* layer);
 		void PopOverlay(Layer* overlay);
 
+		// Locks nest, changes are applied when the outermost lock is released
+		void Lock();
+		void Unlock();
+
+		inline const std::vector<Layer*>& GetUpdateLayers() const { return m_UpdateLayers; }
+		inline const std::vector<Layer*>& GetFixedUpdateLayers() const { return m_FixedUpdateLayers; }
+		// In dispatch order, the top overlay first
+		inline const std::vector<Layer*>& GetEventLayers() const { return m_EventLayers; }
+
 		std::vector<Layer*>::iterator begin() { return m_Layers.begin(); }
 		std::vector<Layer*>::iterator end() { return m_Layers.end(); }
 		
 		std::vector<Layer*>::reverse_iterator rbegin() { return m_Layers.rbegin(); }
 		std::vector<Layer*>::reverse_iterator rend() { return m_Layers.rend(); }
+	private:
+		struct PendingChange
+		{
+			Layer* Target;
+			bool Push;
+			bool Overlay;
+		};
+
+		// A block of stack owned storage holding one emplaced layer
+		struct StorageSlot
+		{
+			Layer* Owner;
+			void* Memory;
+			size_t Size;
+		};
+
+		template<typename T>
+		static int DetectHooks(T* layer)
+		{
+			static_assert(std::is_base_of_v<Layer, T>, "Layers must derive from Photon::Layer");
+
+			// Pushed through a base pointer, the overrides can't be seen
+			if constexpr (std::is_same_v<T, Layer>)
+				return LayerHookAll;
+			else
+			{
+				if (typeid(*layer) != typeid(T))
+					return LayerHookAll;
+
+				// A hook T doesn't override still names Layer's own member
+				int hooks = 0;
+				if constexpr (!std::is_same_v<decltype(&T::OnUpdate), decltype(&Layer::OnUpdate)>)
+					hooks |= LayerHookUpdate;
+				if constexpr (!std::is_same_v<decltype(&T::OnFixedUpdate), decltype(&Layer::OnFixedUpdate)>)
+					hooks |= LayerHookFixedUpdate;
+				if constexpr (!std::is_same_v<decltype(&T::OnEvent), decltype(&Layer::OnEvent)>)
+					hooks |= LayerHookEvent;
+				return hooks;
+			}
+		}
+
+		template<typename T, typename... Args>
+		T* Emplace(bool overlay, Args&&... args)
+		{
+			size_t size = sizeof(T);
+			void* storage = AllocateStorage(size, alignof(T));
+			T* layer = new (storage) T(std::forward<Args>(args)...);
+			m_Storage.push_back({ layer, storage, size });
+			Push(layer, DetectHooks<T>(layer), overlay);
+			return layer;
+		}
+
+		void Push(Layer* layer, int hooks, bool overlay);
+		void Pop(Layer* layer);
+		void Apply(const PendingChange& change);
+		// Destroys an emplaced layer, returns false for layers pushed by pointer
+		bool Destroy(Layer* layer);
+		void RebuildHookLists();
+
+		// size is raised to the size of the slot handed out
+		void* AllocateStorage(size_t& size, size_t alignment);
 	private:
 		std::vector<Layer*> m_Layers;
-		std::vector<Layer*>::iterator m_LayerInsert;
+		size_t m_LayerInsertIndex = 0;
+
+		std::vector<Layer*> m_UpdateLayers;
+		std::vector<Layer*> m_FixedUpdateLayers;
+		std::vector<Layer*> m_EventLayers;
+
+		uint32_t m_LockCount = 0;
+		std::vector<PendingChange> m_Pending;
+
+		// Emplaced layers are bump allocated from fixed size blocks, memory
+		// of popped layers is reused by later emplaces that fit
+		struct StorageBlock
+		{
+			uint8_t* Data;
+			size_t Size;
+		};
+
+		std::vector<StorageBlock> m_Blocks;
+		uint8_t* m_CurrentBlock = nullptr;
+		size_t m_BlockOffset = 0;
+		std::vector<StorageSlot> m_Storage;
+		std::vector<StorageSlot> m_FreeStorage;
 	};
-}
\ No newline at end of file
+}
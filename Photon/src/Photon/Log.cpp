@@ -1,21 +1,63 @@
 #include "ptpch.h"
 
 #include "Log.h"
+#include "AsyncLogSink.h"
 
 #include "spdlog/sinks/stdout_color_sinks.h"
+#include "spdlog/sinks/basic_file_sink.h"
 
 namespace Photon
 {
 	std::shared_ptr<spdlog::logger> Log::s_CoreLogger;
 	std::shared_ptr<spdlog::logger> Log::s_ClientLogger;
+	std::shared_ptr<AsyncLogSink> Log::s_AsyncSink;
 
-	void Log::Init()
+	void Log::Init(const LogConfig& config)
 	{
-		spdlog::set_pattern("%^[%T] %n: %v%$");
-		s_CoreLogger = spdlog::stdout_color_mt("PHOTON");
+		std::vector<spdlog::sink_ptr> sinks;
+		if (config.Console)
+			sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+		if (!config.FilePath.empty())
+			sinks.push_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>(config.FilePath, true));
+
+		if (config.Async)
+		{
+			// Both loggers share one queue and writer thread
+			s_AsyncSink = std::make_shared<AsyncLogSink>(std::move(sinks), config.QueueSize, config.OverflowPolicy);
+			sinks = { s_AsyncSink };
+		}
+
+		s_CoreLogger = std::make_shared<spdlog::logger>("PHOTON", sinks.begin(), sinks.end());
 		s_CoreLogger->set_level(spdlog::level::trace);
+		s_CoreLogger->flush_on(spdlog::level::err);
+		spdlog::register_logger(s_CoreLogger);
 
-		s_ClientLogger = spdlog::stdout_color_mt("APP");
+		s_ClientLogger = std::make_shared<spdlog::logger>("APP", sinks.begin(), sinks.end());
 		s_ClientLogger->set_level(spdlog::level::trace);
+		s_ClientLogger->flush_on(spdlog::level::err);
+		spdlog::register_logger(s_ClientLogger);
+
+		spdlog::set_pattern("%^[%T] %n: %v%$");
+	}
+
+	void Log::Shutdown()
+	{
+		// Only asks the async writer to flush, it is joined below
+		if (s_CoreLogger)
+			s_CoreLogger->flush();
+		if (s_ClientLogger)
+			s_ClientLogger->flush();
+
+		spdlog::drop_all();
+		s_CoreLogger.reset();
+		s_ClientLogger.reset();
+
+		// Joins the writer thread once everything queued has been written
+		s_AsyncSink.reset();
+	}
+
+	uint64_t Log::GetDroppedMessageCount()
+	{
+		return s_AsyncSink ? s_AsyncSink->GetDroppedCount() : 0;
 	}
-}
\ No newline at end of file
+}
@@ -7,32 +7,112 @@
 
 namespace Photon
 {
+	class AsyncLogSink;
+
+	// What an async logger does when its queue is full
+	enum class LogOverflowPolicy
+	{
+		Block,           // Wait for the writer thread to make room
+		Drop,            // Discard the new message
+		OverwriteOldest  // Discard the oldest queued message
+	};
+
+	struct LogConfig
+	{
+		// Write from a background thread instead of the calling thread
+		bool Async = true;
+		size_t QueueSize = 8192;
+		LogOverflowPolicy OverflowPolicy = LogOverflowPolicy::Block;
+
+		// Log to stdout. Can be turned off when only FilePath is wanted
+		bool Console = true;
+		// Also log to this file when set
+		std::string FilePath;
+	};
+
 	class PHOTON_API Log
 	{
 	public:
-		static void Init();
+		static void Init(const LogConfig& config = LogConfig());
+		static void Shutdown();
 
 		inline static std::shared_ptr<spdlog::logger>& GetCoreLogger() { return s_CoreLogger; }
 		inline static std::shared_ptr<spdlog::logger>& GetClientLogger() { return s_ClientLogger; }
 
+		static uint64_t GetDroppedMessageCount();
 	private:
 		static std::shared_ptr<spdlog::logger> s_CoreLogger;
 		static std::shared_ptr<spdlog::logger> s_ClientLogger;
+
+		static std::shared_ptr<AsyncLogSink> s_AsyncSink;
 	};
 }
 
+// Log calls below PT_LOG_ACTIVE_LEVEL are compiled out entirely, their
+// arguments are not evaluated
+#define PT_LOG_LEVEL_TRACE 0
+#define PT_LOG_LEVEL_INFO  1
+#define PT_LOG_LEVEL_WARN  2
+#define PT_LOG_LEVEL_ERROR 3
+#define PT_LOG_LEVEL_FATAL 4
+#define PT_LOG_LEVEL_OFF   5
+
+#ifndef PT_LOG_ACTIVE_LEVEL
+	#if defined(PT_RELEASE) || defined(PT_DIST)
+		#define PT_LOG_ACTIVE_LEVEL PT_LOG_LEVEL_WARN
+	#else
+		#define PT_LOG_ACTIVE_LEVEL PT_LOG_LEVEL_TRACE
+	#endif
+#endif
+
+#define PT_LOG_STRIPPED(...) (void)0
+
+// Reports asked for on the command line (--benchmark, --record, --metrics,
+// the memory reports), logged at INFO but kept at every level except OFF
+#if PT_LOG_ACTIVE_LEVEL < PT_LOG_LEVEL_OFF
+	#define PT_CORE_REPORT(...)  ::Photon::Log::GetCoreLogger()->info(__VA_ARGS__)
+#else
+	#define PT_CORE_REPORT(...)  PT_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
 // Core log macros
-#define PT_CORE_TRACE(...)   ::Photon::Log::GetCoreLogger()->trace(__VA_ARGS__)
-#define PT_CORE_INFO(...)    ::Photon::Log::GetCoreLogger()->info(__VA_ARGS__)
-#define PT_CORE_WARN(...)    ::Photon::Log::GetCoreLogger()->warn(__VA_ARGS__)
-#define PT_CORE_ERROR(...)   ::Photon::Log::GetCoreLogger()->error(__VA_ARGS__)
-#define PT_CORE_FATAL(...)   ::Photon::Log::GetCoreLogger()->fatal(__VA_ARGS__)
-
-// Client log macros
-#define PT_TRACE(...)   ::Photon::Log::GetClientLogger()->trace(__VA_ARGS__)
-#define PT_INFO(...)    ::Photon::Log::GetClientLogger()->info(__VA_ARGS__)
-#define PT_WARN(...)    ::Photon::Log::GetClientLogger()->warn(__VA_ARGS__)
-#define PT_ERROR(...)   ::Photon::Log::GetClientLogger()->error(__VA_ARGS__)
-#define PT_FATAL(...)   ::Photon::Log::GetClientLogger()->fatal(__VA_ARGS__)
+#if PT_LOG_ACTIVE_LEVEL <= PT_LOG_LEVEL_TRACE
+	#define PT_CORE_TRACE(...)   ::Photon::Log::GetCoreLogger()->trace(__VA_ARGS__)
+	#define PT_TRACE(...)        ::Photon::Log::GetClientLogger()->trace(__VA_ARGS__)
+#else
+	#define PT_CORE_TRACE(...)   PT_LOG_STRIPPED(__VA_ARGS__)
+	#define PT_TRACE(...)        PT_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if PT_LOG_ACTIVE_LEVEL <= PT_LOG_LEVEL_INFO
+	#define PT_CORE_INFO(...)    ::Photon::Log::GetCoreLogger()->info(__VA_ARGS__)
+	#define PT_INFO(...)         ::Photon::Log::GetClientLogger()->info(__VA_ARGS__)
+#else
+	#define PT_CORE_INFO(...)    PT_LOG_STRIPPED(__VA_ARGS__)
+	#define PT_INFO(...)         PT_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if PT_LOG_ACTIVE_LEVEL <= PT_LOG_LEVEL_WARN
+	#define PT_CORE_WARN(...)    ::Photon::Log::GetCoreLogger()->warn(__VA_ARGS__)
+	#define PT_WARN(...)         ::Photon::Log::GetClientLogger()->warn(__VA_ARGS__)
+#else
+	#define PT_CORE_WARN(...)    PT_LOG_STRIPPED(__VA_ARGS__)
+	#define PT_WARN(...)         PT_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if PT_LOG_ACTIVE_LEVEL <= PT_LOG_LEVEL_ERROR
+	#define PT_CORE_ERROR(...)   ::Photon::Log::GetCoreLogger()->error(__VA_ARGS__)
+	#define PT_ERROR(...)        ::Photon::Log::GetClientLogger()->error(__VA_ARGS__)
+#else
+	#define PT_CORE_ERROR(...)   PT_LOG_STRIPPED(__VA_ARGS__)
+	#define PT_ERROR(...)        PT_LOG_STRIPPED(__VA_ARGS__)
+#endif
 
+#if PT_LOG_ACTIVE_LEVEL <= PT_LOG_LEVEL_FATAL
+	#define PT_CORE_FATAL(...)   ::Photon::Log::GetCoreLogger()->critical(__VA_ARGS__)
+	#define PT_FATAL(...)        ::Photon::Log::GetClientLogger()->critical(__VA_ARGS__)
+#else
+	#define PT_CORE_FATAL(...)   PT_LOG_STRIPPED(__VA_ARGS__)
+	#define PT_FATAL(...)        PT_LOG_STRIPPED(__VA_ARGS__)
+#endif
 
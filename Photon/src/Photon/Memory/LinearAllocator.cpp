@@ -0,0 +1,66 @@
+#include "ptpch.h"
+#include "LinearAllocator.h"
+
+namespace Photon
+{
+	static constexpr size_t BufferAlignment = 64;
+
+	LinearAllocator::LinearAllocator(size_t capacity, MemoryTag tag)
+		: m_Capacity(capacity), m_Tag(tag)
+	{
+		m_Buffer = (uint8_t*)Memory::Allocate(m_Capacity, BufferAlignment, m_Tag);
+	}
+
+	LinearAllocator::~LinearAllocator()
+	{
+		// Not Reset, that would grow the buffer only to free it again
+		FreeOverflow();
+		Memory::Free(m_Buffer, m_Capacity, BufferAlignment, m_Tag);
+	}
+
+	void* LinearAllocator::Allocate(size_t size, size_t alignment)
+	{
+		PT_CORE_ASSERT(alignment <= BufferAlignment && (alignment & (alignment - 1)) == 0, "Unsupported alignment");
+
+		size_t offset = (m_Offset + alignment - 1) & ~(alignment - 1);
+		if (offset + size <= m_Capacity)
+		{
+			m_Offset = offset + size;
+			return m_Buffer + offset;
+		}
+
+		// Out of room, this block is freed on Reset
+		OverflowBlock block = { (uint8_t*)Memory::Allocate(size, BufferAlignment, m_Tag), size };
+		m_Overflow.push_back(block);
+		m_OverflowBytes += size;
+		return block.Data;
+	}
+
+	void LinearAllocator::Reset()
+	{
+		m_HighWater = std::max(m_HighWater, GetUsed());
+
+		if (!m_Overflow.empty())
+		{
+			FreeOverflow();
+
+			// Grow with some headroom so a slowly rising peak doesn't
+			// reallocate every frame
+			size_t capacity = m_HighWater + m_HighWater / 2;
+			Memory::Free(m_Buffer, m_Capacity, BufferAlignment, m_Tag);
+			m_Buffer = (uint8_t*)Memory::Allocate(capacity, BufferAlignment, m_Tag);
+			m_Capacity = capacity;
+			PT_CORE_TRACE("LinearAllocator grown to {0} bytes", m_Capacity);
+		}
+
+		m_Offset = 0;
+		m_OverflowBytes = 0;
+	}
+
+	void LinearAllocator::FreeOverflow()
+	{
+		for (const OverflowBlock& block : m_Overflow)
+			Memory::Free(block.Data, block.Size, BufferAlignment, m_Tag);
+		m_Overflow.clear();
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Memory.h"
+
+#include <type_traits>
+#include <vector>
+
+namespace Photon
+{
+	// Bump allocator for data that lives until the next Reset, like the
+	// per-frame scratch memory the Application hands out. Allocating is a
+	// pointer bump, freeing is not possible, and destructors are never run.
+	//
+	// When a frame needs more than the capacity, the extra allocations go to
+	// overflow blocks and the next Reset grows the buffer to fit, so the
+	// steady state is a single allocation-free buffer. Not thread safe.
+	class PHOTON_API LinearAllocator
+	{
+	public:
+		LinearAllocator(size_t capacity, MemoryTag tag = MemoryTag::Frame);
+		~LinearAllocator();
+
+		LinearAllocator(const LinearAllocator&) = delete;
+		LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		template<typename T, typename... Args>
+		T* New(Args&&... args)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "LinearAllocator never runs destructors");
+			return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		template<typename T>
+		T* AllocateArray(size_t count)
+		{
+			return (T*)Allocate(sizeof(T) * count, alignof(T));
+		}
+
+		void Reset();
+
+		// Bytes handed out since the last Reset, overflow included
+		inline size_t GetUsed() const { return m_Offset + m_OverflowBytes; }
+		inline size_t GetCapacity() const { return m_Capacity; }
+		// Most bytes used between two Resets
+		inline size_t GetHighWater() const { return m_HighWater; }
+	private:
+		void FreeOverflow();
+
+		struct OverflowBlock
+		{
+			uint8_t* Data;
+			size_t Size;
+		};
+
+		uint8_t* m_Buffer = nullptr;
+		size_t m_Capacity;
+		size_t m_Offset = 0;
+		MemoryTag m_Tag;
+
+		std::vector<OverflowBlock> m_Overflow;
+		size_t m_OverflowBytes = 0;
+		size_t m_HighWater = 0;
+	};
+}
@@ -0,0 +1,134 @@
+#include "ptpch.h"
+#include "Memory.h"
+
+namespace Photon
+{
+	struct TagData
+	{
+		std::atomic<uint64_t> LiveBytes = 0;
+		std::atomic<uint64_t> PeakBytes = 0;
+		std::atomic<uint64_t> LiveAllocations = 0;
+		std::atomic<uint64_t> TotalAllocations = 0;
+		std::atomic<uint64_t> Budget = 0;
+		std::atomic<bool> OverBudget = false;
+	};
+
+	static TagData s_Tags[(size_t)MemoryTag::Count];
+
+	static inline bool IsOverAligned(size_t alignment)
+	{
+		return alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+	}
+
+	void* Memory::Allocate(size_t size, size_t alignment, MemoryTag tag)
+	{
+		void* ptr = IsOverAligned(alignment)
+			? ::operator new(size, std::align_val_t(alignment))
+			: ::operator new(size);
+
+#if PT_TRACK_MEMORY
+		TagData& data = s_Tags[(size_t)tag];
+		uint64_t live = data.LiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+		data.LiveAllocations.fetch_add(1, std::memory_order_relaxed);
+		data.TotalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+		uint64_t peak = data.PeakBytes.load(std::memory_order_relaxed);
+		while (live > peak && !data.PeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+			;
+
+		uint64_t budget = data.Budget.load(std::memory_order_relaxed);
+		if (budget && live > budget && !data.OverBudget.exchange(true, std::memory_order_relaxed))
+			PT_CORE_ERROR("Memory: {0} is over its budget ({1} of {2} bytes)", GetTagName(tag), live, budget);
+#endif
+
+		return ptr;
+	}
+
+	void Memory::Free(void* ptr, size_t size, size_t alignment, MemoryTag tag)
+	{
+		if (!ptr)
+			return;
+
+		if (IsOverAligned(alignment))
+			::operator delete(ptr, std::align_val_t(alignment));
+		else
+			::operator delete(ptr);
+
+#if PT_TRACK_MEMORY
+		TagData& data = s_Tags[(size_t)tag];
+		uint64_t live = data.LiveBytes.fetch_sub(size, std::memory_order_relaxed) - size;
+		data.LiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+
+		if (data.OverBudget.load(std::memory_order_relaxed) && live <= data.Budget.load(std::memory_order_relaxed))
+			data.OverBudget.store(false, std::memory_order_relaxed);
+#endif
+	}
+
+	void Memory::SetBudget(MemoryTag tag, uint64_t bytes)
+	{
+		TagData& data = s_Tags[(size_t)tag];
+		data.Budget.store(bytes, std::memory_order_relaxed);
+		data.OverBudget.store(bytes && data.LiveBytes.load(std::memory_order_relaxed) > bytes, std::memory_order_relaxed);
+	}
+
+	bool Memory::IsOverBudget(MemoryTag tag)
+	{
+		return s_Tags[(size_t)tag].OverBudget.load(std::memory_order_relaxed);
+	}
+
+	MemoryStats Memory::GetStats(MemoryTag tag)
+	{
+		const TagData& data = s_Tags[(size_t)tag];
+
+		MemoryStats stats;
+		stats.LiveBytes = data.LiveBytes.load(std::memory_order_relaxed);
+		stats.PeakBytes = data.PeakBytes.load(std::memory_order_relaxed);
+		stats.LiveAllocations = data.LiveAllocations.load(std::memory_order_relaxed);
+		stats.TotalAllocations = data.TotalAllocations.load(std::memory_order_relaxed);
+		stats.Budget = data.Budget.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	uint64_t Memory::GetTotalAllocationCount()
+	{
+		uint64_t total = 0;
+		for (const TagData& data : s_Tags)
+			total += data.TotalAllocations.load(std::memory_order_relaxed);
+		return total;
+	}
+
+	const char* Memory::GetTagName(MemoryTag tag)
+	{
+		switch (tag)
+		{
+			case MemoryTag::General:  return "General";
+			case MemoryTag::Events:   return "Events";
+			case MemoryTag::Layers:   return "Layers";
+			case MemoryTag::ECS:      return "ECS";
+			case MemoryTag::Jobs:     return "Jobs";
+			case MemoryTag::Frame:    return "Frame";
+			case MemoryTag::Tasks:    return "Tasks";
+			case MemoryTag::Renderer: return "Renderer";
+			default:                  return "Unknown";
+		}
+	}
+
+	void Memory::LogReport()
+	{
+#if PT_TRACK_MEMORY
+		PT_CORE_REPORT("Memory report:");
+		for (size_t i = 0; i < (size_t)MemoryTag::Count; i++)
+		{
+			MemoryStats stats = GetStats((MemoryTag)i);
+			if (!stats.TotalAllocations)
+				continue;
+
+			PT_CORE_REPORT("\t{0}: {1} live bytes in {2} allocations, peak {3} bytes, {4} allocations in total",
+				GetTagName((MemoryTag)i), stats.LiveBytes, stats.LiveAllocations, stats.PeakBytes, stats.TotalAllocations);
+
+			if (stats.LiveAllocations)
+				PT_CORE_WARN("\t{0}: leaked {1} bytes in {2} allocations", GetTagName((MemoryTag)i), stats.LiveBytes, stats.LiveAllocations);
+		}
+#endif
+	}
+}
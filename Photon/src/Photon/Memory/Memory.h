@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Photon/Core.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Per tag allocation statistics, on by default outside Dist builds
+#ifndef PT_TRACK_MEMORY
+	#ifdef PT_DIST
+		#define PT_TRACK_MEMORY 0
+	#else
+		#define PT_TRACK_MEMORY 1
+	#endif
+#endif
+
+namespace Photon
+{
+	// Subsystem an allocation is charged to
+	enum class MemoryTag : uint8_t
+	{
+		General = 0,
+		Events,
+		Layers,
+		ECS,
+		Jobs,
+		Frame,
+		Tasks,
+		Renderer,
+		Count
+	};
+
+	struct MemoryStats
+	{
+		uint64_t LiveBytes = 0;
+		uint64_t PeakBytes = 0;
+		uint64_t LiveAllocations = 0;
+		uint64_t TotalAllocations = 0;
+		// 0 when the tag has no budget
+		uint64_t Budget = 0;
+	};
+
+	// Tagged heap allocation for engine subsystems. With PT_TRACK_MEMORY the
+	// live bytes, peak and allocation counts of every tag are kept, and
+	// whatever is still live at shutdown is reported as a leak.
+	//
+	// Frees must pass the same size, alignment and tag as the allocation.
+	class PHOTON_API Memory
+	{
+	public:
+		static void* Allocate(size_t size, size_t alignment, MemoryTag tag);
+		static void Free(void* ptr, size_t size, size_t alignment, MemoryTag tag);
+
+		template<typename T, typename... Args>
+		static T* New(MemoryTag tag, Args&&... args)
+		{
+			return new (Allocate(sizeof(T), alignof(T), tag)) T(std::forward<Args>(args)...);
+		}
+
+		template<typename T>
+		static void Delete(T* object, MemoryTag tag)
+		{
+			if (!object)
+				return;
+
+			object->~T();
+			Free(object, sizeof(T), alignof(T), tag);
+		}
+
+		// Soft cap in bytes, 0 removes it. Going over logs an error once per
+		// crossing and makes IsOverBudget true until usage drops back
+		static void SetBudget(MemoryTag tag, uint64_t bytes);
+		static bool IsOverBudget(MemoryTag tag);
+
+		static MemoryStats GetStats(MemoryTag tag);
+		// Tracked allocations made so far, across every tag
+		static uint64_t GetTotalAllocationCount();
+		static const char* GetTagName(MemoryTag tag);
+
+		// Logs the statistics of every tag that was used, and every tag with
+		// live allocations as a leak
+		static void LogReport();
+	};
+}
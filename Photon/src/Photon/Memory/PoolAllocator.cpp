@@ -0,0 +1,61 @@
+#include "ptpch.h"
+#include "PoolAllocator.h"
+
+namespace Photon
+{
+	PoolAllocator::PoolAllocator(size_t blockSize, size_t alignment, size_t blocksPerPage, MemoryTag tag)
+		: m_Alignment(alignment), m_BlocksPerPage(blocksPerPage), m_Tag(tag)
+	{
+		PT_CORE_ASSERT((alignment & (alignment - 1)) == 0, "Pool alignment must be a power of two");
+
+		// Every block has to be able to hold the free list link, and stay
+		// aligned when packed back to back
+		m_BlockSize = std::max(blockSize, sizeof(FreeBlock));
+		m_BlockSize = (m_BlockSize + alignment - 1) & ~(alignment - 1);
+	}
+
+	PoolAllocator::~PoolAllocator()
+	{
+		if (m_LiveCount)
+			PT_CORE_WARN("PoolAllocator destroyed with {0} live blocks of {1} bytes", m_LiveCount, m_BlockSize);
+
+		for (void* page : m_Pages)
+			Memory::Free(page, m_BlockSize * m_BlocksPerPage, m_Alignment, m_Tag);
+	}
+
+	void* PoolAllocator::Allocate()
+	{
+		if (!m_FreeList)
+			AllocatePage();
+
+		FreeBlock* block = m_FreeList;
+		m_FreeList = block->Next;
+		m_LiveCount++;
+		return block;
+	}
+
+	void PoolAllocator::Free(void* block)
+	{
+		if (!block)
+			return;
+
+		FreeBlock* freed = (FreeBlock*)block;
+		freed->Next = m_FreeList;
+		m_FreeList = freed;
+		m_LiveCount--;
+	}
+
+	void PoolAllocator::AllocatePage()
+	{
+		uint8_t* page = (uint8_t*)Memory::Allocate(m_BlockSize * m_BlocksPerPage, m_Alignment, m_Tag);
+		m_Pages.push_back(page);
+
+		// Link back to front so blocks are handed out in address order
+		for (size_t i = m_BlocksPerPage; i-- > 0; )
+		{
+			FreeBlock* block = (FreeBlock*)(page + i * m_BlockSize);
+			block->Next = m_FreeList;
+			m_FreeList = block;
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Memory.h"
+
+#include <vector>
+
+namespace Photon
+{
+	// Hands out fixed size blocks from pages of blocksPerPage, with freed
+	// blocks kept on an intrusive free list. Pages are only returned to the
+	// heap when the pool is destroyed. Not thread safe.
+	class PHOTON_API PoolAllocator
+	{
+	public:
+		PoolAllocator(size_t blockSize, size_t alignment = alignof(std::max_align_t), size_t blocksPerPage = 64, MemoryTag tag = MemoryTag::General);
+		~PoolAllocator();
+
+		PoolAllocator(const PoolAllocator&) = delete;
+		PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+		void* Allocate();
+		void Free(void* block);
+
+		inline size_t GetBlockSize() const { return m_BlockSize; }
+		inline size_t GetLiveCount() const { return m_LiveCount; }
+		inline size_t GetPageCount() const { return m_Pages.size(); }
+	private:
+		void AllocatePage();
+	private:
+		struct FreeBlock
+		{
+			FreeBlock* Next;
+		};
+
+		size_t m_BlockSize;
+		size_t m_Alignment;
+		size_t m_BlocksPerPage;
+		MemoryTag m_Tag;
+
+		FreeBlock* m_FreeList = nullptr;
+		std::vector<void*> m_Pages;
+		size_t m_LiveCount = 0;
+	};
+
+	// Typed PoolAllocator
+	template<typename T>
+	class ObjectPool
+	{
+	public:
+		ObjectPool(size_t objectsPerPage = 64, MemoryTag tag = MemoryTag::General)
+			: m_Pool(sizeof(T), alignof(T), objectsPerPage, tag)
+		{}
+
+		template<typename... Args>
+		T* New(Args&&... args)
+		{
+			return new (m_Pool.Allocate()) T(std::forward<Args>(args)...);
+		}
+
+		void Delete(T* object)
+		{
+			if (!object)
+				return;
+
+			object->~T();
+			m_Pool.Free(object);
+		}
+
+		inline size_t GetLiveCount() const { return m_Pool.GetLiveCount(); }
+	private:
+		PoolAllocator m_Pool;
+	};
+}
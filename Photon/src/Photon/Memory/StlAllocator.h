@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Memory.h"
+#include "LinearAllocator.h"
+
+#include <vector>
+
+namespace Photon
+{
+	// std:: container allocator charging a MemoryTag
+	template<typename T, MemoryTag Tag = MemoryTag::General>
+	class TrackedAllocator
+	{
+	public:
+		using value_type = T;
+
+		template<typename U>
+		struct rebind { using other = TrackedAllocator<U, Tag>; };
+
+		TrackedAllocator() = default;
+		template<typename U>
+		TrackedAllocator(const TrackedAllocator<U, Tag>&) {}
+
+		T* allocate(size_t count) { return (T*)Memory::Allocate(count * sizeof(T), alignof(T), Tag); }
+		void deallocate(T* ptr, size_t count) { Memory::Free(ptr, count * sizeof(T), alignof(T), Tag); }
+
+		template<typename U>
+		bool operator==(const TrackedAllocator<U, Tag>&) const { return true; }
+		template<typename U>
+		bool operator!=(const TrackedAllocator<U, Tag>&) const { return false; }
+	};
+
+	// std:: container allocator backed by a LinearAllocator. Deallocation is
+	// a no-op, the memory comes back when the LinearAllocator is reset, so the
+	// container must not outlive that
+	template<typename T>
+	class LinearStlAllocator
+	{
+	public:
+		using value_type = T;
+
+		LinearStlAllocator(LinearAllocator& allocator)
+			: m_Allocator(&allocator)
+		{}
+
+		template<typename U>
+		LinearStlAllocator(const LinearStlAllocator<U>& other)
+			: m_Allocator(other.m_Allocator)
+		{}
+
+		T* allocate(size_t count) { return (T*)m_Allocator->Allocate(count * sizeof(T), alignof(T)); }
+		void deallocate(T*, size_t) {}
+
+		template<typename U>
+		bool operator==(const LinearStlAllocator<U>& other) const { return m_Allocator == other.m_Allocator; }
+		template<typename U>
+		bool operator!=(const LinearStlAllocator<U>& other) const { return m_Allocator != other.m_Allocator; }
+	private:
+		LinearAllocator* m_Allocator;
+
+		template<typename U>
+		friend class LinearStlAllocator;
+	};
+
+	template<typename T, MemoryTag Tag = MemoryTag::General>
+	using TrackedVector = std::vector<T, TrackedAllocator<T, Tag>>;
+
+	// Scratch vector for the current frame, see Application::GetFrameAllocator
+	template<typename T>
+	using FrameVector = std::vector<T, LinearStlAllocator<T>>;
+}
@@ -0,0 +1,274 @@
+#include "ptpch.h"
+#include "TlsfAllocator.h"
+
+#include <bit>
+
+namespace Photon
+{
+	TlsfAllocator::TlsfAllocator(uint64_t size)
+		: m_Size(size)
+	{
+		PT_CORE_ASSERT(size > 0, "TlsfAllocator needs a non-empty range");
+
+		for (uint32_t fl = 0; fl < FirstLevelCount; fl++)
+		{
+			for (uint32_t sl = 0; sl < SecondLevelCount; sl++)
+				m_FreeLists[fl][sl] = InvalidNode;
+		}
+
+		InsertFree(NewNode(0, size));
+	}
+
+	void TlsfAllocator::GetSizeClass(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+	{
+		if (size < SecondLevelCount)
+		{
+			firstLevel = 0;
+			secondLevel = (uint32_t)size;
+			return;
+		}
+
+		uint32_t log2 = (uint32_t)std::bit_width(size) - 1;
+		firstLevel = log2 - SecondLevelBits + 1;
+		secondLevel = (uint32_t)(size >> (log2 - SecondLevelBits)) - SecondLevelCount;
+	}
+
+	uint32_t TlsfAllocator::NewNode(uint64_t offset, uint64_t size)
+	{
+		uint32_t index;
+		if (!m_UnusedNodes.empty())
+		{
+			index = m_UnusedNodes.back();
+			m_UnusedNodes.pop_back();
+			m_Nodes[index] = Node();
+		}
+		else
+		{
+			index = (uint32_t)m_Nodes.size();
+			m_Nodes.emplace_back();
+		}
+
+		m_Nodes[index].Offset = offset;
+		m_Nodes[index].Size = size;
+		return index;
+	}
+
+	void TlsfAllocator::ReleaseNode(uint32_t node)
+	{
+		m_UnusedNodes.push_back(node);
+	}
+
+	void TlsfAllocator::InsertFree(uint32_t node)
+	{
+		Node& n = m_Nodes[node];
+		uint32_t fl, sl;
+		GetSizeClass(n.Size, fl, sl);
+
+		n.Free = true;
+		n.PrevFree = InvalidNode;
+		n.NextFree = m_FreeLists[fl][sl];
+		if (n.NextFree != InvalidNode)
+			m_Nodes[n.NextFree].PrevFree = node;
+		m_FreeLists[fl][sl] = node;
+
+		m_FirstLevelBitmap |= 1ull << fl;
+		m_SecondLevelBitmaps[fl] |= 1u << sl;
+		m_FreeRangeCount++;
+	}
+
+	void TlsfAllocator::RemoveFree(uint32_t node)
+	{
+		Node& n = m_Nodes[node];
+		uint32_t fl, sl;
+		GetSizeClass(n.Size, fl, sl);
+
+		if (n.PrevFree != InvalidNode)
+			m_Nodes[n.PrevFree].NextFree = n.NextFree;
+		else
+			m_FreeLists[fl][sl] = n.NextFree;
+		if (n.NextFree != InvalidNode)
+			m_Nodes[n.NextFree].PrevFree = n.PrevFree;
+
+		if (m_FreeLists[fl][sl] == InvalidNode)
+		{
+			m_SecondLevelBitmaps[fl] &= ~(1u << sl);
+			if (!m_SecondLevelBitmaps[fl])
+				m_FirstLevelBitmap &= ~(1ull << fl);
+		}
+
+		n.Free = false;
+		n.PrevFree = n.NextFree = InvalidNode;
+		m_FreeRangeCount--;
+	}
+
+	uint32_t TlsfAllocator::FindFree(uint64_t size) const
+	{
+		// Round up to the next size class, so that any range in the class
+		// found is large enough and the list head can be taken as is
+		if (size >= SecondLevelCount)
+		{
+			uint32_t log2 = (uint32_t)std::bit_width(size) - 1;
+			size += (1ull << (log2 - SecondLevelBits)) - 1;
+		}
+
+		uint32_t fl, sl;
+		GetSizeClass(size, fl, sl);
+
+		uint32_t secondLevelMap = m_SecondLevelBitmaps[fl] & (~0u << sl);
+		if (!secondLevelMap)
+		{
+			uint64_t firstLevelMap = fl + 1 < 64 ? m_FirstLevelBitmap & (~0ull << (fl + 1)) : 0;
+			if (!firstLevelMap)
+				return InvalidNode;
+
+			fl = (uint32_t)std::countr_zero(firstLevelMap);
+			secondLevelMap = m_SecondLevelBitmaps[fl];
+		}
+
+		sl = (uint32_t)std::countr_zero(secondLevelMap);
+		return m_FreeLists[fl][sl];
+	}
+
+	uint32_t TlsfAllocator::FindFreeExact(uint64_t size, uint64_t alignment) const
+	{
+		// Ranges in the classes from size's up to that of size plus the worst
+		// case padding may be large enough, depending on where they start
+		uint32_t fl, sl, lastFl, lastSl;
+		GetSizeClass(size, fl, sl);
+		GetSizeClass(size + alignment - 1, lastFl, lastSl);
+		for (;;)
+		{
+			if (m_SecondLevelBitmaps[fl] & (1u << sl))
+			{
+				for (uint32_t node = m_FreeLists[fl][sl]; node != InvalidNode; node = m_Nodes[node].NextFree)
+				{
+					const Node& n = m_Nodes[node];
+					uint64_t aligned = (n.Offset + alignment - 1) & ~(alignment - 1);
+					if (aligned + size <= n.Offset + n.Size)
+						return node;
+				}
+			}
+
+			if (fl == lastFl && sl == lastSl)
+				return InvalidNode;
+			if (++sl == SecondLevelCount)
+			{
+				sl = 0;
+				fl++;
+			}
+		}
+	}
+
+	TlsfAllocator::Allocation TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		PT_CORE_ASSERT(alignment && (alignment & (alignment - 1)) == 0, "TlsfAllocator alignment must be a power of two");
+
+		size = std::max<uint64_t>(size, 1);
+		if (size > m_Size || alignment > m_Size)
+			return {};
+
+		// Room for the worst case padding in front
+		uint32_t node = FindFree(size + alignment - 1);
+		if (node == InvalidNode)
+			node = FindFreeExact(size, alignment);
+		if (node == InvalidNode)
+			return {};
+		RemoveFree(node);
+
+		uint64_t offset = m_Nodes[node].Offset;
+		uint64_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+		if (aligned != offset)
+		{
+			// Free ranges are always merged, so the neighbours of a free
+			// node are in use and the padding becomes a range of its own
+			uint64_t padding = aligned - offset;
+			uint32_t prev = m_Nodes[node].PrevPhysical;
+			uint32_t front = NewNode(offset, padding);
+			m_Nodes[front].PrevPhysical = prev;
+			m_Nodes[front].NextPhysical = node;
+			if (prev != InvalidNode)
+				m_Nodes[prev].NextPhysical = front;
+			m_Nodes[node].PrevPhysical = front;
+			InsertFree(front);
+
+			m_Nodes[node].Offset = aligned;
+			m_Nodes[node].Size -= padding;
+		}
+
+		uint64_t remainder = m_Nodes[node].Size - size;
+		if (remainder)
+		{
+			// Likewise the range after the node is in use
+			uint32_t back = NewNode(aligned + size, remainder);
+			uint32_t next = m_Nodes[node].NextPhysical;
+			m_Nodes[back].PrevPhysical = node;
+			m_Nodes[back].NextPhysical = next;
+			if (next != InvalidNode)
+				m_Nodes[next].PrevPhysical = back;
+			m_Nodes[node].NextPhysical = back;
+			m_Nodes[node].Size = size;
+			InsertFree(back);
+		}
+
+		m_UsedBytes += size;
+		m_AllocationCount++;
+
+		Allocation allocation;
+		allocation.Offset = aligned;
+		allocation.Size = size;
+		allocation.Node = node;
+		return allocation;
+	}
+
+	void TlsfAllocator::Free(const Allocation& allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		uint32_t node = allocation.Node;
+		PT_CORE_ASSERT(node < m_Nodes.size() && !m_Nodes[node].Free, "TlsfAllocator freed an allocation twice");
+
+		m_UsedBytes -= m_Nodes[node].Size;
+		m_AllocationCount--;
+
+		uint32_t next = m_Nodes[node].NextPhysical;
+		if (next != InvalidNode && m_Nodes[next].Free)
+		{
+			RemoveFree(next);
+			m_Nodes[node].Size += m_Nodes[next].Size;
+			m_Nodes[node].NextPhysical = m_Nodes[next].NextPhysical;
+			if (m_Nodes[node].NextPhysical != InvalidNode)
+				m_Nodes[m_Nodes[node].NextPhysical].PrevPhysical = node;
+			ReleaseNode(next);
+		}
+
+		uint32_t prev = m_Nodes[node].PrevPhysical;
+		if (prev != InvalidNode && m_Nodes[prev].Free)
+		{
+			RemoveFree(prev);
+			m_Nodes[prev].Size += m_Nodes[node].Size;
+			m_Nodes[prev].NextPhysical = m_Nodes[node].NextPhysical;
+			if (m_Nodes[prev].NextPhysical != InvalidNode)
+				m_Nodes[m_Nodes[prev].NextPhysical].PrevPhysical = prev;
+			ReleaseNode(node);
+			node = prev;
+		}
+
+		InsertFree(node);
+	}
+
+	uint64_t TlsfAllocator::GetLargestFreeRange() const
+	{
+		if (!m_FirstLevelBitmap)
+			return 0;
+
+		// Only the highest non-empty size class can hold the largest range
+		uint32_t fl = 63 - (uint32_t)std::countl_zero(m_FirstLevelBitmap);
+		uint32_t sl = 31 - (uint32_t)std::countl_zero(m_SecondLevelBitmaps[fl]);
+
+		uint64_t largest = 0;
+		for (uint32_t node = m_FreeLists[fl][sl]; node != InvalidNode; node = m_Nodes[node].NextFree)
+			largest = std::max(largest, m_Nodes[node].Size);
+		return largest;
+	}
+}
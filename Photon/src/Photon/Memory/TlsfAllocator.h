@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Photon/Core.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Photon
+{
+	// Two level segregated fit allocator over the offsets [0, size). It never
+	// touches the memory it hands out, the bookkeeping lives on the heap, so
+	// it can carve up GPU memory or anything else addressed by offset.
+	//
+	// Free ranges are kept in lists by size class. A size class is found
+	// through two levels of bitmaps and freed ranges are merged with free
+	// neighbours right away, so both allocating and freeing are O(1).
+	// Not thread safe.
+	class PHOTON_API TlsfAllocator
+	{
+	public:
+		static constexpr uint32_t InvalidNode = UINT32_MAX;
+
+		struct Allocation
+		{
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+			uint32_t Node = InvalidNode;
+
+			inline bool IsValid() const { return Node != InvalidNode; }
+		};
+
+		TlsfAllocator(uint64_t size);
+
+		// alignment must be a power of two. Returns an invalid allocation when
+		// no free range is large enough
+		Allocation Allocate(uint64_t size, uint64_t alignment = 1);
+		void Free(const Allocation& allocation);
+
+		inline uint64_t GetSize() const { return m_Size; }
+		inline uint64_t GetUsedBytes() const { return m_UsedBytes; }
+		inline uint64_t GetFreeBytes() const { return m_Size - m_UsedBytes; }
+		inline uint32_t GetAllocationCount() const { return m_AllocationCount; }
+		inline uint32_t GetFreeRangeCount() const { return m_FreeRangeCount; }
+		inline bool IsEmpty() const { return m_AllocationCount == 0; }
+
+		uint64_t GetLargestFreeRange() const;
+	private:
+		// Sizes below SecondLevelCount get a class each, above that every
+		// power of two is split into SecondLevelCount classes
+		static constexpr uint32_t SecondLevelBits = 4;
+		static constexpr uint32_t SecondLevelCount = 1u << SecondLevelBits;
+		static constexpr uint32_t FirstLevelCount = 64 - SecondLevelBits + 1;
+
+		struct Node
+		{
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+			// Neighbours in address order
+			uint32_t PrevPhysical = InvalidNode, NextPhysical = InvalidNode;
+			// Neighbours in the free list of the node's size class
+			uint32_t PrevFree = InvalidNode, NextFree = InvalidNode;
+			bool Free = false;
+		};
+
+		static void GetSizeClass(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+		uint32_t NewNode(uint64_t offset, uint64_t size);
+		void ReleaseNode(uint32_t node);
+
+		void InsertFree(uint32_t node);
+		void RemoveFree(uint32_t node);
+		// A free node of at least size bytes, or InvalidNode
+		uint32_t FindFree(uint64_t size) const;
+		// Slow path through the free ranges of the classes the rounded up
+		// search skips, for when it finds nothing
+		uint32_t FindFreeExact(uint64_t size, uint64_t alignment) const;
+	private:
+		uint64_t m_Size;
+		uint64_t m_UsedBytes = 0;
+		uint32_t m_AllocationCount = 0;
+		uint32_t m_FreeRangeCount = 0;
+
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_UnusedNodes;
+
+		uint64_t m_FirstLevelBitmap = 0;
+		uint32_t m_SecondLevelBitmaps[FirstLevelCount] = {};
+		uint32_t m_FreeLists[FirstLevelCount][SecondLevelCount];
+	};
+}
@@ -0,0 +1,203 @@
+#include "ptpch.h"
+#include "Metrics.h"
+
+#include <bit>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace Photon
+{
+	void Gauge::Add(double amount)
+	{
+		double value = m_Value.load(std::memory_order_relaxed);
+		while (!m_Value.compare_exchange_weak(value, value + amount, std::memory_order_relaxed))
+			;
+	}
+
+	uint32_t Histogram::GetBucketIndex(uint64_t value)
+	{
+		value = std::min<uint64_t>(value, (1ull << MaxValueBits) - 1);
+		if (value < SubBucketCount)
+			return (uint32_t)value;
+
+		// The top SubBucketBits + 1 bits of the value pick the bucket within
+		// its power of two range
+		uint32_t shift = (uint32_t)std::bit_width(value) - 1 - SubBucketBits;
+		return (shift + 1) * SubBucketCount + (uint32_t)(value >> shift) - SubBucketCount;
+	}
+
+	uint64_t Histogram::GetBucketLowest(uint32_t index)
+	{
+		if (index < SubBucketCount)
+			return index;
+
+		uint32_t shift = index / SubBucketCount - 1;
+		return (uint64_t)(index % SubBucketCount + SubBucketCount) << shift;
+	}
+
+	uint64_t Histogram::GetBucketHighest(uint32_t index)
+	{
+		if (index < SubBucketCount)
+			return index;
+
+		uint32_t shift = index / SubBucketCount - 1;
+		return GetBucketLowest(index) + (1ull << shift) - 1;
+	}
+
+	Histogram::Histogram()
+	{
+		for (std::atomic<uint64_t>& bucket : m_Buckets)
+			bucket.store(0, std::memory_order_relaxed);
+	}
+
+	void Histogram::Record(uint64_t value)
+	{
+		m_Buckets[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+		m_Sum.fetch_add(value, std::memory_order_relaxed);
+
+		// Min and max rarely change once a few values are in
+		uint64_t min = m_Min.load(std::memory_order_relaxed);
+		while (value < min && !m_Min.compare_exchange_weak(min, value, std::memory_order_relaxed))
+			;
+		uint64_t max = m_Max.load(std::memory_order_relaxed);
+		while (value > max && !m_Max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+			;
+	}
+
+	HistogramSnapshot Histogram::Snapshot() const
+	{
+		// Taken while other threads record, so the fields can disagree by the
+		// values recorded meanwhile. Count is summed from the buckets so that
+		// percentiles are consistent
+		HistogramSnapshot snapshot;
+		snapshot.Buckets.resize(BucketCount);
+		for (uint32_t i = 0; i < BucketCount; i++)
+		{
+			snapshot.Buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+			snapshot.Count += snapshot.Buckets[i];
+		}
+
+		snapshot.Sum = m_Sum.load(std::memory_order_relaxed);
+		if (snapshot.Count)
+		{
+			snapshot.Min = m_Min.load(std::memory_order_relaxed);
+			snapshot.Max = m_Max.load(std::memory_order_relaxed);
+		}
+		return snapshot;
+	}
+
+	uint64_t HistogramSnapshot::GetPercentile(double percentile) const
+	{
+		if (!Count)
+			return 0;
+
+		uint64_t rank = (uint64_t)std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * Count);
+		rank = std::max<uint64_t>(rank, 1);
+
+		uint64_t seen = 0;
+		for (uint32_t i = 0; i < (uint32_t)Buckets.size(); i++)
+		{
+			seen += Buckets[i];
+			if (seen >= rank)
+				return std::clamp<uint64_t>(Histogram::GetBucketHighest(i), Min, Max);
+		}
+		return Max;
+	}
+
+	HistogramSnapshot HistogramSnapshot::Since(const HistogramSnapshot& earlier) const
+	{
+		HistogramSnapshot interval;
+		interval.Buckets.resize(Buckets.size());
+		interval.Sum = Sum - earlier.Sum;
+
+		bool first = true;
+		for (size_t i = 0; i < Buckets.size(); i++)
+		{
+			uint64_t count = Buckets[i] - (i < earlier.Buckets.size() ? earlier.Buckets[i] : 0);
+			interval.Buckets[i] = count;
+			interval.Count += count;
+
+			if (!count)
+				continue;
+			if (first)
+				interval.Min = Histogram::GetBucketLowest((uint32_t)i);
+			interval.Max = Histogram::GetBucketHighest((uint32_t)i);
+			first = false;
+		}
+
+		// The exact extremes still apply where they fall in the interval's range
+		if (interval.Count)
+		{
+			interval.Min = std::clamp<uint64_t>(interval.Min, Min, Max);
+			interval.Max = std::clamp<uint64_t>(interval.Max, Min, Max);
+		}
+		return interval;
+	}
+
+	struct MetricsRegistry
+	{
+		std::mutex Mutex;
+		std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+		std::map<std::string, std::unique_ptr<Counter>> Counters;
+		std::map<std::string, std::unique_ptr<Gauge>> Gauges;
+		std::map<std::string, std::unique_ptr<Histogram>> Histograms;
+	};
+
+	// Never destroyed, references handed out stay valid through static
+	// destruction
+	static MetricsRegistry& GetRegistry()
+	{
+		static MetricsRegistry* s_Registry = new MetricsRegistry();
+		return *s_Registry;
+	}
+
+	template<typename T>
+	static T& GetOrCreate(std::map<std::string, std::unique_ptr<T>>& metrics, const std::string& name)
+	{
+		std::unique_ptr<T>& metric = metrics[name];
+		if (!metric)
+			metric = std::make_unique<T>();
+		return *metric;
+	}
+
+	Counter& Metrics::GetCounter(const std::string& name)
+	{
+		MetricsRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		return GetOrCreate(registry.Counters, name);
+	}
+
+	Gauge& Metrics::GetGauge(const std::string& name)
+	{
+		MetricsRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		return GetOrCreate(registry.Gauges, name);
+	}
+
+	Histogram& Metrics::GetHistogram(const std::string& name)
+	{
+		MetricsRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		return GetOrCreate(registry.Histograms, name);
+	}
+
+	MetricsSnapshot Metrics::Snapshot()
+	{
+		MetricsRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+
+		MetricsSnapshot snapshot;
+		snapshot.Time = std::chrono::duration<double>(std::chrono::steady_clock::now() - registry.Start).count();
+
+		for (const auto& [name, counter] : registry.Counters)
+			snapshot.Counters.emplace_back(name, counter->Get());
+		for (const auto& [name, gauge] : registry.Gauges)
+			snapshot.Gauges.emplace_back(name, gauge->Get());
+		for (const auto& [name, histogram] : registry.Histograms)
+			snapshot.Histograms.emplace_back(name, histogram->Snapshot());
+
+		return snapshot;
+	}
+}
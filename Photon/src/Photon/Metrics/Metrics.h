@@ -0,0 +1,140 @@
+#pragma once
+#include "Photon/Core.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Photon
+{
+	// Monotonic count, e.g. events dispatched. Safe to add to from any thread
+	class PHOTON_API Counter
+	{
+	public:
+		inline void Add(uint64_t amount) { m_Value.fetch_add(amount, std::memory_order_relaxed); }
+		inline void Increment() { Add(1); }
+
+		inline uint64_t Get() const { return m_Value.load(std::memory_order_relaxed); }
+	private:
+		alignas(64) std::atomic<uint64_t> m_Value = 0;
+	};
+
+	// Current value of something that goes up and down, e.g. live tasks
+	class PHOTON_API Gauge
+	{
+	public:
+		inline void Set(double value) { m_Value.store(value, std::memory_order_relaxed); }
+		void Add(double amount);
+
+		inline double Get() const { return m_Value.load(std::memory_order_relaxed); }
+	private:
+		alignas(64) std::atomic<double> m_Value = 0.0;
+	};
+
+	// Point in time copy of a Histogram
+	struct PHOTON_API HistogramSnapshot
+	{
+		uint64_t Count = 0;
+		uint64_t Sum = 0;
+		uint64_t Min = 0, Max = 0;
+		std::vector<uint64_t> Buckets;
+
+		inline double GetMean() const { return Count ? (double)Sum / Count : 0.0; }
+		// Highest value equivalent to the one at percentile (0-100), within
+		// the histogram's precision
+		uint64_t GetPercentile(double percentile) const;
+
+		// What was recorded between earlier and this snapshot. Min and max of
+		// the interval are only known to the histogram's precision
+		HistogramSnapshot Since(const HistogramSnapshot& earlier) const;
+	};
+
+	// HDR-style histogram of unsigned values, normally durations in
+	// nanoseconds. Buckets are log-linear: every power of two range is split
+	// into SubBucketCount equal buckets, so any value is stored within about
+	// 3% of what was recorded while the whole range up to 2^MaxValueBits
+	// takes a fixed 9KB. Larger values are clamped.
+	//
+	// Recording is a few relaxed atomic adds and is safe from any thread.
+	class PHOTON_API Histogram
+	{
+	public:
+		static constexpr uint32_t SubBucketBits = 5;
+		static constexpr uint32_t SubBucketCount = 1u << SubBucketBits;
+		// 2^40 ns is a little over 18 minutes
+		static constexpr uint32_t MaxValueBits = 40;
+		static constexpr uint32_t BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+
+		Histogram();
+
+		Histogram(const Histogram&) = delete;
+		Histogram& operator=(const Histogram&) = delete;
+
+		void Record(uint64_t value);
+		inline void Record(std::chrono::nanoseconds duration) { Record((uint64_t)std::max<int64_t>(duration.count(), 0)); }
+
+		HistogramSnapshot Snapshot() const;
+
+		static uint32_t GetBucketIndex(uint64_t value);
+		static uint64_t GetBucketLowest(uint32_t index);
+		static uint64_t GetBucketHighest(uint32_t index);
+	private:
+		std::atomic<uint64_t> m_Buckets[BucketCount];
+		std::atomic<uint64_t> m_Sum = 0;
+		std::atomic<uint64_t> m_Min = UINT64_MAX;
+		std::atomic<uint64_t> m_Max = 0;
+	};
+
+	// Records the time from construction to destruction into a histogram
+	class HistogramTimer
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		HistogramTimer(Histogram& histogram)
+			: m_Histogram(histogram), m_Start(Clock::now())
+		{
+		}
+
+		~HistogramTimer()
+		{
+			m_Histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_Start));
+		}
+
+		HistogramTimer(const HistogramTimer&) = delete;
+		HistogramTimer& operator=(const HistogramTimer&) = delete;
+	private:
+		Histogram& m_Histogram;
+		Clock::time_point m_Start;
+	};
+
+	// Every registered metric at one point in time, sorted by name
+	struct MetricsSnapshot
+	{
+		// Seconds since the first metric was registered
+		double Time = 0.0;
+		std::vector<std::pair<std::string, uint64_t>> Counters;
+		std::vector<std::pair<std::string, double>> Gauges;
+		std::vector<std::pair<std::string, HistogramSnapshot>> Histograms;
+	};
+
+	// Process wide registry of named metrics. Getting a metric registers it
+	// on first use and takes a lock, so call sites look a metric up once and
+	// keep the reference, which stays valid until the program exits. Updating
+	// a metric never locks.
+	//
+	// Names are dot separated with the unit last where there is one, e.g.
+	// "frame.time_ns" or "events.KeyPressed.dispatched".
+	class PHOTON_API Metrics
+	{
+	public:
+		static Counter& GetCounter(const std::string& name);
+		static Gauge& GetGauge(const std::string& name);
+		static Histogram& GetHistogram(const std::string& name);
+
+		static MetricsSnapshot Snapshot();
+	};
+}
@@ -0,0 +1,172 @@
+#include "ptpch.h"
+#include "MetricsExporter.h"
+
+#include "spdlog/fmt/fmt.h"
+
+namespace Photon
+{
+	static constexpr double ExportedPercentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+
+	MetricsExporter::MetricsExporter(const std::string& filepath, double intervalSeconds, MetricsFormat format)
+		: m_File(filepath), m_Format(format),
+		m_Interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::max(intervalSeconds, 0.001))))
+	{
+		if (!m_File.is_open())
+		{
+			PT_CORE_ERROR("MetricsExporter could not open '{0}'", filepath);
+			return;
+		}
+
+		if (m_Format == MetricsFormat::Csv)
+			m_File << "time,name,type,value,delta,count,mean,min,p50,p90,p99,p999,max\n";
+
+		m_Thread = std::thread(&MetricsExporter::ExporterThread, this);
+	}
+
+	MetricsExporter::~MetricsExporter()
+	{
+		if (!m_Thread.joinable())
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_Wake.notify_one();
+		m_Thread.join();
+	}
+
+	MetricsFormat MetricsExporter::GetFormatForPath(const std::string& filepath)
+	{
+		size_t dot = filepath.rfind('.');
+		if (dot != std::string::npos && filepath.compare(dot, std::string::npos, ".json") == 0)
+			return MetricsFormat::Json;
+		return MetricsFormat::Csv;
+	}
+
+	void MetricsExporter::ExporterThread()
+	{
+		std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + m_Interval;
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (!m_Wake.wait_until(lock, next, [this] { return m_Stopping; }))
+		{
+			lock.unlock();
+			Export();
+			lock.lock();
+
+			// Keep to the schedule, but don't try to catch up after a stall
+			next = std::max(next + m_Interval, std::chrono::steady_clock::now());
+		}
+		lock.unlock();
+
+		// Whatever was recorded since the last interval
+		Export();
+	}
+
+	void MetricsExporter::Export()
+	{
+		MetricsSnapshot snapshot = Metrics::Snapshot();
+
+		if (m_Format == MetricsFormat::Json)
+			WriteJson(snapshot);
+		else
+			WriteCsv(snapshot);
+		m_File.flush();
+
+		for (const auto& [name, value] : snapshot.Counters)
+			m_PreviousCounters[name] = value;
+		for (auto& [name, histogram] : snapshot.Histograms)
+			m_PreviousHistograms[name] = std::move(histogram);
+	}
+
+	static std::string QuoteCsv(const std::string& text)
+	{
+		if (text.find_first_of(",\"\n") == std::string::npos)
+			return text;
+
+		std::string quoted = "\"";
+		for (char c : text)
+		{
+			if (c == '"')
+				quoted += '"';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+
+	static std::string EscapeJson(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			if ((unsigned char)c >= 0x20)
+				escaped += c;
+		}
+		return escaped;
+	}
+
+	void MetricsExporter::WriteCsv(const MetricsSnapshot& snapshot)
+	{
+		fmt::memory_buffer out;
+
+		for (const auto& [name, value] : snapshot.Counters)
+		{
+			uint64_t delta = value - m_PreviousCounters[name];
+			fmt::format_to(fmt::appender(out), "{:.3f},{},counter,{},{},,,,,,,,\n", snapshot.Time, QuoteCsv(name), value, delta);
+		}
+
+		for (const auto& [name, value] : snapshot.Gauges)
+			fmt::format_to(fmt::appender(out), "{:.3f},{},gauge,{},,,,,,,,,\n", snapshot.Time, QuoteCsv(name), value);
+
+		for (const auto& [name, histogram] : snapshot.Histograms)
+		{
+			HistogramSnapshot interval = histogram.Since(m_PreviousHistograms[name]);
+			fmt::format_to(fmt::appender(out), "{:.3f},{},histogram,{},,{},{:.1f},{}", snapshot.Time, QuoteCsv(name),
+				histogram.Count, interval.Count, interval.GetMean(), interval.Min);
+			for (double percentile : ExportedPercentiles)
+				fmt::format_to(fmt::appender(out), ",{}", interval.GetPercentile(percentile));
+			fmt::format_to(fmt::appender(out), ",{}\n", interval.Max);
+		}
+
+		m_File.write(out.data(), out.size());
+	}
+
+	void MetricsExporter::WriteJson(const MetricsSnapshot& snapshot)
+	{
+		fmt::memory_buffer out;
+		fmt::format_to(fmt::appender(out), "{{\"time\": {:.3f}, \"counters\": {{", snapshot.Time);
+
+		const char* separator = "";
+		for (const auto& [name, value] : snapshot.Counters)
+		{
+			uint64_t delta = value - m_PreviousCounters[name];
+			fmt::format_to(fmt::appender(out), "{}\"{}\": {{\"value\": {}, \"delta\": {}}}", separator, EscapeJson(name), value, delta);
+			separator = ", ";
+		}
+
+		fmt::format_to(fmt::appender(out), "}}, \"gauges\": {{");
+		separator = "";
+		for (const auto& [name, value] : snapshot.Gauges)
+		{
+			fmt::format_to(fmt::appender(out), "{}\"{}\": {}", separator, EscapeJson(name), value);
+			separator = ", ";
+		}
+
+		fmt::format_to(fmt::appender(out), "}}, \"histograms\": {{");
+		separator = "";
+		for (const auto& [name, histogram] : snapshot.Histograms)
+		{
+			HistogramSnapshot interval = histogram.Since(m_PreviousHistograms[name]);
+			fmt::format_to(fmt::appender(out), "{}\"{}\": {{\"total\": {}, \"count\": {}, \"mean\": {:.1f}, \"min\": {}, \"p50\": {}, \"p90\": {}, \"p99\": {}, \"p999\": {}, \"max\": {}}}",
+				separator, EscapeJson(name), histogram.Count, interval.Count, interval.GetMean(), interval.Min,
+				interval.GetPercentile(50.0), interval.GetPercentile(90.0), interval.GetPercentile(99.0), interval.GetPercentile(99.9), interval.Max);
+			separator = ", ";
+		}
+
+		fmt::format_to(fmt::appender(out), "}}}}\n");
+		m_File.write(out.data(), out.size());
+	}
+}
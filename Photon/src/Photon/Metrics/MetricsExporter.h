@@ -0,0 +1,59 @@
+#pragma once
+#include "Metrics.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace Photon
+{
+	enum class MetricsFormat
+	{
+		// One row per metric per export:
+		//   time,name,type,value,delta,count,mean,min,p50,p90,p99,p999,max
+		Csv,
+		// One JSON object per export and line
+		Json
+	};
+
+	// Writes a snapshot of every metric to a file at a fixed interval from a
+	// background thread, and a last one when it is destroyed. Counters are
+	// written with their total and the increase over the interval. Histogram
+	// statistics cover only the values recorded during the interval, so a
+	// soak run's p99 frame time can be followed over time; value holds the
+	// histogram's total count.
+	class PHOTON_API MetricsExporter
+	{
+	public:
+		MetricsExporter(const std::string& filepath, double intervalSeconds = 10.0, MetricsFormat format = MetricsFormat::Csv);
+		~MetricsExporter();
+
+		MetricsExporter(const MetricsExporter&) = delete;
+		MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+		inline bool IsOpen() const { return m_File.is_open(); }
+
+		// .json selects MetricsFormat::Json, anything else Csv
+		static MetricsFormat GetFormatForPath(const std::string& filepath);
+	private:
+		void ExporterThread();
+		void Export();
+		void WriteCsv(const MetricsSnapshot& snapshot);
+		void WriteJson(const MetricsSnapshot& snapshot);
+	private:
+		std::ofstream m_File;
+		MetricsFormat m_Format;
+		std::chrono::steady_clock::duration m_Interval;
+
+		// Values at the previous export, only used by the exporter thread
+		std::map<std::string, uint64_t> m_PreviousCounters;
+		std::map<std::string, HistogramSnapshot> m_PreviousHistograms;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Wake;
+		bool m_Stopping = false;
+		std::thread m_Thread;
+	};
+}
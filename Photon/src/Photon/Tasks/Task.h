@@ -0,0 +1,109 @@
+#pragma once
+#include "Photon/Core.h"
+
+#include <coroutine>
+#include <utility>
+
+namespace Photon
+{
+	// Coroutine for game logic that spans several frames, e.g.
+	//
+	//   Photon::Task Blink()
+	//   {
+	//       for (;;)
+	//       {
+	//           co_await Photon::WaitForSeconds(0.5f);
+	//           m_Visible = !m_Visible;
+	//       }
+	//   }
+	//
+	// A task starts when it is spawned on the TaskScheduler or awaited by
+	// another task, which then resumes once it has finished. Tasks are
+	// created and resumed on the main thread only, and their frames come
+	// from the scheduler's pools.
+	class PHOTON_API Task
+	{
+	public:
+		struct promise_type;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		// Hands control back to the awaiting task, or releases a spawned task
+		struct PHOTON_API FinalAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			std::coroutine_handle<> await_suspend(Handle handle) noexcept;
+			void await_resume() const noexcept {}
+		};
+
+		struct PHOTON_API promise_type
+		{
+			static constexpr size_t NotSpawned = (size_t)-1;
+
+			// Task waiting for this one to finish
+			std::coroutine_handle<> Continuation;
+			// Position in the scheduler's list of spawned tasks
+			size_t Index = NotSpawned;
+
+			Task get_return_object() { return Task(Handle::from_promise(*this)); }
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			FinalAwaiter final_suspend() const noexcept { return {}; }
+			void return_void() const {}
+			void unhandled_exception() const;
+
+			static void* operator new(size_t size);
+			static void operator delete(void* frame, size_t size);
+		};
+
+		struct Awaiter
+		{
+			Handle Child;
+
+			bool await_ready() const noexcept { return !Child || Child.done(); }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent) noexcept
+			{
+				Child.promise().Continuation = parent;
+				return Child;
+			}
+			void await_resume() const noexcept {}
+		};
+	public:
+		Task() = default;
+		Task(Task&& other) noexcept
+			: m_Handle(std::exchange(other.m_Handle, nullptr))
+		{}
+		Task& operator=(Task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_Handle)
+					m_Handle.destroy();
+				m_Handle = std::exchange(other.m_Handle, nullptr);
+			}
+			return *this;
+		}
+		~Task()
+		{
+			if (m_Handle)
+				m_Handle.destroy();
+		}
+
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		// Runs the task as part of the awaiting one
+		Awaiter operator co_await() const noexcept { return { m_Handle }; }
+
+		inline bool IsValid() const { return (bool)m_Handle; }
+		inline bool IsDone() const { return m_Handle && m_Handle.done(); }
+	private:
+		explicit Task(Handle handle)
+			: m_Handle(handle)
+		{}
+
+		Handle Release() { return std::exchange(m_Handle, nullptr); }
+	private:
+		Handle m_Handle;
+
+		friend class TaskScheduler;
+	};
+}
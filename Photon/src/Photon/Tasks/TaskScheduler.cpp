@@ -0,0 +1,226 @@
+#include "ptpch.h"
+#include "TaskScheduler.h"
+
+#include "Photon/Events/EventStorage.h"
+
+#include <thread>
+
+namespace Photon
+{
+	TaskScheduler* TaskScheduler::s_Instance = nullptr;
+
+	void* Task::promise_type::operator new(size_t size)
+	{
+		PT_CORE_ASSERT(TaskScheduler::s_Instance, "Tasks can only be created while a TaskScheduler exists");
+		return TaskScheduler::s_Instance->AllocateFrame(size);
+	}
+
+	void Task::promise_type::operator delete(void* frame, size_t size)
+	{
+		TaskScheduler::s_Instance->FreeFrame(frame, size);
+	}
+
+	void Task::promise_type::unhandled_exception() const
+	{
+		PT_CORE_ASSERT(false, "Unhandled exception in task");
+		std::terminate();
+	}
+
+	std::coroutine_handle<> Task::FinalAwaiter::await_suspend(Handle handle) noexcept
+	{
+		if (std::coroutine_handle<> continuation = handle.promise().Continuation)
+			return continuation;
+
+		// A spawned task has nobody to return to and frees itself
+		if (handle.promise().Index != promise_type::NotSpawned)
+			TaskScheduler::s_Instance->Finish(handle);
+
+		return std::noop_coroutine();
+	}
+
+	void NextFrameAwaiter::await_suspend(std::coroutine_handle<> handle) const
+	{
+		TaskScheduler::Get().m_Ready.push_back(handle);
+	}
+
+	void SecondsAwaiter::await_suspend(std::coroutine_handle<> handle) const
+	{
+		TaskScheduler& scheduler = TaskScheduler::Get();
+		scheduler.m_Timers.push_back({ scheduler.m_Time + Seconds, scheduler.m_TimerOrder++, handle });
+		std::push_heap(scheduler.m_Timers.begin(), scheduler.m_Timers.end(), std::greater<>());
+	}
+
+	void JobAwaiter::await_suspend(std::coroutine_handle<> handle)
+	{
+		Handle = handle;
+		Scheduler = &TaskScheduler::Get();
+
+		// The continuation runs on whichever thread finishes the last job, it
+		// only hands the task over to the main thread
+		Job job;
+		job.Function = [](void* data, uint32_t, uint32_t)
+		{
+			JobAwaiter* awaiter = (JobAwaiter*)data;
+			awaiter->Scheduler->PushCompletedJob(awaiter);
+		};
+		job.Data = this;
+		JobSystem::Schedule(job, Scheduler->m_WakeJobs, &Counter);
+	}
+
+	TaskScheduler::TaskScheduler()
+		: m_FramePools{
+			{ FrameSizeClasses[0], alignof(std::max_align_t), 64, MemoryTag::Tasks },
+			{ FrameSizeClasses[1], alignof(std::max_align_t), 64, MemoryTag::Tasks },
+			{ FrameSizeClasses[2], alignof(std::max_align_t), 32, MemoryTag::Tasks },
+			{ FrameSizeClasses[3], alignof(std::max_align_t), 16, MemoryTag::Tasks } }
+	{
+		PT_CORE_ASSERT(!s_Instance, "TaskScheduler already exists!");
+		s_Instance = this;
+	}
+
+	TaskScheduler::~TaskScheduler()
+	{
+		// Destroying a spawned task also destroys the tasks it is awaiting,
+		// their frames are still owned by the Task objects inside it
+		m_Ready.clear();
+		m_Timers.clear();
+		for (auto& waiters : m_EventWaiters)
+			waiters.clear();
+		m_CompletedJobs.store(nullptr);
+
+		while (!m_Tasks.empty())
+		{
+			Task::Handle handle = m_Tasks.back();
+			m_Tasks.pop_back();
+			handle.destroy();
+		}
+
+		s_Instance = nullptr;
+	}
+
+	void TaskScheduler::Spawn(Task task)
+	{
+		Task::Handle handle = task.Release();
+		if (!handle || handle.done())
+		{
+			if (handle)
+				handle.destroy();
+			return;
+		}
+
+		PT_CORE_ASSERT(handle.promise().Index == Task::promise_type::NotSpawned, "Task was already started");
+		handle.promise().Index = m_Tasks.size();
+		m_Tasks.push_back(handle);
+
+		handle.resume();
+	}
+
+	void TaskScheduler::Finish(Task::Handle handle)
+	{
+		// Swap with the last task so removal stays O(1)
+		size_t index = handle.promise().Index;
+		Task::Handle last = m_Tasks.back();
+		m_Tasks[index] = last;
+		last.promise().Index = index;
+		m_Tasks.pop_back();
+
+		handle.destroy();
+	}
+
+	void TaskScheduler::Update(Timestep ts)
+	{
+		m_Time += ts.GetSeconds();
+
+		// Everything woken before this point runs now, wakes that happen while
+		// tasks are running go to m_Ready for the next frame
+		m_Resuming.swap(m_Ready);
+
+		while (!m_Timers.empty() && m_Timers.front().WakeTime <= m_Time)
+		{
+			std::pop_heap(m_Timers.begin(), m_Timers.end(), std::greater<>());
+			m_Resuming.push_back(m_Timers.back().Handle);
+			m_Timers.pop_back();
+		}
+
+		if (JobAwaiter* completed = m_CompletedJobs.exchange(nullptr, std::memory_order_acquire))
+		{
+			// The stack is newest first, resume in completion order instead
+			size_t first = m_Resuming.size();
+			for (JobAwaiter* awaiter = completed; awaiter; )
+			{
+				JobAwaiter* next = awaiter->Next;
+
+				// The last job may still be leaving JobSystem::Finish, and the
+				// task is free to destroy the counter once it resumes
+				while (!awaiter->Counter.IsDone())
+					std::this_thread::yield();
+
+				m_Resuming.push_back(awaiter->Handle);
+				awaiter = next;
+			}
+			std::reverse(m_Resuming.begin() + first, m_Resuming.end());
+		}
+
+		for (std::coroutine_handle<> handle : m_Resuming)
+			handle.resume();
+		m_Resuming.clear();
+	}
+
+	void TaskScheduler::OnEvent(const Event& event)
+	{
+		auto& waiters = m_EventWaiters[(size_t)event.GetEventType()];
+		if (waiters.empty())
+			return;
+
+		for (const EventWaiter& waiter : waiters)
+		{
+			VisitEvent(event, [&waiter](const auto& e)
+			{
+				using T = std::remove_cvref_t<decltype(e)>;
+				new (waiter.Storage) T(e);
+			});
+			m_Ready.push_back(waiter.Handle);
+		}
+		waiters.clear();
+	}
+
+	void TaskScheduler::WaitForEvent(EventType type, std::coroutine_handle<> handle, void* storage)
+	{
+		PT_CORE_ASSERT(type != EventType::None && (size_t)type < EventTypeCount, "Tasks can only wait for engine event types");
+		m_EventWaiters[(size_t)type].push_back({ handle, storage });
+	}
+
+	void TaskScheduler::PushCompletedJob(JobAwaiter* awaiter)
+	{
+		JobAwaiter* head = m_CompletedJobs.load(std::memory_order_relaxed);
+		do
+		{
+			awaiter->Next = head;
+		} while (!m_CompletedJobs.compare_exchange_weak(head, awaiter, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	void* TaskScheduler::AllocateFrame(size_t size)
+	{
+		for (size_t i = 0; i < FrameSizeClassCount; i++)
+		{
+			if (size <= FrameSizeClasses[i])
+				return m_FramePools[i].Allocate();
+		}
+
+		return Memory::Allocate(size, alignof(std::max_align_t), MemoryTag::Tasks);
+	}
+
+	void TaskScheduler::FreeFrame(void* frame, size_t size)
+	{
+		for (size_t i = 0; i < FrameSizeClassCount; i++)
+		{
+			if (size <= FrameSizeClasses[i])
+			{
+				m_FramePools[i].Free(frame);
+				return;
+			}
+		}
+
+		Memory::Free(frame, size, alignof(std::max_align_t), MemoryTag::Tasks);
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include "Task.h"
+
+#include "Photon/Timestep.h"
+#include "Photon/Events/Event.h"
+#include "Photon/Jobs/JobSystem.h"
+#include "Photon/Memory/PoolAllocator.h"
+#include "Photon/Memory/StlAllocator.h"
+
+#include <array>
+#include <atomic>
+
+namespace Photon
+{
+	class TaskScheduler;
+
+	struct NextFrameAwaiter
+	{
+		bool await_ready() const noexcept { return false; }
+		PHOTON_API void await_suspend(std::coroutine_handle<> handle) const;
+		void await_resume() const noexcept {}
+	};
+
+	struct SecondsAwaiter
+	{
+		float Seconds;
+
+		bool await_ready() const noexcept { return Seconds <= 0.0f; }
+		PHOTON_API void await_suspend(std::coroutine_handle<> handle) const;
+		void await_resume() const noexcept {}
+	};
+
+	template<typename T>
+	struct EventAwaiter
+	{
+		// Filled in with a copy of the event before the task is resumed
+		alignas(T) uint8_t Storage[sizeof(T)];
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle);
+		T await_resume() const { return *(const T*)Storage; }
+	};
+
+	struct JobAwaiter
+	{
+		JobCounter& Counter;
+		std::coroutine_handle<> Handle = nullptr;
+		TaskScheduler* Scheduler = nullptr;
+		JobAwaiter* Next = nullptr;
+
+		bool await_ready() const { return Counter.IsDone(); }
+		PHOTON_API void await_suspend(std::coroutine_handle<> handle);
+		void await_resume() const noexcept {}
+	};
+
+	// Resumes the task in the next frame
+	inline NextFrameAwaiter NextFrame() { return {}; }
+	// Resumes the task in the first frame at least seconds later
+	inline SecondsAwaiter WaitForSeconds(float seconds) { return { seconds }; }
+	// Resumes the task with a copy of the next event of type T. The event is
+	// only observed, it still goes on to the layers
+	template<typename T>
+	EventAwaiter<T> WaitForEvent()
+	{
+		static_assert(std::is_base_of_v<Event, T>, "WaitForEvent needs an event type");
+		return {};
+	}
+	// Resumes the task in the first frame after the jobs counted by counter
+	// are done. The counter must stay alive until then
+	inline JobAwaiter WaitForJobs(JobCounter& counter) { return { counter }; }
+
+	// Owns the spawned tasks and resumes them once per frame. Waiting tasks
+	// cost nothing until they are woken: each wait puts the task on exactly
+	// one list (next frame, a timer heap, the waiters for one event type or
+	// a lock-free stack filled by job completion) and Update only resumes
+	// what was woken. Main thread only, except for the job completions.
+	// Job waits that are still pending keep pointers into task frames, so the
+	// scheduler has to outlive the job system.
+	class PHOTON_API TaskScheduler
+	{
+	public:
+		TaskScheduler();
+		~TaskScheduler();
+
+		TaskScheduler(const TaskScheduler&) = delete;
+		TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+		// Starts the task, it runs up to its first wait before Spawn returns.
+		// The scheduler owns it from then on and frees it when it finishes
+		void Spawn(Task task);
+
+		// Advances the task clock and resumes every task whose wait is over.
+		// Tasks that wait again during Update resume in a later frame
+		void Update(Timestep ts);
+		// Wakes the tasks waiting for this type of event
+		void OnEvent(const Event& event);
+
+		inline size_t GetTaskCount() const { return m_Tasks.size(); }
+		inline double GetTime() const { return m_Time; }
+
+		inline static TaskScheduler& Get() { return *s_Instance; }
+	private:
+		void* AllocateFrame(size_t size);
+		void FreeFrame(void* frame, size_t size);
+		void Finish(Task::Handle handle);
+
+		void WaitForEvent(EventType type, std::coroutine_handle<> handle, void* storage);
+		void PushCompletedJob(JobAwaiter* awaiter);
+	private:
+		struct Timer
+		{
+			double WakeTime;
+			// Keeps timers that expire in the same frame in the order they were set
+			uint64_t Order;
+			std::coroutine_handle<> Handle;
+
+			bool operator>(const Timer& other) const
+			{
+				return WakeTime != other.WakeTime ? WakeTime > other.WakeTime : Order > other.Order;
+			}
+		};
+
+		struct EventWaiter
+		{
+			std::coroutine_handle<> Handle;
+			void* Storage;
+		};
+
+		static constexpr size_t FrameSizeClassCount = 4;
+		static constexpr size_t FrameSizeClasses[FrameSizeClassCount] = { 128, 256, 512, 1024 };
+
+		PoolAllocator m_FramePools[FrameSizeClassCount];
+
+		TrackedVector<Task::Handle, MemoryTag::Tasks> m_Tasks;
+		TrackedVector<std::coroutine_handle<>, MemoryTag::Tasks> m_Ready;
+		TrackedVector<std::coroutine_handle<>, MemoryTag::Tasks> m_Resuming;
+		TrackedVector<Timer, MemoryTag::Tasks> m_Timers;
+		std::array<TrackedVector<EventWaiter, MemoryTag::Tasks>, EventTypeCount> m_EventWaiters;
+
+		// Pushed by job continuations on any thread, taken whole by Update
+		std::atomic<JobAwaiter*> m_CompletedJobs = nullptr;
+		JobCounter m_WakeJobs;
+
+		double m_Time = 0.0;
+		uint64_t m_TimerOrder = 0;
+
+		static TaskScheduler* s_Instance;
+
+		friend class Task;
+		friend struct NextFrameAwaiter;
+		friend struct SecondsAwaiter;
+		template<typename T>
+		friend struct EventAwaiter;
+		friend struct JobAwaiter;
+	};
+
+	template<typename T>
+	void EventAwaiter<T>::await_suspend(std::coroutine_handle<> handle)
+	{
+		TaskScheduler::Get().WaitForEvent(T::StaticType, handle, Storage);
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+namespace Photon
+{
+	// Time elapsed between two updates, in seconds
+	class Timestep
+	{
+	public:
+		Timestep(float time = 0.0f)
+			: m_Time(time)
+		{
+		}
+
+		operator float() const { return m_Time; }
+
+		inline float GetSeconds() const { return m_Time; }
+		inline float GetMilliseconds() const { return m_Time * 1000.0f; }
+	private:
+		float m_Time;
+	};
+}
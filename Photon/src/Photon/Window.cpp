@@ -0,0 +1,28 @@
+#include "ptpch.h"
+#include "Window.h"
+
+#include "Platform/Headless/HeadlessWindow.h"
+
+#if defined(PT_PLATFORM_WINDOWS)
+	#include "Platform/Windows/WindowsWindow.h"
+#elif defined(PT_PLATFORM_LINUX)
+	#include "Platform/Linux/LinuxWindow.h"
+#endif
+
+namespace Photon
+{
+	Window* Window::Create(const WindowProps& props)
+	{
+		if (props.Headless)
+			return new HeadlessWindow(props);
+
+#if defined(PT_PLATFORM_WINDOWS)
+		return new WindowsWindow(props);
+#elif defined(PT_PLATFORM_LINUX)
+		return new LinuxWindow(props);
+#else
+		PT_CORE_ASSERT(false, "No native window backend for this platform");
+		return nullptr;
+#endif
+	}
+}
@@ -6,12 +6,30 @@
 
 namespace Photon
 {
+	class VulkanRenderer;
+
 	struct WindowProps
 	{
+		using EventScriptFn = std::function<void(uint64_t frame, const std::function<void(Event&)>& emit)>;
+
 		std::string Title;
 		uint32_t Width;
 		uint32_t Height;
 
+		// Headless windows have no OS window and only raise the events they
+		// are scripted to raise
+		bool Headless = false;
+		// Gives a headless window a renderer on a device without a surface,
+		// which renders into offscreen images
+		bool Offscreen = false;
+		// Called by a headless window once per OnUpdate to emit events.
+		// When empty, SyntheticEventsPerFrame input events are generated instead
+		EventScriptFn EventScript;
+		uint32_t SyntheticEventsPerFrame = 0;
+
+		// Frames the CPU may record ahead of the GPU, 2 or 3
+		uint32_t FramesInFlight = 2;
+
 		WindowProps(const std::string& title = "Photon Engine",
 					uint32_t width = 1280,
 					uint32_t height = 720)
@@ -38,6 +56,9 @@ namespace Photon
 		virtual void SetVSync(bool enabled) = 0;
 		virtual bool IsVSync() const = 0;
 
+		// Null for windows without a graphics context
+		virtual VulkanRenderer* GetRenderer() { return nullptr; }
+
 		static Window* Create(const WindowProps& props = WindowProps());
 	};
 }
\ No newline at end of file
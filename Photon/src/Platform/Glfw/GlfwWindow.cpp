@@ -0,0 +1,248 @@
+#include "ptpch.h"
+#include "GlfwWindow.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+#include "Photon/Events/ApplicationEvent.h"
+#include "Photon/Events/KeyEvent.h"
+#include "Photon/Events/MouseEvent.h"
+
+namespace Photon
+{
+	static bool s_GLFWInitialized = false;
+
+	static void GLFWErrorCallback(int error, const char* description)
+	{
+		PT_CORE_ERROR("GLFW Error {0}: {1}", error, description);
+	}
+
+	void GlfwWindow::Init(const WindowProps& props)
+	{
+		PT_PROFILE_FUNCTION();
+
+		m_Data.Title = props.Title;
+		m_Data.Width = props.Width;
+		m_Data.Height = props.Height;
+
+		PT_CORE_INFO("Creating Window {0} ({1}, {2})", props.Title, props.Width, props.Height);
+
+		if (!s_GLFWInitialized)
+		{
+			int success;
+			{
+				PT_PROFILE_SCOPE("glfwInit");
+				success = glfwInit();
+			}
+			PT_CORE_ASSERT(success, "Could not initialize GLFW!");
+			glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+			glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+			glfwSetErrorCallback(GLFWErrorCallback);
+
+			s_GLFWInitialized = true;
+		}
+
+		// Every window sets up Vulkan for itself, like a headless one does
+		m_Context = CreateContext();
+
+		{
+			PT_PROFILE_SCOPE("glfwCreateWindow");
+			m_Window = glfwCreateWindow((int)m_Data.Width, (int)m_Data.Height, m_Data.Title.c_str(), nullptr, nullptr);
+		}
+		glfwSetWindowUserPointer(m_Window, &m_Data);
+
+		SetVSync(true);
+
+		if (m_Context)
+			InitRenderer(props.FramesInFlight);
+
+		// Set GLFW callbacks
+		glfwSetWindowSizeCallback(m_Window, [](GLFWwindow* window, int width, int height)
+		{
+			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+
+			data.Width = width;
+			data.Height = height;
+
+			WindowResizeEvent event(width, height);
+			data.EventCallback(event);
+		});
+
+		glfwSetWindowCloseCallback(m_Window, [](GLFWwindow* window)
+		{
+			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+
+			WindowCloseEvent event;
+			data.EventCallback(event);
+		});
+
+		glfwSetWindowFocusCallback(m_Window, [](GLFWwindow* window, int focused)
+		{
+			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+
+			if (focused)
+			{
+				WindowFocusEvent event;
+				data.EventCallback(event);
+			}
+			else
+			{
+				WindowLostFocusEvent event;
+				data.EventCallback(event);
+			}
+		});
+
+		glfwSetKeyCallback(m_Window, [](GLFWwindow* window, int key, int scanCode, int action, int mods)
+		{
+			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+
+			switch (action)
+			{
+				case GLFW_PRESS:
+				{
+					KeyPressedEvent event(key, 0);
+					data.EventCallback(event);
+					break;
+				}
+				case GLFW_RELEASE:
+				{
+					KeyReleasedEvent event(key);
+					data.EventCallback(event);
+					break;
+				}
+				case GLFW_REPEAT:
+				{
+					KeyPressedEvent event(key, 1);
+					data.EventCallback(event);
+					break;
+				}
+			}
+		});
+
+		glfwSetMouseButtonCallback(m_Window, [](GLFWwindow* window, int button, int action, int mods)
+		{
+			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+
+			switch (action)
+			{
+				case GLFW_PRESS:
+				{
+					MouseButtonPressedEvent event(button);
+					data.EventCallback(event);
+					break;
+				}
+				case GLFW_RELEASE:
+				{
+					MouseButtonReleasedEvent event(button);
+					data.EventCallback(event);
+					break;
+				}
+			}
+		});
+
+		glfwSetScrollCallback(m_Window, [](GLFWwindow* window, double xOffset, double yOffset)
+		{
+			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+
+			MouseScrolledEvent event((float)xOffset, (float)yOffset);
+			data.EventCallback(event);
+		});
+
+		glfwSetCursorPosCallback(m_Window, [](GLFWwindow* window, double xPos, double yPos)
+		{
+			WindowData& data = *(WindowData*)glfwGetWindowUserPointer(window);
+
+			MouseMovedEvent event((float)xPos, (float)yPos);
+			data.EventCallback(event);
+		});
+	}
+
+	void GlfwWindow::Shutdown()
+	{
+		PT_PROFILE_FUNCTION();
+
+		m_Renderer.reset();
+		if (m_Surface)
+			m_Context->GetInstance().destroySurfaceKHR(m_Surface);
+		m_Context.reset();
+
+		glfwDestroyWindow(m_Window);
+	}
+
+	std::unique_ptr<VulkanContext> GlfwWindow::CreateContext()
+	{
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+		VulkanContextProps contextProps;
+		contextProps.InstanceExtensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		contextProps.Present = true;
+		return std::make_unique<VulkanContext>(contextProps);
+	}
+
+	void GlfwWindow::InitRenderer(uint32_t framesInFlight)
+	{
+		PT_PROFILE_FUNCTION();
+
+		vk::Instance instance = m_Context->GetInstance();
+		VkSurfaceKHR surface;
+		if (glfwCreateWindowSurface(instance, m_Window, nullptr, &surface) == VK_SUCCESS)
+			m_Surface = surface;
+		else
+			PT_CORE_ERROR("Could not create a Vulkan surface for the window");
+
+		// Without a surface the frames are still rendered, into offscreen images
+		if (m_Surface && !m_Context->GetPhysicalDevice().getSurfaceSupportKHR(m_Context->GetGraphicsFamily(), m_Surface))
+		{
+			PT_CORE_WARN("The present queue family can't present to the window, rendering offscreen");
+			instance.destroySurfaceKHR(m_Surface);
+			m_Surface = nullptr;
+		}
+
+		// In pixels, which differs from the window size on high DPI displays
+		int width, height;
+		glfwGetFramebufferSize(m_Window, &width, &height);
+
+		m_Renderer = std::make_unique<VulkanRenderer>(*m_Context, m_Surface, (uint32_t)width, (uint32_t)height, m_Data.VSync, framesInFlight);
+		m_Renderer->BeginFrame();
+	}
+
+	void GlfwWindow::OnUpdate()
+	{
+		PT_PROFILE_FUNCTION();
+
+		// There is no client API context to swap, presenting is up to Vulkan
+		glfwPollEvents();
+
+		// Submits what was recorded into the frame during this update and
+		// starts the next one right away, so layers always have a frame to
+		// record into
+		if (m_Renderer)
+		{
+			m_Renderer->EndFrame();
+
+			// The swapchain waits for a burst of resizes to end by itself,
+			// the size is passed on every frame
+			int width, height;
+			glfwGetFramebufferSize(m_Window, &width, &height);
+			m_Renderer->Resize((uint32_t)width, (uint32_t)height);
+
+			m_Renderer->BeginFrame();
+		}
+	}
+
+	void GlfwWindow::SetVSync(bool enabled)
+	{
+		// Picks the present mode of the next swapchain
+		if (m_Renderer)
+			m_Renderer->SetVSync(enabled);
+
+		m_Data.VSync = enabled;
+	}
+
+	bool GlfwWindow::IsVSync() const
+	{
+		return m_Data.VSync;
+	}
+}
+
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Photon/Window.h"
+#include "Platform/Vulkan/VulkanContext.h"
+#include "Platform/Vulkan/VulkanRenderer.h"
+
+#include <vulkan/vulkan.hpp>
+#include <GLFW/glfw3.h>
+
+namespace Photon
+{
+	// GLFW window presenting through a VulkanRenderer. Window creation, the
+	// event callbacks and the renderer are shared by every desktop platform,
+	// the platform windows only add what differs between them.
+	class GlfwWindow : public Window
+	{
+	public:
+		virtual ~GlfwWindow() = default;
+
+		void OnUpdate() override;
+
+		inline uint32_t GetWidth() const override { return m_Data.Width; }
+		inline uint32_t GetHeight() const override { return m_Data.Height; }
+
+		// Window attributes
+		inline void SetEventCallback(const EventCallbackFn& callback) override { m_Data.EventCallback = callback; }
+		void SetVSync(bool enabled) override;
+		bool IsVSync() const override;
+
+		// Null when Vulkan couldn't be set up for the window
+		inline VulkanRenderer* GetRenderer() override { return m_Renderer.get(); }
+	protected:
+		GlfwWindow() = default;
+
+		void Init(const WindowProps& props);
+		void Shutdown();
+
+		// Called by every window after GLFW is initialized. May return null
+		// when the platform can't run Vulkan
+		virtual std::unique_ptr<VulkanContext> CreateContext();
+	private:
+		void InitRenderer(uint32_t framesInFlight);
+	private:
+		GLFWwindow* m_Window = nullptr;
+
+		struct WindowData
+		{
+			std::string Title;
+			uint32_t Width, Height;
+			bool VSync;
+
+			EventCallbackFn EventCallback;
+		};
+
+		std::unique_ptr<VulkanContext> m_Context;
+		vk::SurfaceKHR m_Surface;
+		std::unique_ptr<VulkanRenderer> m_Renderer;
+
+		WindowData m_Data;
+	};
+}
@@ -0,0 +1,110 @@
+#include "ptpch.h"
+#include "HeadlessWindow.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+#include "Photon/Events/KeyEvent.h"
+#include "Photon/Events/MouseEvent.h"
+
+#include "Platform/Vulkan/VulkanContext.h"
+#include "Platform/Vulkan/VulkanRenderer.h"
+
+namespace Photon
+{
+	HeadlessWindow::HeadlessWindow(const WindowProps& props)
+		: m_EventScript(props.EventScript), m_SyntheticEventsPerFrame(props.SyntheticEventsPerFrame)
+	{
+		m_Data.Title = props.Title;
+		m_Data.Width = props.Width;
+		m_Data.Height = props.Height;
+		m_Data.VSync = false;
+
+		// Synthetic cursor positions wrap around the size
+		if (m_Data.Width == 0 || m_Data.Height == 0)
+		{
+			PT_CORE_WARN("Headless window size ({0}, {1}) is empty, using at least 1 pixel", props.Width, props.Height);
+			m_Data.Width = std::max(m_Data.Width, 1u);
+			m_Data.Height = std::max(m_Data.Height, 1u);
+		}
+
+		PT_CORE_INFO("Creating headless Window {0} ({1}, {2})", props.Title, m_Data.Width, m_Data.Height);
+
+		if (props.Offscreen)
+		{
+			m_Context = std::make_unique<VulkanContext>(VulkanContextProps());
+			m_Renderer = std::make_unique<VulkanRenderer>(*m_Context, nullptr, m_Data.Width, m_Data.Height, m_Data.VSync, props.FramesInFlight);
+			m_Renderer->BeginFrame();
+		}
+	}
+
+	HeadlessWindow::~HeadlessWindow()
+	{
+		m_Renderer.reset();
+		m_Context.reset();
+	}
+
+	void HeadlessWindow::OnUpdate()
+	{
+		PT_PROFILE_FUNCTION();
+
+		if (m_Data.EventCallback)
+		{
+			if (m_EventScript)
+				m_EventScript(m_FrameIndex, m_Data.EventCallback);
+			else
+				EmitSyntheticEvents();
+		}
+
+		// Like a window, submits the frame recorded during this update and
+		// begins the next
+		if (m_Renderer)
+		{
+			m_Renderer->EndFrame();
+			m_Renderer->BeginFrame();
+		}
+
+		m_FrameIndex++;
+	}
+
+	void HeadlessWindow::EmitSyntheticEvents()
+	{
+		// Deterministic input mix: mostly cursor motion with a key
+		// press/release pair every 8 events
+		for (uint32_t i = 0; i < m_SyntheticEventsPerFrame; i++)
+		{
+			uint64_t n = m_FrameIndex * m_SyntheticEventsPerFrame + i;
+
+			if (n % 8 == 6)
+			{
+				KeyPressedEvent event((int)('A' + n % 26), 0);
+				m_Data.EventCallback(event);
+			}
+			else if (n % 8 == 7)
+			{
+				KeyReleasedEvent event((int)('A' + (n - 1) % 26));
+				m_Data.EventCallback(event);
+			}
+			else
+			{
+				MouseMovedEvent event((float)(n % m_Data.Width), (float)((n / m_Data.Width) % m_Data.Height));
+				m_Data.EventCallback(event);
+			}
+		}
+	}
+
+	void HeadlessWindow::SetVSync(bool enabled)
+	{
+		// Nothing is presented, so VSync is only recorded
+		m_Data.VSync = enabled;
+	}
+
+	bool HeadlessWindow::IsVSync() const
+	{
+		return m_Data.VSync;
+	}
+
+	VulkanRenderer* HeadlessWindow::GetRenderer()
+	{
+		return m_Renderer.get();
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Photon/Window.h"
+
+#include <memory>
+
+namespace Photon
+{
+	class VulkanContext;
+
+	// Window without an OS window. Events come from WindowProps::EventScript
+	// or a deterministic synthetic input generator, which makes the engine
+	// loop runnable in CI and measurable without compositor noise.
+	//
+	// With WindowProps::Offscreen it renders like any other window, into
+	// offscreen images on a device created without a surface.
+	class HeadlessWindow : public Window
+	{
+	public:
+		HeadlessWindow(const WindowProps& props);
+		virtual ~HeadlessWindow();
+
+		void OnUpdate() override;
+
+		inline uint32_t GetWidth() const override { return m_Data.Width; }
+		inline uint32_t GetHeight() const override { return m_Data.Height; }
+
+		// Window attributes
+		inline void SetEventCallback(const EventCallbackFn& callback) override { m_Data.EventCallback = callback; }
+		void SetVSync(bool enabled) override;
+		bool IsVSync() const override;
+
+		// Null unless created with WindowProps::Offscreen
+		VulkanRenderer* GetRenderer() override;
+	private:
+		void EmitSyntheticEvents();
+	private:
+		struct WindowData
+		{
+			std::string Title;
+			uint32_t Width, Height;
+			bool VSync;
+
+			EventCallbackFn EventCallback;
+		};
+
+		WindowData m_Data;
+
+		std::unique_ptr<VulkanContext> m_Context;
+		std::unique_ptr<VulkanRenderer> m_Renderer;
+
+		WindowProps::EventScriptFn m_EventScript;
+		uint32_t m_SyntheticEventsPerFrame;
+		uint64_t m_FrameIndex = 0;
+	};
+}
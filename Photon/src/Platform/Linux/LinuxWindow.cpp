@@ -0,0 +1,27 @@
+#include "ptpch.h"
+#include "LinuxWindow.h"
+
+namespace Photon
+{
+	LinuxWindow::LinuxWindow(const WindowProps& props)
+	{
+		Init(props);
+	}
+
+	LinuxWindow::~LinuxWindow()
+	{
+		Shutdown();
+	}
+
+	std::unique_ptr<VulkanContext> LinuxWindow::CreateContext()
+	{
+		// Distributions often ship GLFW without a Vulkan loader installed
+		if (!glfwVulkanSupported())
+		{
+			PT_CORE_ERROR("GLFW found no Vulkan loader, the window can't render");
+			return nullptr;
+		}
+
+		return GlfwWindow::CreateContext();
+	}
+}
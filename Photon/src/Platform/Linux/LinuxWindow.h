@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Platform/Glfw/GlfwWindow.h"
+
+namespace Photon
+{
+	// GLFW window for X11/Wayland, presenting through a VulkanRenderer
+	class LinuxWindow : public GlfwWindow
+	{
+	public:
+		LinuxWindow(const WindowProps& props);
+		virtual ~LinuxWindow();
+	protected:
+		std::unique_ptr<VulkanContext> CreateContext() override;
+	};
+}
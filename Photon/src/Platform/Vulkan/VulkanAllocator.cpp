@@ -0,0 +1,492 @@
+#include "ptpch.h"
+#include "VulkanAllocator.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+#include <bit>
+
+namespace Photon
+{
+	struct VulkanMemoryBlock
+	{
+		VulkanMemoryBlock(vk::DeviceSize size)
+			: Ranges(size)
+		{}
+
+		vk::DeviceMemory Memory;
+		void* MappedData = nullptr;
+		uint32_t MemoryType = 0;
+		TlsfAllocator Ranges;
+	};
+
+	static inline vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	VulkanAllocator::VulkanAllocator(vk::PhysicalDevice physicalDevice, vk::Device device, bool memoryBudget, vk::DeviceSize blockSize)
+		: m_PhysicalDevice(physicalDevice), m_Device(device), m_MemoryBudget(memoryBudget), m_BlockSize(blockSize),
+		m_DeviceBytesMetric(Metrics::GetGauge("vulkan.memory.device_bytes")),
+		m_UsedBytesMetric(Metrics::GetGauge("vulkan.memory.used_bytes"))
+	{
+		m_DeviceProperties = m_PhysicalDevice.getProperties();
+		m_MemoryProperties = m_PhysicalDevice.getMemoryProperties();
+	}
+
+	VulkanAllocator::~VulkanAllocator()
+	{
+		for (uint32_t type = 0; type < m_MemoryProperties.memoryTypeCount; type++)
+		{
+			for (std::unique_ptr<VulkanMemoryBlock>& block : m_Blocks[type])
+			{
+				if (!block->Ranges.IsEmpty())
+					PT_CORE_WARN("VulkanAllocator destroyed with {0} live allocations ({1} bytes) in memory type {2}",
+						block->Ranges.GetAllocationCount(), block->Ranges.GetUsedBytes(), type);
+
+				FreeDeviceMemory(block->Memory, block->Ranges.GetSize(), type);
+			}
+
+			if (m_DedicatedCount[type])
+				PT_CORE_WARN("VulkanAllocator destroyed with {0} live dedicated allocations in memory type {1}", m_DedicatedCount[type], type);
+		}
+	}
+
+	uint32_t VulkanAllocator::FindMemoryType(uint32_t typeBits, VulkanMemoryUsage usage) const
+	{
+		using Flags = vk::MemoryPropertyFlagBits;
+
+		vk::MemoryPropertyFlags required, preferred, avoided;
+		switch (usage)
+		{
+			case VulkanMemoryUsage::GpuOnly:
+				preferred = Flags::eDeviceLocal;
+				avoided = Flags::eHostVisible;
+				break;
+			case VulkanMemoryUsage::Upload:
+				required = Flags::eHostVisible;
+				preferred = Flags::eHostCoherent;
+				avoided = Flags::eHostCached;
+				break;
+			case VulkanMemoryUsage::Readback:
+				// Uncached reads are very slow, worth invalidating for
+				required = Flags::eHostVisible;
+				preferred = Flags::eHostCached;
+				break;
+		}
+
+		// The first type with the most preferred and fewest avoided flags,
+		// drivers list their types in order of preference
+		uint32_t best = UINT32_MAX;
+		int bestScore = INT32_MIN;
+		for (uint32_t type = 0; type < m_MemoryProperties.memoryTypeCount; type++)
+		{
+			vk::MemoryPropertyFlags flags = m_MemoryProperties.memoryTypes[type].propertyFlags;
+			if (!(typeBits & (1u << type)) || (flags & required) != required)
+				continue;
+
+			int score = std::popcount((VkMemoryPropertyFlags)(flags & preferred)) * 2 - std::popcount((VkMemoryPropertyFlags)(flags & avoided));
+			if (score > bestScore)
+			{
+				best = type;
+				bestScore = score;
+			}
+		}
+		return best;
+	}
+
+	vk::DeviceSize VulkanAllocator::GetBlockSize(uint32_t memoryType) const
+	{
+		// Small heaps, like the 256 MB host visible one without resizable BAR,
+		// shouldn't be taken up by a couple of blocks
+		vk::DeviceSize heapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryType].heapIndex].size;
+		return std::min(m_BlockSize, std::bit_floor(std::max<vk::DeviceSize>(heapSize / 8, 1)));
+	}
+
+	vk::DeviceMemory VulkanAllocator::AllocateDeviceMemory(vk::DeviceSize size, uint32_t memoryType, void** mappedData, const void* next)
+	{
+		PT_PROFILE_FUNCTION();
+
+		uint32_t heap = m_MemoryProperties.memoryTypes[memoryType].heapIndex;
+		if (m_HeapUsage[heap] + size > m_MemoryProperties.memoryHeaps[heap].size)
+			return vk::DeviceMemory();
+
+		vk::MemoryAllocateInfo allocateInfo(size, memoryType);
+		allocateInfo.pNext = next;
+
+		vk::DeviceMemory memory;
+		if (m_Device.allocateMemory(&allocateInfo, nullptr, &memory) != vk::Result::eSuccess)
+			return vk::DeviceMemory();
+
+		*mappedData = nullptr;
+		if (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+		{
+			if (m_Device.mapMemory(memory, 0, VK_WHOLE_SIZE, vk::MemoryMapFlags(), mappedData) != vk::Result::eSuccess)
+			{
+				m_Device.freeMemory(memory);
+				return vk::DeviceMemory();
+			}
+		}
+
+		m_HeapUsage[heap] += size;
+		m_DeviceAllocationCount++;
+		m_DeviceBytesMetric.Add((double)size);
+
+		if (m_DeviceAllocationCount == m_DeviceProperties.limits.maxMemoryAllocationCount)
+			PT_CORE_WARN("Reached the device's limit of {0} memory allocations", m_DeviceAllocationCount);
+
+		return memory;
+	}
+
+	void VulkanAllocator::FreeDeviceMemory(vk::DeviceMemory memory, vk::DeviceSize size, uint32_t memoryType)
+	{
+		// Freeing unmaps as well
+		m_Device.freeMemory(memory);
+
+		m_HeapUsage[m_MemoryProperties.memoryTypes[memoryType].heapIndex] -= size;
+		m_DeviceAllocationCount--;
+		m_DeviceBytesMetric.Add(-(double)size);
+	}
+
+	VulkanAllocation VulkanAllocator::AllocateDedicated(vk::DeviceSize size, uint32_t memoryType, const void* next)
+	{
+		VulkanAllocation allocation;
+		allocation.Memory = AllocateDeviceMemory(size, memoryType, &allocation.MappedData, next);
+		if (!allocation.Memory)
+			return allocation;
+
+		allocation.Size = size;
+		allocation.MemoryType = memoryType;
+		m_DedicatedCount[memoryType]++;
+		m_DedicatedBytes[memoryType] += size;
+		m_UsedBytesMetric.Add((double)size);
+		return allocation;
+	}
+
+	bool VulkanAllocator::AllocateFromBlocks(vk::DeviceSize size, vk::DeviceSize alignment, uint32_t memoryType, VulkanAllocation& allocation)
+	{
+		std::vector<std::unique_ptr<VulkanMemoryBlock>>& blocks = m_Blocks[memoryType];
+
+		// Newest blocks first, older ones are likelier to be full
+		VulkanMemoryBlock* block = nullptr;
+		TlsfAllocator::Allocation range;
+		for (auto it = blocks.rbegin(); it != blocks.rend() && !range.IsValid(); ++it)
+		{
+			block = it->get();
+			range = block->Ranges.Allocate(size, alignment);
+		}
+
+		if (!range.IsValid())
+		{
+			// Halve the block size when the driver refuses, as long as the
+			// request still fits
+			vk::DeviceSize blockSize = GetBlockSize(memoryType);
+			vk::DeviceMemory memory;
+			void* mappedData = nullptr;
+			for (; blockSize >= size && !memory; blockSize /= 2)
+				memory = AllocateDeviceMemory(blockSize, memoryType, &mappedData);
+			if (!memory)
+				return false;
+			blockSize *= 2;
+
+			blocks.push_back(std::make_unique<VulkanMemoryBlock>(blockSize));
+			block = blocks.back().get();
+			block->Memory = memory;
+			block->MappedData = mappedData;
+			block->MemoryType = memoryType;
+
+			range = block->Ranges.Allocate(size, alignment);
+			PT_CORE_ASSERT(range.IsValid(), "A new memory block is too small for the allocation it was made for");
+		}
+
+		allocation.Memory = block->Memory;
+		allocation.Offset = range.Offset;
+		allocation.Size = range.Size;
+		allocation.MappedData = block->MappedData ? (uint8_t*)block->MappedData + range.Offset : nullptr;
+		allocation.MemoryType = memoryType;
+		allocation.m_Block = block;
+		allocation.m_Range = range;
+		m_UsedBytesMetric.Add((double)range.Size);
+		return true;
+	}
+
+	VulkanAllocation VulkanAllocator::Allocate(const vk::MemoryRequirements& requirements, VulkanMemoryUsage usage, bool linear, bool dedicated)
+	{
+		PT_PROFILE_FUNCTION();
+
+		uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, usage);
+		if (memoryType == UINT32_MAX)
+		{
+			PT_CORE_ERROR("No memory type for a {0} byte allocation (type bits {1:#x})", requirements.size, requirements.memoryTypeBits);
+			return {};
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (dedicated || requirements.size > GetBlockSize(memoryType) / 2)
+			return AllocateDedicated(requirements.size, memoryType, nullptr);
+
+		// Optimal tiling images take whole pages of bufferImageGranularity,
+		// so linear resources never share a page with them
+		vk::DeviceSize size = requirements.size;
+		vk::DeviceSize alignment = std::max<vk::DeviceSize>(requirements.alignment, 1);
+		if (!linear)
+		{
+			vk::DeviceSize granularity = m_DeviceProperties.limits.bufferImageGranularity;
+			alignment = std::max(alignment, granularity);
+			size = AlignUp(size, granularity);
+		}
+
+		VulkanAllocation allocation;
+		if (!AllocateFromBlocks(size, alignment, memoryType, allocation))
+		{
+			PT_CORE_ERROR("Out of device memory for a {0} byte allocation in memory type {1}", size, memoryType);
+			return {};
+		}
+		return allocation;
+	}
+
+	void VulkanAllocator::Free(VulkanAllocation& allocation)
+	{
+		if (!allocation)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_UsedBytesMetric.Add(-(double)allocation.Size);
+
+		uint32_t type = allocation.MemoryType;
+		VulkanMemoryBlock* block = allocation.m_Block;
+		if (!block)
+		{
+			m_DedicatedCount[type]--;
+			m_DedicatedBytes[type] -= allocation.Size;
+			FreeDeviceMemory(allocation.Memory, allocation.Size, type);
+			allocation = VulkanAllocation();
+			return;
+		}
+
+		block->Ranges.Free(allocation.m_Range);
+		allocation = VulkanAllocation();
+
+		if (!block->Ranges.IsEmpty())
+			return;
+
+		// Keep one empty block around
+		std::vector<std::unique_ptr<VulkanMemoryBlock>>& blocks = m_Blocks[type];
+		uint32_t emptyBlocks = 0;
+		for (std::unique_ptr<VulkanMemoryBlock>& other : blocks)
+			emptyBlocks += other->Ranges.IsEmpty();
+		if (emptyBlocks < 2)
+			return;
+
+		auto it = std::find_if(blocks.begin(), blocks.end(), [block](const std::unique_ptr<VulkanMemoryBlock>& b) { return b.get() == block; });
+		FreeDeviceMemory(block->Memory, block->Ranges.GetSize(), type);
+		blocks.erase(it);
+	}
+
+	VulkanBuffer VulkanAllocator::CreateBuffer(const vk::BufferCreateInfo& createInfo, VulkanMemoryUsage usage)
+	{
+		VulkanBuffer buffer;
+		if (m_Device.createBuffer(&createInfo, nullptr, &buffer.Buffer) != vk::Result::eSuccess)
+			return {};
+
+		auto requirements = m_Device.getBufferMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(vk::BufferMemoryRequirementsInfo2(buffer.Buffer));
+		const vk::MemoryRequirements& memory = requirements.get<vk::MemoryRequirements2>().memoryRequirements;
+		const vk::MemoryDedicatedRequirements& dedicated = requirements.get<vk::MemoryDedicatedRequirements>();
+
+		if (dedicated.prefersDedicatedAllocation || dedicated.requiresDedicatedAllocation)
+		{
+			uint32_t memoryType = FindMemoryType(memory.memoryTypeBits, usage);
+			vk::MemoryDedicatedAllocateInfo dedicatedInfo(vk::Image(), buffer.Buffer);
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (memoryType != UINT32_MAX)
+				buffer.Allocation = AllocateDedicated(memory.size, memoryType, &dedicatedInfo);
+		}
+		else
+		{
+			buffer.Allocation = Allocate(memory, usage, true);
+		}
+
+		if (!buffer.Allocation)
+		{
+			m_Device.destroyBuffer(buffer.Buffer);
+			return {};
+		}
+
+		m_Device.bindBufferMemory(buffer.Buffer, buffer.Allocation.Memory, buffer.Allocation.Offset);
+		return buffer;
+	}
+
+	void VulkanAllocator::DestroyBuffer(VulkanBuffer& buffer)
+	{
+		if (buffer.Buffer)
+			m_Device.destroyBuffer(buffer.Buffer);
+		Free(buffer.Allocation);
+		buffer = VulkanBuffer();
+	}
+
+	VulkanImage VulkanAllocator::CreateImage(const vk::ImageCreateInfo& createInfo, VulkanMemoryUsage usage)
+	{
+		VulkanImage image;
+		if (m_Device.createImage(&createInfo, nullptr, &image.Image) != vk::Result::eSuccess)
+			return {};
+
+		auto requirements = m_Device.getImageMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(vk::ImageMemoryRequirementsInfo2(image.Image));
+		const vk::MemoryRequirements& memory = requirements.get<vk::MemoryRequirements2>().memoryRequirements;
+		const vk::MemoryDedicatedRequirements& dedicated = requirements.get<vk::MemoryDedicatedRequirements>();
+
+		if (dedicated.prefersDedicatedAllocation || dedicated.requiresDedicatedAllocation)
+		{
+			uint32_t memoryType = FindMemoryType(memory.memoryTypeBits, usage);
+			vk::MemoryDedicatedAllocateInfo dedicatedInfo(image.Image, vk::Buffer());
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (memoryType != UINT32_MAX)
+				image.Allocation = AllocateDedicated(memory.size, memoryType, &dedicatedInfo);
+		}
+		else
+		{
+			image.Allocation = Allocate(memory, usage, createInfo.tiling == vk::ImageTiling::eLinear);
+		}
+
+		if (!image.Allocation)
+		{
+			m_Device.destroyImage(image.Image);
+			return {};
+		}
+
+		m_Device.bindImageMemory(image.Image, image.Allocation.Memory, image.Allocation.Offset);
+		return image;
+	}
+
+	void VulkanAllocator::DestroyImage(VulkanImage& image)
+	{
+		if (image.Image)
+			m_Device.destroyImage(image.Image);
+		Free(image.Allocation);
+		image = VulkanImage();
+	}
+
+	vk::MappedMemoryRange VulkanAllocator::GetMappedRange(const VulkanAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const
+	{
+		// Ranges have to start and end on nonCoherentAtomSize, the memory
+		// around the allocation may be flushed along with it
+		vk::DeviceSize atom = m_DeviceProperties.limits.nonCoherentAtomSize;
+		if (size == VK_WHOLE_SIZE)
+			size = allocation.Size - offset;
+
+		vk::DeviceSize begin = (allocation.Offset + offset) / atom * atom;
+		vk::DeviceSize end = AlignUp(allocation.Offset + offset + size, atom);
+		vk::DeviceSize memorySize = allocation.m_Block ? allocation.m_Block->Ranges.GetSize() : allocation.Size;
+		if (end > memorySize)
+			return vk::MappedMemoryRange(allocation.Memory, begin, VK_WHOLE_SIZE);
+
+		return vk::MappedMemoryRange(allocation.Memory, begin, end - begin);
+	}
+
+	void VulkanAllocator::Flush(const VulkanAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size)
+	{
+		if (!allocation || IsCoherent(allocation))
+			return;
+
+		vk::MappedMemoryRange range = GetMappedRange(allocation, offset, size);
+		(void)m_Device.flushMappedMemoryRanges(1, &range);
+	}
+
+	void VulkanAllocator::Invalidate(const VulkanAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size)
+	{
+		if (!allocation || IsCoherent(allocation))
+			return;
+
+		vk::MappedMemoryRange range = GetMappedRange(allocation, offset, size);
+		(void)m_Device.invalidateMappedMemoryRanges(1, &range);
+	}
+
+	std::vector<VulkanHeapBudget> VulkanAllocator::GetBudgets() const
+	{
+		std::vector<VulkanHeapBudget> budgets(m_MemoryProperties.memoryHeapCount);
+
+		vk::PhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties;
+		if (m_MemoryBudget)
+		{
+			vk::PhysicalDeviceMemoryProperties2 properties;
+			properties.pNext = &budgetProperties;
+			m_PhysicalDevice.getMemoryProperties2(&properties);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (uint32_t heap = 0; heap < m_MemoryProperties.memoryHeapCount; heap++)
+		{
+			VulkanHeapBudget& budget = budgets[heap];
+			budget.Flags = m_MemoryProperties.memoryHeaps[heap].flags;
+			budget.Size = m_MemoryProperties.memoryHeaps[heap].size;
+
+			if (m_MemoryBudget)
+			{
+				budget.Budget = budgetProperties.heapBudget[heap];
+				budget.Usage = budgetProperties.heapUsage[heap];
+			}
+			else
+			{
+				// Other processes and the driver take their share as well
+				budget.Budget = budget.Size / 10 * 8;
+				budget.Usage = m_HeapUsage[heap];
+			}
+		}
+		return budgets;
+	}
+
+	VulkanAllocatorStats VulkanAllocator::GetStats() const
+	{
+		VulkanAllocatorStats stats;
+		stats.Heaps = GetBudgets();
+		stats.MemoryTypes.resize(m_MemoryProperties.memoryTypeCount);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		stats.DeviceAllocationCount = m_DeviceAllocationCount;
+		for (uint32_t type = 0; type < m_MemoryProperties.memoryTypeCount; type++)
+		{
+			VulkanMemoryTypeStats& typeStats = stats.MemoryTypes[type];
+			typeStats.Flags = m_MemoryProperties.memoryTypes[type].propertyFlags;
+			typeStats.Heap = m_MemoryProperties.memoryTypes[type].heapIndex;
+			typeStats.DedicatedCount = m_DedicatedCount[type];
+			typeStats.DedicatedBytes = m_DedicatedBytes[type];
+
+			for (const std::unique_ptr<VulkanMemoryBlock>& block : m_Blocks[type])
+			{
+				typeStats.BlockCount++;
+				typeStats.AllocationCount += block->Ranges.GetAllocationCount();
+				typeStats.FreeRangeCount += block->Ranges.GetFreeRangeCount();
+				typeStats.BlockBytes += block->Ranges.GetSize();
+				typeStats.UsedBytes += block->Ranges.GetUsedBytes();
+				typeStats.LargestFreeRange = std::max(typeStats.LargestFreeRange, block->Ranges.GetLargestFreeRange());
+			}
+		}
+		return stats;
+	}
+
+	void VulkanAllocator::LogStats() const
+	{
+		VulkanAllocatorStats stats = GetStats();
+
+		PT_CORE_REPORT("GPU memory report ({0} device allocations):", stats.DeviceAllocationCount);
+		for (size_t heap = 0; heap < stats.Heaps.size(); heap++)
+		{
+			const VulkanHeapBudget& budget = stats.Heaps[heap];
+			PT_CORE_REPORT("\tHeap {0} ({1}): {2} MB used of a {3} MB budget, {4} MB in total", heap, vk::to_string(budget.Flags),
+				budget.Usage >> 20, budget.Budget >> 20, budget.Size >> 20);
+		}
+
+		for (size_t type = 0; type < stats.MemoryTypes.size(); type++)
+		{
+			const VulkanMemoryTypeStats& typeStats = stats.MemoryTypes[type];
+			if (!typeStats.BlockCount && !typeStats.DedicatedCount)
+				continue;
+
+			PT_CORE_REPORT("\tType {0} ({1}): {2} allocations using {3} KB of {4} blocks with {5} KB, {6:.1f}% utilized, "
+				"{7} free ranges, {8:.1f}% fragmented, {9} dedicated allocations with {10} KB",
+				type, vk::to_string(typeStats.Flags), typeStats.AllocationCount, typeStats.UsedBytes >> 10, typeStats.BlockCount,
+				typeStats.BlockBytes >> 10, typeStats.GetUtilization() * 100.0, typeStats.FreeRangeCount, typeStats.GetFragmentation() * 100.0,
+				typeStats.DedicatedCount, typeStats.DedicatedBytes >> 10);
+		}
+	}
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "Photon/Core.h"
+#include "Photon/Memory/TlsfAllocator.h"
+#include "Photon/Metrics/Metrics.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Photon
+{
+	// What an allocation is used for, which decides the memory type
+	enum class VulkanMemoryUsage : uint8_t
+	{
+		// Only the GPU reads and writes it, e.g. textures and vertex buffers
+		GpuOnly = 0,
+		// Written by the CPU and read by the GPU, e.g. staging and uniforms
+		Upload,
+		// Written by the GPU and read back by the CPU
+		Readback
+	};
+
+	struct VulkanMemoryBlock;
+
+	// A range of device memory. Host visible memory stays mapped for the
+	// lifetime of the block it comes from, MappedData points at the range
+	struct VulkanAllocation
+	{
+		vk::DeviceMemory Memory;
+		vk::DeviceSize Offset = 0;
+		vk::DeviceSize Size = 0;
+		void* MappedData = nullptr;
+		uint32_t MemoryType = 0;
+
+		inline explicit operator bool() const { return (bool)Memory; }
+	private:
+		// Null for dedicated allocations
+		VulkanMemoryBlock* m_Block = nullptr;
+		TlsfAllocator::Allocation m_Range;
+
+		friend class VulkanAllocator;
+	};
+
+	struct VulkanBuffer
+	{
+		vk::Buffer Buffer;
+		VulkanAllocation Allocation;
+	};
+
+	struct VulkanImage
+	{
+		vk::Image Image;
+		VulkanAllocation Allocation;
+	};
+
+	struct VulkanHeapBudget
+	{
+		vk::MemoryHeapFlags Flags;
+		vk::DeviceSize Size = 0;
+		// How much the process may use and uses, across every allocator and
+		// the driver's own allocations. Without VK_EXT_memory_budget the
+		// budget is an estimate and the usage only counts this allocator
+		vk::DeviceSize Budget = 0;
+		vk::DeviceSize Usage = 0;
+	};
+
+	struct VulkanMemoryTypeStats
+	{
+		vk::MemoryPropertyFlags Flags;
+		uint32_t Heap = 0;
+
+		uint32_t BlockCount = 0;
+		uint32_t AllocationCount = 0;
+		uint32_t FreeRangeCount = 0;
+		vk::DeviceSize BlockBytes = 0;
+		vk::DeviceSize UsedBytes = 0;
+		vk::DeviceSize LargestFreeRange = 0;
+
+		uint32_t DedicatedCount = 0;
+		vk::DeviceSize DedicatedBytes = 0;
+
+		// Used share of the block memory
+		inline double GetUtilization() const { return BlockBytes ? (double)UsedBytes / BlockBytes : 0.0; }
+		// 0 when all free memory is one range, towards 1 the more it is split up
+		inline double GetFragmentation() const
+		{
+			vk::DeviceSize free = BlockBytes - UsedBytes;
+			return free ? 1.0 - (double)LargestFreeRange / free : 0.0;
+		}
+	};
+
+	struct VulkanAllocatorStats
+	{
+		// Indexed by memory type and heap
+		std::vector<VulkanMemoryTypeStats> MemoryTypes;
+		std::vector<VulkanHeapBudget> Heaps;
+		// Live vkAllocateMemory allocations, which drivers limit to maxMemoryAllocationCount
+		uint32_t DeviceAllocationCount = 0;
+	};
+
+	// Sub-allocates buffers and images from large blocks of device memory,
+	// one list of blocks per memory type, so the number of vkAllocateMemory
+	// calls stays small. Every block has a TlsfAllocator for its ranges.
+	// Resources the driver wants a dedicated allocation for, or that are
+	// larger than half a block, get memory of their own.
+	//
+	// Optimal tiling images are padded to bufferImageGranularity so they can
+	// share a block with buffers. Empty blocks are freed, except for one per
+	// memory type to keep allocation churn from reaching the driver.
+	//
+	// Thread safe.
+	class PHOTON_API VulkanAllocator
+	{
+	public:
+		// memoryBudget is whether VK_EXT_memory_budget is enabled on the device
+		VulkanAllocator(vk::PhysicalDevice physicalDevice, vk::Device device, bool memoryBudget, vk::DeviceSize blockSize = 64 * 1024 * 1024);
+		~VulkanAllocator();
+
+		VulkanAllocator(const VulkanAllocator&) = delete;
+		VulkanAllocator& operator=(const VulkanAllocator&) = delete;
+
+		// Returns an empty allocation when out of memory
+		VulkanAllocation Allocate(const vk::MemoryRequirements& requirements, VulkanMemoryUsage usage, bool linear = true, bool dedicated = false);
+		void Free(VulkanAllocation& allocation);
+
+		// Create the resource, allocate and bind its memory. An empty result
+		// means either failed
+		VulkanBuffer CreateBuffer(const vk::BufferCreateInfo& createInfo, VulkanMemoryUsage usage);
+		void DestroyBuffer(VulkanBuffer& buffer);
+		VulkanImage CreateImage(const vk::ImageCreateInfo& createInfo, VulkanMemoryUsage usage);
+		void DestroyImage(VulkanImage& image);
+
+		// Only needed for memory that isn't host coherent. The range is relative
+		// to the allocation
+		void Flush(const VulkanAllocation& allocation, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
+		void Invalidate(const VulkanAllocation& allocation, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
+
+		std::vector<VulkanHeapBudget> GetBudgets() const;
+		VulkanAllocatorStats GetStats() const;
+		// Logs utilization and fragmentation of every memory type in use
+		void LogStats() const;
+
+		inline const vk::PhysicalDeviceProperties& GetDeviceProperties() const { return m_DeviceProperties; }
+		inline bool IsCoherent(const VulkanAllocation& allocation) const
+		{
+			return (bool)(m_MemoryProperties.memoryTypes[allocation.MemoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+		}
+	private:
+		uint32_t FindMemoryType(uint32_t typeBits, VulkanMemoryUsage usage) const;
+		vk::DeviceSize GetBlockSize(uint32_t memoryType) const;
+		vk::DeviceMemory AllocateDeviceMemory(vk::DeviceSize size, uint32_t memoryType, void** mappedData, const void* next = nullptr);
+		void FreeDeviceMemory(vk::DeviceMemory memory, vk::DeviceSize size, uint32_t memoryType);
+		VulkanAllocation AllocateDedicated(vk::DeviceSize size, uint32_t memoryType, const void* next);
+		bool AllocateFromBlocks(vk::DeviceSize size, vk::DeviceSize alignment, uint32_t memoryType, VulkanAllocation& allocation);
+		vk::MappedMemoryRange GetMappedRange(const VulkanAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const;
+	private:
+		vk::PhysicalDevice m_PhysicalDevice;
+		vk::Device m_Device;
+		vk::PhysicalDeviceProperties m_DeviceProperties;
+		vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
+		bool m_MemoryBudget;
+		vk::DeviceSize m_BlockSize;
+
+		mutable std::mutex m_Mutex;
+		std::vector<std::unique_ptr<VulkanMemoryBlock>> m_Blocks[VK_MAX_MEMORY_TYPES];
+		uint32_t m_DedicatedCount[VK_MAX_MEMORY_TYPES] = {};
+		vk::DeviceSize m_DedicatedBytes[VK_MAX_MEMORY_TYPES] = {};
+		// Everything allocated from the driver, per heap
+		vk::DeviceSize m_HeapUsage[VK_MAX_MEMORY_HEAPS] = {};
+		uint32_t m_DeviceAllocationCount = 0;
+
+		Gauge& m_DeviceBytesMetric;
+		Gauge& m_UsedBytesMetric;
+	};
+}
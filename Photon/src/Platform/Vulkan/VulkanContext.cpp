@@ -0,0 +1,422 @@
+#include "ptpch.h"
+#include "VulkanContext.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+#include <set>
+
+namespace Photon
+{
+	static bool supported(const std::vector<const char*>& extensions, const std::vector<const char*>& layers)
+	{
+		// Supported Extensions
+		std::vector<vk::ExtensionProperties> supportedExtensions = vk::enumerateInstanceExtensionProperties();
+#ifdef PT_DEBUG
+		PT_CORE_INFO("Supported Extensions:");
+		for(auto& supportedExt : supportedExtensions)
+		{
+			PT_CORE_INFO("\t{0}", supportedExt.extensionName);
+		}
+#endif
+
+		// Finding the extension in the extension list
+		bool found;
+		for (const char* ext : extensions)
+		{
+			found = false;
+			for (auto& supportedExt : supportedExtensions)
+			{
+				if (strcmp(ext, supportedExt.extensionName) == 0)
+				{
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+				return false;
+		}
+
+		// Supported layers
+		std::vector<vk::LayerProperties> supportedLayers = vk::enumerateInstanceLayerProperties();
+#ifdef PT_DEBUG
+		PT_CORE_INFO("Supported Layers:");
+		for (auto& supportedLayer : supportedLayers)
+		{
+			PT_CORE_INFO("\t{0}", supportedLayer.layerName);
+		}
+#endif
+
+		// Finding the extension in the extension list
+		for (const char* layer : layers)
+		{
+			found = false;
+			for (auto& supportedLayer : supportedLayers)
+			{
+				if (strcmp(layer, supportedLayer.layerName) == 0)
+				{
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+				return false;
+		}
+
+		return true;
+	}
+
+	static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
+		VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+		VkDebugUtilsMessageTypeFlagsEXT messageType,
+		const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+		void* pUserData
+	)
+	{
+		std::string type = vk::to_string(static_cast<vk::DebugUtilsMessageSeverityFlagBitsEXT>(messageType));
+
+		switch (messageSeverity)
+		{
+		case (int)vk::DebugUtilsMessageSeverityFlagBitsEXT::eError:
+			PT_CORE_ERROR("VK Validation Layer ({0}): {1}", type, pCallbackData->pMessage);
+			break;
+		case (int)vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning:
+			PT_CORE_WARN("VK Validation Layer ({0}): {1}", type, pCallbackData->pMessage);
+			break;
+		case (int)vk::DebugUtilsMessageSeverityFlagBitsEXT::eInfo:
+			PT_CORE_INFO("VK Validation Layer ({0}): {1}", type, pCallbackData->pMessage);
+			break;
+		default:
+			PT_CORE_TRACE("VK Validation Layer ({0}): {1}", type, pCallbackData->pMessage);
+		}
+
+		return VK_FALSE;
+	}
+
+	static bool CheckDeviceExtensionSupport(const vk::PhysicalDevice& device, const std::vector<const char*>& requestedExtensions)
+	{
+		std::vector<vk::ExtensionProperties> extensions = device.enumerateDeviceExtensionProperties();
+		std::set<std::string> extensionsSet;
+		for (auto& ext : extensions)
+			extensionsSet.insert(ext.extensionName);
+
+		for (auto& reqExt : requestedExtensions)
+		{
+			if (!extensionsSet.contains(reqExt))
+				return false;
+		}
+
+		return true;
+	}
+
+	// Offscreen rendering takes any device with a graphics queue
+	static bool IsSuitable(const vk::PhysicalDevice& device, bool present)
+	{
+		static const std::vector<const char*> requestedExtensions = {
+			VK_KHR_SWAPCHAIN_EXTENSION_NAME
+		};
+
+		bool graphics = false;
+		for (const vk::QueueFamilyProperties& family : device.getQueueFamilyProperties())
+			graphics |= (bool)(family.queueFlags & vk::QueueFlagBits::eGraphics);
+
+		return graphics && (!present || CheckDeviceExtensionSupport(device, requestedExtensions));
+	}
+
+	bool VulkanContext::IsDeviceAvailable()
+	{
+		PT_PROFILE_FUNCTION();
+
+		// Without a loader or an ICD creating the instance already fails
+		try
+		{
+			vk::ApplicationInfo appInfo(nullptr, 0, nullptr, 0, VK_API_VERSION_1_0);
+			vk::Instance instance = vk::createInstance(vk::InstanceCreateInfo(vk::InstanceCreateFlags(), &appInfo));
+
+			bool available = false;
+			for (const vk::PhysicalDevice& device : instance.enumeratePhysicalDevices())
+				available |= IsSuitable(device, false);
+
+			instance.destroy();
+			return available;
+		}
+		catch (const vk::SystemError&)
+		{
+			return false;
+		}
+	}
+
+	VulkanContext::VulkanContext(const VulkanContextProps& props)
+	{
+		PT_PROFILE_FUNCTION();
+
+		CreateInstance(props);
+		CreateDevice(props);
+	}
+
+	VulkanContext::~VulkanContext()
+	{
+		PT_PROFILE_FUNCTION();
+
+		if (m_Device)
+			m_Device.waitIdle();
+
+		// Waits for the uploads still being copied
+		m_Uploader.reset();
+		// Waits for pipelines still compiling and saves the cache
+		m_PipelineManager.reset();
+		m_Allocator.reset();
+
+		if (m_Device)
+			m_Device.destroy();
+		if (m_DebugMessenger)
+			m_Instance.destroyDebugUtilsMessengerEXT(m_DebugMessenger, nullptr, vk::DispatchLoaderDynamic(m_Instance, vkGetInstanceProcAddr));
+		m_Instance.destroy();
+	}
+
+	void VulkanContext::CreateInstance(const VulkanContextProps& props)
+	{
+		PT_PROFILE_FUNCTION();
+
+		// Finds the instance version supported by the implementation
+		uint32_t version;
+		vkEnumerateInstanceVersion(&version);
+		m_ApiVersion = version;
+
+		// Outputs version info
+		PT_CORE_INFO("System supports Vulkan Variant: {0}, {1}.{2}.{3}",
+			VK_API_VERSION_VARIANT(version), VK_API_VERSION_MAJOR(version),
+			VK_API_VERSION_MINOR(version), VK_API_VERSION_PATCH(version));
+
+		vk::ApplicationInfo appInfo = vk::ApplicationInfo(
+			nullptr,
+			version,
+			nullptr,
+			version,
+			version
+		);
+
+		std::vector<const char*> extensions = props.InstanceExtensions;
+		#ifdef PT_DEBUG
+			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		#endif
+
+		#ifdef PT_DEBUG
+				m_Layers.push_back("VK_LAYER_KHRONOS_validation");
+		#endif
+
+		PT_CORE_ASSERT(supported(extensions, m_Layers), "Extensions not supported");
+
+		vk::InstanceCreateInfo instanceCreateInfo = vk::InstanceCreateInfo(
+			vk::InstanceCreateFlags(),
+			&appInfo,
+			(uint32_t)m_Layers.size(), m_Layers.data(), // enabled layers
+			(uint32_t)extensions.size(), extensions.data() // enabled extensions
+		);
+
+		try
+		{
+			PT_PROFILE_SCOPE("vk::createInstance");
+			m_Instance = vk::createInstance(instanceCreateInfo);
+		}
+		catch (vk::SystemError e)
+		{
+			PT_CORE_ASSERT(false, "Could not create Vulkan instance ({0})", e.what());
+		}
+
+#ifdef PT_DEBUG
+		vk::DispatchLoaderDynamic dldi(m_Instance, vkGetInstanceProcAddr);
+
+		// Create Debug Messenger
+		vk::DebugUtilsMessengerCreateInfoEXT dmCreateInfo = vk::DebugUtilsMessengerCreateInfoEXT(
+			vk::DebugUtilsMessengerCreateFlagsEXT(),
+			//vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose | vk::DebugUtilsMessageSeverityFlagBitsEXT::eInfo |
+			vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning | vk::DebugUtilsMessageSeverityFlagBitsEXT::eError,
+			vk::DebugUtilsMessageTypeFlagBitsEXT::eGeneral | vk::DebugUtilsMessageTypeFlagBitsEXT::eValidation |
+			vk::DebugUtilsMessageTypeFlagBitsEXT::ePerformance | vk::DebugUtilsMessageTypeFlagBitsEXT::eDeviceAddressBinding,
+			debugCallback,
+			nullptr
+		);
+
+		m_DebugMessenger = m_Instance.createDebugUtilsMessengerEXT(dmCreateInfo, nullptr, dldi);
+#endif
+	}
+
+	void VulkanContext::CreateDevice(const VulkanContextProps& props)
+	{
+		PT_PROFILE_FUNCTION();
+
+		// Set physical device
+		std::vector<vk::PhysicalDevice> availableDevices = m_Instance.enumeratePhysicalDevices();
+
+		PT_CORE_INFO("Devices:");
+		for (auto& device : availableDevices)
+		{
+			auto properties = device.getProperties();
+			PT_CORE_INFO("\tDevice Name: {0}", properties.deviceName);
+
+			if (IsSuitable(device, props.Present)) {
+				m_PhysicalDevice = device;
+				PT_CORE_INFO("\tSelected Physical Device: {0}", m_PhysicalDevice.getProperties().deviceName);
+				break;
+			}
+		}
+
+		PT_CORE_ASSERT(m_PhysicalDevice, "No suitable Vulkan device");
+
+		// Getting queue families. Besides graphics, families without
+		// graphics are looked for, their queues run next to it: one with
+		// compute for async compute and a transfer only one for uploads
+		std::optional<uint32_t> graphicsFamily, computeFamily, transferFamily;
+		std::vector<vk::QueueFamilyProperties> queueFamilies = m_PhysicalDevice.getQueueFamilyProperties();
+
+		for (uint32_t i = 0; i < (uint32_t)queueFamilies.size(); i++)
+		{
+			vk::QueueFlags flags = queueFamilies[i].queueFlags;
+			if (flags & vk::QueueFlagBits::eGraphics)
+			{
+				if (!graphicsFamily.has_value())
+					graphicsFamily = i;
+			}
+			else if (flags & vk::QueueFlagBits::eCompute)
+			{
+				if (!computeFamily.has_value())
+					computeFamily = i;
+			}
+			else if (flags & vk::QueueFlagBits::eTransfer)
+			{
+				if (!transferFamily.has_value())
+					transferFamily = i;
+			}
+		}
+
+		// Graphics and compute families can always transfer
+		if (!computeFamily.has_value())
+			computeFamily = graphicsFamily;
+		if (!transferFamily.has_value())
+			transferFamily = computeFamily;
+
+		m_GraphicsFamily = graphicsFamily.value();
+		m_ComputeFamily = computeFamily.value();
+		m_TransferFamily = transferFamily.value();
+		m_TimestampBits = queueFamilies[m_GraphicsFamily].timestampValidBits;
+
+		PT_CORE_INFO("Queue families: graphics {0}, compute {1}, transfer {2}", m_GraphicsFamily, m_ComputeFamily, m_TransferFamily);
+
+		// Every role gets a queue of its own while the family has enough,
+		// after that it shares the family's last one
+		std::unordered_map<uint32_t, uint32_t> queueCounts;
+		auto nextQueue = [&](uint32_t family)
+		{
+			return std::min(queueCounts[family]++, queueFamilies[family].queueCount - 1);
+		};
+		uint32_t graphicsIndex = nextQueue(m_GraphicsFamily);
+		uint32_t transferIndex = nextQueue(m_TransferFamily);
+		uint32_t computeIndex = nextQueue(m_ComputeFamily);
+
+		// Setting logical device. Uploads and async compute yield to rendering
+		std::vector<std::vector<float>> queuePriorities;
+		std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
+		queuePriorities.reserve(queueCounts.size());
+		for (auto [family, count] : queueCounts)
+		{
+			count = std::min(count, queueFamilies[family].queueCount);
+			std::vector<float>& priorities = queuePriorities.emplace_back(count, 0.5f);
+			if (family == m_GraphicsFamily)
+				priorities[0] = 1.0f;
+
+			queueCreateInfos.push_back(vk::DeviceQueueCreateInfo(
+				vk::DeviceQueueCreateFlags(),
+				family,
+				count, priorities.data()
+			));
+		}
+
+		vk::PhysicalDeviceFeatures deviceFeatures = {};
+		deviceFeatures.samplerAnisotropy = m_PhysicalDevice.getFeatures().samplerAnisotropy;
+
+		// Every device picked for presenting has it, see IsSuitable
+		std::vector<const char*> deviceExtensions;
+		if (props.Present)
+			deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+		// Pipeline creation feedback reports pipeline cache hits. It is core
+		// from Vulkan 1.3, before that it is an extension
+		uint32_t deviceVersion = std::min(m_ApiVersion, m_PhysicalDevice.getProperties().apiVersion);
+		bool creationFeedback = deviceVersion >= VK_API_VERSION_1_3;
+		if (!creationFeedback && CheckDeviceExtensionSupport(m_PhysicalDevice, { VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME }))
+		{
+			deviceExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+			creationFeedback = true;
+		}
+
+		// Lets the allocator see how much memory the whole process may use
+		bool memoryBudget = CheckDeviceExtensionSupport(m_PhysicalDevice, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME });
+		if (memoryBudget)
+			deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		// Timeline semaphores hand uploads over to graphics, they are core
+		// from Vulkan 1.2
+		vk::PhysicalDeviceVulkan12Features supported12;
+		if (deviceVersion >= VK_API_VERSION_1_2)
+		{
+			vk::PhysicalDeviceFeatures2 features2(vk::PhysicalDeviceFeatures(), &supported12);
+			m_PhysicalDevice.getFeatures2(&features2);
+		}
+		bool timelineSemaphores = supported12.timelineSemaphore;
+		vk::PhysicalDeviceVulkan12Features enabled12;
+		enabled12.timelineSemaphore = timelineSemaphores;
+
+		vk::DeviceCreateInfo logicalDeviceCreateInfo = vk::DeviceCreateInfo(
+			vk::DeviceCreateFlags(),
+			(uint32_t)queueCreateInfos.size(), queueCreateInfos.data(),
+			(uint32_t)m_Layers.size(), m_Layers.data(),
+			(uint32_t)deviceExtensions.size(), deviceExtensions.data(),
+			&deviceFeatures
+		);
+		if (timelineSemaphores)
+			logicalDeviceCreateInfo.setPNext(&enabled12);
+
+		try
+		{
+			PT_PROFILE_SCOPE("vk::PhysicalDevice::createDevice");
+			m_Device = m_PhysicalDevice.createDevice(logicalDeviceCreateInfo);
+		}
+		catch (vk::SystemError e)
+		{
+			PT_CORE_ASSERT(false, "Could not create the logical device ({0})", e.what());
+		}
+
+		// Getting the queues from device
+		m_GraphicsQueue = m_Device.getQueue(m_GraphicsFamily, graphicsIndex);
+		m_TransferQueue = m_Device.getQueue(m_TransferFamily, transferIndex);
+		m_ComputeQueue = m_Device.getQueue(m_ComputeFamily, computeIndex);
+		if (m_ComputeQueue == m_GraphicsQueue || m_ComputeQueue == m_TransferQueue)
+		{
+			PT_CORE_INFO("No queue left for async compute");
+			m_ComputeQueue = nullptr;
+		}
+
+		m_Allocator = std::make_unique<VulkanAllocator>(m_PhysicalDevice, m_Device, memoryBudget);
+
+		// The uploader submits from any thread. Devices with a single queue,
+		// like lavapipe and many integrated GPUs, get it to share the
+		// graphics queue, with every submit to it serialized
+		if (timelineSemaphores)
+		{
+			bool shared = m_TransferQueue == m_GraphicsQueue;
+			if (shared)
+				PT_CORE_INFO("No queue left for uploads, they share the graphics queue");
+			m_Uploader = std::make_unique<VulkanUploader>(m_Device, *m_Allocator, m_TransferFamily, m_TransferQueue, m_GraphicsFamily,
+				shared ? &m_GraphicsQueueMutex : nullptr);
+			if (!m_Uploader->IsValid())
+				m_Uploader.reset();
+		}
+		else
+		{
+			PT_CORE_WARN("No timeline semaphores, uploads are not available");
+		}
+		m_PipelineManager = std::make_unique<VulkanPipelineManager>(m_PhysicalDevice, m_Device, props.PipelineCachePath, creationFeedback);
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Photon/Core.h"
+#include "Platform/Vulkan/VulkanAllocator.h"
+#include "Platform/Vulkan/VulkanPipelineManager.h"
+#include "Platform/Vulkan/VulkanUploader.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Photon
+{
+	struct VulkanContextProps
+	{
+		// What the surface needs, e.g. from glfwGetRequiredInstanceExtensions.
+		// Empty for a device that only renders offscreen
+		std::vector<const char*> InstanceExtensions;
+		// Picks a device with VK_KHR_swapchain
+		bool Present = false;
+		std::string PipelineCachePath = "Cache";
+	};
+
+	// The instance, device and queues, with what is shared by everything
+	// rendering on them: the allocator, the uploader and the pipeline
+	// manager. Needs no window, a device without a surface renders into
+	// offscreen images.
+	class PHOTON_API VulkanContext
+	{
+	public:
+		VulkanContext(const VulkanContextProps& props);
+		// Waits for the device to go idle
+		~VulkanContext();
+
+		VulkanContext(const VulkanContext&) = delete;
+		VulkanContext& operator=(const VulkanContext&) = delete;
+
+		// Whether a device that can render offscreen is present, e.g. to skip
+		// GPU work where there is no driver. The constructor asserts on one
+		static bool IsDeviceAvailable();
+
+		inline vk::Instance GetInstance() const { return m_Instance; }
+		inline vk::PhysicalDevice GetPhysicalDevice() const { return m_PhysicalDevice; }
+		inline vk::Device GetDevice() const { return m_Device; }
+
+		inline uint32_t GetGraphicsFamily() const { return m_GraphicsFamily; }
+		inline vk::Queue GetGraphicsQueue() const { return m_GraphicsQueue; }
+		// Present goes through the graphics queue
+		inline vk::Queue GetPresentQueue() const { return m_GraphicsQueue; }
+		// Null when the device has no queue left for it, of GetComputeFamily
+		inline vk::Queue GetComputeQueue() const { return m_ComputeQueue; }
+		inline uint32_t GetComputeFamily() const { return m_ComputeFamily; }
+		// Held around every submit, present and wait for idle on the graphics
+		// queue, the uploader shares it on devices with a single queue
+		inline std::mutex& GetGraphicsQueueMutex() { return m_GraphicsQueueMutex; }
+		// Bits of the graphics queue's timestamps, 0 when it has none
+		inline uint32_t GetTimestampBits() const { return m_TimestampBits; }
+
+		inline VulkanAllocator& GetAllocator() { return *m_Allocator; }
+		inline VulkanPipelineManager& GetPipelineManager() { return *m_PipelineManager; }
+		// Null without timeline semaphores
+		inline VulkanUploader* GetUploader() { return m_Uploader.get(); }
+	private:
+		void CreateInstance(const VulkanContextProps& props);
+		void CreateDevice(const VulkanContextProps& props);
+	private:
+		vk::Instance m_Instance;
+		vk::DebugUtilsMessengerEXT m_DebugMessenger;
+		vk::PhysicalDevice m_PhysicalDevice;
+		vk::Device m_Device;
+		uint32_t m_ApiVersion = VK_API_VERSION_1_0;
+		std::vector<const char*> m_Layers;
+
+		uint32_t m_GraphicsFamily = 0;
+		uint32_t m_ComputeFamily = 0;
+		uint32_t m_TransferFamily = 0;
+		vk::Queue m_GraphicsQueue;
+		vk::Queue m_ComputeQueue;
+		vk::Queue m_TransferQueue;
+		std::mutex m_GraphicsQueueMutex;
+		uint32_t m_TimestampBits = 0;
+
+		std::unique_ptr<VulkanAllocator> m_Allocator;
+		std::unique_ptr<VulkanUploader> m_Uploader;
+		std::unique_ptr<VulkanPipelineManager> m_PipelineManager;
+	};
+}
@@ -0,0 +1,451 @@
+#include "ptpch.h"
+#include "VulkanPipelineManager.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Photon
+{
+	VulkanPipelineStatus VulkanPipelineHandle::GetStatus() const
+	{
+		return m_Entry ? m_Entry->Status.load(std::memory_order_acquire) : VulkanPipelineStatus::Failed;
+	}
+
+	vk::Pipeline VulkanPipelineHandle::Get() const
+	{
+		return IsReady() ? m_Entry->Pipeline : vk::Pipeline();
+	}
+
+	// Precedes the driver's cache data in the file
+	struct PipelineCacheFileHeader
+	{
+		char Magic[4] = { 'P', 'T', 'P', 'C' };
+		uint32_t Version = 1;
+		uint32_t VendorID = 0;
+		uint32_t DeviceID = 0;
+		uint32_t DriverVersion = 0;
+		uint8_t PipelineCacheUUID[VK_UUID_SIZE] = {};
+		uint8_t DeviceUUID[VK_UUID_SIZE] = {};
+		uint8_t DriverUUID[VK_UUID_SIZE] = {};
+		uint32_t Reserved = 0;
+		uint64_t DataSize = 0;
+		uint64_t DataHash = 0;
+	};
+	static_assert(sizeof(PipelineCacheFileHeader) == 88, "The pipeline cache file header has padding");
+
+	static inline uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	template<typename T>
+	static inline uint64_t HashValue(const T& value, uint64_t hash)
+	{
+		static_assert(std::has_unique_object_representations_v<T> || std::is_enum_v<T>, "Only types without padding can be hashed bytewise");
+		return Fnv1a(&value, sizeof(T), hash);
+	}
+
+	template<typename T>
+	static inline uint64_t HashArray(const std::vector<T>& values, uint64_t hash)
+	{
+		hash = HashValue(values.size(), hash);
+		return values.empty() ? hash : Fnv1a(values.data(), values.size() * sizeof(T), hash);
+	}
+
+	template<typename T>
+	static inline uint64_t HashHandle(T handle, uint64_t hash)
+	{
+		auto raw = (typename T::CType)handle;
+		return Fnv1a(&raw, sizeof(raw), hash);
+	}
+
+	static uint64_t HashStage(const VulkanShaderStage& stage, uint64_t hash)
+	{
+		hash = HashValue(stage.Stage, hash);
+		hash = HashArray(stage.Code, hash);
+		return Fnv1a(stage.EntryPoint.data(), stage.EntryPoint.size() + 1, hash);
+	}
+
+	static uint64_t HashDesc(const VulkanGraphicsPipelineDesc& desc)
+	{
+		uint64_t hash = Fnv1a("graphics", 8);
+		for (const VulkanShaderStage& stage : desc.Stages)
+			hash = HashStage(stage, hash);
+
+		// The vk:: structs are plain 32 bit fields, they are hashed through
+		// their C counterparts
+		for (const vk::VertexInputBindingDescription& binding : desc.VertexBindings)
+			hash = HashValue((const VkVertexInputBindingDescription&)binding, hash);
+		for (const vk::VertexInputAttributeDescription& attribute : desc.VertexAttributes)
+			hash = HashValue((const VkVertexInputAttributeDescription&)attribute, hash);
+		for (const vk::PipelineColorBlendAttachmentState& blend : desc.ColorBlend)
+			hash = HashValue((const VkPipelineColorBlendAttachmentState&)blend, hash);
+
+		hash = HashValue(desc.Topology, hash);
+		hash = HashValue(desc.PolygonMode, hash);
+		hash = HashValue((VkCullModeFlags)desc.CullMode, hash);
+		hash = HashValue(desc.FrontFace, hash);
+		hash = HashValue(desc.Samples, hash);
+		hash = HashValue(desc.DepthTest, hash);
+		hash = HashValue(desc.DepthWrite, hash);
+		hash = HashValue(desc.DepthCompare, hash);
+		hash = HashHandle(desc.Layout, hash);
+		hash = HashHandle(desc.RenderPass, hash);
+		return HashValue(desc.Subpass, hash);
+	}
+
+	static uint64_t HashDesc(const VulkanComputePipelineDesc& desc)
+	{
+		uint64_t hash = HashStage(desc.Shader, Fnv1a("compute", 7));
+		return HashHandle(desc.Layout, hash);
+	}
+
+	static PipelineCacheFileHeader MakeFileHeader(vk::PhysicalDevice physicalDevice)
+	{
+		auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+		const vk::PhysicalDeviceProperties& device = properties.get<vk::PhysicalDeviceProperties2>().properties;
+		const vk::PhysicalDeviceIDProperties& ids = properties.get<vk::PhysicalDeviceIDProperties>();
+
+		PipelineCacheFileHeader header;
+		header.VendorID = device.vendorID;
+		header.DeviceID = device.deviceID;
+		header.DriverVersion = device.driverVersion;
+		memcpy(header.PipelineCacheUUID, device.pipelineCacheUUID.data(), VK_UUID_SIZE);
+		memcpy(header.DeviceUUID, ids.deviceUUID.data(), VK_UUID_SIZE);
+		memcpy(header.DriverUUID, ids.driverUUID.data(), VK_UUID_SIZE);
+		return header;
+	}
+
+	VulkanPipelineManager::VulkanPipelineManager(vk::PhysicalDevice physicalDevice, vk::Device device, const std::string& cacheDirectory, bool creationFeedback)
+		: m_PhysicalDevice(physicalDevice), m_Device(device), m_CreationFeedback(creationFeedback),
+		m_CompileTimeMetric(Metrics::GetHistogram("vulkan.pipeline.compile_ns")),
+		m_CacheHitMetric(Metrics::GetCounter("vulkan.pipeline.cache_hits")),
+		m_CacheMissMetric(Metrics::GetCounter("vulkan.pipeline.cache_misses"))
+	{
+		PT_PROFILE_FUNCTION();
+
+		PipelineCacheFileHeader header = MakeFileHeader(m_PhysicalDevice);
+		uint64_t key = Fnv1a(header.DriverUUID, VK_UUID_SIZE, Fnv1a(header.DeviceUUID, VK_UUID_SIZE));
+
+		std::error_code error;
+		std::filesystem::create_directories(cacheDirectory, error);
+		m_CachePath = (std::filesystem::path(cacheDirectory) / fmt::format("PipelineCache-{0:016x}.bin", key)).string();
+
+		std::vector<uint8_t> data = LoadCache();
+		try
+		{
+			m_Cache = m_Device.createPipelineCache(vk::PipelineCacheCreateInfo(vk::PipelineCacheCreateFlags(), data.size(), data.data()));
+			m_LoadedCacheBytes = data.size();
+		}
+		catch (vk::SystemError& e)
+		{
+			PT_CORE_WARN("Driver rejected the pipeline cache '{0}' ({1}), starting empty", m_CachePath, e.what());
+			m_Cache = m_Device.createPipelineCache(vk::PipelineCacheCreateInfo());
+		}
+
+		if (m_LoadedCacheBytes)
+			PT_CORE_INFO("Loaded {0} KB pipeline cache from '{1}'", m_LoadedCacheBytes / 1024, m_CachePath);
+	}
+
+	VulkanPipelineManager::~VulkanPipelineManager()
+	{
+		PT_PROFILE_FUNCTION();
+
+		WaitAll();
+		Save();
+
+		for (VulkanPipelineEntry& entry : m_Entries)
+		{
+			if (entry.Pipeline)
+				m_Device.destroyPipeline(entry.Pipeline);
+		}
+		m_Device.destroyPipelineCache(m_Cache);
+	}
+
+	std::vector<uint8_t> VulkanPipelineManager::LoadCache()
+	{
+		std::ifstream file(m_CachePath, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return {};
+
+		size_t fileSize = (size_t)file.tellg();
+		file.seekg(0);
+
+		PipelineCacheFileHeader expected = MakeFileHeader(m_PhysicalDevice);
+		PipelineCacheFileHeader header;
+		if (fileSize < sizeof(header) || !file.read((char*)&header, sizeof(header)))
+		{
+			PT_CORE_WARN("Pipeline cache '{0}' is truncated, ignoring it", m_CachePath);
+			return {};
+		}
+
+		expected.DataSize = header.DataSize;
+		expected.DataHash = header.DataHash;
+		if (memcmp(&header, &expected, sizeof(header)) != 0)
+		{
+			PT_CORE_INFO("Pipeline cache '{0}' is from another device or driver version, ignoring it", m_CachePath);
+			return {};
+		}
+
+		std::vector<uint8_t> data(fileSize - sizeof(header));
+		if (header.DataSize != data.size() || !file.read((char*)data.data(), data.size())
+			|| Fnv1a(data.data(), data.size()) != header.DataHash)
+		{
+			PT_CORE_WARN("Pipeline cache '{0}' is corrupt, ignoring it", m_CachePath);
+			return {};
+		}
+
+		// The driver's own header has to agree as well
+		VkPipelineCacheHeaderVersionOne driverHeader;
+		if (data.size() < sizeof(driverHeader))
+			return {};
+
+		memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+		if (driverHeader.headerSize < sizeof(driverHeader) || driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			|| driverHeader.vendorID != expected.VendorID || driverHeader.deviceID != expected.DeviceID
+			|| memcmp(driverHeader.pipelineCacheUUID, expected.PipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			PT_CORE_WARN("Pipeline cache '{0}' has a mismatching driver header, ignoring it", m_CachePath);
+			return {};
+		}
+
+		return data;
+	}
+
+	bool VulkanPipelineManager::Save()
+	{
+		PT_PROFILE_FUNCTION();
+
+		std::vector<uint8_t> data = m_Device.getPipelineCacheData(m_Cache);
+
+		PipelineCacheFileHeader header = MakeFileHeader(m_PhysicalDevice);
+		header.DataSize = data.size();
+		header.DataHash = Fnv1a(data.data(), data.size());
+
+		// Written next to the cache and renamed over it, so a crash while
+		// saving leaves the previous cache intact
+		std::string tempPath = m_CachePath + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			file.write((const char*)&header, sizeof(header));
+			file.write((const char*)data.data(), data.size());
+			if (!file)
+			{
+				PT_CORE_ERROR("Could not write the pipeline cache to '{0}'", tempPath);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, m_CachePath, error);
+		if (error)
+		{
+			PT_CORE_ERROR("Could not replace the pipeline cache '{0}' ({1})", m_CachePath, error.message());
+			return false;
+		}
+
+		PT_CORE_INFO("Saved {0} KB pipeline cache to '{1}'", data.size() / 1024, m_CachePath);
+		return true;
+	}
+
+	VulkanPipelineHandle VulkanPipelineManager::Compile(const std::string& name, VulkanGraphicsPipelineDesc desc)
+	{
+		uint64_t key = HashDesc(desc);
+		return Submit(name, key, std::move(desc));
+	}
+
+	VulkanPipelineHandle VulkanPipelineManager::Compile(const std::string& name, VulkanComputePipelineDesc desc)
+	{
+		uint64_t key = HashDesc(desc);
+		return Submit(name, key, std::move(desc));
+	}
+
+	VulkanPipelineHandle VulkanPipelineManager::Submit(const std::string& name, uint64_t key, std::variant<VulkanGraphicsPipelineDesc, VulkanComputePipelineDesc>&& desc)
+	{
+		m_Requested.fetch_add(1, std::memory_order_relaxed);
+
+		VulkanPipelineEntry* entry;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto [begin, end] = m_EntriesByKey.equal_range(key);
+			for (auto it = begin; it != end; ++it)
+			{
+				// The hash alone could hand back a pipeline built from
+				// something else
+				if (it->second->Desc == desc)
+				{
+					m_Deduplicated.fetch_add(1, std::memory_order_relaxed);
+					return VulkanPipelineHandle(it->second);
+				}
+			}
+
+			entry = &m_Entries.emplace_back();
+			entry->Manager = this;
+			entry->Name = name;
+			entry->Desc = std::move(desc);
+			m_EntriesByKey.emplace(key, entry);
+		}
+
+		// Scheduled outside the lock, without a job system it runs right here
+		Job job;
+		job.Function = CompileJob;
+		job.Data = entry;
+		JobSystem::Schedule(job, entry->Counter);
+
+		return VulkanPipelineHandle(entry);
+	}
+
+	void VulkanPipelineManager::CompileJob(void* data, uint32_t, uint32_t)
+	{
+		VulkanPipelineEntry& entry = *(VulkanPipelineEntry*)data;
+		entry.Manager->Build(entry);
+	}
+
+	void VulkanPipelineManager::Build(VulkanPipelineEntry& entry)
+	{
+		PT_PROFILE_FUNCTION();
+
+		using Clock = std::chrono::steady_clock;
+		Clock::time_point start = Clock::now();
+
+		vk::PipelineCreationFeedback feedback;
+		vk::PipelineCreationFeedbackCreateInfo feedbackInfo(&feedback, 0, nullptr);
+		const void* next = m_CreationFeedback ? &feedbackInfo : nullptr;
+
+		std::vector<vk::ShaderModule> modules;
+		vk::Pipeline pipeline;
+		try
+		{
+			if (VulkanGraphicsPipelineDesc* graphics = std::get_if<VulkanGraphicsPipelineDesc>(&entry.Desc))
+				pipeline = BuildGraphics(*graphics, modules, next);
+			else
+				pipeline = BuildCompute(std::get<VulkanComputePipelineDesc>(entry.Desc), modules, next);
+		}
+		catch (vk::SystemError& e)
+		{
+			PT_CORE_ERROR("Pipeline '{0}' failed to compile ({1})", entry.Name, e.what());
+		}
+
+		for (vk::ShaderModule module : modules)
+			m_Device.destroyShaderModule(module);
+
+		std::chrono::nanoseconds duration = Clock::now() - start;
+		m_CompileTimeMetric.Record(duration);
+
+		bool cacheHit = false;
+		if (pipeline && (feedback.flags & vk::PipelineCreationFeedbackFlagBits::eValid))
+		{
+			cacheHit = (bool)(feedback.flags & vk::PipelineCreationFeedbackFlagBits::eApplicationPipelineCacheHit);
+			(cacheHit ? m_CacheHits : m_CacheMisses).fetch_add(1, std::memory_order_relaxed);
+			(cacheHit ? m_CacheHitMetric : m_CacheMissMetric).Increment();
+		}
+
+		if (!pipeline)
+		{
+			m_Failed.fetch_add(1, std::memory_order_relaxed);
+			entry.Status.store(VulkanPipelineStatus::Failed, std::memory_order_release);
+			return;
+		}
+
+		PT_CORE_TRACE("Compiled pipeline '{0}' in {1:.2f} ms{2}", entry.Name, duration.count() / 1e6, cacheHit ? " (cache hit)" : "");
+
+		m_Compiled.fetch_add(1, std::memory_order_relaxed);
+		entry.Pipeline = pipeline;
+		entry.Status.store(VulkanPipelineStatus::Ready, std::memory_order_release);
+	}
+
+	vk::Pipeline VulkanPipelineManager::BuildGraphics(const VulkanGraphicsPipelineDesc& desc, std::vector<vk::ShaderModule>& modules, const void* next)
+	{
+		std::vector<vk::PipelineShaderStageCreateInfo> stages;
+		for (const VulkanShaderStage& stage : desc.Stages)
+		{
+			modules.push_back(m_Device.createShaderModule(vk::ShaderModuleCreateInfo(vk::ShaderModuleCreateFlags(), stage.Code.size() * sizeof(uint32_t), stage.Code.data())));
+			stages.emplace_back(vk::PipelineShaderStageCreateFlags(), stage.Stage, modules.back(), stage.EntryPoint.c_str());
+		}
+
+		vk::PipelineVertexInputStateCreateInfo vertexInput(vk::PipelineVertexInputStateCreateFlags(), desc.VertexBindings, desc.VertexAttributes);
+		vk::PipelineInputAssemblyStateCreateInfo inputAssembly(vk::PipelineInputAssemblyStateCreateFlags(), desc.Topology, false);
+		vk::PipelineViewportStateCreateInfo viewport(vk::PipelineViewportStateCreateFlags(), 1, nullptr, 1, nullptr);
+
+		vk::PipelineRasterizationStateCreateInfo rasterization(vk::PipelineRasterizationStateCreateFlags(), false, false,
+			desc.PolygonMode, desc.CullMode, desc.FrontFace, false, 0.0f, 0.0f, 0.0f, 1.0f);
+		vk::PipelineMultisampleStateCreateInfo multisample(vk::PipelineMultisampleStateCreateFlags(), desc.Samples);
+		vk::PipelineDepthStencilStateCreateInfo depthStencil(vk::PipelineDepthStencilStateCreateFlags(), desc.DepthTest, desc.DepthWrite, desc.DepthCompare);
+		vk::PipelineColorBlendStateCreateInfo colorBlend(vk::PipelineColorBlendStateCreateFlags(), false, vk::LogicOp::eCopy, desc.ColorBlend);
+
+		std::array<vk::DynamicState, 2> dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+		vk::PipelineDynamicStateCreateInfo dynamicState(vk::PipelineDynamicStateCreateFlags(), dynamicStates);
+
+		vk::GraphicsPipelineCreateInfo createInfo(vk::PipelineCreateFlags(), stages, &vertexInput, &inputAssembly, nullptr,
+			&viewport, &rasterization, &multisample, &depthStencil, &colorBlend, &dynamicState, desc.Layout, desc.RenderPass, desc.Subpass);
+		createInfo.pNext = next;
+
+		return m_Device.createGraphicsPipeline(m_Cache, createInfo).value;
+	}
+
+	vk::Pipeline VulkanPipelineManager::BuildCompute(const VulkanComputePipelineDesc& desc, std::vector<vk::ShaderModule>& modules, const void* next)
+	{
+		const VulkanShaderStage& shader = desc.Shader;
+		modules.push_back(m_Device.createShaderModule(vk::ShaderModuleCreateInfo(vk::ShaderModuleCreateFlags(), shader.Code.size() * sizeof(uint32_t), shader.Code.data())));
+
+		vk::ComputePipelineCreateInfo createInfo(vk::PipelineCreateFlags(),
+			vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eCompute, modules.back(), shader.EntryPoint.c_str()),
+			desc.Layout);
+		createInfo.pNext = next;
+
+		return m_Device.createComputePipeline(m_Cache, createInfo).value;
+	}
+
+	vk::Pipeline VulkanPipelineManager::Wait(VulkanPipelineHandle handle)
+	{
+		if (!handle.IsValid())
+			return vk::Pipeline();
+
+		JobSystem::Wait(handle.m_Entry->Counter);
+		return handle.Get();
+	}
+
+	void VulkanPipelineManager::WaitAll()
+	{
+		// Waiting runs other jobs, which may request pipelines themselves, so
+		// the lock isn't held while waiting
+		std::vector<VulkanPipelineEntry*> entries;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			for (VulkanPipelineEntry& entry : m_Entries)
+				entries.push_back(&entry);
+		}
+
+		for (VulkanPipelineEntry* entry : entries)
+			JobSystem::Wait(entry->Counter);
+	}
+
+	VulkanPipelineStats VulkanPipelineManager::GetStats() const
+	{
+		VulkanPipelineStats stats;
+		stats.Requested = m_Requested.load(std::memory_order_relaxed);
+		stats.Deduplicated = m_Deduplicated.load(std::memory_order_relaxed);
+		stats.Compiled = m_Compiled.load(std::memory_order_relaxed);
+		stats.Failed = m_Failed.load(std::memory_order_relaxed);
+		// The counters are read one by one, a request finishing in between
+		// mustn't make this wrap around
+		uint64_t done = stats.Deduplicated + stats.Compiled + stats.Failed;
+		stats.Pending = stats.Requested > done ? stats.Requested - done : 0;
+		stats.CacheHits = m_CacheHits.load(std::memory_order_relaxed);
+		stats.CacheMisses = m_CacheMisses.load(std::memory_order_relaxed);
+		stats.LoadedCacheBytes = m_LoadedCacheBytes;
+		stats.CompileTimes = m_CompileTimeMetric.Snapshot();
+		return stats;
+	}
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "Photon/Core.h"
+#include "Photon/Jobs/JobSystem.h"
+#include "Photon/Metrics/Metrics.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace Photon
+{
+	struct VulkanShaderStage
+	{
+		vk::ShaderStageFlagBits Stage = vk::ShaderStageFlagBits::eVertex;
+		// SPIR-V words
+		std::vector<uint32_t> Code;
+		std::string EntryPoint = "main";
+
+		bool operator==(const VulkanShaderStage& other) const = default;
+	};
+
+	// Everything a graphics pipeline is built from. Viewport and scissor are
+	// always dynamic state. The description owns its data, so it can be handed
+	// to a worker thread and the caller's copy thrown away
+	struct VulkanGraphicsPipelineDesc
+	{
+		std::vector<VulkanShaderStage> Stages;
+
+		std::vector<vk::VertexInputBindingDescription> VertexBindings;
+		std::vector<vk::VertexInputAttributeDescription> VertexAttributes;
+		vk::PrimitiveTopology Topology = vk::PrimitiveTopology::eTriangleList;
+
+		vk::PolygonMode PolygonMode = vk::PolygonMode::eFill;
+		vk::CullModeFlags CullMode = vk::CullModeFlagBits::eBack;
+		vk::FrontFace FrontFace = vk::FrontFace::eCounterClockwise;
+		vk::SampleCountFlagBits Samples = vk::SampleCountFlagBits::e1;
+
+		bool DepthTest = false;
+		bool DepthWrite = false;
+		vk::CompareOp DepthCompare = vk::CompareOp::eLess;
+
+		// One per color attachment of the subpass
+		std::vector<vk::PipelineColorBlendAttachmentState> ColorBlend;
+
+		vk::PipelineLayout Layout;
+		vk::RenderPass RenderPass;
+		uint32_t Subpass = 0;
+
+		bool operator==(const VulkanGraphicsPipelineDesc& other) const = default;
+	};
+
+	struct VulkanComputePipelineDesc
+	{
+		VulkanShaderStage Shader;
+		vk::PipelineLayout Layout;
+
+		bool operator==(const VulkanComputePipelineDesc& other) const = default;
+	};
+
+	enum class VulkanPipelineStatus : uint8_t
+	{
+		Compiling = 0, Ready, Failed
+	};
+
+	class VulkanPipelineManager;
+
+	// A requested pipeline, owned by its manager
+	struct VulkanPipelineEntry
+	{
+		VulkanPipelineManager* Manager = nullptr;
+		std::string Name;
+		// Kept to tell requests with the same hash apart. Only read once the
+		// entry is created, so workers and Submit share it without locking
+		std::variant<VulkanGraphicsPipelineDesc, VulkanComputePipelineDesc> Desc;
+
+		// Written before Status is set to Ready
+		vk::Pipeline Pipeline;
+		std::atomic<VulkanPipelineStatus> Status = VulkanPipelineStatus::Compiling;
+		JobCounter Counter;
+	};
+
+	// Refers to a pipeline requested from a VulkanPipelineManager. Reading it
+	// never blocks or locks, Get returns a null pipeline until the compile has
+	// finished, so a draw can be skipped for a frame instead of hitching it.
+	// Handles stay valid as long as their manager
+	class PHOTON_API VulkanPipelineHandle
+	{
+	public:
+		VulkanPipelineHandle() = default;
+
+		inline bool IsValid() const { return m_Entry != nullptr; }
+		VulkanPipelineStatus GetStatus() const;
+		inline bool IsReady() const { return GetStatus() == VulkanPipelineStatus::Ready; }
+
+		vk::Pipeline Get() const;
+	private:
+		VulkanPipelineHandle(VulkanPipelineEntry* entry)
+			: m_Entry(entry)
+		{}
+	private:
+		VulkanPipelineEntry* m_Entry = nullptr;
+
+		friend class VulkanPipelineManager;
+	};
+
+	struct VulkanPipelineStats
+	{
+		uint64_t Requested = 0;
+		// Requests answered with an already requested pipeline
+		uint64_t Deduplicated = 0;
+		uint64_t Compiled = 0;
+		uint64_t Failed = 0;
+		uint64_t Pending = 0;
+
+		// As reported by the driver through pipeline creation feedback, both
+		// stay 0 on devices without it
+		uint64_t CacheHits = 0;
+		uint64_t CacheMisses = 0;
+
+		// Size of the cache data loaded from disk, 0 when nothing valid was found
+		size_t LoadedCacheBytes = 0;
+
+		// Every compile in the process, from the "vulkan.pipeline.compile_ns" metric
+		HistogramSnapshot CompileTimes;
+	};
+
+	// Creates pipelines on the job system through a vk::PipelineCache that
+	// is saved to disk, so the second launch on the same device and driver
+	// builds from the cache instead of compiling shaders again.
+	//
+	// The cache file is named after the device and driver UUIDs and starts
+	// with a header repeating them along with the vendor, device and driver
+	// version and a hash of the data. Anything that doesn't match is ignored
+	// and the cache starts empty, drivers are not trusted to reject stale or
+	// truncated data themselves.
+	//
+	// Identical descriptions share one pipeline, descriptions are kept with
+	// their pipelines to compare new requests against. Pipelines live until
+	// the manager is destroyed, which waits for compiles still running and saves
+	// the cache.
+	class PHOTON_API VulkanPipelineManager
+	{
+	public:
+		// creationFeedback is whether the device has pipeline creation
+		// feedback (Vulkan 1.3 or VK_EXT_pipeline_creation_feedback), which is
+		// how cache hits are counted
+		VulkanPipelineManager(vk::PhysicalDevice physicalDevice, vk::Device device, const std::string& cacheDirectory, bool creationFeedback);
+		~VulkanPipelineManager();
+
+		VulkanPipelineManager(const VulkanPipelineManager&) = delete;
+		VulkanPipelineManager& operator=(const VulkanPipelineManager&) = delete;
+
+		// Starts compiling on a worker and returns right away. Safe to call
+		// from any thread
+		VulkanPipelineHandle Compile(const std::string& name, VulkanGraphicsPipelineDesc desc);
+		VulkanPipelineHandle Compile(const std::string& name, VulkanComputePipelineDesc desc);
+
+		// Runs other jobs until the pipeline is compiled, for the few that
+		// are needed before anything can be drawn
+		vk::Pipeline Wait(VulkanPipelineHandle handle);
+		void WaitAll();
+
+		// Writes the cache to disk now rather than on destruction
+		bool Save();
+
+		VulkanPipelineStats GetStats() const;
+		inline const std::string& GetCachePath() const { return m_CachePath; }
+	private:
+		VulkanPipelineHandle Submit(const std::string& name, uint64_t key, std::variant<VulkanGraphicsPipelineDesc, VulkanComputePipelineDesc>&& desc);
+
+		static void CompileJob(void* data, uint32_t, uint32_t);
+		void Build(VulkanPipelineEntry& entry);
+		vk::Pipeline BuildGraphics(const VulkanGraphicsPipelineDesc& desc, std::vector<vk::ShaderModule>& modules, const void* next);
+		vk::Pipeline BuildCompute(const VulkanComputePipelineDesc& desc, std::vector<vk::ShaderModule>& modules, const void* next);
+
+		std::vector<uint8_t> LoadCache();
+	private:
+		vk::PhysicalDevice m_PhysicalDevice;
+		vk::Device m_Device;
+		vk::PipelineCache m_Cache;
+		bool m_CreationFeedback;
+
+		std::string m_CachePath;
+		size_t m_LoadedCacheBytes = 0;
+
+		// Entries never move, handles point straight at them
+		std::mutex m_Mutex;
+		std::deque<VulkanPipelineEntry> m_Entries;
+		// By the hash of the description, which is compared on a hit
+		std::unordered_multimap<uint64_t, VulkanPipelineEntry*> m_EntriesByKey;
+
+		std::atomic<uint64_t> m_Requested = 0;
+		std::atomic<uint64_t> m_Deduplicated = 0;
+		std::atomic<uint64_t> m_Compiled = 0;
+		std::atomic<uint64_t> m_Failed = 0;
+		std::atomic<uint64_t> m_CacheHits = 0;
+		std::atomic<uint64_t> m_CacheMisses = 0;
+
+		Histogram& m_CompileTimeMetric;
+		Counter& m_CacheHitMetric;
+		Counter& m_CacheMissMetric;
+	};
+}
@@ -0,0 +1,324 @@
+#include "ptpch.h"
+#include "VulkanReadback.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+
+namespace Photon
+{
+	// Buffers are rounded up to this, so frames of slightly different sizes
+	// share them
+	static constexpr vk::DeviceSize BufferGranularity = 64 * 1024;
+
+	// Offsets of red and blue in an 8 bit four channel texel, false for
+	// other formats
+	static bool GetRgbOffsets(vk::Format format, uint32_t& red, uint32_t& blue)
+	{
+		bool bgra = format == vk::Format::eB8G8R8A8Unorm || format == vk::Format::eB8G8R8A8Srgb;
+		bool rgba = format == vk::Format::eR8G8B8A8Unorm || format == vk::Format::eR8G8B8A8Srgb;
+		red = bgra ? 2 : 0;
+		blue = bgra ? 0 : 2;
+		return bgra || rgba;
+	}
+
+	// Skips whitespace and comments, then reads a decimal number
+	static bool ReadPpmNumber(std::istream& in, uint32_t& value)
+	{
+		for (;;)
+		{
+			int c = in.peek();
+			if (c == '#')
+				in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+			else if (std::isspace(c))
+				in.get();
+			else
+				break;
+		}
+
+		in >> value;
+		return (bool)in;
+	}
+
+	VulkanReadback::VulkanReadback(VulkanAllocator& allocator)
+		: m_Allocator(allocator), m_BytesMetric(Metrics::GetCounter("vulkan.readback.bytes"))
+	{
+	}
+
+	VulkanReadback::~VulkanReadback()
+	{
+		for (auto& [request, copy] : m_Requests)
+			m_Allocator.DestroyBuffer(copy.Buffer);
+		for (VulkanBuffer& buffer : m_Pool)
+			m_Allocator.DestroyBuffer(buffer);
+	}
+
+	uint64_t VulkanReadback::Request(vk::Format format, vk::Extent2D extent, uint64_t frameNumber)
+	{
+		PT_PROFILE_FUNCTION();
+
+		uint32_t texelSize = GetTexelSize(format);
+		if (!texelSize)
+		{
+			PT_CORE_ERROR("Can't read back images of format {0}", vk::to_string(format));
+			return 0;
+		}
+
+		PendingCopy copy;
+		copy.Data.Format = format;
+		copy.Data.Extent = extent;
+		copy.Data.RowPitch = extent.width * texelSize;
+		copy.Data.Size = (vk::DeviceSize)copy.Data.RowPitch * extent.height;
+		copy.Data.FrameNumber = frameNumber;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// The smallest pooled buffer that fits
+		auto best = m_Pool.end();
+		for (auto it = m_Pool.begin(); it != m_Pool.end(); ++it)
+		{
+			if (it->Allocation.Size >= copy.Data.Size && (best == m_Pool.end() || it->Allocation.Size < best->Allocation.Size))
+				best = it;
+		}
+
+		if (best != m_Pool.end())
+		{
+			copy.Buffer = *best;
+			m_Pool.erase(best);
+		}
+		else
+		{
+			vk::DeviceSize size = (copy.Data.Size + BufferGranularity - 1) / BufferGranularity * BufferGranularity;
+			copy.Buffer = m_Allocator.CreateBuffer(vk::BufferCreateInfo(vk::BufferCreateFlags(), size, vk::BufferUsageFlagBits::eTransferDst),
+				VulkanMemoryUsage::Readback);
+			if (!copy.Buffer.Buffer)
+			{
+				PT_CORE_ERROR("Out of memory for a {0} byte readback", size);
+				return 0;
+			}
+		}
+
+		uint64_t request = m_NextRequest++;
+		m_Requests.emplace(request, copy);
+		return request;
+	}
+
+	void VulkanReadback::RecordCopy(uint64_t request, vk::CommandBuffer commandBuffer, vk::Image image)
+	{
+		VulkanReadbackData data;
+		vk::Buffer buffer;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto it = m_Requests.find(request);
+			PT_CORE_ASSERT(it != m_Requests.end(), "Unknown readback request {0}", request);
+			data = it->second.Data;
+			buffer = it->second.Buffer.Buffer;
+		}
+
+		bool depth = data.Format == vk::Format::eD32Sfloat || data.Format == vk::Format::eD16Unorm;
+		vk::BufferImageCopy region(0, 0, 0, vk::ImageSubresourceLayers(depth ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+			vk::Offset3D(0, 0, 0), vk::Extent3D(data.Extent.width, data.Extent.height, 1));
+		commandBuffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, buffer, 1, &region);
+
+		// The host reads it once the frame's fence is signaled, which makes
+		// the transfer writes available to it
+		vk::BufferMemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			buffer, 0, VK_WHOLE_SIZE);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, vk::DependencyFlags(),
+			0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	void VulkanReadback::Complete(uint64_t frameNumber)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (auto& [request, copy] : m_Requests)
+		{
+			if (copy.Ready || copy.Data.FrameNumber > frameNumber)
+				continue;
+
+			if (!m_Allocator.IsCoherent(copy.Buffer.Allocation))
+				m_Allocator.Invalidate(copy.Buffer.Allocation, 0, copy.Data.Size);
+			copy.Data.Data = copy.Buffer.Allocation.MappedData;
+			copy.Ready = true;
+
+			m_BytesRead += copy.Data.Size;
+			m_BytesMetric.Add(copy.Data.Size);
+		}
+	}
+
+	bool VulkanReadback::IsReady(uint64_t request) const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Requests.find(request);
+		return it != m_Requests.end() && it->second.Ready;
+	}
+
+	VulkanReadbackData VulkanReadback::GetData(uint64_t request) const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Requests.find(request);
+		return it != m_Requests.end() ? it->second.Data : VulkanReadbackData();
+	}
+
+	void VulkanReadback::Release(uint64_t request)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Requests.find(request);
+		if (it == m_Requests.end())
+			return;
+
+		PT_CORE_ASSERT(it->second.Ready, "Readback {0} released while the GPU may still copy into it", request);
+		if (m_Pool.size() < MaxPooledBuffers)
+			m_Pool.push_back(it->second.Buffer);
+		else
+			m_Allocator.DestroyBuffer(it->second.Buffer);
+		m_Requests.erase(it);
+	}
+
+	VulkanReadbackStats VulkanReadback::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		VulkanReadbackStats stats;
+		for (auto& [request, copy] : m_Requests)
+			stats.Pending += copy.Ready ? 0 : 1;
+		stats.PooledBuffers = (uint32_t)m_Pool.size();
+		for (const VulkanBuffer& buffer : m_Pool)
+			stats.PooledBytes += buffer.Allocation.Size;
+		stats.BytesRead = m_BytesRead;
+		return stats;
+	}
+
+	uint32_t VulkanReadback::GetTexelSize(vk::Format format)
+	{
+		switch (format)
+		{
+		case vk::Format::eR8Unorm:
+			return 1;
+		case vk::Format::eD16Unorm:
+		case vk::Format::eR16Sfloat:
+			return 2;
+		case vk::Format::eR8G8B8A8Unorm:
+		case vk::Format::eR8G8B8A8Srgb:
+		case vk::Format::eB8G8R8A8Unorm:
+		case vk::Format::eB8G8R8A8Srgb:
+		case vk::Format::eA2B10G10R10UnormPack32:
+		case vk::Format::eB10G11R11UfloatPack32:
+		case vk::Format::eR16G16Sfloat:
+		case vk::Format::eR32Sfloat:
+		case vk::Format::eD32Sfloat:
+			return 4;
+		case vk::Format::eR16G16B16A16Sfloat:
+		case vk::Format::eR32G32Sfloat:
+			return 8;
+		case vk::Format::eR32G32B32A32Sfloat:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	bool VulkanReadback::WritePpm(const std::string& filepath, const VulkanReadbackData& data)
+	{
+		uint32_t red, blue;
+		if (!data.Data || !GetRgbOffsets(data.Format, red, blue))
+		{
+			PT_CORE_ERROR("Can't write a {0} readback to '{1}'", vk::to_string(data.Format), filepath);
+			return false;
+		}
+
+		std::ofstream file(filepath, std::ios::binary);
+		if (!file)
+		{
+			PT_CORE_ERROR("Could not open '{0}' for writing", filepath);
+			return false;
+		}
+
+		file << "P6\n" << data.Extent.width << " " << data.Extent.height << "\n255\n";
+
+		std::vector<uint8_t> row(data.Extent.width * 3);
+		const uint8_t* texels = (const uint8_t*)data.Data;
+		for (uint32_t y = 0; y < data.Extent.height; y++)
+		{
+			const uint8_t* source = texels + (size_t)y * data.RowPitch;
+			for (uint32_t x = 0; x < data.Extent.width; x++)
+			{
+				row[x * 3 + 0] = source[x * 4 + red];
+				row[x * 3 + 1] = source[x * 4 + 1];
+				row[x * 3 + 2] = source[x * 4 + blue];
+			}
+			file.write((const char*)row.data(), row.size());
+		}
+
+		return (bool)file;
+	}
+
+	bool VulkanReadback::ReadPpm(const std::string& filepath, VulkanPpmImage& image)
+	{
+		std::ifstream file(filepath, std::ios::binary);
+		if (!file)
+		{
+			PT_CORE_ERROR("Could not open '{0}'", filepath);
+			return false;
+		}
+
+		// Only what WritePpm produces: binary, 8 bits per channel
+		char magic[2] = {};
+		file.read(magic, 2);
+		uint32_t maxValue = 0;
+		if (magic[0] != 'P' || magic[1] != '6' || !ReadPpmNumber(file, image.Width) || !ReadPpmNumber(file, image.Height)
+			|| !ReadPpmNumber(file, maxValue) || maxValue != 255 || !std::isspace(file.get()))
+		{
+			PT_CORE_ERROR("'{0}' is not an 8 bit binary PPM", filepath);
+			return false;
+		}
+
+		image.Texels.resize((size_t)image.Width * image.Height * 3);
+		file.read((char*)image.Texels.data(), image.Texels.size());
+		if ((size_t)file.gcount() != image.Texels.size())
+		{
+			PT_CORE_ERROR("'{0}' is truncated", filepath);
+			return false;
+		}
+		return true;
+	}
+
+	VulkanImageDifference VulkanReadback::Compare(const VulkanReadbackData& data, const VulkanPpmImage& reference, uint32_t tolerance)
+	{
+		PT_PROFILE_FUNCTION();
+
+		VulkanImageDifference difference;
+		uint32_t red, blue;
+		if (!data.Data || !GetRgbOffsets(data.Format, red, blue))
+		{
+			PT_CORE_ERROR("Can't compare a {0} readback", vk::to_string(data.Format));
+			return difference;
+		}
+
+		difference.SizeMatches = data.Extent.width == reference.Width && data.Extent.height == reference.Height;
+		if (!difference.SizeMatches)
+			return difference;
+
+		const uint32_t channels[3] = { red, 1, blue };
+		const uint8_t* texels = (const uint8_t*)data.Data;
+		const uint8_t* expected = reference.Texels.data();
+		for (uint32_t y = 0; y < data.Extent.height; y++)
+		{
+			const uint8_t* source = texels + (size_t)y * data.RowPitch;
+			for (uint32_t x = 0; x < data.Extent.width; x++, expected += 3)
+			{
+				uint32_t pixelDifference = 0;
+				for (uint32_t c = 0; c < 3; c++)
+					pixelDifference = std::max(pixelDifference, (uint32_t)std::abs(source[x * 4 + channels[c]] - expected[c]));
+
+				difference.MaxDifference = std::max(difference.MaxDifference, pixelDifference);
+				if (pixelDifference > tolerance)
+					difference.DifferingPixels++;
+			}
+		}
+		return difference;
+	}
+}
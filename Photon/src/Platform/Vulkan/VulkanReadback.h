@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Photon/Core.h"
+#include "Photon/Metrics/Metrics.h"
+#include "Platform/Vulkan/VulkanAllocator.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Photon
+{
+	// An image copied back, texels tightly packed row after row
+	struct VulkanReadbackData
+	{
+		// Null until the copy is done
+		const void* Data = nullptr;
+		vk::DeviceSize Size = 0;
+		vk::Format Format = vk::Format::eUndefined;
+		vk::Extent2D Extent;
+		uint32_t RowPitch = 0;
+		// Of the frame the copy was recorded into
+		uint64_t FrameNumber = 0;
+	};
+
+	// 8 bit RGB texels, tightly packed, as stored in a binary PPM
+	struct VulkanPpmImage
+	{
+		uint32_t Width = 0, Height = 0;
+		std::vector<uint8_t> Texels;
+	};
+
+	struct VulkanImageDifference
+	{
+		// False when the sizes differ, nothing else is compared then
+		bool SizeMatches = false;
+		// Pixels with a channel differing by more than the tolerance
+		uint64_t DifferingPixels = 0;
+		// Largest channel difference over the whole image
+		uint32_t MaxDifference = 0;
+	};
+
+	struct VulkanReadbackStats
+	{
+		uint32_t Pending = 0;
+		uint32_t PooledBuffers = 0;
+		vk::DeviceSize PooledBytes = 0;
+		uint64_t BytesRead = 0;
+	};
+
+	// Copies images back to the CPU, e.g. frames for image comparisons.
+	//
+	// The copies go into host visible buffers that stay mapped. A buffer
+	// goes back into a pool on Release and is reused for the next copy that
+	// fits, so reading back a frame every frame allocates nothing. Requests
+	// are ready once the frame they were recorded into is reported complete.
+	//
+	// Thread safe, copies may be recorded by passes on any thread.
+	class PHOTON_API VulkanReadback
+	{
+	public:
+		VulkanReadback(VulkanAllocator& allocator);
+		// The GPU has to be done with every copy
+		~VulkanReadback();
+
+		VulkanReadback(const VulkanReadback&) = delete;
+		VulkanReadback& operator=(const VulkanReadback&) = delete;
+
+		// Reserves a buffer for the first mip level and layer of an image
+		// rendered in frameNumber. Returns 0 for formats without a known
+		// texel size
+		uint64_t Request(vk::Format format, vk::Extent2D extent, uint64_t frameNumber);
+		// Records the copy, image has to be in eTransferSrcOptimal
+		void RecordCopy(uint64_t request, vk::CommandBuffer commandBuffer, vk::Image image);
+
+		// The GPU is done with every frame up to frameNumber
+		void Complete(uint64_t frameNumber);
+
+		bool IsReady(uint64_t request) const;
+		// Valid until Release
+		VulkanReadbackData GetData(uint64_t request) const;
+		// Hands the buffer back to the pool
+		void Release(uint64_t request);
+
+		VulkanReadbackStats GetStats() const;
+
+		static uint32_t GetTexelSize(vk::Format format);
+		// Binary PPM, for 8 bit RGBA and BGRA images. Alpha is dropped
+		static bool WritePpm(const std::string& filepath, const VulkanReadbackData& data);
+		static bool ReadPpm(const std::string& filepath, VulkanPpmImage& image);
+		// Compares an 8 bit RGBA or BGRA image with a reference read by ReadPpm
+		static VulkanImageDifference Compare(const VulkanReadbackData& data, const VulkanPpmImage& reference, uint32_t tolerance);
+	private:
+		struct PendingCopy
+		{
+			VulkanBuffer Buffer;
+			VulkanReadbackData Data;
+			bool Ready = false;
+		};
+	private:
+		// Unused buffers kept beyond this are destroyed
+		static constexpr uint32_t MaxPooledBuffers = 8;
+
+		VulkanAllocator& m_Allocator;
+
+		mutable std::mutex m_Mutex;
+		std::unordered_map<uint64_t, PendingCopy> m_Requests;
+		std::vector<VulkanBuffer> m_Pool;
+		uint64_t m_NextRequest = 1;
+		uint64_t m_BytesRead = 0;
+
+		Counter& m_BytesMetric;
+	};
+}
@@ -0,0 +1,1035 @@
+#include "ptpch.h"
+#include "VulkanRenderGraph.h"
+
+#include "Photon/Debug/Instrumentor.h"
+#include "Photon/Jobs/JobSystem.h"
+
+namespace Photon
+{
+	struct UsageInfo
+	{
+		vk::PipelineStageFlags Stage;
+		vk::AccessFlags Access;
+		// eUndefined for usages only buffers have
+		vk::ImageLayout Layout;
+		vk::ImageUsageFlags ImageUsage;
+		vk::BufferUsageFlags BufferUsage;
+	};
+
+	// Which shader reads or writes isn't declared, so all of them
+	static constexpr vk::PipelineStageFlags ShaderStages = vk::PipelineStageFlagBits::eVertexShader
+		| vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+	static constexpr vk::PipelineStageFlags DepthStages = vk::PipelineStageFlagBits::eEarlyFragmentTests
+		| vk::PipelineStageFlagBits::eLateFragmentTests;
+	static constexpr vk::AccessFlags WriteAccess = vk::AccessFlagBits::eColorAttachmentWrite
+		| vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite;
+
+	static UsageInfo GetUsageInfo(RenderGraphUsage usage)
+	{
+		using Stage = vk::PipelineStageFlagBits;
+		using Access = vk::AccessFlagBits;
+		using Layout = vk::ImageLayout;
+		using ImageUsage = vk::ImageUsageFlagBits;
+		using BufferUsage = vk::BufferUsageFlagBits;
+
+		switch (usage)
+		{
+		case RenderGraphUsage::ColorAttachment:
+			return { Stage::eColorAttachmentOutput, Access::eColorAttachmentRead | Access::eColorAttachmentWrite,
+				Layout::eColorAttachmentOptimal, ImageUsage::eColorAttachment, {} };
+		case RenderGraphUsage::DepthAttachment:
+			return { DepthStages, Access::eDepthStencilAttachmentRead | Access::eDepthStencilAttachmentWrite,
+				Layout::eDepthStencilAttachmentOptimal, ImageUsage::eDepthStencilAttachment, {} };
+		case RenderGraphUsage::StorageWrite:
+			return { ShaderStages, Access::eShaderRead | Access::eShaderWrite, Layout::eGeneral, ImageUsage::eStorage, BufferUsage::eStorageBuffer };
+		case RenderGraphUsage::TransferDst:
+			return { Stage::eTransfer, Access::eTransferWrite, Layout::eTransferDstOptimal, ImageUsage::eTransferDst, BufferUsage::eTransferDst };
+		case RenderGraphUsage::DepthRead:
+			return { DepthStages, Access::eDepthStencilAttachmentRead, Layout::eDepthStencilReadOnlyOptimal, ImageUsage::eDepthStencilAttachment, {} };
+		case RenderGraphUsage::Sampled:
+			return { ShaderStages, Access::eShaderRead, Layout::eShaderReadOnlyOptimal, ImageUsage::eSampled, BufferUsage::eUniformTexelBuffer };
+		case RenderGraphUsage::StorageRead:
+			return { ShaderStages, Access::eShaderRead, Layout::eGeneral, ImageUsage::eStorage, BufferUsage::eStorageBuffer };
+		case RenderGraphUsage::TransferSrc:
+			return { Stage::eTransfer, Access::eTransferRead, Layout::eTransferSrcOptimal, ImageUsage::eTransferSrc, BufferUsage::eTransferSrc };
+		case RenderGraphUsage::VertexBuffer:
+			return { Stage::eVertexInput, Access::eVertexAttributeRead, Layout::eUndefined, {}, BufferUsage::eVertexBuffer };
+		case RenderGraphUsage::IndexBuffer:
+			return { Stage::eVertexInput, Access::eIndexRead, Layout::eUndefined, {}, BufferUsage::eIndexBuffer };
+		case RenderGraphUsage::UniformBuffer:
+			return { ShaderStages, Access::eUniformRead, Layout::eUndefined, {}, BufferUsage::eUniformBuffer };
+		case RenderGraphUsage::IndirectBuffer:
+			return { Stage::eDrawIndirect, Access::eIndirectCommandRead, Layout::eUndefined, {}, BufferUsage::eIndirectBuffer };
+		}
+
+		PT_CORE_ASSERT(false, "Unknown render graph usage");
+		return {};
+	}
+
+	static inline bool IsWrite(RenderGraphUsage usage)
+	{
+		return usage <= RenderGraphUsage::TransferDst;
+	}
+
+	static vk::ImageAspectFlags GetAspect(vk::Format format)
+	{
+		switch (format)
+		{
+		case vk::Format::eD16Unorm:
+		case vk::Format::eX8D24UnormPack32:
+		case vk::Format::eD32Sfloat:
+			return vk::ImageAspectFlagBits::eDepth;
+		case vk::Format::eD16UnormS8Uint:
+		case vk::Format::eD24UnormS8Uint:
+		case vk::Format::eD32SfloatS8Uint:
+			return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+		default:
+			return vk::ImageAspectFlagBits::eColor;
+		}
+	}
+
+	static inline uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	template<typename T>
+	static inline uint64_t HashValue(const T& value, uint64_t hash)
+	{
+		static_assert(std::has_unique_object_representations_v<T> || std::is_enum_v<T>, "Only types without padding can be hashed bytewise");
+		return Fnv1a(&value, sizeof(T), hash);
+	}
+
+	static inline vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	RenderGraphPassBuilder& RenderGraphPassBuilder::Read(RenderGraphResource resource, RenderGraphUsage usage)
+	{
+		PT_CORE_ASSERT(!IsWrite(usage), "Pass '{0}' reads with a write usage", m_Graph.m_Passes[m_Pass].Name);
+		return Write(resource, usage);
+	}
+
+	RenderGraphPassBuilder& RenderGraphPassBuilder::Write(RenderGraphResource resource, RenderGraphUsage usage)
+	{
+		PT_CORE_ASSERT(resource.Index < m_Graph.m_Resources.size(), "Pass '{0}' uses an invalid resource", m_Graph.m_Passes[m_Pass].Name);
+
+		// Read forwards here as well, the usage tells them apart
+		UsageInfo info = GetUsageInfo(usage);
+		bool isImage = m_Graph.m_Resources[resource.Index].IsImage;
+		PT_CORE_ASSERT(isImage ? (bool)info.ImageUsage : (bool)info.BufferUsage, "Pass '{0}' uses '{1}' in a way its kind of resource can't be used",
+			m_Graph.m_Passes[m_Pass].Name, m_Graph.m_Resources[resource.Index].Name);
+
+		m_Graph.m_Passes[m_Pass].Accesses.push_back({ resource.Index, usage });
+		return *this;
+	}
+
+	RenderGraphPassBuilder& RenderGraphPassBuilder::Clear(RenderGraphResource resource, const vk::ClearValue& value)
+	{
+		m_Graph.m_Passes[m_Pass].Clears.emplace_back(resource.Index, value);
+		return *this;
+	}
+
+	RenderGraphPassBuilder& RenderGraphPassBuilder::SideEffects()
+	{
+		m_Graph.m_Passes[m_Pass].SideEffects = true;
+		return *this;
+	}
+
+	VulkanRenderGraph::VulkanRenderGraph(vk::Device device, VulkanAllocator& allocator, uint32_t queueFamily, uint32_t framesInFlight, uint32_t timestampBits)
+		: m_Device(device), m_Allocator(allocator), m_QueueFamily(queueFamily), m_FramesInFlight(framesInFlight)
+	{
+		PT_CORE_ASSERT(framesInFlight > 0, "A render graph needs at least one frame in flight");
+
+		m_ThreadContexts.resize(framesInFlight);
+
+		if (timestampBits)
+		{
+			m_TimestampMask = timestampBits >= 64 ? UINT64_MAX : (1ull << timestampBits) - 1;
+			m_TimestampPeriod = allocator.GetDeviceProperties().limits.timestampPeriod;
+			m_Timestamps.resize(framesInFlight);
+		}
+	}
+
+	VulkanRenderGraph::~VulkanRenderGraph()
+	{
+		PT_PROFILE_FUNCTION();
+
+		for (std::vector<ThreadContext>& contexts : m_ThreadContexts)
+		{
+			for (ThreadContext& context : contexts)
+				m_Device.destroyCommandPool(context.CommandPool);
+		}
+		for (auto& [key, framebuffer] : m_Framebuffers)
+			m_Device.destroyFramebuffer(framebuffer.Framebuffer);
+		for (auto& [key, renderPass] : m_RenderPasses)
+			m_Device.destroyRenderPass(renderPass);
+		for (auto& [key, layout] : m_Layouts)
+			DestroyTransientLayout(layout);
+		for (TimestampQueries& queries : m_Timestamps)
+			m_Device.destroyQueryPool(queries.Pool);
+	}
+
+	RenderGraphResource VulkanRenderGraph::CreateImage(const std::string& name, const RenderGraphImageDesc& desc)
+	{
+		Resource& resource = m_Resources.emplace_back();
+		resource.Name = name;
+		resource.IsImage = true;
+		resource.ImageDesc = desc;
+		return { (uint32_t)m_Resources.size() - 1 };
+	}
+
+	RenderGraphResource VulkanRenderGraph::CreateBuffer(const std::string& name, vk::DeviceSize size)
+	{
+		Resource& resource = m_Resources.emplace_back();
+		resource.Name = name;
+		resource.Size = size;
+		return { (uint32_t)m_Resources.size() - 1 };
+	}
+
+	RenderGraphResource VulkanRenderGraph::ImportImage(const std::string& name, vk::Image image, vk::ImageView view, const RenderGraphImageDesc& desc,
+		const RenderGraphImageState& initial, const RenderGraphImageState& final)
+	{
+		Resource& resource = m_Resources.emplace_back();
+		resource.Name = name;
+		resource.IsImage = true;
+		resource.Imported = true;
+		resource.ImageDesc = desc;
+		resource.Final = final;
+		resource.Image = image;
+		resource.View = view;
+		// Whatever happened before counts as a write
+		resource.State.Layout = initial.Layout;
+		resource.State.WriteStage = initial.Stage;
+		resource.State.WriteAccess = initial.Access;
+		return { (uint32_t)m_Resources.size() - 1 };
+	}
+
+	RenderGraphResource VulkanRenderGraph::ImportBuffer(const std::string& name, vk::Buffer buffer, vk::DeviceSize size)
+	{
+		Resource& resource = m_Resources.emplace_back();
+		resource.Name = name;
+		resource.Imported = true;
+		resource.Size = size;
+		resource.Buffer = buffer;
+		return { (uint32_t)m_Resources.size() - 1 };
+	}
+
+	RenderGraphPassBuilder VulkanRenderGraph::AddPass(const std::string& name, RenderGraphExecuteFn execute)
+	{
+		Pass& pass = m_Passes.emplace_back();
+		pass.Name = name;
+		pass.Execute = std::move(execute);
+		return RenderGraphPassBuilder(*this, (uint32_t)m_Passes.size() - 1);
+	}
+
+	vk::Image VulkanRenderGraph::GetImage(RenderGraphResource resource) const
+	{
+		PT_CORE_ASSERT(resource.Index < m_Resources.size(), "Invalid render graph resource");
+		return m_Resources[resource.Index].Image;
+	}
+
+	vk::ImageView VulkanRenderGraph::GetImageView(RenderGraphResource resource) const
+	{
+		PT_CORE_ASSERT(resource.Index < m_Resources.size(), "Invalid render graph resource");
+		return m_Resources[resource.Index].View;
+	}
+
+	vk::Buffer VulkanRenderGraph::GetBuffer(RenderGraphResource resource) const
+	{
+		PT_CORE_ASSERT(resource.Index < m_Resources.size(), "Invalid render graph resource");
+		return m_Resources[resource.Index].Buffer;
+	}
+
+	void VulkanRenderGraph::Execute(vk::CommandBuffer commandBuffer, uint64_t frameNumber)
+	{
+		PT_PROFILE_FUNCTION();
+
+		uint32_t slot = (uint32_t)(frameNumber % m_FramesInFlight);
+		Prune(frameNumber);
+		Cull();
+
+		// The passes that are left, in the order they were added
+		std::vector<uint32_t> order;
+		for (uint32_t i = 0; i < (uint32_t)m_Passes.size(); i++)
+		{
+			if (!m_Passes[i].Culled)
+				order.push_back(i);
+		}
+
+		for (uint32_t position = 0; position < (uint32_t)order.size(); position++)
+		{
+			for (const Access& access : m_Passes[order[position]].Accesses)
+			{
+				Resource& resource = m_Resources[access.Resource];
+				resource.FirstPass = std::min(resource.FirstPass, position);
+				resource.LastPass = std::max(resource.LastPass, position);
+
+				UsageInfo info = GetUsageInfo(access.Usage);
+				resource.ImageUsage |= info.ImageUsage;
+				resource.BufferUsage |= info.BufferUsage;
+			}
+		}
+
+		// Transient resources only culled passes use are never created
+		std::vector<uint32_t> transients;
+		for (uint32_t i = 0; i < (uint32_t)m_Resources.size(); i++)
+		{
+			Resource& resource = m_Resources[i];
+			if (resource.Imported || resource.FirstPass == UINT32_MAX)
+				continue;
+
+			resource.Transient = (uint32_t)transients.size();
+			transients.push_back(i);
+		}
+
+		TransientLayout* layout = nullptr;
+		if (!transients.empty())
+		{
+			layout = GetTransientLayout(transients, frameNumber);
+			if (!layout)
+			{
+				// Nothing to record into, the passes are skipped this frame
+				// and the imported images only go to their final state
+				PT_CORE_ERROR("Render graph: no memory for the transient resources, skipping {0} passes", order.size());
+				order.clear();
+			}
+			for (uint32_t transient = 0; layout && transient < (uint32_t)transients.size(); transient++)
+			{
+				const PhysicalResource& physical = layout->Resources[slot][transient];
+				Resource& resource = m_Resources[transients[transient]];
+				resource.Image = physical.Image;
+				resource.View = physical.View;
+				resource.Buffer = physical.Buffer;
+			}
+		}
+
+		for (uint32_t position = 0; position < (uint32_t)order.size(); position++)
+			PrepareRenderPass(m_Passes[order[position]], position, frameNumber);
+
+		// The GPU is done with the frame that last used this slot's pools
+		std::vector<ThreadContext>& contexts = m_ThreadContexts[slot];
+		uint32_t threadCount = JobSystem::GetWorkerCount() + 2;
+		while (contexts.size() < threadCount)
+		{
+			ThreadContext& context = contexts.emplace_back();
+			context.CommandPool = m_Device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient, m_QueueFamily));
+		}
+		for (ThreadContext& context : contexts)
+		{
+			if (context.Used)
+				m_Device.resetCommandPool(context.CommandPool);
+			context.Used = 0;
+		}
+
+		{
+			PT_PROFILE_SCOPE("Record render graph passes");
+			JobSystem::ParallelFor((uint32_t)order.size(), 1, [this, &order, slot](uint32_t i)
+			{
+				RecordPass(m_Passes[order[i]], slot);
+			});
+		}
+
+		TimestampQueries* queries = nullptr;
+		if (m_TimestampMask && !order.empty())
+		{
+			PrepareTimestamps(slot, (uint32_t)order.size());
+			queries = &m_Timestamps[slot];
+			queries->FrameNumber = frameNumber;
+			for (uint32_t index : order)
+				queries->Passes.push_back(m_Passes[index].Name);
+			commandBuffer.resetQueryPool(queries->Pool, 0, (uint32_t)order.size() * 2);
+		}
+
+		uint32_t barrierCount = 0;
+		std::vector<vk::ImageMemoryBarrier> imageBarriers;
+		std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+		for (uint32_t position = 0; position < (uint32_t)order.size(); position++)
+		{
+			Pass& pass = m_Passes[order[position]];
+
+			imageBarriers.clear();
+			bufferBarriers.clear();
+			vk::PipelineStageFlags srcStage, dstStage;
+			for (const Access& access : pass.Accesses)
+			{
+				// Memory shared with transients used earlier in the frame is
+				// only free once their last pass is done with it
+				vk::PipelineStageFlags aliasStage;
+				vk::AccessFlags aliasAccess;
+				const Resource& resource = m_Resources[access.Resource];
+				if (layout && resource.Transient != UINT32_MAX && resource.FirstPass == position)
+				{
+					for (uint32_t previous : layout->AliasedAfter[resource.Transient])
+					{
+						const ResourceState& state = m_Resources[transients[previous]].State;
+						aliasStage |= state.WriteStage | state.ReadStages;
+						aliasAccess |= state.WriteAccess;
+					}
+				}
+
+				AddBarriers(access.Resource, access.Usage, aliasStage, aliasAccess, imageBarriers, bufferBarriers, srcStage, dstStage);
+			}
+
+			if (!imageBarriers.empty() || !bufferBarriers.empty())
+			{
+				commandBuffer.pipelineBarrier(srcStage ? srcStage : vk::PipelineStageFlagBits::eTopOfPipe, dstStage, vk::DependencyFlags(), 0, nullptr,
+					(uint32_t)bufferBarriers.size(), bufferBarriers.data(), (uint32_t)imageBarriers.size(), imageBarriers.data());
+				barrierCount += (uint32_t)(imageBarriers.size() + bufferBarriers.size());
+			}
+
+			// The barriers wait for the passes before, they aren't timed
+			if (queries)
+				commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, queries->Pool, position * 2);
+
+			if (pass.RenderPass)
+			{
+				vk::RenderPassBeginInfo beginInfo(pass.RenderPass, pass.Framebuffer, vk::Rect2D(vk::Offset2D(0, 0), pass.Extent),
+					(uint32_t)pass.ClearValues.size(), pass.ClearValues.data());
+				commandBuffer.beginRenderPass(beginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+				commandBuffer.executeCommands(1, &pass.CommandBuffer);
+				commandBuffer.endRenderPass();
+			}
+			else
+			{
+				commandBuffer.executeCommands(1, &pass.CommandBuffer);
+			}
+
+			if (queries)
+				commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, queries->Pool, position * 2 + 1);
+		}
+
+		// Imported images are left the way the code after the graph expects,
+		// even when no pass touched them
+		imageBarriers.clear();
+		vk::PipelineStageFlags srcStage, dstStage;
+		for (Resource& resource : m_Resources)
+		{
+			if (!resource.Imported || !resource.IsImage)
+				continue;
+
+			const ResourceState& state = resource.State;
+			if (resource.FirstPass == UINT32_MAX && state.Layout == resource.Final.Layout)
+				continue;
+
+			imageBarriers.push_back(vk::ImageMemoryBarrier(state.WriteAccess, resource.Final.Access, state.Layout, resource.Final.Layout,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, resource.Image,
+				vk::ImageSubresourceRange(GetAspect(resource.ImageDesc.Format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS)));
+			srcStage |= state.WriteStage | state.ReadStages;
+			dstStage |= resource.Final.Stage;
+		}
+		if (!imageBarriers.empty())
+		{
+			commandBuffer.pipelineBarrier(srcStage ? srcStage : vk::PipelineStageFlagBits::eTopOfPipe, dstStage, vk::DependencyFlags(), 0, nullptr,
+				0, nullptr, (uint32_t)imageBarriers.size(), imageBarriers.data());
+			barrierCount += (uint32_t)imageBarriers.size();
+		}
+
+		m_Stats = VulkanRenderGraphStats();
+		m_Stats.Passes = (uint32_t)m_Passes.size();
+		m_Stats.CulledPasses = (uint32_t)(m_Passes.size() - order.size());
+		m_Stats.Barriers = barrierCount;
+		for (uint32_t index : transients)
+			(m_Resources[index].IsImage ? m_Stats.TransientImages : m_Stats.TransientBuffers)++;
+		if (layout)
+		{
+			m_Stats.TransientBytes = layout->TransientBytes;
+			m_Stats.AliasedBytes = layout->AliasedBytes;
+		}
+		m_Stats.Layouts = (uint32_t)m_Layouts.size();
+
+		Clear();
+	}
+
+	void VulkanRenderGraph::Clear()
+	{
+		m_Passes.clear();
+		m_Resources.clear();
+	}
+
+	void VulkanRenderGraph::Cull()
+	{
+		// Walking backwards, a pass is needed when it writes something a
+		// needed pass after it reads, or that is imported
+		std::vector<bool> needed(m_Resources.size());
+		for (uint32_t i = 0; i < (uint32_t)m_Resources.size(); i++)
+			needed[i] = m_Resources[i].Imported;
+
+		for (uint32_t i = (uint32_t)m_Passes.size(); i-- > 0;)
+		{
+			Pass& pass = m_Passes[i];
+
+			bool alive = pass.SideEffects;
+			for (const Access& access : pass.Accesses)
+			{
+				if (IsWrite(access.Usage) && needed[access.Resource])
+					alive = true;
+			}
+
+			pass.Culled = !alive;
+			if (!alive)
+				continue;
+
+			// What it writes stays needed, it may only be drawn on top of
+			for (const Access& access : pass.Accesses)
+			{
+				if (!IsWrite(access.Usage))
+					needed[access.Resource] = true;
+			}
+		}
+	}
+
+	VulkanRenderGraph::TransientLayout* VulkanRenderGraph::GetTransientLayout(const std::vector<uint32_t>& transients, uint64_t frameNumber)
+	{
+		// Same resources used by the same passes, the same layout fits
+		std::vector<TransientKey> key;
+		key.reserve(transients.size());
+		for (uint32_t index : transients)
+		{
+			const Resource& resource = m_Resources[index];
+			key.push_back({ resource.IsImage, resource.ImageDesc.Format, resource.ImageDesc.Extent, resource.ImageUsage,
+				resource.Size, resource.BufferUsage, resource.FirstPass, resource.LastPass });
+		}
+
+		auto it = m_Layouts.find(key);
+		if (it == m_Layouts.end())
+		{
+			// Not cached when it fails, the next frame tries again
+			TransientLayout layout;
+			if (!CreateTransientLayout(transients, layout))
+				return nullptr;
+			it = m_Layouts.emplace(std::move(key), std::move(layout)).first;
+		}
+
+		it->second.LastUsed = frameNumber;
+		return &it->second;
+	}
+
+	bool VulkanRenderGraph::CreateTransientLayout(const std::vector<uint32_t>& transients, TransientLayout& layout)
+	{
+		PT_PROFILE_FUNCTION();
+
+		uint32_t count = (uint32_t)transients.size();
+
+		layout.Resources.resize(m_FramesInFlight, std::vector<PhysicalResource>(count));
+		layout.Memory.resize(m_FramesInFlight);
+		layout.AliasedAfter.resize(count);
+
+		// The resources come first, their requirements decide the placement
+		std::vector<vk::MemoryRequirements> requirements(count);
+		for (uint32_t slot = 0; slot < m_FramesInFlight; slot++)
+		{
+			for (uint32_t transient = 0; transient < count; transient++)
+			{
+				const Resource& resource = m_Resources[transients[transient]];
+				PhysicalResource& physical = layout.Resources[slot][transient];
+				if (resource.IsImage)
+				{
+					vk::ImageCreateInfo createInfo(vk::ImageCreateFlags(), vk::ImageType::e2D, resource.ImageDesc.Format,
+						vk::Extent3D(resource.ImageDesc.Extent.width, resource.ImageDesc.Extent.height, 1), 1, 1,
+						vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, resource.ImageUsage);
+					physical.Image = m_Device.createImage(createInfo);
+					requirements[transient] = m_Device.getImageMemoryRequirements(physical.Image);
+				}
+				else
+				{
+					physical.Buffer = m_Device.createBuffer(vk::BufferCreateInfo(vk::BufferCreateFlags(), resource.Size, resource.BufferUsage));
+					requirements[transient] = m_Device.getBufferMemoryRequirements(physical.Buffer);
+				}
+			}
+		}
+
+		// Resources that can live in the same memory types share one
+		// allocation per frame in flight
+		std::vector<uint32_t> groupTypeBits;
+		std::vector<uint32_t> group(count);
+		for (uint32_t transient = 0; transient < count; transient++)
+		{
+			auto it = std::find(groupTypeBits.begin(), groupTypeBits.end(), requirements[transient].memoryTypeBits);
+			group[transient] = (uint32_t)(it - groupTypeBits.begin());
+			if (it == groupTypeBits.end())
+				groupTypeBits.push_back(requirements[transient].memoryTypeBits);
+		}
+
+		// Largest first, each at the lowest offset where it doesn't overlap
+		// anything alive at the same time. Everything is padded to
+		// bufferImageGranularity, buffers and images may be neighbours
+		vk::DeviceSize granularity = m_Allocator.GetDeviceProperties().limits.bufferImageGranularity;
+		std::vector<uint32_t> bySize(count);
+		for (uint32_t transient = 0; transient < count; transient++)
+			bySize[transient] = transient;
+		std::sort(bySize.begin(), bySize.end(), [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+
+		auto livesWith = [&](uint32_t a, uint32_t b)
+		{
+			const Resource& first = m_Resources[transients[a]];
+			const Resource& second = m_Resources[transients[b]];
+			return first.FirstPass <= second.LastPass && second.FirstPass <= first.LastPass;
+		};
+
+		std::vector<vk::DeviceSize> offsets(count);
+		std::vector<vk::DeviceSize> groupSizes(groupTypeBits.size());
+		std::vector<vk::DeviceSize> groupAlignments(groupTypeBits.size(), 1);
+		std::vector<std::vector<uint32_t>> placed(groupTypeBits.size());
+		for (uint32_t transient : bySize)
+		{
+			uint32_t g = group[transient];
+			vk::DeviceSize size = AlignUp(requirements[transient].size, granularity);
+			vk::DeviceSize alignment = std::max(requirements[transient].alignment, granularity);
+
+			std::vector<vk::DeviceSize> candidates = { 0 };
+			for (uint32_t other : placed[g])
+				candidates.push_back(offsets[other] + AlignUp(requirements[other].size, granularity));
+			std::sort(candidates.begin(), candidates.end());
+
+			for (vk::DeviceSize candidate : candidates)
+			{
+				vk::DeviceSize offset = AlignUp(candidate, alignment);
+				bool fits = true;
+				for (uint32_t other : placed[g])
+				{
+					vk::DeviceSize otherEnd = offsets[other] + AlignUp(requirements[other].size, granularity);
+					if (livesWith(transient, other) && offset < otherEnd && offsets[other] < offset + size)
+					{
+						fits = false;
+						break;
+					}
+				}
+
+				if (fits)
+				{
+					offsets[transient] = offset;
+					break;
+				}
+			}
+
+			placed[g].push_back(transient);
+			groupSizes[g] = std::max(groupSizes[g], offsets[transient] + size);
+			groupAlignments[g] = std::max(groupAlignments[g], alignment);
+			layout.TransientBytes += requirements[transient].size;
+		}
+
+		for (uint32_t transient = 0; transient < count; transient++)
+		{
+			vk::DeviceSize end = offsets[transient] + AlignUp(requirements[transient].size, granularity);
+			for (uint32_t other : placed[group[transient]])
+			{
+				vk::DeviceSize otherEnd = offsets[other] + AlignUp(requirements[other].size, granularity);
+				bool overlaps = offsets[transient] < otherEnd && offsets[other] < end;
+				if (other != transient && overlaps && m_Resources[transients[other]].LastPass < m_Resources[transients[transient]].FirstPass)
+					layout.AliasedAfter[transient].push_back(other);
+			}
+		}
+
+		for (vk::DeviceSize size : groupSizes)
+			layout.AliasedBytes += size;
+
+		for (uint32_t slot = 0; slot < m_FramesInFlight; slot++)
+		{
+			for (uint32_t g = 0; g < (uint32_t)groupTypeBits.size(); g++)
+			{
+				vk::MemoryRequirements groupRequirements(groupSizes[g], groupAlignments[g], groupTypeBits[g]);
+				VulkanAllocation memory = m_Allocator.Allocate(groupRequirements, VulkanMemoryUsage::GpuOnly, false);
+				if (!memory)
+				{
+					PT_CORE_ERROR("Out of memory for {0} bytes of transient resources", groupSizes[g]);
+					DestroyTransientLayout(layout);
+					layout = TransientLayout();
+					return false;
+				}
+				layout.Memory[slot].push_back(memory);
+			}
+
+			for (uint32_t transient = 0; transient < count; transient++)
+			{
+				const Resource& resource = m_Resources[transients[transient]];
+				const VulkanAllocation& memory = layout.Memory[slot][group[transient]];
+				PhysicalResource& physical = layout.Resources[slot][transient];
+				if (resource.IsImage)
+				{
+					m_Device.bindImageMemory(physical.Image, memory.Memory, memory.Offset + offsets[transient]);
+					physical.View = m_Device.createImageView(vk::ImageViewCreateInfo(vk::ImageViewCreateFlags(), physical.Image,
+						vk::ImageViewType::e2D, resource.ImageDesc.Format, vk::ComponentMapping(),
+						vk::ImageSubresourceRange(GetAspect(resource.ImageDesc.Format), 0, 1, 0, 1)));
+				}
+				else
+				{
+					m_Device.bindBufferMemory(physical.Buffer, memory.Memory, memory.Offset + offsets[transient]);
+				}
+			}
+		}
+
+		PT_CORE_INFO("Render graph: {0} transient resources take {1} KB instead of {2} KB per frame in flight",
+			count, layout.AliasedBytes / 1024, layout.TransientBytes / 1024);
+		return true;
+	}
+
+	void VulkanRenderGraph::DestroyTransientLayout(TransientLayout& layout)
+	{
+		std::vector<vk::ImageView> views;
+		for (const std::vector<PhysicalResource>& resources : layout.Resources)
+		{
+			for (const PhysicalResource& physical : resources)
+			{
+				if (physical.View)
+					views.push_back(physical.View);
+			}
+		}
+		ReleaseImageViews(views);
+
+		for (std::vector<PhysicalResource>& resources : layout.Resources)
+		{
+			for (PhysicalResource& physical : resources)
+			{
+				if (physical.View)
+					m_Device.destroyImageView(physical.View);
+				if (physical.Image)
+					m_Device.destroyImage(physical.Image);
+				if (physical.Buffer)
+					m_Device.destroyBuffer(physical.Buffer);
+			}
+		}
+		for (std::vector<VulkanAllocation>& memory : layout.Memory)
+		{
+			for (VulkanAllocation& allocation : memory)
+				m_Allocator.Free(allocation);
+		}
+	}
+
+	void VulkanRenderGraph::PrepareRenderPass(Pass& pass, uint32_t position, uint64_t frameNumber)
+	{
+		std::vector<vk::AttachmentDescription> attachments;
+		std::vector<vk::ImageView> views;
+		pass.ClearValues.clear();
+		pass.RenderPass = nullptr;
+		pass.Framebuffer = nullptr;
+
+		auto addAttachment = [&](const Access& access)
+		{
+			const Resource& resource = m_Resources[access.Resource];
+			auto clear = std::find_if(pass.Clears.begin(), pass.Clears.end(), [&](const auto& c) { return c.first == access.Resource; });
+
+			// Contents that came before are loaded, those needed after stored
+			vk::AttachmentLoadOp load = vk::AttachmentLoadOp::eDontCare;
+			if (clear != pass.Clears.end())
+				load = vk::AttachmentLoadOp::eClear;
+			else if (resource.Imported || resource.FirstPass < position)
+				load = vk::AttachmentLoadOp::eLoad;
+			bool keep = resource.Imported || resource.LastPass > position;
+			vk::AttachmentStoreOp store = keep ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+
+			bool stencil = (bool)(GetAspect(resource.ImageDesc.Format) & vk::ImageAspectFlagBits::eStencil);
+			vk::ImageLayout layout = GetUsageInfo(access.Usage).Layout;
+
+			// The barriers before the pass transition the layout
+			attachments.push_back(vk::AttachmentDescription(vk::AttachmentDescriptionFlags(), resource.ImageDesc.Format, vk::SampleCountFlagBits::e1,
+				load, store, stencil ? load : vk::AttachmentLoadOp::eDontCare, stencil ? store : vk::AttachmentStoreOp::eDontCare, layout, layout));
+			views.push_back(resource.View);
+			pass.ClearValues.push_back(clear != pass.Clears.end() ? clear->second : vk::ClearValue());
+
+			PT_CORE_ASSERT(attachments.size() == 1 || resource.ImageDesc.Extent == pass.Extent, "Attachments of pass '{0}' differ in size", pass.Name);
+			pass.Extent = resource.ImageDesc.Extent;
+		};
+
+		// Color attachments in the order they were declared, depth last
+		for (const Access& access : pass.Accesses)
+		{
+			if (access.Usage == RenderGraphUsage::ColorAttachment)
+				addAttachment(access);
+		}
+		bool depth = false;
+		for (const Access& access : pass.Accesses)
+		{
+			if (access.Usage == RenderGraphUsage::DepthAttachment || access.Usage == RenderGraphUsage::DepthRead)
+			{
+				PT_CORE_ASSERT(!depth, "Pass '{0}' has more than one depth attachment", pass.Name);
+				addAttachment(access);
+				depth = true;
+			}
+		}
+
+		if (attachments.empty())
+			return;
+
+		pass.RenderPass = GetRenderPass(attachments, depth);
+
+		FramebufferKey key{ pass.RenderPass, std::move(views), pass.Extent };
+		CachedFramebuffer& framebuffer = m_Framebuffers[key];
+		if (!framebuffer.Framebuffer)
+		{
+			framebuffer.Framebuffer = m_Device.createFramebuffer(vk::FramebufferCreateInfo(vk::FramebufferCreateFlags(), pass.RenderPass,
+				(uint32_t)key.Views.size(), key.Views.data(), pass.Extent.width, pass.Extent.height, 1));
+		}
+		framebuffer.LastUsed = frameNumber;
+		pass.Framebuffer = framebuffer.Framebuffer;
+	}
+
+	vk::RenderPass VulkanRenderGraph::GetRenderPass(const std::vector<vk::AttachmentDescription>& attachments, bool depth)
+	{
+		vk::RenderPass& renderPass = m_RenderPasses[RenderPassKey{ attachments, depth }];
+		if (renderPass)
+			return renderPass;
+
+		uint32_t colorCount = (uint32_t)attachments.size() - (depth ? 1 : 0);
+		std::vector<vk::AttachmentReference> colorReferences;
+		for (uint32_t i = 0; i < colorCount; i++)
+			colorReferences.push_back(vk::AttachmentReference(i, attachments[i].initialLayout));
+		vk::AttachmentReference depthReference(colorCount, depth ? attachments.back().initialLayout : vk::ImageLayout::eUndefined);
+
+		vk::SubpassDescription subpass(vk::SubpassDescriptionFlags(), vk::PipelineBindPoint::eGraphics, 0, nullptr,
+			colorCount, colorReferences.data(), nullptr, depth ? &depthReference : nullptr);
+
+		// Barriers outside of the render pass order it with the other passes
+		renderPass = m_Device.createRenderPass(vk::RenderPassCreateInfo(vk::RenderPassCreateFlags(),
+			(uint32_t)attachments.size(), attachments.data(), 1, &subpass));
+		return renderPass;
+	}
+
+	void VulkanRenderGraph::AddBarriers(uint32_t index, RenderGraphUsage usage, vk::PipelineStageFlags aliasStage, vk::AccessFlags aliasAccess,
+		std::vector<vk::ImageMemoryBarrier>& images, std::vector<vk::BufferMemoryBarrier>& buffers,
+		vk::PipelineStageFlags& srcStage, vk::PipelineStageFlags& dstStage)
+	{
+		Resource& resource = m_Resources[index];
+		ResourceState& state = resource.State;
+		UsageInfo info = GetUsageInfo(usage);
+
+		bool write = IsWrite(usage);
+		vk::ImageLayout layout = resource.IsImage ? info.Layout : vk::ImageLayout::eUndefined;
+		bool transition = resource.IsImage && layout != state.Layout;
+
+		// A read needs nothing when the last write is already visible to it,
+		// or when nothing was written
+		if (!write && !transition && !aliasStage)
+		{
+			bool visible = !(info.Stage & ~state.VisibleStages) && !(info.Access & ~state.VisibleAccess);
+			if (visible || !state.WriteStage)
+			{
+				state.ReadStages |= info.Stage;
+				return;
+			}
+		}
+
+		// Writes and transitions also wait for the reads before them
+		vk::PipelineStageFlags waitStage = state.WriteStage | aliasStage;
+		if (write || transition)
+			waitStage |= state.ReadStages;
+		if (!waitStage && !transition)
+		{
+			// Untouched memory, nothing to wait for
+			state.WriteStage = info.Stage;
+			state.WriteAccess = info.Access & WriteAccess;
+			state.VisibleStages = info.Stage;
+			state.VisibleAccess = info.Access;
+			return;
+		}
+
+		srcStage |= waitStage;
+		dstStage |= info.Stage;
+		vk::AccessFlags srcAccess = state.WriteAccess | aliasAccess;
+		if (resource.IsImage)
+		{
+			// Aliased memory and transient images start out undefined
+			images.push_back(vk::ImageMemoryBarrier(srcAccess, info.Access, state.Layout, layout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+				resource.Image, vk::ImageSubresourceRange(GetAspect(resource.ImageDesc.Format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS)));
+		}
+		else
+		{
+			buffers.push_back(vk::BufferMemoryBarrier(srcAccess, info.Access, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+				resource.Buffer, 0, VK_WHOLE_SIZE));
+		}
+
+		if (write || transition)
+		{
+			// A transition counts as a write, later reads in other stages
+			// have to wait for it. The barrier made the last write available,
+			// waiting on the transition's stage is enough after it and the
+			// old write access may not even be valid for that stage
+			state.Layout = layout;
+			state.WriteStage = info.Stage;
+			state.WriteAccess = write ? info.Access & WriteAccess : vk::AccessFlags();
+			state.ReadStages = write ? vk::PipelineStageFlags() : info.Stage;
+			state.VisibleStages = info.Stage;
+			state.VisibleAccess = info.Access;
+		}
+		else
+		{
+			state.ReadStages |= info.Stage;
+			state.VisibleStages |= info.Stage;
+			state.VisibleAccess |= info.Access;
+		}
+	}
+
+	void VulkanRenderGraph::RecordPass(Pass& pass, uint32_t slot)
+	{
+		const char* profileName = Instrumentor::IsActive() ? Instrumentor::Get().InternName(pass.Name) : "Render graph pass";
+		PT_PROFILE_SCOPE(profileName);
+
+		// Every thread has pools of its own, only threads outside the job
+		// system share one
+		int32_t thread = JobSystem::GetThreadIndex();
+		std::unique_lock<std::mutex> lock(m_OutsideMutex, std::defer_lock);
+		if (thread < 0)
+			lock.lock();
+
+		ThreadContext& context = m_ThreadContexts[slot][thread + 1];
+		if (context.Used == context.CommandBuffers.size())
+		{
+			context.CommandBuffers.push_back(m_Device.allocateCommandBuffers(
+				vk::CommandBufferAllocateInfo(context.CommandPool, vk::CommandBufferLevel::eSecondary, 1))[0]);
+		}
+		vk::CommandBuffer commandBuffer = context.CommandBuffers[context.Used++];
+
+		vk::CommandBufferInheritanceInfo inheritance(pass.RenderPass, 0, pass.Framebuffer);
+		vk::CommandBufferUsageFlags flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		if (pass.RenderPass)
+			flags |= vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+		commandBuffer.begin(vk::CommandBufferBeginInfo(flags, &inheritance));
+
+		if (pass.Execute)
+		{
+			RenderGraphPassContext context;
+			context.CommandBuffer = commandBuffer;
+			context.RenderPass = pass.RenderPass;
+			context.Extent = pass.Extent;
+			context.Graph = this;
+			pass.Execute(context);
+		}
+
+		commandBuffer.end();
+		pass.CommandBuffer = commandBuffer;
+	}
+
+	void VulkanRenderGraph::PrepareTimestamps(uint32_t slot, uint32_t passCount)
+	{
+		TimestampQueries& queries = m_Timestamps[slot];
+
+		// The frame that used the slot before is done, its times are there
+		if (!queries.Passes.empty())
+		{
+			std::vector<uint64_t> values(queries.Passes.size() * 2);
+			vk::Result result = m_Device.getQueryPoolResults(queries.Pool, 0, (uint32_t)values.size(), values.size() * sizeof(uint64_t),
+				values.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+			if (result == vk::Result::eSuccess)
+			{
+				m_PassTimings.clear();
+				for (uint32_t i = 0; i < (uint32_t)queries.Passes.size(); i++)
+				{
+					uint64_t ticks = (values[i * 2 + 1] - values[i * 2]) & m_TimestampMask;
+					uint64_t ns = (uint64_t)((double)ticks * m_TimestampPeriod);
+					m_PassTimings.push_back({ queries.Passes[i], queries.FrameNumber, ns });
+					GetPassMetric(queries.Passes[i]).Record(ns);
+				}
+			}
+			queries.Passes.clear();
+		}
+
+		if (queries.Capacity < passCount * 2)
+		{
+			m_Device.destroyQueryPool(queries.Pool);
+			queries.Capacity = std::max(passCount * 2, 64u);
+			queries.Pool = m_Device.createQueryPool(vk::QueryPoolCreateInfo(vk::QueryPoolCreateFlags(), vk::QueryType::eTimestamp, queries.Capacity));
+		}
+	}
+
+	Histogram& VulkanRenderGraph::GetPassMetric(const std::string& name)
+	{
+		Histogram*& metric = m_PassMetrics[name];
+		if (!metric)
+			metric = &Metrics::GetHistogram("vulkan.pass." + name + ".gpu_ns");
+		return *metric;
+	}
+
+	void VulkanRenderGraph::ReleaseImageViews(const std::vector<vk::ImageView>& views)
+	{
+		if (views.empty())
+			return;
+
+		for (auto it = m_Framebuffers.begin(); it != m_Framebuffers.end();)
+		{
+			bool released = std::find_first_of(it->first.Views.begin(), it->first.Views.end(), views.begin(), views.end()) != it->first.Views.end();
+			if (released)
+			{
+				m_Device.destroyFramebuffer(it->second.Framebuffer);
+				it = m_Framebuffers.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	size_t VulkanRenderGraph::TransientKeyHash::operator()(const std::vector<TransientKey>& key) const
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (const TransientKey& transient : key)
+		{
+			hash = HashValue(transient.IsImage, hash);
+			hash = HashValue(transient.Format, hash);
+			hash = HashValue(transient.Extent.width, hash);
+			hash = HashValue(transient.Extent.height, hash);
+			hash = HashValue((VkImageUsageFlags)transient.ImageUsage, hash);
+			hash = HashValue(transient.Size, hash);
+			hash = HashValue((VkBufferUsageFlags)transient.BufferUsage, hash);
+			hash = HashValue(transient.FirstPass, hash);
+			hash = HashValue(transient.LastPass, hash);
+		}
+		return (size_t)hash;
+	}
+
+	size_t VulkanRenderGraph::RenderPassKeyHash::operator()(const RenderPassKey& key) const
+	{
+		uint64_t hash = HashValue(key.Depth, 14695981039346656037ull);
+		for (const vk::AttachmentDescription& attachment : key.Attachments)
+			hash = HashValue((const VkAttachmentDescription&)attachment, hash);
+		return (size_t)hash;
+	}
+
+	size_t VulkanRenderGraph::FramebufferKeyHash::operator()(const FramebufferKey& key) const
+	{
+		uint64_t hash = HashValue((VkRenderPass)key.RenderPass, 14695981039346656037ull);
+		for (vk::ImageView view : key.Views)
+			hash = HashValue((VkImageView)view, hash);
+		hash = HashValue(key.Extent.width, hash);
+		return (size_t)HashValue(key.Extent.height, hash);
+	}
+
+	void VulkanRenderGraph::Prune(uint64_t frameNumber)
+	{
+		// Unused since a frame the GPU is done with
+		auto expired = [&](uint64_t lastUsed) { return frameNumber > lastUsed + m_FramesInFlight + KeepFrames; };
+
+		for (auto it = m_Framebuffers.begin(); it != m_Framebuffers.end();)
+		{
+			if (expired(it->second.LastUsed))
+			{
+				m_Device.destroyFramebuffer(it->second.Framebuffer);
+				it = m_Framebuffers.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		for (auto it = m_Layouts.begin(); it != m_Layouts.end();)
+		{
+			if (expired(it->second.LastUsed))
+			{
+				DestroyTransientLayout(it->second);
+				it = m_Layouts.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+}
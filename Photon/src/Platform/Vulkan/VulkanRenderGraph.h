@@ -0,0 +1,386 @@
+#pragma once
+
+#include "Photon/Core.h"
+#include "Photon/Metrics/Metrics.h"
+#include "Platform/Vulkan/VulkanAllocator.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Photon
+{
+	// How a pass uses a resource. Decides the pipeline stages and access of
+	// the barriers, the layout of images and the usage flags transient
+	// resources are created with. The first four are writes
+	enum class RenderGraphUsage : uint8_t
+	{
+		ColorAttachment,
+		DepthAttachment,
+		StorageWrite,
+		TransferDst,
+
+		DepthRead,
+		Sampled,
+		StorageRead,
+		TransferSrc,
+		VertexBuffer,
+		IndexBuffer,
+		UniformBuffer,
+		IndirectBuffer
+	};
+
+	struct RenderGraphImageDesc
+	{
+		vk::Format Format = vk::Format::eR8G8B8A8Unorm;
+		vk::Extent2D Extent;
+	};
+
+	// Where an imported image is when the graph starts, or has to be left
+	struct RenderGraphImageState
+	{
+		vk::ImageLayout Layout = vk::ImageLayout::eUndefined;
+		vk::PipelineStageFlags Stage = vk::PipelineStageFlagBits::eTopOfPipe;
+		vk::AccessFlags Access;
+	};
+
+	// Refers to a resource of the graph until the next Execute
+	struct RenderGraphResource
+	{
+		uint32_t Index = UINT32_MAX;
+
+		inline explicit operator bool() const { return Index != UINT32_MAX; }
+	};
+
+	class VulkanRenderGraph;
+
+	// What a pass records with. Passes record at the same time on different
+	// threads, each into a secondary command buffer of its own
+	struct RenderGraphPassContext
+	{
+		vk::CommandBuffer CommandBuffer;
+		// The pass records inside it when it has attachments, null otherwise.
+		// Compatible from frame to frame, pipelines can be made for it
+		vk::RenderPass RenderPass;
+		vk::Extent2D Extent;
+		const VulkanRenderGraph* Graph = nullptr;
+	};
+
+	using RenderGraphExecuteFn = std::function<void(const RenderGraphPassContext&)>;
+
+	class PHOTON_API RenderGraphPassBuilder
+	{
+	public:
+		RenderGraphPassBuilder& Read(RenderGraphResource resource, RenderGraphUsage usage);
+		RenderGraphPassBuilder& Write(RenderGraphResource resource, RenderGraphUsage usage);
+		// Clears an attachment when the pass begins instead of loading it
+		RenderGraphPassBuilder& Clear(RenderGraphResource resource, const vk::ClearValue& value);
+		// Keeps the pass even when nothing reads what it writes
+		RenderGraphPassBuilder& SideEffects();
+	private:
+		RenderGraphPassBuilder(VulkanRenderGraph& graph, uint32_t pass)
+			: m_Graph(graph), m_Pass(pass) {}
+	private:
+		VulkanRenderGraph& m_Graph;
+		uint32_t m_Pass;
+
+		friend class VulkanRenderGraph;
+	};
+
+	struct VulkanRenderGraphStats
+	{
+		uint32_t Passes = 0;
+		uint32_t CulledPasses = 0;
+		uint32_t Barriers = 0;
+		uint32_t TransientImages = 0;
+		uint32_t TransientBuffers = 0;
+		// What the transient resources would take each on their own, and
+		// what they take sharing memory
+		vk::DeviceSize TransientBytes = 0;
+		vk::DeviceSize AliasedBytes = 0;
+		// Cached transient resource sets, one per graph shape in use
+		uint32_t Layouts = 0;
+	};
+
+	// GPU time of a pass, from timestamps written around it
+	struct RenderGraphPassTiming
+	{
+		std::string Name;
+		uint64_t FrameNumber = 0;
+		uint64_t GpuNs = 0;
+	};
+
+	// Records a frame from passes that declare what they read and write,
+	// built anew every frame.
+	//
+	// Execute culls the passes whose results nobody reads, derives the
+	// barriers and layout transitions between the rest and lets the passes
+	// record into secondary command buffers on the job system, one command
+	// pool per thread and frame in flight. The primary command buffer then
+	// gets the barriers, a render pass per pass with attachments and the
+	// secondaries, in the order the passes were added.
+	//
+	// Transient resources whose lifetimes don't overlap share memory. The
+	// resources and their memory are kept per graph shape and frame in
+	// flight, a graph like the last frame's creates nothing.
+	//
+	// With timestamps, every pass is timed on the GPU. The times are read
+	// once the frame's slot comes around again, framesInFlight frames
+	// later, and go to a "vulkan.pass.<name>.gpu_ns" histogram.
+	//
+	// Not thread safe, build and execute the graph on one thread.
+	class PHOTON_API VulkanRenderGraph
+	{
+	public:
+		// timestampBits are the queue family's timestampValidBits, 0 turns
+		// the timestamps off
+		VulkanRenderGraph(vk::Device device, VulkanAllocator& allocator, uint32_t queueFamily, uint32_t framesInFlight, uint32_t timestampBits = 0);
+		// The GPU has to be done with every executed frame
+		~VulkanRenderGraph();
+
+		VulkanRenderGraph(const VulkanRenderGraph&) = delete;
+		VulkanRenderGraph& operator=(const VulkanRenderGraph&) = delete;
+
+		// Transient, only live during the frame
+		RenderGraphResource CreateImage(const std::string& name, const RenderGraphImageDesc& desc);
+		RenderGraphResource CreateBuffer(const std::string& name, vk::DeviceSize size);
+		// Created elsewhere, like the swapchain image. Imported resources
+		// count as read after the graph, passes writing them are never culled.
+		// Images always end in final, unused ones are transitioned straight there
+		RenderGraphResource ImportImage(const std::string& name, vk::Image image, vk::ImageView view, const RenderGraphImageDesc& desc,
+			const RenderGraphImageState& initial, const RenderGraphImageState& final);
+		RenderGraphResource ImportBuffer(const std::string& name, vk::Buffer buffer, vk::DeviceSize size);
+
+		RenderGraphPassBuilder AddPass(const std::string& name, RenderGraphExecuteFn execute);
+
+		// Records the graph into commandBuffer and clears it for the next
+		// frame. The GPU has to be done with frameNumber - framesInFlight
+		void Execute(vk::CommandBuffer commandBuffer, uint64_t frameNumber);
+		// Drops the passes and resources without recording them, for frames
+		// that are skipped
+		void Clear();
+
+		// Destroys the framebuffers made for views that are about to be
+		// destroyed. The GPU has to be done with them, e.g. call it from
+		// VulkanSwapchain::DeferDestroy. Handles of destroyed views get
+		// reused, a framebuffer for one must not be found for the next
+		void ReleaseImageViews(const std::vector<vk::ImageView>& views);
+
+		// For passes while they record
+		vk::Image GetImage(RenderGraphResource resource) const;
+		vk::ImageView GetImageView(RenderGraphResource resource) const;
+		vk::Buffer GetBuffer(RenderGraphResource resource) const;
+
+		// Of the last Execute
+		inline const VulkanRenderGraphStats& GetStats() const { return m_Stats; }
+		// Of the latest frame the GPU is done with, in execution order. Empty
+		// without timestamps
+		inline const std::vector<RenderGraphPassTiming>& GetPassTimings() const { return m_PassTimings; }
+	private:
+		struct Access
+		{
+			uint32_t Resource;
+			RenderGraphUsage Usage;
+		};
+
+		struct Pass
+		{
+			std::string Name;
+			RenderGraphExecuteFn Execute;
+			std::vector<Access> Accesses;
+			std::vector<std::pair<uint32_t, vk::ClearValue>> Clears;
+			bool SideEffects = false;
+			bool Culled = false;
+
+			vk::RenderPass RenderPass;
+			vk::Framebuffer Framebuffer;
+			vk::Extent2D Extent;
+			std::vector<vk::ClearValue> ClearValues;
+			vk::CommandBuffer CommandBuffer;
+		};
+
+		// Where a resource is between the passes
+		struct ResourceState
+		{
+			vk::ImageLayout Layout = vk::ImageLayout::eUndefined;
+			// Of the last write or layout transition
+			vk::PipelineStageFlags WriteStage;
+			vk::AccessFlags WriteAccess;
+			// Stages that read it since
+			vk::PipelineStageFlags ReadStages;
+			// Stages and access the last write is already visible to
+			vk::PipelineStageFlags VisibleStages;
+			vk::AccessFlags VisibleAccess;
+		};
+
+		struct Resource
+		{
+			std::string Name;
+			bool IsImage = false;
+			bool Imported = false;
+			RenderGraphImageDesc ImageDesc;
+			vk::DeviceSize Size = 0;
+			RenderGraphImageState Final;
+
+			vk::Image Image;
+			vk::ImageView View;
+			vk::Buffer Buffer;
+
+			// Set by Execute. First and last pass using it, in execution order
+			uint32_t FirstPass = UINT32_MAX;
+			uint32_t LastPass = 0;
+			vk::ImageUsageFlags ImageUsage;
+			vk::BufferUsageFlags BufferUsage;
+			// Index among the transient resources of the layout
+			uint32_t Transient = UINT32_MAX;
+			ResourceState State;
+		};
+
+		struct PhysicalResource
+		{
+			vk::Image Image;
+			vk::ImageView View;
+			vk::Buffer Buffer;
+		};
+
+		// The transient resources of one graph shape
+		struct TransientLayout
+		{
+			// [frame in flight][transient]
+			std::vector<std::vector<PhysicalResource>> Resources;
+			// [frame in flight][memory type group]
+			std::vector<std::vector<VulkanAllocation>> Memory;
+			// Per transient, those that used its memory earlier in the frame
+			std::vector<std::vector<uint32_t>> AliasedAfter;
+			vk::DeviceSize TransientBytes = 0;
+			vk::DeviceSize AliasedBytes = 0;
+			uint64_t LastUsed = 0;
+		};
+
+		// What a transient is in a graph shape, a layout is reused for a
+		// graph with the same transients
+		struct TransientKey
+		{
+			bool IsImage = false;
+			vk::Format Format = vk::Format::eUndefined;
+			vk::Extent2D Extent;
+			vk::ImageUsageFlags ImageUsage;
+			vk::DeviceSize Size = 0;
+			vk::BufferUsageFlags BufferUsage;
+			uint32_t FirstPass = 0;
+			uint32_t LastPass = 0;
+
+			bool operator==(const TransientKey& other) const = default;
+		};
+
+		struct TransientKeyHash
+		{
+			size_t operator()(const std::vector<TransientKey>& key) const;
+		};
+
+		struct RenderPassKey
+		{
+			std::vector<vk::AttachmentDescription> Attachments;
+			bool Depth = false;
+
+			bool operator==(const RenderPassKey& other) const = default;
+		};
+
+		struct RenderPassKeyHash
+		{
+			size_t operator()(const RenderPassKey& key) const;
+		};
+
+		struct FramebufferKey
+		{
+			vk::RenderPass RenderPass;
+			std::vector<vk::ImageView> Views;
+			vk::Extent2D Extent;
+
+			bool operator==(const FramebufferKey& other) const = default;
+		};
+
+		struct FramebufferKeyHash
+		{
+			size_t operator()(const FramebufferKey& key) const;
+		};
+
+		struct CachedFramebuffer
+		{
+			vk::Framebuffer Framebuffer;
+			uint64_t LastUsed = 0;
+		};
+
+		// Per frame in flight, the pass timestamps are written to
+		struct TimestampQueries
+		{
+			vk::QueryPool Pool;
+			uint32_t Capacity = 0;
+			// Of the passes written last time, two queries each
+			std::vector<std::string> Passes;
+			uint64_t FrameNumber = 0;
+		};
+
+		// Per thread and frame in flight
+		struct ThreadContext
+		{
+			vk::CommandPool CommandPool;
+			std::vector<vk::CommandBuffer> CommandBuffers;
+			uint32_t Used = 0;
+		};
+
+		void Cull();
+		// Null when the memory for a new layout can't be allocated
+		TransientLayout* GetTransientLayout(const std::vector<uint32_t>& transients, uint64_t frameNumber);
+		bool CreateTransientLayout(const std::vector<uint32_t>& transients, TransientLayout& layout);
+		void DestroyTransientLayout(TransientLayout& layout);
+		void PrepareRenderPass(Pass& pass, uint32_t position, uint64_t frameNumber);
+		vk::RenderPass GetRenderPass(const std::vector<vk::AttachmentDescription>& attachments, bool depth);
+		// aliasStage and aliasAccess are of the resources that used the
+		// memory before, for the first use of a transient
+		void AddBarriers(uint32_t index, RenderGraphUsage usage, vk::PipelineStageFlags aliasStage, vk::AccessFlags aliasAccess,
+			std::vector<vk::ImageMemoryBarrier>& images, std::vector<vk::BufferMemoryBarrier>& buffers,
+			vk::PipelineStageFlags& srcStage, vk::PipelineStageFlags& dstStage);
+		void RecordPass(Pass& pass, uint32_t slot);
+		void Prune(uint64_t frameNumber);
+		// Reads the times of the frame that last used the slot and makes room
+		// for passCount passes
+		void PrepareTimestamps(uint32_t slot, uint32_t passCount);
+		Histogram& GetPassMetric(const std::string& name);
+	private:
+		// Caches unused for this many frames past the frames in flight go
+		static constexpr uint64_t KeepFrames = 8;
+
+		vk::Device m_Device;
+		VulkanAllocator& m_Allocator;
+		uint32_t m_QueueFamily;
+		uint32_t m_FramesInFlight;
+
+		std::vector<Pass> m_Passes;
+		std::vector<Resource> m_Resources;
+
+		std::unordered_map<std::vector<TransientKey>, TransientLayout, TransientKeyHash> m_Layouts;
+		std::unordered_map<RenderPassKey, vk::RenderPass, RenderPassKeyHash> m_RenderPasses;
+		std::unordered_map<FramebufferKey, CachedFramebuffer, FramebufferKeyHash> m_Framebuffers;
+
+		// [frame in flight][thread index + 1], threads outside the job
+		// system share the first one under m_OutsideMutex
+		std::vector<std::vector<ThreadContext>> m_ThreadContexts;
+		std::mutex m_OutsideMutex;
+
+		uint64_t m_TimestampMask = 0;
+		float m_TimestampPeriod = 1.0f;
+		std::vector<TimestampQueries> m_Timestamps;
+		std::vector<RenderGraphPassTiming> m_PassTimings;
+		std::unordered_map<std::string, Histogram*> m_PassMetrics;
+
+		VulkanRenderGraphStats m_Stats;
+
+		friend class RenderGraphPassBuilder;
+	};
+}
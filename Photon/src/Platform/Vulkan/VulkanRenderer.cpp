@@ -0,0 +1,164 @@
+#include "ptpch.h"
+#include "VulkanRenderer.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+namespace Photon
+{
+	VulkanRenderer::VulkanRenderer(VulkanContext& context, vk::SurfaceKHR surface, uint32_t width, uint32_t height, bool vsync, uint32_t framesInFlight)
+		: m_Context(context), m_FramesInFlight(framesInFlight)
+	{
+		PT_PROFILE_FUNCTION();
+
+		m_Readback = std::make_unique<VulkanReadback>(context.GetAllocator());
+		m_RenderGraph = std::make_unique<VulkanRenderGraph>(context.GetDevice(), context.GetAllocator(), context.GetGraphicsFamily(), framesInFlight,
+			context.GetTimestampBits());
+		m_Swapchain = std::make_unique<VulkanSwapchain>(context.GetPhysicalDevice(), context.GetDevice(), context.GetAllocator(), surface,
+			context.GetGraphicsFamily(), context.GetGraphicsQueue(), context.GetPresentQueue(), context.GetGraphicsQueueMutex(), width, height, vsync, framesInFlight);
+
+		// The graph caches framebuffers by view, they go with the views
+		m_Swapchain->SetImageViewsReleasedCallback([graph = m_RenderGraph.get()](const std::vector<vk::ImageView>& views)
+		{
+			graph->ReleaseImageViews(views);
+		});
+	}
+
+	VulkanRenderer::~VulkanRenderer()
+	{
+		PT_PROFILE_FUNCTION();
+
+		// The swapchain waits for the device to go idle, after that nothing
+		// the graph and the readbacks own is in use
+		m_Swapchain.reset();
+		m_RenderGraph.reset();
+		m_Readback.reset();
+	}
+
+	void VulkanRenderer::BeginFrame()
+	{
+		PT_PROFILE_FUNCTION();
+
+		VulkanFrame* frame = m_Swapchain->BeginFrame();
+		m_Backbuffer = RenderGraphResource();
+		if (!frame)
+			return;
+
+		// Waiting for the slot means the frame that used it last is done
+		if (frame->Number >= m_FramesInFlight)
+			m_Readback->Complete(frame->Number - m_FramesInFlight);
+
+		// The swapchain clears the image and leaves it as a color attachment
+		RenderGraphImageState state;
+		state.Layout = vk::ImageLayout::eColorAttachmentOptimal;
+		state.Stage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+		state.Access = vk::AccessFlagBits::eColorAttachmentWrite;
+		RenderGraphImageState final = state;
+		final.Access |= vk::AccessFlagBits::eColorAttachmentRead;
+		m_Backbuffer = m_RenderGraph->ImportImage("Backbuffer", frame->Image, frame->ImageView,
+			{ m_Swapchain->GetFormat(), m_Swapchain->GetExtent() }, state, final);
+
+		VulkanUploader* uploader = m_Context.GetUploader();
+		if (!uploader)
+			return;
+
+		// Takes over the uploads that are done, the frame doesn't wait for
+		// the ones still being copied
+		uint64_t uploads = uploader->Acquire(frame->CommandBuffer);
+		if (uploads)
+			m_Swapchain->AddWait(uploader->GetSemaphore(), uploads, VulkanUploader::WaitStages);
+	}
+
+	bool VulkanRenderer::EndFrame()
+	{
+		PT_PROFILE_FUNCTION();
+
+		VulkanFrame* frame = m_Swapchain->GetCurrentFrame();
+		if (!frame)
+		{
+			m_RenderGraph->Clear();
+			return m_Swapchain->EndFrame();
+		}
+
+		// After every other pass that touches the backbuffer
+		if (!m_FrameReadbacks.empty())
+		{
+			m_RenderGraph->AddPass("Readback", [this, readbacks = std::move(m_FrameReadbacks), backbuffer = m_Backbuffer](const RenderGraphPassContext& context)
+			{
+				for (uint64_t request : readbacks)
+					m_Readback->RecordCopy(request, context.CommandBuffer, context.Graph->GetImage(backbuffer));
+			}).Read(m_Backbuffer, RenderGraphUsage::TransferSrc).SideEffects();
+			m_FrameReadbacks.clear();
+		}
+
+		m_RenderGraph->Execute(frame->CommandBuffer, frame->Number);
+		return m_Swapchain->EndFrame();
+	}
+
+	void VulkanRenderer::Resize(uint32_t width, uint32_t height)
+	{
+		m_Swapchain->Resize(width, height);
+	}
+
+	void VulkanRenderer::SetVSync(bool enabled)
+	{
+		m_Swapchain->SetVSync(enabled);
+	}
+
+	uint64_t VulkanRenderer::RequestReadback()
+	{
+		VulkanFrame* frame = m_Swapchain->GetCurrentFrame();
+		if (!frame)
+			return 0;
+
+		if (!(m_Swapchain->GetImageUsage() & vk::ImageUsageFlagBits::eTransferSrc))
+		{
+			PT_CORE_ERROR("The surface's images can't be read back");
+			return 0;
+		}
+
+		uint64_t request = m_Readback->Request(m_Swapchain->GetFormat(), m_Swapchain->GetExtent(), frame->Number);
+		if (request)
+			m_FrameReadbacks.push_back(request);
+		return request;
+	}
+
+	bool VulkanRenderer::WaitForReadback(uint64_t request)
+	{
+		PT_PROFILE_FUNCTION();
+
+		VulkanReadbackData data = m_Readback->GetData(request);
+		if (!data.Size)
+			return false;
+
+		if (!m_Readback->IsReady(request))
+		{
+			VulkanFrame* frame = m_Swapchain->GetCurrentFrame();
+			PT_CORE_ASSERT(!frame || frame->Number != data.FrameNumber, "Readback {0} waited for before its frame ended", request);
+
+			m_Swapchain->WaitForFrame(data.FrameNumber);
+			m_Readback->Complete(data.FrameNumber);
+		}
+		return true;
+	}
+
+	bool VulkanRenderer::ReadFrame(const std::function<bool(const VulkanReadbackData&)>& read)
+	{
+		PT_PROFILE_FUNCTION();
+
+		uint64_t request = RequestReadback();
+		bool submitted = EndFrame();
+
+		// A dropped frame never copies into the readback
+		bool result = request && submitted && WaitForReadback(request) && read(m_Readback->GetData(request));
+		if (request)
+			m_Readback->Release(request);
+
+		BeginFrame();
+		return result;
+	}
+
+	bool VulkanRenderer::CaptureFrame(const std::string& filepath)
+	{
+		return ReadFrame([&](const VulkanReadbackData& data) { return VulkanReadback::WritePpm(filepath, data); });
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Photon/Core.h"
+#include "Platform/Vulkan/VulkanContext.h"
+#include "Platform/Vulkan/VulkanReadback.h"
+#include "Platform/Vulkan/VulkanRenderGraph.h"
+#include "Platform/Vulkan/VulkanSwapchain.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Photon
+{
+	// The frame loop on a VulkanContext: a swapchain, the render graph
+	// executed into every frame and readbacks of the frames.
+	//
+	// Without a surface the frames go into offscreen images, which together
+	// with a context created without a window renders headless, e.g. on a
+	// software ICD to compare frames against reference images.
+	//
+	// Between BeginFrame and EndFrame passes are added to the render graph,
+	// EndFrame executes and submits it.
+	class PHOTON_API VulkanRenderer
+	{
+	public:
+		// surface may be null to render offscreen
+		VulkanRenderer(VulkanContext& context, vk::SurfaceKHR surface, uint32_t width, uint32_t height, bool vsync, uint32_t framesInFlight = 2);
+		// Waits for the frames still on the GPU
+		~VulkanRenderer();
+
+		VulkanRenderer(const VulkanRenderer&) = delete;
+		VulkanRenderer& operator=(const VulkanRenderer&) = delete;
+
+		// Does nothing while there is no frame to render to, see GetCurrentFrame
+		void BeginFrame();
+		// False when the frame could not be submitted
+		bool EndFrame();
+
+		// See VulkanSwapchain
+		void Resize(uint32_t width, uint32_t height);
+		void SetVSync(bool enabled);
+
+		// Reads the current frame's backbuffer back once the frame is done.
+		// Returns 0 while there is no frame or it can't be read
+		uint64_t RequestReadback();
+		// Blocks until the readback's frame is done, it has to be ended
+		// already. Returns false for unknown requests
+		bool WaitForReadback(uint64_t request);
+
+		// Ends the current frame, hands its backbuffer to read once the GPU
+		// is done with it and begins the next. Returns what read returns,
+		// false when the frame can't be read back
+		bool ReadFrame(const std::function<bool(const VulkanReadbackData&)>& read);
+		// ReadFrame writing the frame to a PPM file
+		bool CaptureFrame(const std::string& filepath);
+
+		inline VulkanContext& GetContext() { return m_Context; }
+		inline VulkanSwapchain& GetSwapchain() { return *m_Swapchain; }
+		inline VulkanRenderGraph& GetRenderGraph() { return *m_RenderGraph; }
+		inline VulkanReadback& GetReadback() { return *m_Readback; }
+		// The frame's swapchain image in the render graph, invalid while
+		// there is no frame
+		inline RenderGraphResource GetBackbuffer() const { return m_Backbuffer; }
+		// Null outside of BeginFrame/EndFrame and for skipped frames
+		inline VulkanFrame* GetCurrentFrame() { return m_Swapchain->GetCurrentFrame(); }
+	private:
+		VulkanContext& m_Context;
+		uint32_t m_FramesInFlight;
+
+		std::unique_ptr<VulkanReadback> m_Readback;
+		std::unique_ptr<VulkanRenderGraph> m_RenderGraph;
+		std::unique_ptr<VulkanSwapchain> m_Swapchain;
+		RenderGraphResource m_Backbuffer;
+		// Requested for the current frame
+		std::vector<uint64_t> m_FrameReadbacks;
+	};
+}
@@ -0,0 +1,88 @@
+#include "ptpch.h"
+#include "VulkanRingBuffer.h"
+
+namespace Photon
+{
+	VulkanRingBuffer::VulkanRingBuffer(VulkanAllocator& allocator, vk::DeviceSize size, vk::BufferUsageFlags usage, uint32_t framesInFlight)
+		: m_Allocator(allocator), m_Size(size), m_FramesInFlight(framesInFlight)
+	{
+		PT_CORE_ASSERT(framesInFlight > 0, "A ring buffer needs at least one frame in flight");
+		PT_CORE_ASSERT(size > 0, "A ring buffer can't be empty");
+
+		m_DefaultAlignment = std::max<vk::DeviceSize>(m_Allocator.GetDeviceProperties().limits.minUniformBufferOffsetAlignment, 1);
+
+		m_Buffer = m_Allocator.CreateBuffer(vk::BufferCreateInfo(vk::BufferCreateFlags(), size, usage), VulkanMemoryUsage::Upload);
+		if (!m_Buffer.Buffer)
+			PT_CORE_ERROR("Failed to create a {0} byte ring buffer", size);
+	}
+
+	VulkanRingBuffer::~VulkanRingBuffer()
+	{
+		m_Allocator.DestroyBuffer(m_Buffer);
+	}
+
+	VulkanRingAllocation VulkanRingBuffer::Allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+	{
+		if (!alignment)
+			alignment = m_DefaultAlignment;
+		if (!m_Buffer.Buffer || size > m_Size)
+			return {};
+
+		// The position in the buffer is what has to be aligned, the size
+		// needn't be a multiple of the alignment. Not masked, so alignments
+		// like a 12 byte vertex stride work too
+		uint64_t position = m_Head % m_Size;
+		uint64_t aligned = (position + alignment - 1) / alignment * alignment;
+		uint64_t offset = m_Head - position + aligned;
+		// A range can't wrap around the end, skip to the start instead
+		if (aligned + size > m_Size)
+			offset = (m_Head / m_Size + 1) * m_Size;
+		if (offset + size - m_Tail > m_Size)
+			return {};
+
+		m_Head = offset + size;
+
+		VulkanRingAllocation allocation;
+		allocation.Buffer = m_Buffer.Buffer;
+		allocation.Offset = offset % m_Size;
+		allocation.Size = size;
+		allocation.Data = (uint8_t*)m_Buffer.Allocation.MappedData + allocation.Offset;
+		return allocation;
+	}
+
+	void VulkanRingBuffer::NextFrame()
+	{
+		if (!m_Allocator.IsCoherent(m_Buffer.Allocation) && m_Head != m_FrameStart)
+		{
+			uint64_t begin = m_FrameStart % m_Size;
+			uint64_t written = m_Head - m_FrameStart;
+			if (written >= m_Size)
+			{
+				m_Allocator.Flush(m_Buffer.Allocation);
+			}
+			else if (begin + written > m_Size)
+			{
+				// Wrapped around, flush both ends
+				m_Allocator.Flush(m_Buffer.Allocation, begin, m_Size - begin);
+				m_Allocator.Flush(m_Buffer.Allocation, 0, begin + written - m_Size);
+			}
+			else
+			{
+				m_Allocator.Flush(m_Buffer.Allocation, begin, written);
+			}
+		}
+
+		m_FrameEnds.push_back(m_Head);
+		m_FrameStart = m_Head;
+		while (m_FrameEnds.size() >= m_FramesInFlight + 1)
+		{
+			m_Tail = m_FrameEnds.front();
+			m_FrameEnds.pop_front();
+		}
+	}
+
+	vk::DeviceSize VulkanRingBuffer::GetUsedBytes() const
+	{
+		return m_Head - m_Tail;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Photon/Core.h"
+#include "Platform/Vulkan/VulkanAllocator.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+
+namespace Photon
+{
+	struct VulkanRingAllocation
+	{
+		vk::Buffer Buffer;
+		vk::DeviceSize Offset = 0;
+		vk::DeviceSize Size = 0;
+		// Persistently mapped, write the data here
+		void* Data = nullptr;
+
+		inline explicit operator bool() const { return Data != nullptr; }
+	};
+
+	// One host visible buffer handed out front to back for data that lives
+	// for a single frame, like uniforms and dynamic vertices. Allocating is a
+	// pointer bump. The space used by a frame is reclaimed framesInFlight
+	// frames later, the caller waits for that frame's fence before it
+	// records the next one anyway.
+	//
+	// Not thread safe, meant to be used by the thread recording the frame.
+	class PHOTON_API VulkanRingBuffer
+	{
+	public:
+		VulkanRingBuffer(VulkanAllocator& allocator, vk::DeviceSize size, vk::BufferUsageFlags usage, uint32_t framesInFlight);
+		~VulkanRingBuffer();
+
+		VulkanRingBuffer(const VulkanRingBuffer&) = delete;
+		VulkanRingBuffer& operator=(const VulkanRingBuffer&) = delete;
+
+		// alignment 0 is minUniformBufferOffsetAlignment. Returns an empty
+		// allocation when the frames in flight have used up the buffer
+		VulkanRingAllocation Allocate(vk::DeviceSize size, vk::DeviceSize alignment = 0);
+
+		// Call once per frame, before submitting it. Flushes what the frame
+		// wrote and reclaims the oldest frame's space
+		void NextFrame();
+
+		inline vk::Buffer GetBuffer() const { return m_Buffer.Buffer; }
+		inline vk::DeviceSize GetSize() const { return m_Size; }
+		// Bytes held by the current frame and the ones in flight
+		vk::DeviceSize GetUsedBytes() const;
+	private:
+		VulkanAllocator& m_Allocator;
+		VulkanBuffer m_Buffer;
+		vk::DeviceSize m_Size;
+		vk::DeviceSize m_DefaultAlignment;
+		uint32_t m_FramesInFlight;
+
+		// Offsets grow without wrapping, the position in the buffer is the
+		// offset modulo its size
+		uint64_t m_Head = 0;
+		uint64_t m_Tail = 0;
+		uint64_t m_FrameStart = 0;
+		// Where every frame in flight ended, oldest first
+		std::deque<uint64_t> m_FrameEnds;
+	};
+}
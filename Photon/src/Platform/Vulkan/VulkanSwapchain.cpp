@@ -0,0 +1,536 @@
+#include "ptpch.h"
+#include "VulkanSwapchain.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+namespace Photon
+{
+	static constexpr vk::Format OffscreenFormat = vk::Format::eR8G8B8A8Unorm;
+
+	static void TransitionImage(vk::CommandBuffer commandBuffer, vk::Image image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+		vk::PipelineStageFlags srcStage, vk::AccessFlags srcAccess, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess)
+	{
+		vk::ImageMemoryBarrier barrier(srcAccess, dstAccess, oldLayout, newLayout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			image, vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
+		commandBuffer.pipelineBarrier(srcStage, dstStage, vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	VulkanSwapchain::VulkanSwapchain(vk::PhysicalDevice physicalDevice, vk::Device device, VulkanAllocator& allocator, vk::SurfaceKHR surface,
+		uint32_t graphicsFamily, vk::Queue graphicsQueue, vk::Queue presentQueue, std::mutex& queueMutex, uint32_t width, uint32_t height, bool vsync, uint32_t framesInFlight)
+		: m_PhysicalDevice(physicalDevice), m_Device(device), m_Allocator(allocator), m_Surface(surface),
+		m_GraphicsQueue(graphicsQueue), m_PresentQueue(presentQueue), m_QueueMutex(queueMutex), m_Width(width), m_Height(height), m_VSync(vsync),
+		m_FenceWaitMetric(Metrics::GetHistogram("vulkan.frame.fence_wait_ns"))
+	{
+		PT_PROFILE_FUNCTION();
+
+		PT_CORE_ASSERT(framesInFlight > 0, "A swapchain needs at least one frame in flight");
+
+		m_Frames.resize(framesInFlight);
+		for (VulkanFrame& frame : m_Frames)
+		{
+			// The pool is reset as a whole every frame
+			frame.CommandPool = m_Device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient, graphicsFamily));
+			frame.CommandBuffer = m_Device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(frame.CommandPool, vk::CommandBufferLevel::ePrimary, 1))[0];
+			// Signaled, the first wait on a slot returns right away
+			frame.Fence = m_Device.createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled));
+			frame.ImageAcquired = m_Device.createSemaphore(vk::SemaphoreCreateInfo());
+		}
+
+		Create(nullptr);
+	}
+
+	VulkanSwapchain::~VulkanSwapchain()
+	{
+		PT_PROFILE_FUNCTION();
+
+		// An acquired image has to go back through present
+		EndFrame();
+		{
+			std::lock_guard<std::mutex> lock(m_QueueMutex);
+			m_Device.waitIdle();
+		}
+
+		RunDeferred(UINT64_MAX);
+		Destroy();
+		for (VulkanFrame& frame : m_Frames)
+		{
+			m_Device.destroySemaphore(frame.ImageAcquired);
+			m_Device.destroyFence(frame.Fence);
+			m_Device.destroyCommandPool(frame.CommandPool);
+		}
+	}
+
+	vk::PresentModeKHR VulkanSwapchain::ChoosePresentMode() const
+	{
+		// FIFO is the only mode every surface has
+		if (m_VSync || !m_Surface)
+			return vk::PresentModeKHR::eFifo;
+
+		std::vector<vk::PresentModeKHR> modes = m_PhysicalDevice.getSurfacePresentModesKHR(m_Surface);
+		// MAILBOX doesn't tear, it replaces the queued image instead of waiting
+		for (vk::PresentModeKHR preferred : { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate })
+		{
+			if (std::find(modes.begin(), modes.end(), preferred) != modes.end())
+				return preferred;
+		}
+		return vk::PresentModeKHR::eFifo;
+	}
+
+	vk::Extent2D VulkanSwapchain::ChooseExtent(const vk::SurfaceCapabilitiesKHR& capabilities) const
+	{
+		// The surface dictates the extent unless it reports the special value
+		if (capabilities.currentExtent.width != UINT32_MAX)
+			return capabilities.currentExtent;
+
+		return vk::Extent2D(
+			std::clamp(m_Width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width),
+			std::clamp(m_Height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height));
+	}
+
+	void VulkanSwapchain::Create(vk::SwapchainKHR oldSwapchain)
+	{
+		PT_PROFILE_FUNCTION();
+
+		m_OutOfDate = false;
+		m_RebuildRequested = false;
+		m_PresentMode = ChoosePresentMode();
+
+		if (!m_Surface)
+		{
+			// One image per frame slot, the slot's fence guards its image
+			m_Format = OffscreenFormat;
+			m_ImageUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst
+				| vk::ImageUsageFlagBits::eSampled;
+			m_Extent = vk::Extent2D(m_Width, m_Height);
+			if (m_Extent.width == 0 || m_Extent.height == 0)
+			{
+				m_OutOfDate = true;
+				return;
+			}
+			for (size_t i = 0; i < m_Frames.size(); i++)
+			{
+				vk::ImageCreateInfo imageInfo(vk::ImageCreateFlags(), vk::ImageType::e2D, m_Format, vk::Extent3D(m_Extent.width, m_Extent.height, 1), 1, 1,
+					vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, m_ImageUsage);
+				VulkanImage image = m_Allocator.CreateImage(imageInfo, VulkanMemoryUsage::GpuOnly);
+				if (!image.Image)
+				{
+					// Tried again on the next BeginFrame, like a failed swapchain
+					PT_CORE_ERROR("Could not create the {0}x{1} offscreen images", m_Extent.width, m_Extent.height);
+					for (VulkanImage& created : m_OffscreenImages)
+						m_Allocator.DestroyImage(created);
+					m_OffscreenImages.clear();
+					m_Images.clear();
+					m_OutOfDate = true;
+					return;
+				}
+
+				m_OffscreenImages.push_back(image);
+				m_Images.push_back(image.Image);
+			}
+		}
+		else
+		{
+			vk::SurfaceCapabilitiesKHR capabilities = m_PhysicalDevice.getSurfaceCapabilitiesKHR(m_Surface);
+
+			m_Extent = ChooseExtent(capabilities);
+
+			// Minimized, there is nothing to present to until the size changes
+			if (m_Extent.width == 0 || m_Extent.height == 0)
+			{
+				m_OutOfDate = true;
+				return;
+			}
+
+			std::vector<vk::SurfaceFormatKHR> formats = m_PhysicalDevice.getSurfaceFormatsKHR(m_Surface);
+			vk::SurfaceFormatKHR surfaceFormat = formats[0];
+			for (const vk::SurfaceFormatKHR& format : formats)
+			{
+				if ((format.format == vk::Format::eB8G8R8A8Unorm || format.format == vk::Format::eR8G8B8A8Unorm)
+					&& format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear)
+				{
+					surfaceFormat = format;
+					break;
+				}
+			}
+			m_Format = surfaceFormat.format;
+
+			// One image more than the minimum so acquire doesn't wait for the
+			// compositor, and a third to make MAILBOX worth it
+			uint32_t imageCount = std::max(capabilities.minImageCount + 1, m_PresentMode == vk::PresentModeKHR::eMailbox ? 3u : 2u);
+			if (capabilities.maxImageCount)
+				imageCount = std::min(imageCount, capabilities.maxImageCount);
+
+			// Transfer source lets frames be read back, most surfaces have it
+			m_ImageUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst;
+			m_ImageUsage |= capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferSrc;
+
+			vk::SwapchainCreateInfoKHR createInfo(vk::SwapchainCreateFlagsKHR(), m_Surface, imageCount, m_Format, surfaceFormat.colorSpace,
+				m_Extent, 1, m_ImageUsage,
+				vk::SharingMode::eExclusive, 0, nullptr, capabilities.currentTransform, vk::CompositeAlphaFlagBitsKHR::eOpaque,
+				m_PresentMode, true, oldSwapchain);
+
+			try
+			{
+				m_Swapchain = m_Device.createSwapchainKHR(createInfo);
+			}
+			catch (vk::SystemError& e)
+			{
+				PT_CORE_ERROR("Could not create the swapchain ({0})", e.what());
+				m_OutOfDate = true;
+				return;
+			}
+
+			m_Images = m_Device.getSwapchainImagesKHR(m_Swapchain);
+		}
+
+		for (vk::Image image : m_Images)
+		{
+			vk::ImageViewCreateInfo viewInfo(vk::ImageViewCreateFlags(), image, vk::ImageViewType::e2D, m_Format, vk::ComponentMapping(),
+				vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
+			m_ImageViews.push_back(m_Device.createImageView(viewInfo));
+			if (m_Surface)
+				m_RenderFinished.push_back(m_Device.createSemaphore(vk::SemaphoreCreateInfo()));
+		}
+
+		PT_CORE_INFO("Created a {0}x{1} {2} with {3} images, {4} frames in flight, {5}", m_Extent.width, m_Extent.height,
+			m_Surface ? "swapchain" : "offscreen swapchain", m_Images.size(), m_Frames.size(), vk::to_string(m_PresentMode));
+	}
+
+	void VulkanSwapchain::Destroy()
+	{
+		if (m_ViewsReleased && !m_ImageViews.empty())
+			m_ViewsReleased(m_ImageViews);
+		for (vk::ImageView view : m_ImageViews)
+			m_Device.destroyImageView(view);
+		for (vk::Semaphore semaphore : m_RenderFinished)
+			m_Device.destroySemaphore(semaphore);
+		for (VulkanImage& image : m_OffscreenImages)
+			m_Allocator.DestroyImage(image);
+		if (m_Swapchain)
+			m_Device.destroySwapchainKHR(m_Swapchain);
+
+		m_ImageViews.clear();
+		m_RenderFinished.clear();
+		m_OffscreenImages.clear();
+		m_Images.clear();
+		m_Swapchain = nullptr;
+	}
+
+	void VulkanSwapchain::Recreate()
+	{
+		PT_PROFILE_FUNCTION();
+
+		// Frames in flight may still render to the old images and present
+		// them, everything made for them goes once those frames are done.
+		// The old swapchain is retired by creating the new one, so no image
+		// can be acquired from it anymore
+		// Minimized, the old swapchain stays until there is a size for a new
+		// one, a surface can't have two that aren't retired
+		vk::Extent2D extent = m_Surface ? ChooseExtent(m_PhysicalDevice.getSurfaceCapabilitiesKHR(m_Surface)) : vk::Extent2D(m_Width, m_Height);
+		if (extent.width == 0 || extent.height == 0)
+		{
+			m_OutOfDate = true;
+			return;
+		}
+
+		vk::SwapchainKHR oldSwapchain = m_Swapchain;
+		if (!m_Images.empty())
+		{
+			DeferDestroy([device = m_Device, &allocator = m_Allocator, swapchain = oldSwapchain, views = std::move(m_ImageViews),
+				semaphores = std::move(m_RenderFinished), images = std::move(m_OffscreenImages), released = m_ViewsReleased]() mutable
+			{
+				if (released)
+					released(views);
+				for (vk::ImageView view : views)
+					device.destroyImageView(view);
+				for (vk::Semaphore semaphore : semaphores)
+					device.destroySemaphore(semaphore);
+				for (VulkanImage& image : images)
+					allocator.DestroyImage(image);
+				if (swapchain)
+					device.destroySwapchainKHR(swapchain);
+			});
+		}
+
+		m_ImageViews.clear();
+		m_RenderFinished.clear();
+		m_OffscreenImages.clear();
+		m_Images.clear();
+		m_Swapchain = nullptr;
+
+		Create(oldSwapchain);
+		if (!m_Images.empty())
+			m_Recreations++;
+	}
+
+	void VulkanSwapchain::DeferDestroy(std::function<void()> destroy)
+	{
+		m_Deferred.emplace_back(m_FrameNumber, std::move(destroy));
+	}
+
+	void VulkanSwapchain::RunDeferred(uint64_t completedFrames)
+	{
+		while (!m_Deferred.empty() && m_Deferred.front().first <= completedFrames)
+		{
+			m_Deferred.front().second();
+			m_Deferred.pop_front();
+		}
+	}
+
+	VulkanFrame* VulkanSwapchain::BeginFrame()
+	{
+		PT_PROFILE_FUNCTION();
+
+		PT_CORE_ASSERT(!m_FrameActive, "BeginFrame called twice without EndFrame");
+
+		if (m_OutOfDate || (m_RebuildRequested && std::chrono::steady_clock::now() - m_RebuildRequestTime >= ResizeSettleTime))
+			Recreate();
+		if (m_OutOfDate || m_Images.empty())
+		{
+			m_FramesSkipped++;
+			return nullptr;
+		}
+
+		VulkanFrame& frame = m_Frames[m_FrameIndex];
+		{
+			PT_PROFILE_SCOPE("Wait for frame fence");
+			HistogramTimer timer(m_FenceWaitMetric);
+			(void)m_Device.waitForFences(1, &frame.Fence, true, UINT64_MAX);
+		}
+
+		// Frames finish in submission order, the one that last used this
+		// slot was submitted framesInFlight frames ago
+		uint64_t framesInFlight = m_Frames.size();
+		if (m_FrameNumber >= framesInFlight)
+			RunDeferred(m_FrameNumber - framesInFlight + 1);
+
+		uint32_t imageIndex = m_FrameIndex;
+		if (m_Surface)
+		{
+			vk::Result result = m_Device.acquireNextImageKHR(m_Swapchain, UINT64_MAX, frame.ImageAcquired, nullptr, &imageIndex);
+			if (result == vk::Result::eErrorOutOfDateKHR)
+			{
+				// Rebuild and try once more rather than drop the frame, some
+				// drivers report every step of a window drag this way
+				m_OutOfDate = true;
+				Recreate();
+				if (!m_OutOfDate)
+					result = m_Device.acquireNextImageKHR(m_Swapchain, UINT64_MAX, frame.ImageAcquired, nullptr, &imageIndex);
+			}
+			if (result == vk::Result::eSuboptimalKHR)
+			{
+				// Still presentable, rebuild when the size has settled
+				if (!m_RebuildRequested)
+				{
+					m_RebuildRequested = true;
+					m_RebuildRequestTime = std::chrono::steady_clock::now();
+				}
+			}
+			else if (result != vk::Result::eSuccess)
+			{
+				if (result != vk::Result::eErrorOutOfDateKHR)
+					PT_CORE_ERROR("Could not acquire a swapchain image ({0})", vk::to_string(result));
+				m_OutOfDate = true;
+				m_FramesSkipped++;
+				return nullptr;
+			}
+		}
+
+		// Only reset once the frame is certain to be submitted, a fence that
+		// is never signaled again would hang the next wait on it
+		(void)m_Device.resetFences(1, &frame.Fence);
+		m_Device.resetCommandPool(frame.CommandPool);
+
+		frame.Number = m_FrameNumber++;
+		frame.ImageIndex = imageIndex;
+		frame.Image = m_Images[imageIndex];
+		frame.ImageView = m_ImageViews[imageIndex];
+
+		vk::CommandBuffer commandBuffer = frame.CommandBuffer;
+		commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+		// The old contents are discarded. The source stage matches the stage
+		// the acquire semaphore is waited on in, so the clear waits for it
+		TransitionImage(commandBuffer, frame.Image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+			vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::AccessFlags(),
+			vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite);
+		vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+		commandBuffer.clearColorImage(frame.Image, vk::ImageLayout::eTransferDstOptimal, &m_ClearColor, 1, &range);
+		TransitionImage(commandBuffer, frame.Image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eColorAttachmentOptimal,
+			vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite,
+			vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite);
+
+		m_FrameActive = true;
+		return &frame;
+	}
+
+	bool VulkanSwapchain::EndFrame()
+	{
+		PT_PROFILE_FUNCTION();
+
+		if (!m_FrameActive)
+			return true;
+
+		VulkanFrame& frame = m_Frames[m_FrameIndex];
+		vk::CommandBuffer commandBuffer = frame.CommandBuffer;
+
+		// Offscreen images are left ready to be copied out
+		vk::ImageLayout finalLayout = m_Surface ? vk::ImageLayout::ePresentSrcKHR : vk::ImageLayout::eTransferSrcOptimal;
+		TransitionImage(commandBuffer, frame.Image, vk::ImageLayout::eColorAttachmentOptimal, finalLayout,
+			vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::AccessFlagBits::eColorAttachmentWrite,
+			m_Surface ? vk::PipelineStageFlagBits::eBottomOfPipe : vk::PipelineStageFlagBits::eTransfer,
+			m_Surface ? vk::AccessFlags() : vk::AccessFlagBits::eTransferRead);
+		commandBuffer.end();
+
+		if (m_Surface)
+		{
+			// Binary, the value is ignored
+			m_WaitSemaphores.push_back(frame.ImageAcquired);
+			m_WaitValues.push_back(0);
+			m_WaitStages.push_back(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+		}
+
+		vk::SubmitInfo submitInfo((uint32_t)m_WaitSemaphores.size(), m_WaitSemaphores.data(), m_WaitStages.data(), 1, &commandBuffer);
+		if (m_Surface)
+			submitInfo.setSignalSemaphoreCount(1).setPSignalSemaphores(&m_RenderFinished[frame.ImageIndex]);
+
+		// Only needed when AddWait added a timeline semaphore
+		vk::TimelineSemaphoreSubmitInfo timelineInfo((uint32_t)m_WaitValues.size(), m_WaitValues.data());
+		if (m_WaitSemaphores.size() > (m_Surface ? 1u : 0u))
+			submitInfo.setPNext(&timelineInfo);
+
+		vk::Result result;
+		{
+			PT_PROFILE_SCOPE("vk::Queue::submit");
+			std::lock_guard<std::mutex> lock(m_QueueMutex);
+			result = m_GraphicsQueue.submit(1, &submitInfo, frame.Fence);
+		}
+		if (result != vk::Result::eSuccess)
+		{
+			PT_CORE_ERROR("Could not submit frame {0} ({1})", frame.Number, vk::to_string(result));
+			AbandonFrame(frame);
+			return false;
+		}
+
+		if (m_Surface)
+		{
+			PT_PROFILE_SCOPE("vk::Queue::presentKHR");
+			vk::PresentInfoKHR presentInfo(1, &m_RenderFinished[frame.ImageIndex], 1, &m_Swapchain, &frame.ImageIndex);
+			vk::Result result;
+			{
+				std::lock_guard<std::mutex> lock(m_QueueMutex);
+				result = m_PresentQueue.presentKHR(&presentInfo);
+			}
+			if (result == vk::Result::eErrorOutOfDateKHR)
+			{
+				m_OutOfDate = true;
+			}
+			else if (result == vk::Result::eSuboptimalKHR && !m_RebuildRequested)
+			{
+				m_RebuildRequested = true;
+				m_RebuildRequestTime = std::chrono::steady_clock::now();
+			}
+			else if (result != vk::Result::eSuccess)
+				PT_CORE_ERROR("Could not present frame {0} ({1})", frame.Number, vk::to_string(result));
+		}
+
+		m_WaitSemaphores.clear();
+		m_WaitValues.clear();
+		m_WaitStages.clear();
+
+		m_FramesPresented++;
+		m_FrameIndex = (m_FrameIndex + 1) % (uint32_t)m_Frames.size();
+		m_FrameActive = false;
+		return true;
+	}
+
+	void VulkanSwapchain::AbandonFrame(VulkanFrame& frame)
+	{
+		// The reset fence would never be signaled, a new one starts
+		// signaled so the next wait on the slot returns
+		m_Device.destroyFence(frame.Fence);
+		frame.Fence = m_Device.createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled));
+
+		if (m_Surface)
+		{
+			// The acquired image can't go back without a present and its
+			// semaphore still gets signaled, both are replaced
+			DeferDestroy([device = m_Device, semaphore = frame.ImageAcquired]() { device.destroySemaphore(semaphore); });
+			frame.ImageAcquired = m_Device.createSemaphore(vk::SemaphoreCreateInfo());
+			m_OutOfDate = true;
+		}
+
+		m_WaitSemaphores.clear();
+		m_WaitValues.clear();
+		m_WaitStages.clear();
+
+		// The slot and frame number are used again by the next frame
+		m_FrameNumber--;
+		m_FramesSkipped++;
+		m_FrameActive = false;
+	}
+
+	void VulkanSwapchain::AddWait(vk::Semaphore semaphore, uint64_t value, vk::PipelineStageFlags stage)
+	{
+		PT_CORE_ASSERT(m_FrameActive, "AddWait called outside of BeginFrame/EndFrame");
+
+		m_WaitSemaphores.push_back(semaphore);
+		m_WaitValues.push_back(value);
+		m_WaitStages.push_back(stage);
+	}
+
+	void VulkanSwapchain::WaitForFrame(uint64_t number)
+	{
+		PT_CORE_ASSERT(number + (m_FrameActive ? 1 : 0) < m_FrameNumber, "Frame {0} hasn't been submitted", number);
+
+		// Once its slot was reused the frame's fence has been waited for
+		VulkanFrame& frame = m_Frames[number % m_Frames.size()];
+		if (frame.Number != number)
+			return;
+
+		PT_PROFILE_FUNCTION();
+		HistogramTimer timer(m_FenceWaitMetric);
+		(void)m_Device.waitForFences(1, &frame.Fence, true, UINT64_MAX);
+	}
+
+	void VulkanSwapchain::SetVSync(bool enabled)
+	{
+		if (enabled == m_VSync)
+			return;
+
+		m_VSync = enabled;
+		// Only a new swapchain can change the present mode
+		if (m_Surface)
+			m_OutOfDate = true;
+	}
+
+	void VulkanSwapchain::Resize(uint32_t width, uint32_t height)
+	{
+		if (width == m_Width && height == m_Height)
+			return;
+
+		m_Width = width;
+		m_Height = height;
+
+		// Offscreen images are never scaled to the new size by a compositor
+		if (!m_Surface)
+		{
+			m_OutOfDate = true;
+			return;
+		}
+
+		// Every resize of a burst pushes the rebuild back
+		m_RebuildRequested = true;
+		m_RebuildRequestTime = std::chrono::steady_clock::now();
+	}
+
+	VulkanSwapchainStats VulkanSwapchain::GetStats() const
+	{
+		VulkanSwapchainStats stats;
+		stats.FramesPresented = m_FramesPresented;
+		stats.FramesSkipped = m_FramesSkipped;
+		stats.Recreations = m_Recreations;
+		stats.FenceWaits = m_FenceWaitMetric.Snapshot();
+		return stats;
+	}
+}
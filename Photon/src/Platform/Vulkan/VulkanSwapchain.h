@@ -0,0 +1,185 @@
+#pragma once
+
+#include "Photon/Core.h"
+#include "Photon/Metrics/Metrics.h"
+#include "Platform/Vulkan/VulkanAllocator.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Photon
+{
+	// The resources of one frame in flight. Valid between BeginFrame and
+	// EndFrame, record into CommandBuffer, the image is in
+	// eColorAttachmentOptimal layout and cleared to the clear color
+	struct VulkanFrame
+	{
+		vk::CommandPool CommandPool;
+		vk::CommandBuffer CommandBuffer;
+		// Signaled when the GPU is done with the frame
+		vk::Fence Fence;
+		vk::Semaphore ImageAcquired;
+
+		uint64_t Number = 0;
+		uint32_t ImageIndex = 0;
+		vk::Image Image;
+		vk::ImageView ImageView;
+	};
+
+	struct VulkanSwapchainStats
+	{
+		uint64_t FramesPresented = 0;
+		// Frames BeginFrame returned null for, e.g. while minimized
+		uint64_t FramesSkipped = 0;
+		uint32_t Recreations = 0;
+		// CPU time spent waiting on the oldest frame's fence, from the
+		// "vulkan.frame.fence_wait_ns" metric. Mostly zero as long as the GPU
+		// keeps up
+		HistogramSnapshot FenceWaits;
+	};
+
+	// Presents frames through a VK_KHR_swapchain, or into images of its own
+	// when created without a surface so the same frame loop runs headless.
+	//
+	// Up to framesInFlight frames are recorded and submitted before the CPU
+	// waits for the GPU. The only CPU wait is on the fence of the frame that
+	// is about to be reused, images are acquired and handed to present
+	// through semaphores.
+	//
+	// VSync picks FIFO, otherwise MAILBOX when the surface has it and
+	// IMMEDIATE after that.
+	//
+	// A new swapchain is made from the old one through oldSwapchain at the
+	// start of a frame, the old one and its image views are destroyed once
+	// the frames rendered to them have finished, without waiting for the
+	// device to go idle. Resizes wait until the size has settled for
+	// ResizeSettleTime while the old swapchain can still be presented, so
+	// dragging a window edge rebuilds once rather than every frame.
+	class PHOTON_API VulkanSwapchain
+	{
+	public:
+		// surface may be null for offscreen rendering, presentQueue is ignored
+		// then. queueMutex is held around submit, present and waiting for idle
+		VulkanSwapchain(vk::PhysicalDevice physicalDevice, vk::Device device, VulkanAllocator& allocator, vk::SurfaceKHR surface,
+			uint32_t graphicsFamily, vk::Queue graphicsQueue, vk::Queue presentQueue, std::mutex& queueMutex,
+			uint32_t width, uint32_t height, bool vsync, uint32_t framesInFlight = 2);
+		~VulkanSwapchain();
+
+		VulkanSwapchain(const VulkanSwapchain&) = delete;
+		VulkanSwapchain& operator=(const VulkanSwapchain&) = delete;
+
+		// Waits for the frame slot to be free and acquires an image. Returns
+		// null when there is nothing to render to this frame
+		VulkanFrame* BeginFrame();
+		// Submits the frame's command buffer and queues the image for present.
+		// False when the submit failed, the frame is then dropped
+		bool EndFrame();
+
+		// Takes effect on the next BeginFrame
+		void SetVSync(bool enabled);
+		// Takes effect once no other resize came for ResizeSettleTime, or
+		// right away when the swapchain can't be presented anymore
+		void Resize(uint32_t width, uint32_t height);
+
+		// Makes the current frame's submit wait until a timeline semaphore
+		// reaches value before stage, e.g. for uploads on another queue
+		void AddWait(vk::Semaphore semaphore, uint64_t value, vk::PipelineStageFlags stage);
+
+		// Blocks until the GPU is done with frame number, which has to be
+		// submitted already
+		void WaitForFrame(uint64_t number);
+
+		// Calls destroy once the GPU is done with every frame begun so far,
+		// for resources that depend on the images, like framebuffers
+		void DeferDestroy(std::function<void()> destroy);
+
+		// Called with the image views right before they are destroyed, once
+		// the GPU is done with them, so framebuffers made for them can go
+		inline void SetImageViewsReleasedCallback(std::function<void(const std::vector<vk::ImageView>&)> callback) { m_ViewsReleased = std::move(callback); }
+
+		inline bool IsOffscreen() const { return !m_Surface; }
+		inline vk::Format GetFormat() const { return m_Format; }
+		inline vk::Extent2D GetExtent() const { return m_Extent; }
+		// Frames can be read back when it has eTransferSrc
+		inline vk::ImageUsageFlags GetImageUsage() const { return m_ImageUsage; }
+		inline vk::PresentModeKHR GetPresentMode() const { return m_PresentMode; }
+		inline uint32_t GetImageCount() const { return (uint32_t)m_Images.size(); }
+		inline uint32_t GetFramesInFlight() const { return (uint32_t)m_Frames.size(); }
+		// Null outside of BeginFrame/EndFrame
+		inline VulkanFrame* GetCurrentFrame() { return m_FrameActive ? &m_Frames[m_FrameIndex] : nullptr; }
+
+		inline void SetClearColor(const vk::ClearColorValue& color) { m_ClearColor = color; }
+
+		VulkanSwapchainStats GetStats() const;
+	private:
+		vk::PresentModeKHR ChoosePresentMode() const;
+		vk::Extent2D ChooseExtent(const vk::SurfaceCapabilitiesKHR& capabilities) const;
+		void Create(vk::SwapchainKHR oldSwapchain);
+		void Destroy();
+		void Recreate();
+		void RunDeferred(uint64_t completedFrames);
+		// Undoes BeginFrame after a failed submit
+		void AbandonFrame(VulkanFrame& frame);
+	private:
+		static constexpr std::chrono::milliseconds ResizeSettleTime{ 50 };
+
+		vk::PhysicalDevice m_PhysicalDevice;
+		vk::Device m_Device;
+		VulkanAllocator& m_Allocator;
+		vk::SurfaceKHR m_Surface;
+		vk::Queue m_GraphicsQueue;
+		vk::Queue m_PresentQueue;
+		std::mutex& m_QueueMutex;
+
+		uint32_t m_Width, m_Height;
+		bool m_VSync;
+		// Set when the swapchain has to be rebuilt before the next frame
+		bool m_OutOfDate = false;
+		// Set when it should be rebuilt once the size has settled
+		bool m_RebuildRequested = false;
+		std::chrono::steady_clock::time_point m_RebuildRequestTime;
+
+		vk::SwapchainKHR m_Swapchain;
+		vk::Format m_Format = vk::Format::eUndefined;
+		vk::ImageUsageFlags m_ImageUsage;
+		vk::Extent2D m_Extent;
+		vk::PresentModeKHR m_PresentMode = vk::PresentModeKHR::eFifo;
+
+		std::vector<vk::Image> m_Images;
+		std::vector<vk::ImageView> m_ImageViews;
+		// Signaled by the frame that renders to the image, waited on by its
+		// present. Per image, a frame slot can come around again before the
+		// present of its last image has finished
+		std::vector<vk::Semaphore> m_RenderFinished;
+		// The images when offscreen
+		std::vector<VulkanImage> m_OffscreenImages;
+
+		std::vector<VulkanFrame> m_Frames;
+		uint32_t m_FrameIndex = 0;
+		uint64_t m_FrameNumber = 0;
+		bool m_FrameActive = false;
+
+		// Waits of the current frame's submit besides the acquired image
+		std::vector<vk::Semaphore> m_WaitSemaphores;
+		std::vector<uint64_t> m_WaitValues;
+		std::vector<vk::PipelineStageFlags> m_WaitStages;
+
+		// Destroy functions and the number of frames that have to finish first
+		std::deque<std::pair<uint64_t, std::function<void()>>> m_Deferred;
+		std::function<void(const std::vector<vk::ImageView>&)> m_ViewsReleased;
+
+		vk::ClearColorValue m_ClearColor = std::array<float, 4>{ 0.1f, 0.1f, 0.1f, 1.0f };
+
+		uint64_t m_FramesPresented = 0;
+		uint64_t m_FramesSkipped = 0;
+		uint32_t m_Recreations = 0;
+
+		Histogram& m_FenceWaitMetric;
+	};
+}
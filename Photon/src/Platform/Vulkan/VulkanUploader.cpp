@@ -0,0 +1,371 @@
+#include "ptpch.h"
+#include "VulkanUploader.h"
+
+#include "Photon/Debug/Instrumentor.h"
+
+#include <numeric>
+
+namespace Photon
+{
+	// Covers optimalBufferCopyOffsetAlignment in practice and the texel size
+	// of every format with 1, 2, 4, 8 or 16 byte texels or blocks. Images
+	// with other texel sizes, like 12 byte R32G32B32, align to a multiple
+	static constexpr vk::DeviceSize StagingAlignment = 16;
+
+	static constexpr vk::AccessFlags ConsumerAccess = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead
+		| vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead;
+
+	VulkanUploader::VulkanUploader(vk::Device device, VulkanAllocator& allocator, uint32_t transferFamily, vk::Queue transferQueue,
+		uint32_t graphicsFamily, std::mutex* queueMutex, vk::DeviceSize stagingSize)
+		: m_Device(device), m_Allocator(allocator), m_TransferFamily(transferFamily), m_GraphicsFamily(graphicsFamily),
+		m_TransferQueue(transferQueue), m_QueueMutex(queueMutex), m_StagingSize((stagingSize + StagingAlignment - 1) / StagingAlignment * StagingAlignment),
+		m_BytesMetric(Metrics::GetCounter("vulkan.upload.bytes")),
+		m_StallMetric(Metrics::GetHistogram("vulkan.upload.stall_ns"))
+	{
+		PT_PROFILE_FUNCTION();
+
+		// Rounded up to the alignment, so the start of every lap is aligned
+		PT_CORE_ASSERT(stagingSize > 0, "The staging buffer can't be empty");
+		m_Staging = m_Allocator.CreateBuffer(vk::BufferCreateInfo(vk::BufferCreateFlags(), m_StagingSize, vk::BufferUsageFlagBits::eTransferSrc),
+			VulkanMemoryUsage::Upload);
+		if (!m_Staging.Buffer)
+			PT_CORE_ERROR("Could not create a {0} byte staging buffer, uploads are not available", m_StagingSize);
+
+		// Command buffers are reused one by one as their batches finish
+		m_CommandPool = m_Device.createCommandPool(vk::CommandPoolCreateInfo(
+			vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer, transferFamily));
+
+		vk::SemaphoreTypeCreateInfo typeInfo(vk::SemaphoreType::eTimeline, 0);
+		m_Semaphore = m_Device.createSemaphore(vk::SemaphoreCreateInfo(vk::SemaphoreCreateFlags(), &typeInfo));
+	}
+
+	VulkanUploader::~VulkanUploader()
+	{
+		PT_PROFILE_FUNCTION();
+
+		// Only waits for the transfer queue, graphics may still be running
+		Submit();
+		uint64_t last = m_NextValue - 1;
+		(void)m_Device.waitSemaphores(vk::SemaphoreWaitInfo(vk::SemaphoreWaitFlags(), 1, &m_Semaphore, &last), UINT64_MAX);
+
+		m_Device.destroySemaphore(m_Semaphore);
+		m_Device.destroyCommandPool(m_CommandPool);
+		m_Allocator.DestroyBuffer(m_Staging);
+	}
+
+	uint64_t VulkanUploader::UploadBuffer(vk::Buffer buffer, vk::DeviceSize offset, const void* data, vk::DeviceSize size)
+	{
+		PT_PROFILE_FUNCTION();
+
+		if (!IsValid())
+			return 0;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// Chunks of a quarter ring keep the other batches going meanwhile
+		vk::DeviceSize maxChunk = m_StagingSize / 4;
+		uint64_t value = 0;
+		for (vk::DeviceSize done = 0; done < size;)
+		{
+			vk::DeviceSize chunk = std::min(size - done, maxChunk);
+			uint64_t staging = AllocateStaging(chunk, StagingAlignment);
+			Write(staging, (const uint8_t*)data + done, chunk);
+
+			vk::CommandBuffer commandBuffer = GetCommandBuffer();
+			vk::BufferCopy region(staging % m_StagingSize, offset + done, chunk);
+			commandBuffer.copyBuffer(m_Staging.Buffer, buffer, 1, &region);
+
+			// Within a family the semaphore makes the writes visible, another
+			// family has to take the buffer over first
+			if (!IsSameFamily())
+			{
+				vk::BufferMemoryBarrier release(vk::AccessFlagBits::eTransferWrite, vk::AccessFlags(), m_TransferFamily, m_GraphicsFamily,
+					buffer, offset + done, chunk);
+				commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+					vk::DependencyFlags(), 0, nullptr, 1, &release, 0, nullptr);
+
+				vk::BufferMemoryBarrier acquire = release;
+				acquire.setSrcAccessMask(vk::AccessFlags()).setDstAccessMask(ConsumerAccess);
+				m_BatchHandover.Buffers.push_back(acquire);
+			}
+
+			value = m_Batch.Value;
+			m_Batch.Bytes += chunk;
+			m_BytesUploaded += chunk;
+			m_BytesMetric.Add(chunk);
+			done += chunk;
+
+			if (m_Batch.Bytes >= m_StagingSize / 4 && !SubmitBatch())
+				return 0;
+		}
+		return value;
+	}
+
+	uint64_t VulkanUploader::UploadImage(vk::Image image, vk::Extent3D extent, const void* data, vk::DeviceSize size,
+		vk::ImageLayout layout, vk::ImageAspectFlags aspect)
+	{
+		PT_PROFILE_FUNCTION();
+
+		if (!IsValid())
+			return 0;
+
+		if (size > m_StagingSize)
+		{
+			PT_CORE_ERROR("A {0} byte image doesn't fit into the {1} byte staging buffer", size, m_StagingSize);
+			return 0;
+		}
+
+		// The copy's buffer offset has to be a multiple of the texel size.
+		// Tightly packed, that is size over the texel count, block
+		// compressed formats don't divide evenly and fit StagingAlignment
+		vk::DeviceSize texels = (vk::DeviceSize)extent.width * extent.height * extent.depth;
+		vk::DeviceSize alignment = StagingAlignment;
+		if (texels && size % texels == 0)
+			alignment = std::lcm(StagingAlignment, size / texels);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		uint64_t staging = AllocateStaging(size, alignment);
+		Write(staging, data, size);
+
+		vk::CommandBuffer commandBuffer = GetCommandBuffer();
+		vk::ImageSubresourceRange range(aspect, 0, 1, 0, 1);
+
+		// The old contents are discarded
+		vk::ImageMemoryBarrier toTransfer(vk::AccessFlags(), vk::AccessFlagBits::eTransferWrite,
+			vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, range);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+			vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+		vk::BufferImageCopy region(staging % m_StagingSize, 0, 0, vk::ImageSubresourceLayers(aspect, 0, 0, 1), vk::Offset3D(), extent);
+		commandBuffer.copyBufferToImage(m_Staging.Buffer, image, vk::ImageLayout::eTransferDstOptimal, 1, &region);
+
+		// The transition to layout happens here, and on another family
+		// again as part of the takeover with the same layouts
+		bool sameFamily = IsSameFamily();
+		vk::ImageMemoryBarrier release(vk::AccessFlagBits::eTransferWrite, vk::AccessFlags(), vk::ImageLayout::eTransferDstOptimal, layout,
+			sameFamily ? VK_QUEUE_FAMILY_IGNORED : m_TransferFamily, sameFamily ? VK_QUEUE_FAMILY_IGNORED : m_GraphicsFamily, image, range);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+			vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &release);
+		if (!sameFamily)
+		{
+			vk::ImageMemoryBarrier acquire = release;
+			acquire.setSrcAccessMask(vk::AccessFlags()).setDstAccessMask(ConsumerAccess);
+			m_BatchHandover.Images.push_back(acquire);
+		}
+
+		uint64_t value = m_Batch.Value;
+		m_Batch.Bytes += size;
+		m_BytesUploaded += size;
+		m_BytesMetric.Add(size);
+
+		if (m_Batch.Bytes >= m_StagingSize / 4 && !SubmitBatch())
+			return 0;
+		return value;
+	}
+
+	bool VulkanUploader::Submit()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return SubmitBatch();
+	}
+
+	uint64_t VulkanUploader::Acquire(vk::CommandBuffer commandBuffer, uint64_t value)
+	{
+		PT_PROFILE_FUNCTION();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		SubmitBatch();
+
+		uint64_t completed = m_Device.getSemaphoreCounterValue(m_Semaphore);
+		Retire(completed);
+
+		uint64_t target = std::min(std::max(completed, value), m_NextValue - 1);
+		if (target <= m_AcquiredValue)
+			return 0;
+
+		std::vector<vk::BufferMemoryBarrier> buffers;
+		std::vector<vk::ImageMemoryBarrier> images;
+		while (!m_Handovers.empty() && m_Handovers.front().Value <= target)
+		{
+			Handover& handover = m_Handovers.front();
+			buffers.insert(buffers.end(), handover.Buffers.begin(), handover.Buffers.end());
+			images.insert(images.end(), handover.Images.begin(), handover.Images.end());
+			m_Handovers.pop_front();
+		}
+
+		// The source stages match the stages the semaphore is waited at,
+		// which orders the takeover after the release
+		if (!buffers.empty() || !images.empty())
+		{
+			commandBuffer.pipelineBarrier(WaitStages, WaitStages, vk::DependencyFlags(), 0, nullptr,
+				(uint32_t)buffers.size(), buffers.data(), (uint32_t)images.size(), images.data());
+		}
+
+		m_AcquiredValue = target;
+		return target;
+	}
+
+	bool VulkanUploader::IsComplete(uint64_t value) const
+	{
+		return m_Device.getSemaphoreCounterValue(m_Semaphore) >= value;
+	}
+
+	void VulkanUploader::Wait(uint64_t value)
+	{
+		PT_PROFILE_FUNCTION();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (value >= m_NextValue)
+				SubmitBatch();
+			// Its batch never made it to the queue, nothing will signal it
+			if (value >= m_NextValue)
+				return;
+		}
+		(void)m_Device.waitSemaphores(vk::SemaphoreWaitInfo(vk::SemaphoreWaitFlags(), 1, &m_Semaphore, &value), UINT64_MAX);
+	}
+
+	VulkanUploaderStats VulkanUploader::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		VulkanUploaderStats stats;
+		stats.BytesUploaded = m_BytesUploaded;
+		stats.Batches = m_Batches;
+		stats.Stalls = m_Stalls;
+		stats.StagingUsed = m_Head - m_Tail;
+		stats.StagingSize = m_StagingSize;
+		return stats;
+	}
+
+	uint64_t VulkanUploader::AllocateStaging(vk::DeviceSize size, vk::DeviceSize alignment)
+	{
+		PT_CORE_ASSERT(size <= m_StagingSize, "Staging allocation bigger than the ring");
+
+		for (;;)
+		{
+			// Aligns the position in the buffer rather than the offset
+			uint64_t position = m_Head % m_StagingSize;
+			uint64_t aligned = (position + alignment - 1) / alignment * alignment;
+			uint64_t offset = m_Head - position + aligned;
+			// A range can't wrap around the end, skip to the start instead
+			if (aligned + size > m_StagingSize)
+				offset = (m_Head / m_StagingSize + 1) * m_StagingSize;
+			if (offset + size - m_Tail <= m_StagingSize)
+			{
+				m_Head = offset + size;
+				return offset;
+			}
+
+			Retire(m_Device.getSemaphoreCounterValue(m_Semaphore));
+			if (m_Head == m_Tail && !m_Batch.CommandBuffer)
+			{
+				// Nothing in use, start over at the beginning
+				m_Head = m_Tail = (m_Head + m_StagingSize - 1) / m_StagingSize * m_StagingSize;
+				continue;
+			}
+			if (offset + size - m_Tail <= m_StagingSize)
+				continue;
+
+			// Full, the recorded copies have to go before their space can
+			// come back
+			// A failed submit gives its space back, so there may be nothing
+			// to wait for
+			if (!SubmitBatch() || m_InFlight.empty())
+				continue;
+
+			PT_PROFILE_SCOPE("Wait for staging space");
+			HistogramTimer timer(m_StallMetric);
+			uint64_t oldest = m_InFlight.front().Value;
+			(void)m_Device.waitSemaphores(vk::SemaphoreWaitInfo(vk::SemaphoreWaitFlags(), 1, &m_Semaphore, &oldest), UINT64_MAX);
+			m_Stalls++;
+		}
+	}
+
+	void VulkanUploader::Write(uint64_t offset, const void* data, vk::DeviceSize size)
+	{
+		offset %= m_StagingSize;
+		memcpy((uint8_t*)m_Staging.Allocation.MappedData + offset, data, size);
+		m_Allocator.Flush(m_Staging.Allocation, offset, size);
+	}
+
+	vk::CommandBuffer VulkanUploader::GetCommandBuffer()
+	{
+		if (m_Batch.CommandBuffer)
+			return m_Batch.CommandBuffer;
+
+		if (m_FreeCommandBuffers.empty())
+		{
+			m_Batch.CommandBuffer = m_Device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(m_CommandPool, vk::CommandBufferLevel::ePrimary, 1))[0];
+		}
+		else
+		{
+			m_Batch.CommandBuffer = m_FreeCommandBuffers.back();
+			m_FreeCommandBuffers.pop_back();
+			m_Batch.CommandBuffer.reset();
+		}
+
+		m_Batch.Value = m_NextValue;
+		m_Batch.CommandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		return m_Batch.CommandBuffer;
+	}
+
+	bool VulkanUploader::SubmitBatch()
+	{
+		if (!m_Batch.CommandBuffer)
+			return true;
+
+		PT_PROFILE_FUNCTION();
+
+		m_Batch.CommandBuffer.end();
+
+		vk::TimelineSemaphoreSubmitInfo timelineInfo(0, nullptr, 1, &m_Batch.Value);
+		vk::SubmitInfo submitInfo(0, nullptr, nullptr, 1, &m_Batch.CommandBuffer, 1, &m_Semaphore, &timelineInfo);
+		vk::Result result;
+		{
+			std::unique_lock<std::mutex> queueLock;
+			if (m_QueueMutex)
+				queueLock = std::unique_lock<std::mutex>(*m_QueueMutex);
+			result = m_TransferQueue.submit(1, &submitInfo, nullptr);
+		}
+		if (result != vk::Result::eSuccess)
+		{
+			// The copies are dropped and their value goes to the next batch.
+			// Their staging space is free once the batches before are done
+			PT_CORE_ERROR("Could not submit {0} bytes of uploads ({1})", m_Batch.Bytes, vk::to_string(result));
+			if (m_InFlight.empty())
+				m_Tail = m_Head;
+			else
+				m_InFlight.back().StagingEnd = m_Head;
+			m_FreeCommandBuffers.push_back(m_Batch.CommandBuffer);
+			m_Batch = Batch();
+			m_BatchHandover = Handover();
+			return false;
+		}
+
+		m_Batch.StagingEnd = m_Head;
+		m_InFlight.push_back(m_Batch);
+		// Within a family there is nothing for graphics to take over
+		m_BatchHandover.Value = m_Batch.Value;
+		if (!m_BatchHandover.Buffers.empty() || !m_BatchHandover.Images.empty())
+			m_Handovers.push_back(std::move(m_BatchHandover));
+
+		m_Batch = Batch();
+		m_BatchHandover = Handover();
+		m_NextValue++;
+		m_Batches++;
+		return true;
+	}
+
+	void VulkanUploader::Retire(uint64_t completed)
+	{
+		while (!m_InFlight.empty() && m_InFlight.front().Value <= completed)
+		{
+			m_Tail = m_InFlight.front().StagingEnd;
+			m_FreeCommandBuffers.push_back(m_InFlight.front().CommandBuffer);
+			m_InFlight.pop_front();
+		}
+	}
+}
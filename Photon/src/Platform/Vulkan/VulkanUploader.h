@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Photon/Core.h"
+#include "Photon/Metrics/Metrics.h"
+#include "Platform/Vulkan/VulkanAllocator.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace Photon
+{
+	struct VulkanUploaderStats
+	{
+		uint64_t BytesUploaded = 0;
+		uint64_t Batches = 0;
+		// Uploads that had to wait for the GPU to free staging space
+		uint64_t Stalls = 0;
+		vk::DeviceSize StagingUsed = 0;
+		vk::DeviceSize StagingSize = 0;
+	};
+
+	// Copies data into device local buffers and images on the transfer
+	// queue, so uploads overlap with rendering instead of being queued in
+	// between frames.
+	//
+	// The data goes through one persistently mapped staging ring. Copies
+	// are recorded into a batch that is submitted once it holds a quarter
+	// of the ring, or on Submit and Acquire. Every batch signals the next
+	// value of a timeline semaphore, that value is what an upload returns.
+	// Staging space is reused once the batch is done, the CPU only waits
+	// when the ring is full.
+	//
+	// The graphics queue takes the uploads over through Acquire: it records
+	// the queue family ownership transfers when the transfer queue is of
+	// another family and returns the value to wait on. Resources have to be
+	// created with eExclusive sharing.
+	//
+	// Thread safe. The transfer queue may be the graphics queue on devices
+	// with only one, every submit then holds queueMutex, which everyone else
+	// submitting to it has to hold as well.
+	class PHOTON_API VulkanUploader
+	{
+	public:
+		VulkanUploader(vk::Device device, VulkanAllocator& allocator, uint32_t transferFamily, vk::Queue transferQueue,
+			uint32_t graphicsFamily, std::mutex* queueMutex = nullptr, vk::DeviceSize stagingSize = 32 * 1024 * 1024);
+		~VulkanUploader();
+
+		VulkanUploader(const VulkanUploader&) = delete;
+		VulkanUploader& operator=(const VulkanUploader&) = delete;
+
+		// False when the staging buffer could not be created, every upload
+		// then returns 0
+		inline bool IsValid() const { return (bool)m_Staging.Buffer; }
+
+		// Copies size bytes to offset in buffer, which needs eTransferDst.
+		// Uploads bigger than the ring are split. Returns 0 when a submit
+		// fails
+		uint64_t UploadBuffer(vk::Buffer buffer, vk::DeviceSize offset, const void* data, vk::DeviceSize size);
+		// Copies tightly packed texels into the first mip level and layer of
+		// image, which needs eTransferDst and ends up in layout. The texels
+		// have to fit into the ring. Returns 0 when they don't or a submit
+		// fails
+		uint64_t UploadImage(vk::Image image, vk::Extent3D extent, const void* data, vk::DeviceSize size,
+			vk::ImageLayout layout, vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor);
+
+		// Submits the copies recorded so far, false when the queue refused
+		// them and they were dropped
+		bool Submit();
+		// Submits, then records into a graphics command buffer the takeover
+		// of every finished upload and of those up to value. Returns the
+		// value its submit has to wait for at WaitStages, 0 for none. Waiting
+		// for finished uploads costs nothing, the frame only stalls on value
+		uint64_t Acquire(vk::CommandBuffer commandBuffer, uint64_t value = 0);
+
+		bool IsComplete(uint64_t value) const;
+		// Blocks until the upload that returned value is done
+		void Wait(uint64_t value);
+
+		inline vk::Semaphore GetSemaphore() const { return m_Semaphore; }
+		// Uploads that returned up to this value can be used by graphics
+		inline uint64_t GetAcquiredValue() const { return m_AcquiredValue; }
+
+		VulkanUploaderStats GetStats();
+
+		// Where graphics may first use an upload
+		static constexpr vk::PipelineStageFlags WaitStages = vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader
+			| vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer;
+	private:
+		struct Batch
+		{
+			vk::CommandBuffer CommandBuffer;
+			uint64_t Value = 0;
+			// Where its staging data ends, the ring's tail once it is done
+			uint64_t StagingEnd = 0;
+			vk::DeviceSize Bytes = 0;
+		};
+
+		struct Handover
+		{
+			uint64_t Value = 0;
+			std::vector<vk::BufferMemoryBarrier> Buffers;
+			std::vector<vk::ImageMemoryBarrier> Images;
+		};
+
+		// Returns the ring offset, the data goes at offset % m_StagingSize
+		uint64_t AllocateStaging(vk::DeviceSize size, vk::DeviceSize alignment);
+		void Write(uint64_t offset, const void* data, vk::DeviceSize size);
+		vk::CommandBuffer GetCommandBuffer();
+		bool SubmitBatch();
+		void Retire(uint64_t completed);
+		bool IsSameFamily() const { return m_TransferFamily == m_GraphicsFamily; }
+	private:
+		vk::Device m_Device;
+		VulkanAllocator& m_Allocator;
+		uint32_t m_TransferFamily;
+		uint32_t m_GraphicsFamily;
+		vk::Queue m_TransferQueue;
+		// Null while the transfer queue is the uploader's alone
+		std::mutex* m_QueueMutex;
+
+		std::mutex m_Mutex;
+
+		VulkanBuffer m_Staging;
+		vk::DeviceSize m_StagingSize;
+		// Offsets grow without wrapping, as in VulkanRingBuffer
+		uint64_t m_Head = 0;
+		uint64_t m_Tail = 0;
+
+		vk::CommandPool m_CommandPool;
+		std::vector<vk::CommandBuffer> m_FreeCommandBuffers;
+
+		vk::Semaphore m_Semaphore;
+		uint64_t m_NextValue = 1;
+		uint64_t m_AcquiredValue = 0;
+
+		// Being recorded, no command buffer when empty
+		Batch m_Batch;
+		Handover m_BatchHandover;
+		// Submitted, oldest first
+		std::deque<Batch> m_InFlight;
+		// Submitted but not yet taken over by graphics
+		std::deque<Handover> m_Handovers;
+
+		uint64_t m_BytesUploaded = 0;
+		uint64_t m_Batches = 0;
+		uint64_t m_Stalls = 0;
+
+		Counter& m_BytesMetric;
+		Histogram& m_StallMetric;
+	};
+}
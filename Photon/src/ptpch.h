@@ -16,5 +16,8 @@
 #include "Photon/Log.h"
 
 #ifdef PT_PLATFORM_WINDOWS
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
 	#include <Windows.h>
 #endif
\ No newline at end of file
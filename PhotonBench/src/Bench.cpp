@@ -0,0 +1,370 @@
+#include "Bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace Bench
+{
+	struct Benchmark
+	{
+		std::string Name;
+		BenchmarkFn Function;
+		int64_t Arg;
+		// Name without the "/arg" suffix
+		std::string BaseName;
+	};
+
+	struct Result
+	{
+		std::string Name;
+		uint64_t CallsPerSample = 0;
+		size_t SampleCount = 0;
+		double MinNs = 0.0, MedianNs = 0.0, MeanNs = 0.0, StdDevNs = 0.0, MaxNs = 0.0;
+		double ItemsPerSecond = 0.0;
+		std::map<std::string, double> Counters;
+		std::string Status;
+		std::string Message;
+	};
+
+	static std::vector<Benchmark>& GetRegistry()
+	{
+		static std::vector<Benchmark> s_Registry;
+		return s_Registry;
+	}
+
+	static Options s_Options;
+
+	bool Register(const std::string& name, BenchmarkFn fn, std::vector<int64_t> args)
+	{
+		if (args.empty())
+		{
+			GetRegistry().push_back({ name, std::move(fn), 0, name });
+			return true;
+		}
+
+		for (int64_t arg : args)
+			GetRegistry().push_back({ name + "/" + std::to_string(arg), fn, arg, name });
+		return true;
+	}
+
+	const Options& GetOptions()
+	{
+		return s_Options;
+	}
+
+	Options ParseCommandLine(int argc, char** argv)
+	{
+		Options options;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (arg == "--filter" && hasValue)
+				options.Filter = argv[++i];
+			else if (arg == "--warmup" && hasValue)
+				options.Warmup = (uint32_t)std::stoul(argv[++i]);
+			else if (arg == "--repetitions" && hasValue)
+				options.Repetitions = std::max(1u, (uint32_t)std::stoul(argv[++i]));
+			else if (arg == "--sample-ms" && hasValue)
+				options.SampleMs = std::stod(argv[++i]);
+			else if (arg == "--json" && hasValue)
+				options.JsonPath = argv[++i];
+			else if (arg == "--label" && hasValue)
+				options.Label = argv[++i];
+			else if (arg == "--compare" && hasValue)
+				options.ComparePath = argv[++i];
+			else if (arg == "--threshold" && hasValue)
+				options.Threshold = std::stod(argv[++i]);
+			else if (arg == "--window")
+				options.Window = true;
+			else if (arg == "--list")
+				options.List = true;
+			else
+			{
+				printf("Unknown argument '%s'\n", arg.c_str());
+				printf("Usage: PhotonBench [--filter TEXT] [--warmup N] [--repetitions N] [--sample-ms MS]\n"
+					"                   [--json FILE] [--label TEXT] [--compare FILE] [--threshold PERCENT]\n"
+					"                   [--window] [--list]\n");
+				exit(2);
+			}
+		}
+		return options;
+	}
+
+	Result Summarize(const std::string& name, const State& state)
+	{
+		Result result;
+		result.Name = name;
+		result.CallsPerSample = state.m_CallsPerSample;
+		result.SampleCount = state.m_Samples.size();
+		result.Counters = state.m_Counters;
+		result.Message = state.m_Message;
+
+		if (state.m_Failed)
+		{
+			result.Status = "failed";
+			return result;
+		}
+		if (state.m_Skipped || state.m_Samples.empty())
+		{
+			result.Status = "skipped";
+			return result;
+		}
+		result.Status = "ok";
+
+		std::vector<double> samples = state.m_Samples;
+		std::sort(samples.begin(), samples.end());
+
+		size_t count = samples.size();
+		result.MinNs = samples.front();
+		result.MaxNs = samples.back();
+		result.MedianNs = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) * 0.5;
+
+		double sum = 0.0;
+		for (double sample : samples)
+			sum += sample;
+		result.MeanNs = sum / count;
+
+		double variance = 0.0;
+		for (double sample : samples)
+			variance += (sample - result.MeanNs) * (sample - result.MeanNs);
+		result.StdDevNs = count > 1 ? std::sqrt(variance / (count - 1)) : 0.0;
+
+		if (state.m_ItemsPerCall > 0.0 && result.MedianNs > 0.0)
+			result.ItemsPerSecond = state.m_ItemsPerCall * 1e9 / result.MedianNs;
+
+		return result;
+	}
+
+	static std::string FormatTime(double ns)
+	{
+		char buffer[32];
+		if (ns < 1e3)
+			snprintf(buffer, sizeof(buffer), "%.2f ns", ns);
+		else if (ns < 1e6)
+			snprintf(buffer, sizeof(buffer), "%.2f us", ns / 1e3);
+		else if (ns < 1e9)
+			snprintf(buffer, sizeof(buffer), "%.2f ms", ns / 1e6);
+		else
+			snprintf(buffer, sizeof(buffer), "%.2f s", ns / 1e9);
+		return buffer;
+	}
+
+	static void PrintResult(const Result& result)
+	{
+		if (result.Status != "ok")
+		{
+			printf("%-52s %s: %s\n", result.Name.c_str(), result.Status.c_str(), result.Message.c_str());
+			return;
+		}
+
+		double cv = result.MeanNs > 0.0 ? result.StdDevNs / result.MeanNs * 100.0 : 0.0;
+		printf("%-52s %12s  +-%5.1f%%  min %12s", result.Name.c_str(), FormatTime(result.MedianNs).c_str(), cv, FormatTime(result.MinNs).c_str());
+		if (result.ItemsPerSecond > 0.0)
+			printf("  %10.3fM items/s", result.ItemsPerSecond / 1e6);
+		for (const auto& [name, value] : result.Counters)
+			printf("  %s=%g", name.c_str(), value);
+		printf("\n");
+	}
+
+	static std::string EscapeJson(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			if ((unsigned char)c >= 0x20)
+				escaped += c;
+		}
+		return escaped;
+	}
+
+	static const char* GetBuildName()
+	{
+#if defined(PT_DEBUG)
+		return "Debug";
+#elif defined(PT_RELEASE)
+		return "Release";
+#elif defined(PT_DIST) && defined(PT_STATIC)
+		return "DistStatic";
+#elif defined(PT_DIST)
+		return "Dist";
+#else
+		return "Unknown";
+#endif
+	}
+
+	static const char* GetPlatformName()
+	{
+#if defined(PT_PLATFORM_WINDOWS)
+		return "Windows";
+#elif defined(PT_PLATFORM_LINUX)
+		return "Linux";
+#else
+		return "Unknown";
+#endif
+	}
+
+	// One benchmark per line, so a baseline can be read back line by line
+	static void WriteJson(const Options& options, const std::vector<Result>& results)
+	{
+		std::ofstream out(options.JsonPath);
+		if (!out.is_open())
+		{
+			printf("Could not open '%s' for writing\n", options.JsonPath.c_str());
+			return;
+		}
+
+		char date[32] = {};
+		std::time_t now = std::time(nullptr);
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+		out << "{\n";
+		out << "\"context\": {\"label\": \"" << EscapeJson(options.Label) << "\", \"date\": \"" << date
+			<< "\", \"build\": \"" << GetBuildName() << "\", \"platform\": \"" << GetPlatformName()
+			<< "\", \"hardware_threads\": " << std::thread::hardware_concurrency()
+			<< ", \"warmup\": " << options.Warmup << ", \"repetitions\": " << options.Repetitions
+			<< ", \"sample_ms\": " << options.SampleMs << "},\n";
+		out << "\"benchmarks\": [\n";
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& r = results[i];
+			out << "{\"name\": \"" << EscapeJson(r.Name) << "\", \"status\": \"" << r.Status << "\"";
+			if (r.Status == "ok")
+			{
+				out << ", \"calls_per_sample\": " << r.CallsPerSample << ", \"samples\": " << r.SampleCount
+					<< ", \"min_ns\": " << r.MinNs << ", \"median_ns\": " << r.MedianNs << ", \"mean_ns\": " << r.MeanNs
+					<< ", \"stddev_ns\": " << r.StdDevNs << ", \"max_ns\": " << r.MaxNs
+					<< ", \"items_per_second\": " << r.ItemsPerSecond;
+			}
+			if (!r.Message.empty())
+				out << ", \"message\": \"" << EscapeJson(r.Message) << "\"";
+			if (!r.Counters.empty())
+			{
+				out << ", \"counters\": {";
+				bool first = true;
+				for (const auto& [name, value] : r.Counters)
+				{
+					out << (first ? "" : ", ") << "\"" << EscapeJson(name) << "\": " << value;
+					first = false;
+				}
+				out << "}";
+			}
+			out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+
+		out << "]\n}\n";
+		printf("Results written to '%s'\n", options.JsonPath.c_str());
+	}
+
+	// Reads name -> median_ns from a file written by WriteJson
+	static bool ReadBaseline(const std::string& path, std::map<std::string, double>& medians)
+	{
+		std::ifstream in(path);
+		if (!in.is_open())
+			return false;
+
+		static const std::string NameKey = "\"name\": \"";
+		static const std::string MedianKey = "\"median_ns\": ";
+
+		std::string line;
+		while (std::getline(in, line))
+		{
+			size_t name = line.find(NameKey);
+			size_t median = line.find(MedianKey);
+			if (name == std::string::npos || median == std::string::npos)
+				continue;
+
+			name += NameKey.size();
+			size_t nameEnd = line.find('"', name);
+			if (nameEnd == std::string::npos)
+				continue;
+
+			medians[line.substr(name, nameEnd - name)] = std::strtod(line.c_str() + median + MedianKey.size(), nullptr);
+		}
+		return true;
+	}
+
+	// Returns the number of regressions
+	static int Compare(const Options& options, const std::vector<Result>& results)
+	{
+		std::map<std::string, double> baseline;
+		if (!ReadBaseline(options.ComparePath, baseline))
+		{
+			printf("Could not read baseline '%s'\n", options.ComparePath.c_str());
+			return 0;
+		}
+
+		printf("\nCompared to '%s' (regression threshold %.1f%%):\n", options.ComparePath.c_str(), options.Threshold);
+
+		int regressions = 0;
+		for (const Result& result : results)
+		{
+			auto it = baseline.find(result.Name);
+			if (result.Status != "ok" || it == baseline.end() || it->second <= 0.0)
+				continue;
+
+			double change = (result.MedianNs - it->second) / it->second * 100.0;
+			bool regressed = change > options.Threshold;
+			regressions += regressed;
+
+			printf("%-52s %12s -> %12s  %+7.1f%%%s\n", result.Name.c_str(), FormatTime(it->second).c_str(),
+				FormatTime(result.MedianNs).c_str(), change, regressed ? "  REGRESSION" : "");
+		}
+
+		printf("%d regression(s)\n", regressions);
+		return regressions;
+	}
+
+	int Run(const Options& options)
+	{
+		s_Options = options;
+
+		std::vector<Benchmark>& registry = GetRegistry();
+		// Registration order across files is unspecified, args keep theirs
+		std::stable_sort(registry.begin(), registry.end(), [](const Benchmark& a, const Benchmark& b)
+		{
+			return a.BaseName < b.BaseName;
+		});
+
+		if (options.List)
+		{
+			for (const Benchmark& benchmark : registry)
+				printf("%s\n", benchmark.Name.c_str());
+			return 0;
+		}
+
+		std::vector<Result> results;
+		int failures = 0;
+
+		for (const Benchmark& benchmark : registry)
+		{
+			if (!options.Filter.empty() && benchmark.Name.find(options.Filter) == std::string::npos)
+				continue;
+
+			State state(s_Options, benchmark.Arg);
+			benchmark.Function(state);
+
+			Result result = Summarize(benchmark.Name, state);
+			PrintResult(result);
+			fflush(stdout);
+
+			failures += result.Status == "failed";
+			results.push_back(std::move(result));
+		}
+
+		if (!options.JsonPath.empty())
+			WriteJson(options, results);
+
+		int regressions = options.ComparePath.empty() ? 0 : Compare(options, results);
+		return failures || regressions ? 1 : 0;
+	}
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Minimal benchmark harness. A benchmark is a function taking a State, it
+// sets up whatever it needs and hands the code to measure to State::Run:
+//
+//   PT_BENCHMARK("Events/Dispatch")
+//   {
+//       KeyPressedEvent event(65, 0);
+//       state.Run([&] { ... });
+//   }
+//
+// Run calibrates how many calls make up a sample, runs warmup samples and
+// then the measured repetitions, and the summary (min/median/mean/stddev/
+// max per call) is printed and optionally written to JSON so runs from two
+// commits can be compared with --compare.
+namespace Bench
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Options
+	{
+		std::string Filter;
+		uint32_t Warmup = 2;
+		uint32_t Repetitions = 10;
+		// Target duration of one sample
+		double SampleMs = 10.0;
+
+		std::string JsonPath;
+		// Free form text stored with the results, e.g. the commit hash
+		std::string Label;
+
+		// Baseline JSON to compare against, and the median slowdown in
+		// percent that counts as a regression
+		std::string ComparePath;
+		double Threshold = 5.0;
+
+		// Window and Vulkan benchmarks need a display and a device
+		bool Window = false;
+		bool List = false;
+	};
+
+	struct Result;
+
+	class State
+	{
+	public:
+		// Measures func, called back to back many times per sample
+		template<typename F>
+		void Run(F&& func)
+		{
+			uint64_t calls = Calibrate(func);
+
+			for (uint32_t i = 0; i < m_Options.Warmup; i++)
+				Sample(func, calls);
+
+			m_CallsPerSample = calls;
+			m_Samples.reserve(m_Options.Repetitions);
+			for (uint32_t i = 0; i < m_Options.Repetitions; i++)
+				m_Samples.push_back(Sample(func, calls) / calls);
+		}
+
+		// Measures a single call of func, for one-off costs like startup
+		template<typename F>
+		void RunOnce(F&& func)
+		{
+			m_CallsPerSample = 1;
+			m_Samples.push_back(Sample(func, 1));
+		}
+
+		// Work done by one call, reported as items per second
+		inline void SetItemsPerCall(double items) { m_ItemsPerCall = items; }
+		inline void SetCounter(const std::string& name, double value) { m_Counters[name] = value; }
+
+		void Skip(const std::string& reason) { m_Skipped = true; m_Message = reason; }
+		void Fail(const std::string& reason) { m_Failed = true; m_Message = reason; }
+
+		inline int64_t GetArg() const { return m_Arg; }
+	private:
+		State(const Options& options, int64_t arg)
+			: m_Options(options), m_Arg(arg)
+		{}
+
+		// Nanoseconds for calls calls of func
+		template<typename F>
+		static double Sample(F& func, uint64_t calls)
+		{
+			Clock::time_point start = Clock::now();
+			for (uint64_t i = 0; i < calls; i++)
+				func();
+			return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		}
+
+		template<typename F>
+		uint64_t Calibrate(F& func)
+		{
+			// Double the batch until it is long enough to time reliably, then
+			// scale it to the sample length
+			double targetNs = m_Options.SampleMs * 1e6;
+			uint64_t calls = 1;
+			for (;;)
+			{
+				double ns = Sample(func, calls);
+				if (ns >= targetNs / 10.0 || calls >= (1ull << 40))
+					return std::max<uint64_t>(1, (uint64_t)(calls * targetNs / std::max(ns, 1.0)));
+				calls *= 2;
+			}
+		}
+	private:
+		const Options& m_Options;
+		int64_t m_Arg;
+
+		std::vector<double> m_Samples;
+		uint64_t m_CallsPerSample = 0;
+		double m_ItemsPerCall = 0.0;
+		std::map<std::string, double> m_Counters;
+
+		bool m_Skipped = false;
+		bool m_Failed = false;
+		std::string m_Message;
+
+		friend int Run(const Options& options);
+		friend Result Summarize(const std::string& name, const State& state);
+	};
+
+	using BenchmarkFn = std::function<void(State&)>;
+
+	// Registers fn once per arg, or once without an arg when args is empty.
+	// The arg is appended to the name, e.g. "Events/OnEvent/100"
+	bool Register(const std::string& name, BenchmarkFn fn, std::vector<int64_t> args = {});
+
+	Options ParseCommandLine(int argc, char** argv);
+	// Runs everything matching the filter, returns the process exit code
+	int Run(const Options& options);
+
+	const Options& GetOptions();
+
+	// Keeps the compiler from optimising away a value that is never read
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(_MSC_VER)
+		static const volatile void* s_Sink;
+		s_Sink = &value;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+}
+
+#define PT_BENCH_CONCAT_IMPL(a, b) a##b
+#define PT_BENCH_CONCAT(a, b) PT_BENCH_CONCAT_IMPL(a, b)
+
+// Defines and registers a benchmark, extra arguments are the args to run it with
+#define PT_BENCHMARK(name, ...) \
+	static void PT_BENCH_CONCAT(Benchmark_, __LINE__)(::Bench::State& state); \
+	static bool PT_BENCH_CONCAT(s_BenchmarkRegistered_, __LINE__) = \
+		::Bench::Register(name, PT_BENCH_CONCAT(Benchmark_, __LINE__), { __VA_ARGS__ }); \
+	static void PT_BENCH_CONCAT(Benchmark_, __LINE__)(::Bench::State& state)
@@ -0,0 +1,31 @@
+#include "Bench.h"
+
+#include "Photon/Log.h"
+#include "Photon/Memory/Memory.h"
+
+// PhotonBench has its own entry point, so Photon.h (which brings in the
+// engine's main) is not included anywhere in this project.
+//
+//   PhotonBench [--filter TEXT] [--warmup N] [--repetitions N] [--sample-ms MS]
+//               [--json FILE] [--label TEXT] [--compare FILE] [--threshold PERCENT]
+//               [--window] [--list]
+//
+// --compare exits with 1 when a benchmark's median is more than --threshold
+// percent slower than in the baseline, so it can gate a build.
+int main(int argc, char** argv)
+{
+	Bench::Options options = Bench::ParseCommandLine(argc, argv);
+
+	// Engine chatter would drown the results, only warnings and up are shown
+	Photon::Log::Init();
+	Photon::Log::GetCoreLogger()->set_level(spdlog::level::warn);
+	Photon::Log::GetClientLogger()->set_level(spdlog::level::warn);
+
+	int result = Bench::Run(options);
+
+	// The report logs at info, the results are done so it can't drown them
+	Photon::Log::GetCoreLogger()->set_level(spdlog::level::info);
+	Photon::Memory::LogReport();
+	Photon::Log::Shutdown();
+	return result;
+}
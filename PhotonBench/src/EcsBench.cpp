@@ -0,0 +1,154 @@
+#include "Bench.h"
+
+#include "Photon/ECS/World.h"
+#include "Photon/ECS/Query.h"
+#include "Photon/ECS/CommandBuffer.h"
+
+#include <utility>
+
+using namespace Photon;
+
+namespace
+{
+	struct Position { float X, Y; };
+	struct Velocity { float X, Y; };
+	struct Health { int Value; };
+
+	// Distinct empty-ish components, to spread entities over many archetypes
+	template<int I>
+	struct Tag { int Value = I; };
+
+	constexpr int TagCount = 6;
+
+	template<int... I>
+	void AddTags(World& world, Entity entity, uint32_t mask, std::integer_sequence<int, I...>)
+	{
+		((mask & (1u << I) ? (void)world.Add<Tag<I>>(entity) : (void)0), ...);
+	}
+
+	// count entities with Position and Velocity, spread evenly over every
+	// combination of the tags, 2^TagCount archetypes the query matches
+	void CreateTagged(World& world, int64_t count)
+	{
+		for (int64_t i = 0; i < count; i++)
+		{
+			Entity entity = world.Create(Position{ 0.0f, 0.0f }, Velocity{ (float)i, 1.0f });
+			AddTags(world, entity, (uint32_t)(i % (1 << TagCount)), std::make_integer_sequence<int, TagCount>());
+		}
+	}
+}
+
+PT_BENCHMARK("ECS/Create", 10000, 100000, 1000000)
+{
+	state.SetItemsPerCall((double)state.GetArg());
+	state.Run([&]
+	{
+		World world;
+		for (int64_t i = 0; i < state.GetArg(); i++)
+			world.Create(Position{ 0.0f, 0.0f }, Velocity{ 1.0f, 1.0f });
+	});
+}
+
+PT_BENCHMARK("ECS/Each", 1000, 100000, 1000000)
+{
+	World world;
+	for (int64_t i = 0; i < state.GetArg(); i++)
+	{
+		// Every fourth entity lands in a second archetype the query also matches
+		if (i % 4)
+			world.Create(Position{ 0.0f, 0.0f }, Velocity{ (float)i, 1.0f });
+		else
+			world.Create(Position{ 0.0f, 0.0f }, Velocity{ (float)i, 1.0f }, Health{ 100 });
+	}
+
+	Query<Position, const Velocity> query(world);
+	state.SetItemsPerCall((double)state.GetArg());
+	state.Run([&]
+	{
+		query.Each([](Entity, Position& position, const Velocity& velocity)
+		{
+			position.X += velocity.X * 0.016f;
+			position.Y += velocity.Y * 0.016f;
+		});
+	});
+}
+
+// Adding and removing a component moves the entity between archetypes
+PT_BENCHMARK("ECS/AddRemove", 10000, 100000, 1000000)
+{
+	World world;
+	std::vector<Entity> entities;
+	for (int64_t i = 0; i < state.GetArg(); i++)
+		entities.push_back(world.Create(Position{ 0.0f, 0.0f }, Velocity{ 1.0f, 1.0f }));
+
+	state.SetItemsPerCall((double)state.GetArg());
+	state.Run([&]
+	{
+		for (Entity entity : entities)
+			world.Add<Health>(entity, 100);
+		for (Entity entity : entities)
+			world.Remove<Health>(entity);
+	});
+}
+
+// Entities destroyed and recreated through a command buffer, as a system
+// iterating a query would
+PT_BENCHMARK("ECS/CommandBufferChurn", 10000, 100000, 1000000)
+{
+	World world;
+	for (int64_t i = 0; i < state.GetArg(); i++)
+		world.Create(Position{ 0.0f, 0.0f }, Health{ (int)(i % 2) });
+
+	Query<const Health> query(world);
+	CommandBuffer commands;
+	state.Run([&]
+	{
+		uint32_t destroyed = 0;
+		query.Each([&](Entity entity, const Health& health)
+		{
+			if (health.Value == 0)
+			{
+				commands.Destroy(entity);
+				destroyed++;
+			}
+		});
+		commands.Playback(world);
+
+		for (uint32_t i = 0; i < destroyed; i++)
+			world.Create(Position{ 0.0f, 0.0f }, Health{ 0 });
+	});
+}
+
+// What a query costs on top of the iteration: building it, which matches
+// every archetype, and then running it over arg entities spread over 64
+// archetypes. QueryBuild is the cost of not keeping the Query around
+PT_BENCHMARK("ECS/QueryBuild", 1000, 100000, 1000000)
+{
+	World world;
+	CreateTagged(world, state.GetArg());
+
+	state.Run([&]
+	{
+		Query<Position, const Velocity> query(world);
+		Bench::DoNotOptimize(query.Count());
+	});
+}
+
+// Each over the same entities as QueryBuild, against ECS/Each which has
+// them in two archetypes
+PT_BENCHMARK("ECS/EachFragmented", 1000, 100000, 1000000)
+{
+	World world;
+	CreateTagged(world, state.GetArg());
+
+	Query<Position, const Velocity> query(world);
+	state.SetItemsPerCall((double)state.GetArg());
+	state.Run([&]
+	{
+		query.Each([](Entity, Position& position, const Velocity& velocity)
+		{
+			position.X += velocity.X * 0.016f;
+			position.Y += velocity.Y * 0.016f;
+		});
+	});
+}
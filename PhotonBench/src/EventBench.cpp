@@ -0,0 +1,575 @@
+#include "Bench.h"
+
+#include "Photon/Application.h"
+#include "Photon/Input.h"
+#include "Photon/Layer.h"
+#include "Photon/Events/ApplicationEvent.h"
+#include "Photon/Events/KeyEvent.h"
+#include "Photon/Events/MouseEvent.h"
+#include "Photon/Events/EventQueue.h"
+#include "Photon/Events/ConcurrentEventQueue.h"
+#include "Photon/Events/EventRecording.h"
+#include "Photon/Metrics/Metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <tuple>
+
+using namespace Photon;
+
+namespace
+{
+	// One instance of every event type, with representative payloads
+	auto MakeEvents()
+	{
+		return std::make_tuple(
+			WindowCloseEvent(), WindowResizeEvent(1920, 1080), WindowFocusEvent(), WindowLostFocusEvent(),
+			WindowMovedEvent(640, 360), AppTickEvent(), AppUpdateEvent(), AppRenderEvent(),
+			KeyPressedEvent(65, 2), KeyReleasedEvent(65), MouseButtonPressedEvent(1), MouseButtonReleasedEvent(1),
+			MouseMovedEvent(812.0f, 455.5f), MouseScrolledEvent(0.0f, -1.0f));
+	}
+
+	using EventTypes = decltype(MakeEvents());
+
+	// The event is typed as the base class and laundered through
+	// DoNotOptimize, so its type has to be read back on every call
+	template<typename... Ts>
+	bool DispatchChain(Event& event, std::tuple<Ts...>*)
+	{
+		Bench::DoNotOptimize(event);
+		EventDispatcher dispatcher(event);
+		return (dispatcher.Dispatch<Ts>([](Ts& e) { Bench::DoNotOptimize(e); return false; }) || ...);
+	}
+
+	// The dispatcher as it was before handlers became plain callables: every
+	// Dispatch builds a std::function, here from a std::bind to a member as
+	// the engine's BIND_EVENT_FN did. The type check is today's, so the
+	// difference to Dispatch is the type erasure alone
+	class StdFunctionDispatcher
+	{
+		template<typename T>
+		using EventFn = std::function<bool(T&)>;
+	public:
+		StdFunctionDispatcher(Event& event)
+			: m_Event(event)
+		{
+		}
+
+		template<typename T>
+		bool Dispatch(EventFn<T> func)
+		{
+			if (m_Event.GetEventType() == T::StaticType)
+			{
+				m_Event.Handled = func(static_cast<T&>(m_Event));
+				return true;
+			}
+
+			return false;
+		}
+	private:
+		Event& m_Event;
+	};
+
+	struct BoundHandlers
+	{
+		template<typename T>
+		bool On(T& e)
+		{
+			Bench::DoNotOptimize(e);
+			return false;
+		}
+	};
+
+	template<typename... Ts>
+	bool DispatchStdFunctionChain(Event& event, std::tuple<Ts...>*)
+	{
+		Bench::DoNotOptimize(event);
+		BoundHandlers handlers;
+		StdFunctionDispatcher dispatcher(event);
+		return (dispatcher.Dispatch<Ts>(std::bind(&BoundHandlers::On<Ts>, &handlers, std::placeholders::_1)) || ...);
+	}
+
+	template<typename... Ts>
+	bool DispatchTable(Event& event, std::tuple<Ts...>*)
+	{
+		Bench::DoNotOptimize(event);
+		EventDispatcher dispatcher(event);
+		return dispatcher.DispatchAny([](Ts& e) { Bench::DoNotOptimize(e); return false; }...);
+	}
+
+	template<typename T>
+	void RegisterEventType(const T& prototype)
+	{
+		std::string name = prototype.GetName();
+
+		// Handlers for every type tried in order, as a layer handling many
+		// types would write it. StdFunction is the baseline for both
+		Bench::Register("Events/DispatchStdFunction/" + name, [prototype](Bench::State& state)
+		{
+			T event = prototype;
+			state.Run([&] { DispatchStdFunctionChain(event, (EventTypes*)nullptr); });
+		});
+
+		Bench::Register("Events/Dispatch/" + name, [prototype](Bench::State& state)
+		{
+			T event = prototype;
+			state.Run([&] { DispatchChain(event, (EventTypes*)nullptr); });
+		});
+
+		Bench::Register("Events/DispatchAny/" + name, [prototype](Bench::State& state)
+		{
+			T event = prototype;
+			state.Run([&] { DispatchTable(event, (EventTypes*)nullptr); });
+		});
+
+		Bench::Register("Events/ToString/" + name, [prototype](Bench::State& state)
+		{
+			T event = prototype;
+			state.Run([&] { Bench::DoNotOptimize(event.ToString()); });
+		});
+
+		// What the log macros do with an event, formatting into a reused buffer
+		Bench::Register("Events/FormatTo/" + name, [prototype](Bench::State& state)
+		{
+			T event = prototype;
+			fmt::memory_buffer buffer;
+			state.Run([&]
+			{
+				buffer.clear();
+				fmt::format_to(fmt::appender(buffer), "{0}", event);
+				Bench::DoNotOptimize(buffer.data());
+			});
+		});
+	}
+
+	bool RegisterEventTypes()
+	{
+		std::apply([](const auto&... events) { (RegisterEventType(events), ...); }, MakeEvents());
+		return true;
+	}
+
+	bool s_EventTypesRegistered = RegisterEventTypes();
+
+	class CountingLayer : public Layer
+	{
+	public:
+		CountingLayer(int categories = ~0)
+			: Layer("Counting")
+		{
+			SetEventCategories(categories);
+		}
+
+		void OnEvent(Event&) override { m_Count++; }
+
+		uint64_t m_Count = 0;
+	};
+
+	WindowProps HeadlessProps()
+	{
+		WindowProps props("PhotonBench");
+		props.Headless = true;
+		return props;
+	}
+
+	// Every layer receives the event, none handles it
+	void OnEventThroughLayers(Bench::State& state, int layerCategories)
+	{
+		Application app(HeadlessProps());
+		for (int64_t i = 0; i < state.GetArg(); i++)
+			app.EmplaceLayer<CountingLayer>(layerCategories);
+
+		MouseMovedEvent event(100.0f, 200.0f);
+		state.SetItemsPerCall((double)state.GetArg());
+		state.Run([&] { app.OnEvent(event); });
+	}
+}
+
+PT_BENCHMARK("Events/OnEvent", 1, 10, 100, 1000)
+{
+	OnEventThroughLayers(state, ~0);
+}
+
+// Layers that only listen for keyboard events are skipped by their mask
+PT_BENCHMARK("Events/OnEventMasked", 1, 10, 100, 1000)
+{
+	OnEventThroughLayers(state, EventCategoryKeyboard);
+}
+
+PT_BENCHMARK("Events/QueuedOnEvent", 1, 10, 100, 1000)
+{
+	Application app(HeadlessProps());
+	for (int64_t i = 0; i < state.GetArg(); i++)
+		app.EmplaceLayer<CountingLayer>();
+
+	// One click per call, so the moves around it are not coalesced away.
+	// Turning queueing off delivers what was queued, as the frame's drain would
+	MouseMovedEvent move(100.0f, 200.0f);
+	MouseButtonPressedEvent press(0);
+	MouseButtonReleasedEvent release(0);
+
+	state.SetItemsPerCall(3.0 * state.GetArg());
+	state.Run([&]
+	{
+		app.SetEventQueueing(true);
+		app.OnEvent(move);
+		app.OnEvent(press);
+		app.OnEvent(release);
+		app.SetEventQueueing(false);
+	});
+}
+
+// A frame's worth of input, pushed and drained
+PT_BENCHMARK("Events/QueuePushDrain", 16, 256)
+{
+	EventQueue queue;
+	KeyPressedEvent key(65, 0);
+	MouseMovedEvent move(1.0f, 2.0f);
+	uint64_t delivered = 0;
+
+	state.SetItemsPerCall((double)state.GetArg());
+	state.Run([&]
+	{
+		for (int64_t i = 0; i < state.GetArg(); i++)
+		{
+			if (i % 4)
+				queue.Push(move);
+			else
+				queue.Push(key);
+		}
+		queue.Drain([&](Event&) { delivered++; });
+	});
+	Bench::DoNotOptimize(delivered);
+	state.SetCounter("coalesced", (double)queue.GetCoalescedCount());
+}
+
+// Single thread post and drain, the uncontended cost of PostEvent
+PT_BENCHMARK("Events/PostDrain", 64)
+{
+	ConcurrentEventQueue queue;
+	MouseMovedEvent event(1.0f, 2.0f);
+	uint64_t delivered = 0;
+
+	state.SetItemsPerCall((double)state.GetArg());
+	state.Run([&]
+	{
+		for (int64_t i = 0; i < state.GetArg(); i++)
+			queue.Post(event);
+		queue.Drain([&](Event&) { delivered++; });
+	});
+	Bench::DoNotOptimize(delivered);
+}
+
+// arg producer threads post while the main thread drains. One call is a full
+// run of PostEventsPerProducer events per producer, delivery order per
+// producer is verified
+PT_BENCHMARK("Events/PostContended", 1, 2, 4, 8)
+{
+	constexpr int PostEventsPerProducer = 20000;
+	int producers = (int)state.GetArg();
+	ConcurrentEventQueue queue;
+	bool ordered = true;
+	uint64_t retries = 0;
+
+	state.SetItemsPerCall((double)producers * PostEventsPerProducer);
+	state.Run([&]
+	{
+		std::atomic<uint64_t> full = 0;
+		std::vector<std::thread> threads;
+		for (int p = 0; p < producers; p++)
+		{
+			threads.emplace_back([&, p]
+			{
+				// The producer and sequence number travel in the event
+				for (int i = 0; i < PostEventsPerProducer; i++)
+				{
+					MouseMovedEvent event((float)p, (float)i);
+					while (!queue.Post(event))
+					{
+						full.fetch_add(1, std::memory_order_relaxed);
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		std::vector<int> next(producers, 0);
+		uint64_t total = 0;
+		while (total < (uint64_t)producers * PostEventsPerProducer)
+		{
+			total += queue.Drain([&](Event& e)
+			{
+				MouseMovedEvent& event = (MouseMovedEvent&)e;
+				int p = (int)event.GetX(), i = (int)event.GetY();
+				ordered &= next[p] == i;
+				next[p] = i + 1;
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+		retries += full;
+	});
+
+	if (!ordered)
+		state.Fail("events from one producer were delivered out of order");
+	state.SetCounter("full_retries", (double)retries);
+}
+
+// arg producer threads post while the main thread drains, like
+// PostContended, but every Post is timed on its own, retries on a full queue
+// included. The latencies go into a histogram whose percentiles are reported
+PT_BENCHMARK("Events/PostLatency", 1, 4, 16)
+{
+	constexpr int PostEventsPerProducer = 20000;
+	int producers = (int)state.GetArg();
+	ConcurrentEventQueue queue;
+	Histogram latency;
+	bool ordered = true;
+
+	state.SetItemsPerCall((double)producers * PostEventsPerProducer);
+	state.Run([&]
+	{
+		std::vector<std::thread> threads;
+		for (int p = 0; p < producers; p++)
+		{
+			threads.emplace_back([&, p]
+			{
+				for (int i = 0; i < PostEventsPerProducer; i++)
+				{
+					MouseMovedEvent event((float)p, (float)i);
+					auto start = std::chrono::steady_clock::now();
+					while (!queue.Post(event))
+						std::this_thread::yield();
+					latency.Record(std::chrono::steady_clock::now() - start);
+				}
+			});
+		}
+
+		std::vector<int> next(producers, 0);
+		uint64_t total = 0;
+		while (total < (uint64_t)producers * PostEventsPerProducer)
+		{
+			total += queue.Drain([&](Event& e)
+			{
+				MouseMovedEvent& event = (MouseMovedEvent&)e;
+				int p = (int)event.GetX(), i = (int)event.GetY();
+				ordered &= next[p] == i;
+				next[p] = i + 1;
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+	});
+
+	if (!ordered)
+		state.Fail("events from one producer were delivered out of order");
+
+	HistogramSnapshot snapshot = latency.Snapshot();
+	state.SetCounter("post_p50_ns", (double)snapshot.GetPercentile(50.0));
+	state.SetCounter("post_p99_ns", (double)snapshot.GetPercentile(99.0));
+	state.SetCounter("post_p999_ns", (double)snapshot.GetPercentile(99.9));
+	state.SetCounter("post_max_ns", (double)snapshot.Max);
+}
+
+PT_BENCHMARK("Events/InputPublish")
+{
+	KeyPressedEvent press(65, 0);
+	KeyReleasedEvent release(65);
+	MouseMovedEvent move(10.0f, 20.0f);
+
+	state.Run([&]
+	{
+		Input::OnEvent(press);
+		Input::OnEvent(move);
+		Input::OnEvent(release);
+		Input::Publish();
+	});
+}
+
+PT_BENCHMARK("Events/InputRead")
+{
+	state.Run([&] { Bench::DoNotOptimize(Input::IsKeyDown(65)); });
+}
+
+PT_BENCHMARK("Events/Record")
+{
+	std::string path = (std::filesystem::temp_directory_path() / "PhotonBench-Record.ptev").string();
+	{
+		EventRecorder recorder(path);
+		if (!recorder.IsOpen())
+		{
+			state.Skip("cannot write " + path);
+			return;
+		}
+
+		MouseMovedEvent move(400.0f, 300.0f);
+		KeyPressedEvent key(65, 0);
+		uint64_t i = 0;
+		state.Run([&]
+		{
+			if (i++ % 8)
+				recorder.Record(move);
+			else
+				recorder.Record(key);
+			if (i % 16 == 0)
+				recorder.NextFrame();
+		});
+
+		state.SetCounter("bytes_per_event", (double)recorder.GetBytesWritten() / (double)recorder.GetEventCount());
+	}
+	std::filesystem::remove(path);
+}
+
+namespace
+{
+	// What a replayed event carries, floats by their bits so the float
+	// escape has to round trip exactly
+	struct ReplayedEvent
+	{
+		uint64_t Frame = 0;
+		EventType Type = EventType::None;
+		int64_t A = 0, B = 0;
+		uint32_t X = 0, Y = 0;
+
+		bool operator==(const ReplayedEvent& other) const = default;
+	};
+
+	ReplayedEvent Capture(const Event& event, uint64_t frame)
+	{
+		ReplayedEvent replayed;
+		replayed.Frame = frame;
+		replayed.Type = event.GetEventType();
+		switch (event.GetEventType())
+		{
+			case EventType::WindowResize:
+				replayed.A = ((const WindowResizeEvent&)event).GetWidth();
+				replayed.B = ((const WindowResizeEvent&)event).GetHeight();
+				break;
+			case EventType::KeyPressed:
+				replayed.A = ((const KeyPressedEvent&)event).GetKeyCode();
+				replayed.B = ((const KeyPressedEvent&)event).GetRepeatCount();
+				break;
+			case EventType::KeyReleased:
+				replayed.A = ((const KeyReleasedEvent&)event).GetKeyCode();
+				break;
+			case EventType::MouseButtonPressed:
+				replayed.A = ((const MouseButtonPressedEvent&)event).GetMouseButton();
+				break;
+			case EventType::MouseMoved:
+				replayed.X = std::bit_cast<uint32_t>(((const MouseMovedEvent&)event).GetX());
+				replayed.Y = std::bit_cast<uint32_t>(((const MouseMovedEvent&)event).GetY());
+				break;
+			case EventType::MouseScrolled:
+				replayed.X = std::bit_cast<uint32_t>(((const MouseScrolledEvent&)event).GetXOffset());
+				replayed.Y = std::bit_cast<uint32_t>(((const MouseScrolledEvent&)event).GetYOffset());
+				break;
+			default:
+				break;
+		}
+		return replayed;
+	}
+
+	// Mouse motion that goes back and forth, whole and fractional positions,
+	// some out of the whole number range, key codes with repeat counts and
+	// negative scroll offsets
+	void RecordReplayEvent(EventRecorder& recorder, int64_t i, uint64_t frame, std::vector<ReplayedEvent>& expected)
+	{
+		auto record = [&](const Event& event)
+		{
+			recorder.Record(event);
+			expected.push_back(Capture(event, frame));
+		};
+
+		switch (i % 8)
+		{
+			case 0: record(MouseMovedEvent((float)(i % 1920), (float)(i % 1080))); break;
+			case 1: record(MouseMovedEvent((float)(i % 1920) + 0.25f, 1080.0f - (float)(i % 1080))); break;
+			case 2: record(KeyPressedEvent((int)(i % 348), (int)(i % 5))); break;
+			case 3: record(KeyReleasedEvent(i % 16 == 3 ? -1 : (int)(i % 348))); break;
+			case 4: record(MouseScrolledEvent(i % 16 == 4 ? -1.0f : 0.5f, -(float)(i % 3 + 1))); break;
+			case 5: record(MouseButtonPressedEvent((int)(i % 8))); break;
+			case 6: record(MouseMovedEvent(-(float)(i % 64) - 0.5f, 5.0e9f)); break;
+			case 7: record(WindowResizeEvent((uint32_t)(i % 4096), 720)); break;
+		}
+	}
+}
+
+// Decoding a recording of arg events, delivered all at once. The recording
+// is replayed frame by frame and compared with what was recorded first
+PT_BENCHMARK("Events/Replay", 100000)
+{
+	std::string path = (std::filesystem::temp_directory_path() / "PhotonBench-Replay.ptev").string();
+	std::vector<ReplayedEvent> expected;
+	expected.reserve((size_t)state.GetArg());
+	uint64_t frames = 0;
+	{
+		EventRecorder recorder(path);
+		if (!recorder.IsOpen())
+		{
+			state.Skip("cannot write " + path);
+			return;
+		}
+
+		// Starts at frame 1, events recorded before it are played with it
+		recorder.NextFrame();
+		frames++;
+		for (int64_t i = 0; i < state.GetArg(); i++)
+		{
+			RecordReplayEvent(recorder, i, frames, expected);
+			for (int64_t skip = i % 16 == 0 ? (i % 64 == 0 ? 3 : 1) : 0; skip > 0; skip--)
+			{
+				recorder.NextFrame();
+				frames++;
+			}
+		}
+
+		// Trailing frames without input, only the end marker keeps them
+		for (int i = 0; i < 3; i++)
+		{
+			recorder.NextFrame();
+			frames++;
+		}
+	}
+
+	{
+		std::vector<ReplayedEvent> replayed;
+		replayed.reserve(expected.size());
+		EventPlayer player(path);
+		player.SetEventCallback([&](Event& event) { replayed.push_back(Capture(event, player.GetFrame())); });
+		while (player.NextFrame())
+			;
+
+		auto mismatch = std::mismatch(expected.begin(), expected.end(), replayed.begin(), replayed.end());
+		if (mismatch.first != expected.end() || mismatch.second != replayed.end())
+		{
+			state.Fail("replay differs from the recording at event " + std::to_string(mismatch.first - expected.begin()));
+			std::filesystem::remove(path);
+			return;
+		}
+		if (player.GetFrame() != frames)
+		{
+			state.Fail("replay ended at frame " + std::to_string(player.GetFrame()) + " instead of " + std::to_string(frames));
+			std::filesystem::remove(path);
+			return;
+		}
+	}
+
+	uint64_t delivered = 0;
+	state.SetItemsPerCall((double)state.GetArg());
+	state.Run([&]
+	{
+		EventPlayer player(path, ReplayMode::Immediate);
+		player.SetEventCallback([&](Event&) { delivered++; });
+		player.NextFrame();
+	});
+
+	if (delivered % state.GetArg())
+		state.Fail("replay delivered a partial recording");
+	std::filesystem::remove(path);
+}
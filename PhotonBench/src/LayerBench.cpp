@@ -0,0 +1,125 @@
+#include "Bench.h"
+
+#include "Photon/LayerStack.h"
+
+using namespace Photon;
+
+namespace
+{
+	class UpdateLayer : public Layer
+	{
+	public:
+		UpdateLayer()
+			: Layer("Update")
+		{
+		}
+
+		void OnUpdate(Timestep ts) override { m_Time += ts; }
+		void OnEvent(Event&) override {}
+
+		float m_Time = 0.0f;
+	};
+
+	// A layer that overrides nothing stays out of every hook list
+	class EmptyLayer : public Layer
+	{
+	public:
+		EmptyLayer()
+			: Layer("Empty")
+		{
+		}
+	};
+
+	void FillStack(LayerStack& stack, int64_t count)
+	{
+		for (int64_t i = 0; i < count; i++)
+		{
+			if (i % 2)
+				stack.EmplaceLayer<UpdateLayer>();
+			else
+				stack.EmplaceOverlay<UpdateLayer>();
+		}
+	}
+}
+
+// One layer emplaced on top of arg others and popped again. Both changes
+// rebuild the hook lists, so this grows with the stack size
+PT_BENCHMARK("Layers/EmplacePop", 0, 10, 100, 1000)
+{
+	LayerStack stack;
+	FillStack(stack, state.GetArg());
+
+	state.Run([&]
+	{
+		UpdateLayer* layer = stack.EmplaceLayer<UpdateLayer>();
+		stack.PopLayer(layer);
+	});
+}
+
+PT_BENCHMARK("Layers/EmplacePopOverlay", 0, 10, 100, 1000)
+{
+	LayerStack stack;
+	FillStack(stack, state.GetArg());
+
+	state.Run([&]
+	{
+		UpdateLayer* overlay = stack.EmplaceOverlay<UpdateLayer>();
+		stack.PopOverlay(overlay);
+	});
+}
+
+// Pushed by pointer, so every call also pays for new and delete
+PT_BENCHMARK("Layers/PushPop", 0, 10, 100, 1000)
+{
+	LayerStack stack;
+	FillStack(stack, state.GetArg());
+
+	state.Run([&]
+	{
+		UpdateLayer* layer = new UpdateLayer();
+		stack.PushLayer(layer);
+		stack.PopLayer(layer);
+		delete layer;
+	});
+}
+
+// Changes made mid-frame, queued while the stack is locked and applied
+// together at the end
+PT_BENCHMARK("Layers/DeferredChurn", 0, 10, 100, 1000)
+{
+	constexpr int ChurnLayers = 8;
+	LayerStack stack;
+	FillStack(stack, state.GetArg());
+
+	state.SetItemsPerCall(ChurnLayers);
+	state.Run([&]
+	{
+		Layer* layers[ChurnLayers];
+		stack.Lock();
+		for (int i = 0; i < ChurnLayers; i++)
+			layers[i] = i % 2 ? (Layer*)stack.EmplaceLayer<UpdateLayer>() : (Layer*)stack.EmplaceLayer<EmptyLayer>();
+		stack.Unlock();
+
+		stack.Lock();
+		for (int i = 0; i < ChurnLayers; i++)
+			stack.PopLayer(layers[i]);
+		stack.Unlock();
+	});
+}
+
+// Walking the update list the way a frame does
+PT_BENCHMARK("Layers/Update", 1, 10, 100, 1000)
+{
+	LayerStack stack;
+	FillStack(stack, state.GetArg());
+	for (int64_t i = 0; i < state.GetArg(); i++)
+		stack.EmplaceLayer<EmptyLayer>();
+
+	Timestep ts(1.0f / 60.0f);
+	state.SetItemsPerCall((double)state.GetArg());
+	state.Run([&]
+	{
+		for (Layer* layer : stack.GetUpdateLayers())
+			layer->OnUpdate(ts);
+	});
+}
@@ -0,0 +1,148 @@
+#include "Bench.h"
+
+#include "Photon/Log.h"
+#include "Photon/Events/KeyEvent.h"
+
+#include <filesystem>
+
+using namespace Photon;
+
+namespace
+{
+	// Reconfigures logging for one benchmark and restores the bench's own
+	// console logging afterwards. The loggers are left at warn, so the
+	// benchmarks log with PT_CORE_WARN, which stays compiled in for Release
+	class ScopedLog
+	{
+	public:
+		ScopedLog(LogConfig config, bool toFile)
+		{
+			config.Console = false;
+			if (toFile)
+			{
+				m_Path = (std::filesystem::temp_directory_path() / "PhotonBench.log").string();
+				config.FilePath = m_Path;
+			}
+
+			Log::Shutdown();
+			Log::Init(config);
+			SetLevel(spdlog::level::warn);
+		}
+
+		~ScopedLog()
+		{
+			Log::Shutdown();
+			if (!m_Path.empty())
+				std::filesystem::remove(m_Path);
+
+			Log::Init();
+			SetLevel(spdlog::level::warn);
+		}
+
+		static void SetLevel(spdlog::level::level_enum level)
+		{
+			Log::GetCoreLogger()->set_level(level);
+			Log::GetClientLogger()->set_level(level);
+		}
+	private:
+		std::string m_Path;
+	};
+
+	LogConfig Sync()
+	{
+		LogConfig config;
+		config.Async = false;
+		return config;
+	}
+
+	LogConfig Async(LogOverflowPolicy policy, size_t queueSize = 8192)
+	{
+		LogConfig config;
+		config.Async = true;
+		config.OverflowPolicy = policy;
+		config.QueueSize = queueSize;
+		return config;
+	}
+
+	void LogMessages(Bench::State& state)
+	{
+		int i = 0;
+		state.Run([&] { PT_CORE_WARN("Frame {0} took {1:.3f} ms", i++, 16.6f); });
+	}
+
+	void LogEvents(Bench::State& state)
+	{
+		KeyPressedEvent event(65, 1);
+		state.Run([&] { PT_CORE_WARN("{0}", event); });
+	}
+}
+
+// Below the logger's level, only the level check runs
+PT_BENCHMARK("Log/Disabled")
+{
+	ScopedLog log(Sync(), false);
+	ScopedLog::SetLevel(spdlog::level::off);
+	LogMessages(state);
+}
+
+PT_BENCHMARK("Log/DisabledEvent")
+{
+	ScopedLog log(Sync(), false);
+	ScopedLog::SetLevel(spdlog::level::off);
+	LogEvents(state);
+}
+
+// Enabled but without sinks, the cost of formatting the payload
+PT_BENCHMARK("Log/NoSinks")
+{
+	ScopedLog log(Sync(), false);
+	LogMessages(state);
+}
+
+PT_BENCHMARK("Log/NoSinksEvent")
+{
+	ScopedLog log(Sync(), false);
+	LogEvents(state);
+}
+
+PT_BENCHMARK("Log/SyncFile")
+{
+	ScopedLog log(Sync(), true);
+	LogMessages(state);
+}
+
+PT_BENCHMARK("Log/SyncFileEvent")
+{
+	ScopedLog log(Sync(), true);
+	LogEvents(state);
+}
+
+// Logging faster than the writer can keep up with, so this settles at the
+// writer thread's throughput
+PT_BENCHMARK("Log/AsyncFileBlock")
+{
+	ScopedLog log(Async(LogOverflowPolicy::Block), true);
+	LogMessages(state);
+}
+
+// The caller's side of async logging. Messages the writer can't keep up
+// with are dropped, so this stays at the cost of formatting and enqueueing
+PT_BENCHMARK("Log/AsyncFileDrop")
+{
+	ScopedLog log(Async(LogOverflowPolicy::Drop), true);
+	LogMessages(state);
+	state.SetCounter("dropped", (double)Log::GetDroppedMessageCount());
+}
+
+PT_BENCHMARK("Log/AsyncFileDropEvent")
+{
+	ScopedLog log(Async(LogOverflowPolicy::Drop), true);
+	LogEvents(state);
+	state.SetCounter("dropped", (double)Log::GetDroppedMessageCount());
+}
+
+PT_BENCHMARK("Log/AsyncFileOverwrite")
+{
+	ScopedLog log(Async(LogOverflowPolicy::OverwriteOldest), true);
+	LogMessages(state);
+}
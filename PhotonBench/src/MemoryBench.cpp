@@ -0,0 +1,69 @@
+#include "Bench.h"
+
+#include "Photon/Memory/TlsfAllocator.h"
+
+#include <vector>
+
+using namespace Photon;
+
+// One allocation and free in a 64 MB range, the size of a GPU memory block
+PT_BENCHMARK("Memory/TlsfAllocateFree")
+{
+	TlsfAllocator allocator(64ull * 1024 * 1024);
+	state.Run([&]
+	{
+		TlsfAllocator::Allocation allocation = allocator.Allocate(4096, 256);
+		allocator.Free(allocation);
+	});
+}
+
+// arg allocations kept alive while random ones are replaced, so the free
+// lists hold many fragments as they do after a while of streaming
+PT_BENCHMARK("Memory/TlsfChurn", 256, 4096)
+{
+	TlsfAllocator allocator(256ull * 1024 * 1024);
+	std::vector<TlsfAllocator::Allocation> live(state.GetArg());
+
+	uint64_t random = 1;
+	auto next = [&random]
+	{
+		random = random * 6364136223846793005ull + 1442695040888963407ull;
+		return random >> 33;
+	};
+	for (TlsfAllocator::Allocation& allocation : live)
+		allocation = allocator.Allocate(256 + next() % 65536, 256);
+
+	state.Run([&]
+	{
+		TlsfAllocator::Allocation& allocation = live[next() % live.size()];
+		allocator.Free(allocation);
+		allocation = allocator.Allocate(256 + next() % 65536, 256);
+	});
+}
+
+// An aligned request that only fits a free range whose size class is above
+// its own, found by the slow path. Fails when the range is missed
+PT_BENCHMARK("Memory/TlsfAlignedFragmented")
+{
+	// A 1604 byte gap at offset 4 between two allocations holds 1596 bytes
+	// at offset 8, but the gap's class is above 1596's and below the rounded
+	// up 1596 + 7
+	TlsfAllocator allocator(4096);
+	TlsfAllocator::Allocation front = allocator.Allocate(4);
+	TlsfAllocator::Allocation gap = allocator.Allocate(1604);
+	TlsfAllocator::Allocation back = allocator.Allocate(4096 - 4 - 1604);
+	allocator.Free(gap);
+
+	bool found = true;
+	state.Run([&]
+	{
+		TlsfAllocator::Allocation allocation = allocator.Allocate(1596, 8);
+		found &= allocation.IsValid() && allocation.Offset == 8;
+		allocator.Free(allocation);
+	});
+
+	if (!found)
+		state.Fail("aligned allocation missed a free range large enough for it");
+	allocator.Free(front);
+	allocator.Free(back);
+}
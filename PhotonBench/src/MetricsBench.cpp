@@ -0,0 +1,64 @@
+#include "Bench.h"
+
+#include "Photon/Metrics/Metrics.h"
+
+#include <thread>
+
+using namespace Photon;
+
+PT_BENCHMARK("Metrics/CounterIncrement")
+{
+	Counter& counter = Metrics::GetCounter("bench.counter");
+	state.Run([&] { counter.Increment(); });
+}
+
+PT_BENCHMARK("Metrics/HistogramRecord")
+{
+	Histogram& histogram = Metrics::GetHistogram("bench.histogram");
+	uint64_t value = 1;
+	state.Run([&]
+	{
+		// Spread over many buckets like real frame times would be
+		histogram.Record(value);
+		value = value * 6364136223846793005ull + 1442695040888963407ull;
+		value >>= 40;
+	});
+}
+
+PT_BENCHMARK("Metrics/HistogramTimer")
+{
+	Histogram& histogram = Metrics::GetHistogram("bench.timer_ns");
+	state.Run([&] { HistogramTimer timer(histogram); });
+}
+
+// arg threads recording into one histogram at once, as independent layers do
+PT_BENCHMARK("Metrics/HistogramContended", 2, 4)
+{
+	constexpr int RecordsPerThread = 100000;
+	Histogram& histogram = Metrics::GetHistogram("bench.contended");
+	int threads = (int)state.GetArg();
+
+	state.SetItemsPerCall((double)threads * RecordsPerThread);
+	state.Run([&]
+	{
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++)
+		{
+			workers.emplace_back([&, t]
+			{
+				for (int i = 0; i < RecordsPerThread; i++)
+					histogram.Record((uint64_t)(i + t) * 1000);
+			});
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+	});
+}
+
+PT_BENCHMARK("Metrics/Snapshot")
+{
+	for (int i = 0; i < 32; i++)
+		Metrics::GetHistogram("bench.snapshot." + std::to_string(i)).Record(i);
+
+	state.Run([&] { Bench::DoNotOptimize(Metrics::Snapshot()); });
+}
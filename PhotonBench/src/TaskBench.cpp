@@ -0,0 +1,78 @@
+#include "Bench.h"
+
+#include "Photon/Tasks/Task.h"
+#include "Photon/Tasks/TaskScheduler.h"
+
+using namespace Photon;
+
+namespace
+{
+	Task WaitFrames(uint64_t& resumes)
+	{
+		for (;;)
+		{
+			co_await NextFrame();
+			resumes++;
+		}
+	}
+
+	Task Sleep(uint64_t& wakes)
+	{
+		for (;;)
+		{
+			co_await WaitForSeconds(3600.0f);
+			wakes++;
+		}
+	}
+
+	Task Child(int)
+	{
+		co_return;
+	}
+
+	Task Parent(int children)
+	{
+		for (int i = 0; i < children; i++)
+			co_await Child(i);
+	}
+}
+
+// One Update resuming arg tasks that wait a frame at a time
+PT_BENCHMARK("Tasks/NextFrame", 1000, 100000)
+{
+	TaskScheduler scheduler;
+	uint64_t resumes = 0;
+	for (int64_t i = 0; i < state.GetArg(); i++)
+		scheduler.Spawn(WaitFrames(resumes));
+
+	state.SetItemsPerCall((double)state.GetArg());
+	state.Run([&] { scheduler.Update(Timestep(1.0f / 60.0f)); });
+	Bench::DoNotOptimize(resumes);
+}
+
+// Sleeping tasks should cost Update nothing
+PT_BENCHMARK("Tasks/Sleeping", 1000, 100000)
+{
+	TaskScheduler scheduler;
+	uint64_t wakes = 0;
+	for (int64_t i = 0; i < state.GetArg(); i++)
+		scheduler.Spawn(Sleep(wakes));
+
+	// A zero step takes the same path through Update without moving the
+	// clock, so no sample gets far enough to wake the sleepers
+	state.Run([&] { scheduler.Update(Timestep(0.0f)); });
+	if (wakes)
+		state.Fail("sleeping tasks woke during the measurement");
+}
+
+// Spawning a task that awaits 16 children, frames come from the pools
+PT_BENCHMARK("Tasks/SpawnAwait")
+{
+	constexpr int Children = 16;
+	TaskScheduler scheduler;
+
+	state.SetItemsPerCall(Children + 1);
+	state.Run([&] { scheduler.Spawn(Parent(Children)); });
+	if (scheduler.GetTaskCount())
+		state.Fail("spawned tasks did not finish");
+}
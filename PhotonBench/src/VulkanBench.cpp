@@ -0,0 +1,233 @@
+#include "Bench.h"
+
+#include "Platform/Vulkan/VulkanContext.h"
+#include "Platform/Vulkan/VulkanRingBuffer.h"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+using namespace Photon;
+
+namespace
+{
+	// Offscreen, so these run on a software ICD such as lavapipe in CI.
+	// Null, with the benchmark skipped, when there is no device
+	std::unique_ptr<VulkanContext> CreateContext(Bench::State& state)
+	{
+		if (!VulkanContext::IsDeviceAvailable())
+		{
+			state.Skip("no Vulkan device");
+			return nullptr;
+		}
+
+		VulkanContextProps props;
+		props.PipelineCachePath = (std::filesystem::temp_directory_path() / "PhotonBench-Cache").string();
+		return std::make_unique<VulkanContext>(props);
+	}
+
+	// void main() {} with a local size of (localSizeX, 1, 1), each size
+	// makes a different pipeline
+	std::vector<uint32_t> EmptyComputeShader(uint32_t localSizeX)
+	{
+		return {
+			0x07230203, 0x00010000, 0, 6, 0,
+			0x00020011, 1,                         // OpCapability Shader
+			0x0003000e, 0, 1,                      // OpMemoryModel Logical GLSL450
+			0x0005000f, 5, 4, 0x6e69616d, 0,       // OpEntryPoint GLCompute %4 "main"
+			0x00060010, 4, 17, localSizeX, 1, 1,   // OpExecutionMode %4 LocalSize
+			0x00020013, 2,                         // %2 = OpTypeVoid
+			0x00030021, 3, 2,                      // %3 = OpTypeFunction %2
+			0x00050036, 2, 4, 0, 3,                // %4 = OpFunction %2 None %3
+			0x000200f8, 5,                         // %5 = OpLabel
+			0x000100fd,                            // OpReturn
+			0x00010038,                            // OpFunctionEnd
+		};
+	}
+}
+
+// A vertex buffer sized allocation out of a memory block and back
+PT_BENCHMARK("Vulkan/AllocateBuffer")
+{
+	std::unique_ptr<VulkanContext> context = CreateContext(state);
+	if (!context)
+		return;
+
+	VulkanAllocator& allocator = context->GetAllocator();
+	vk::BufferCreateInfo createInfo(vk::BufferCreateFlags(), 64 * 1024, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst);
+
+	bool created = true;
+	state.Run([&]
+	{
+		VulkanBuffer buffer = allocator.CreateBuffer(createInfo, VulkanMemoryUsage::GpuOnly);
+		created &= (bool)buffer.Buffer;
+		allocator.DestroyBuffer(buffer);
+	});
+
+	state.SetCounter("device_allocations", allocator.GetStats().DeviceAllocationCount);
+	if (!created)
+		state.Fail("buffer creation failed");
+}
+
+PT_BENCHMARK("Vulkan/AllocateImage")
+{
+	std::unique_ptr<VulkanContext> context = CreateContext(state);
+	if (!context)
+		return;
+
+	VulkanAllocator& allocator = context->GetAllocator();
+	vk::ImageCreateInfo createInfo(vk::ImageCreateFlags(), vk::ImageType::e2D, vk::Format::eR8G8B8A8Unorm, vk::Extent3D(256, 256, 1), 1, 1,
+		vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
+
+	bool created = true;
+	state.Run([&]
+	{
+		VulkanImage image = allocator.CreateImage(createInfo, VulkanMemoryUsage::GpuOnly);
+		created &= (bool)image.Image;
+		allocator.DestroyImage(image);
+	});
+
+	state.SetCounter("device_allocations", allocator.GetStats().DeviceAllocationCount);
+	if (!created)
+		state.Fail("image creation failed");
+}
+
+// A frame's worth of uniform and 12 byte vertex allocations, then NextFrame.
+// Every offset is checked against its alignment
+PT_BENCHMARK("Vulkan/RingBufferFrame")
+{
+	constexpr int Allocations = 64;
+	std::unique_ptr<VulkanContext> context = CreateContext(state);
+	if (!context)
+		return;
+
+	VulkanRingBuffer ring(context->GetAllocator(), 4 * 1024 * 1024,
+		vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eVertexBuffer, 3);
+	vk::DeviceSize uniformAlignment = std::max<vk::DeviceSize>(context->GetAllocator().GetDeviceProperties().limits.minUniformBufferOffsetAlignment, 1);
+
+	bool aligned = true, allocated = true;
+	state.SetItemsPerCall(Allocations);
+	state.Run([&]
+	{
+		for (int i = 0; i < Allocations; i++)
+		{
+			bool vertices = i % 2;
+			VulkanRingAllocation allocation = vertices ? ring.Allocate(12 * 37, 12) : ring.Allocate(200);
+			allocated &= (bool)allocation;
+			aligned &= allocation.Offset % (vertices ? 12 : uniformAlignment) == 0;
+		}
+		ring.NextFrame();
+	});
+
+	if (!allocated)
+		state.Fail("ring buffer ran out of space");
+	else if (!aligned)
+		state.Fail("ring buffer allocation is misaligned");
+}
+
+// A 64 KB upload through the staging ring, waited for. Runs on the graphics
+// queue when the device has no other
+PT_BENCHMARK("Vulkan/UploadBuffer")
+{
+	constexpr vk::DeviceSize Size = 64 * 1024;
+	std::unique_ptr<VulkanContext> context = CreateContext(state);
+	if (!context)
+		return;
+
+	VulkanUploader* uploader = context->GetUploader();
+	if (!uploader)
+	{
+		state.Skip("no timeline semaphores");
+		return;
+	}
+
+	VulkanAllocator& allocator = context->GetAllocator();
+	VulkanBuffer buffer = allocator.CreateBuffer(vk::BufferCreateInfo(vk::BufferCreateFlags(), Size,
+		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst), VulkanMemoryUsage::GpuOnly);
+	std::vector<uint8_t> data(Size, 0x5a);
+
+	bool uploaded = true;
+	state.SetItemsPerCall((double)Size);
+	state.Run([&]
+	{
+		uint64_t value = uploader->UploadBuffer(buffer.Buffer, 0, data.data(), Size);
+		uploader->Wait(value);
+		uploaded &= uploader->IsComplete(value);
+	});
+
+	state.SetCounter("batches", (double)uploader->GetStats().Batches);
+	allocator.DestroyBuffer(buffer);
+	if (!uploaded)
+		state.Fail("upload did not complete");
+}
+
+// The same pipelines compiled by a first launch with an empty cache and by
+// a second one with the cache the first saved. The sample is the second
+// launch, the first is reported as cold_ms. Without a job system the
+// compiles run one after another on this thread
+PT_BENCHMARK("Vulkan/PipelineCache")
+{
+	constexpr uint32_t Pipelines = 32;
+	if (!VulkanContext::IsDeviceAvailable())
+	{
+		state.Skip("no Vulkan device");
+		return;
+	}
+
+	VulkanContextProps props;
+	props.PipelineCachePath = (std::filesystem::temp_directory_path() / "PhotonBench-PipelineCache").string();
+	std::filesystem::remove_all(props.PipelineCachePath);
+
+	// Every launch is a context of its own, destroying it saves the cache
+	auto launch = [&](VulkanPipelineStats& stats, HistogramSnapshot& compileTimes, auto&& measure)
+	{
+		VulkanContext context(props);
+		VulkanPipelineManager& manager = context.GetPipelineManager();
+		vk::PipelineLayout layout = context.GetDevice().createPipelineLayout(vk::PipelineLayoutCreateInfo());
+		HistogramSnapshot before = manager.GetStats().CompileTimes;
+
+		measure([&]
+		{
+			for (uint32_t i = 0; i < Pipelines; i++)
+			{
+				VulkanComputePipelineDesc desc;
+				desc.Shader = { vk::ShaderStageFlagBits::eCompute, EmptyComputeShader(i + 1) };
+				desc.Layout = layout;
+				manager.Compile("Compute" + std::to_string(i + 1), std::move(desc));
+			}
+			manager.WaitAll();
+		});
+
+		stats = manager.GetStats();
+		compileTimes = stats.CompileTimes.Since(before);
+		context.GetDevice().destroyPipelineLayout(layout);
+	};
+
+	VulkanPipelineStats cold, warm;
+	HistogramSnapshot coldTimes, warmTimes;
+	std::chrono::nanoseconds coldDuration{};
+	launch(cold, coldTimes, [&](auto&& compile)
+	{
+		auto start = std::chrono::steady_clock::now();
+		compile();
+		coldDuration = std::chrono::steady_clock::now() - start;
+	});
+	launch(warm, warmTimes, [&](auto&& compile) { state.RunOnce(compile); });
+
+	state.SetItemsPerCall(Pipelines);
+	state.SetCounter("cold_ms", coldDuration.count() / 1e6);
+	state.SetCounter("cold_compile_p50_us", coldTimes.GetPercentile(50.0) / 1e3);
+	state.SetCounter("warm_compile_p50_us", warmTimes.GetPercentile(50.0) / 1e3);
+	// Hits and misses stay 0 on drivers without pipeline creation feedback
+	state.SetCounter("cold_cache_hits", (double)cold.CacheHits);
+	state.SetCounter("warm_cache_hits", (double)warm.CacheHits);
+	state.SetCounter("warm_cache_misses", (double)warm.CacheMisses);
+	state.SetCounter("loaded_cache_bytes", (double)warm.LoadedCacheBytes);
+
+	std::filesystem::remove_all(props.PipelineCachePath);
+	if (cold.Failed || warm.Failed)
+		state.Fail("pipeline compile failed");
+	else if (!warm.LoadedCacheBytes)
+		state.Fail("the saved pipeline cache was not loaded");
+}
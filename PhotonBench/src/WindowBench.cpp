@@ -0,0 +1,78 @@
+#include "Bench.h"
+
+#include "Photon/Window.h"
+
+#include <memory>
+
+using namespace Photon;
+
+namespace
+{
+	WindowProps Props(bool headless)
+	{
+		WindowProps props("PhotonBench", 1280, 720);
+		props.Headless = headless;
+		return props;
+	}
+
+	bool s_WindowCreated = false;
+}
+
+PT_BENCHMARK("Window/Headless")
+{
+	state.Run([&] { std::unique_ptr<Window> window(Window::Create(Props(true))); });
+}
+
+PT_BENCHMARK("Window/HeadlessUpdate")
+{
+	std::unique_ptr<Window> window(Window::Create(Props(true)));
+	state.Run([&] { window->OnUpdate(); });
+}
+
+// The first window of the process initialises GLFW on top of setting up its
+// Vulkan instance, device and renderer. Can only be measured once per run,
+// so it is a single sample
+PT_BENCHMARK("Window/Cold")
+{
+	if (!Bench::GetOptions().Window)
+	{
+		state.Skip("needs --window");
+		return;
+	}
+	if (s_WindowCreated)
+	{
+		state.Skip("a window was already created in this run");
+		return;
+	}
+
+	state.RunOnce([&] { std::unique_ptr<Window> window(Window::Create(Props(false))); });
+	s_WindowCreated = true;
+}
+
+// Later windows reuse the initialised GLFW but set up Vulkan and a renderer
+// of their own
+PT_BENCHMARK("Window/Warm")
+{
+	if (!Bench::GetOptions().Window)
+	{
+		state.Skip("needs --window");
+		return;
+	}
+
+	s_WindowCreated = true;
+	state.Run([&] { std::unique_ptr<Window> window(Window::Create(Props(false))); });
+}
+
+PT_BENCHMARK("Window/Update")
+{
+	if (!Bench::GetOptions().Window)
+	{
+		state.Skip("needs --window");
+		return;
+	}
+
+	s_WindowCreated = true;
+	std::unique_ptr<Window> window(Window::Create(Props(false)));
+	window->SetVSync(false);
+	state.Run([&] { window->OnUpdate(); });
+}
@@ -1,21 +1,50 @@
 #include <Photon.h>
 
+struct Position { float X, Y; };
+struct Velocity { float X, Y; };
+
 class ExampleLayer : public Photon::Layer
 {
 public:
 	ExampleLayer()
-		: Layer("Example")
-	{}
+		: Layer("Example"), m_Movement(m_World)
+	{
+		for (int i = 0; i < 1000; i++)
+			m_World.Create(Position{ 0.0f, 0.0f }, Velocity{ (float)i, 1.0f });
+	}
+
+	void OnAttach() override
+	{
+		Photon::Application::Get().SpawnTask(ReportEntities());
+	}
 
-	void OnUpdate() override
+	void OnUpdate(Photon::Timestep ts) override
 	{
 		PT_INFO("ExampleLayer::Update");
+
+		m_Movement.Each([ts](Photon::Entity, Position& position, const Velocity& velocity)
+		{
+			position.X += velocity.X * ts;
+			position.Y += velocity.Y * ts;
+		});
 	}
 
 	void OnEvent(Photon::Event& e) override
 	{
-		PT_CORE_TRACE("{0}", e.ToString());
+		PT_CORE_TRACE("{0}", e);
 	}
+private:
+	Photon::Task ReportEntities()
+	{
+		for (;;)
+		{
+			co_await Photon::WaitForSeconds(1.0f);
+			PT_INFO("{0} entities moving", m_Movement.Count());
+		}
+	}
+
+	Photon::World m_World;
+	Photon::Query<Position, const Velocity> m_Movement;
 };
 
 class Sandbox : public Photon::Application
@@ -23,7 +52,7 @@ class Sandbox : public Photon::Application
 public:
 	Sandbox()
 	{
-		PushLayer(new ExampleLayer());
+		EmplaceLayer<ExampleLayer>();
 	}
 
 	~Sandbox()
@@ -5,7 +5,10 @@ workspace "Photon"
     {
         "Debug",
         "Release",
-        "Dist"
+        "Dist",
+        -- Dist with Photon linked in statically and link-time optimisation,
+        -- so engine code can be inlined into the client
+        "DistStatic"
     }
 
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
@@ -51,7 +54,6 @@ project "Photon"
     links
     {
         "GLFW",
-        "vulkan-1.lib",
         -- "opengl32.lib",
         -- "dwmapi.lib",
     }
@@ -66,9 +68,43 @@ project "Photon"
             "PT_BUILD_DLL",
         }
 
+        links
+        {
+            "vulkan-1.lib",
+        }
+
+        removefiles
+        {
+            "%{prj.name}/src/Platform/Linux/**",
+        }
+
+    filter "system:linux"
+        cppdialect "C++20"
+        pic "On"
+
+        defines
+        {
+            "PT_PLATFORM_LINUX",
+            "PT_BUILD_DLL",
+        }
+
+        links
+        {
+            "vulkan",
+            "pthread",
+            "dl",
+        }
+
+        removefiles
+        {
+            "%{prj.name}/src/Platform/Windows/**",
+        }
+
+    filter { "configurations:not DistStatic" }
         postbuildcommands
         {
-            ("{COPY} %{cfg.buildtarget.relpath} ../bin/" .. outputdir .. "/Sandbox")
+            ("{COPY} %{cfg.buildtarget.relpath} ../bin/" .. outputdir .. "/Sandbox"),
+            ("{COPY} %{cfg.buildtarget.relpath} ../bin/" .. outputdir .. "/PhotonBench"),
         }
 
     filter "configurations:Debug"
@@ -86,6 +122,13 @@ project "Photon"
         optimize "On"
         runtime "Release"
 
+    filter "configurations:DistStatic"
+        kind "StaticLib"
+        defines { "PT_DIST", "PT_STATIC" }
+        optimize "On"
+        runtime "Release"
+        flags { "LinkTimeOptimization" }
+
 project "Sandbox"
     location "Sandbox"
     kind "ConsoleApp"
@@ -122,6 +165,17 @@ project "Sandbox"
             "PT_PLATFORM_WINDOWS",
         }
 
+    filter "system:linux"
+        cppdialect "C++20"
+
+        defines
+        {
+            "PT_PLATFORM_LINUX",
+        }
+
+        -- libPhoton.so is copied next to the executable
+        linkoptions { "-Wl,-rpath,'$$ORIGIN'" }
+
     filter "configurations:Debug"
         defines "PT_DEBUG"
         runtime "Debug"
@@ -135,4 +189,101 @@ project "Sandbox"
     filter "configurations:Dist"
         defines "PT_DIST"
         runtime "Release"
-        optimize "On"
\ No newline at end of file
+        optimize "On"
+
+    -- A static library doesn't carry its dependencies, link them here
+    filter "configurations:DistStatic"
+        defines { "PT_DIST", "PT_STATIC" }
+        runtime "Release"
+        optimize "On"
+        flags { "LinkTimeOptimization" }
+        links { "GLFW" }
+
+    filter { "configurations:DistStatic", "system:windows" }
+        libdirs { "Photon/vendor/Vulkan/lib" }
+        links { "vulkan-1.lib" }
+
+    filter { "configurations:DistStatic", "system:linux" }
+        links { "vulkan", "pthread", "dl" }
+
+-- Microbenchmarks for the engine's hot paths. Run the Release or DistStatic
+-- build, see PhotonBench/src/BenchMain.cpp for the options
+project "PhotonBench"
+    location "PhotonBench"
+    kind "ConsoleApp"
+    staticruntime "off"
+
+    language "C++"
+
+    targetdir("bin/" .. outputdir .. "/%{prj.name}")
+    objdir("bin-int/" .. outputdir .. "/%{prj.name}")
+
+    files
+    {
+        "%{prj.name}/src/**.h",
+        "%{prj.name}/src/**.cpp",
+    }
+
+    includedirs
+    {
+        "Photon/vendor/spdlog/include",
+        "Photon/src",
+        -- The Vulkan benchmarks use the engine's Vulkan classes directly
+        "%{IncludeDir.Vulkan}",
+    }
+
+    links
+    {
+        "Photon"
+    }
+
+    filter "system:windows"
+        cppdialect "C++20"
+        systemversion "latest"
+
+        defines 
+        {
+            "PT_PLATFORM_WINDOWS",
+        }
+
+        -- The Vulkan benchmarks call into Vulkan themselves
+        libdirs { "Photon/vendor/Vulkan/lib" }
+        links { "vulkan-1.lib" }
+
+    filter "system:linux"
+        cppdialect "C++20"
+
+        defines
+        {
+            "PT_PLATFORM_LINUX",
+        }
+
+        links { "vulkan", "pthread" }
+
+        -- libPhoton.so is copied next to the executable
+        linkoptions { "-Wl,-rpath,'$$ORIGIN'" }
+
+    filter "configurations:Debug"
+        defines "PT_DEBUG"
+        runtime "Debug"
+        symbols "On"
+
+    filter "configurations:Release"
+        defines "PT_RELEASE"
+        runtime "Release"
+        optimize "On"
+
+    filter "configurations:Dist"
+        defines "PT_DIST"
+        runtime "Release"
+        optimize "On"
+
+    filter "configurations:DistStatic"
+        defines { "PT_DIST", "PT_STATIC" }
+        runtime "Release"
+        optimize "On"
+        flags { "LinkTimeOptimization" }
+        links { "GLFW" }
+
+    filter { "configurations:DistStatic", "system:linux" }
+        links { "dl" }